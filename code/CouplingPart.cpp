@@ -722,38 +722,34 @@ namespace EMP {
                 return -2;
             }
 
-            // 创建一个临时的LocalData对象
-            LocalData localData;
-
-            // 检查版本号，如果已经更新则跳过
-            bool isVersionSame = (localData.version == sharedData->version.load());
-            if (isVersionSame) {
-                std::cout << "Data " << dataName << " is already up to date (version " << localData.version << ")" << std::endl;
+            // 通过零拷贝视图直接读取共享内存，避免中间LocalData的整体复制
+            SharedDataView view = sharedMemoryManager->getDataView(sharedData);
+            if (!view.isValid()) {
+                // 降低精度存储的数据没有可映射的双精度数组，经 getData 转换为双精度后复制
+                LocalData local;
+                sharedMemoryManager->getData(sharedData, local);
+                t = local.t;
+                if (!local.data.empty()) {
+                    data = Map<const ArrayXd>(local.data[0].data(), local.data[0].size());
+                } else {
+                    data.resize(0);
+                }
+                pos = Map<const ArrayXi>(local.index.data(), local.index.size());
                 return 0;
             }
 
-            // 从共享数据复制到本地数据
-            sharedData->copyToLocal(localData);
-
             // 设置返回值
-            t = localData.t;
+            t = view.getTime();
 
             // 如果有多个分量，只返回第一个分量的数据
-            if (!localData.data.empty()) {
-                // 将本地数据的值转换为Eigen::ArrayXd
-                data.resize(localData.data[0].size());
-                for (size_t i = 0; i < localData.data[0].size(); i++) {
-                    data(i) = localData.data[0][i];
-                }
+            if (view.getComponentCount() > 0) {
+                data = view.component(0);
             } else {
                 data.resize(0);
             }
 
-            // 将本地数据的索引转换为Eigen::ArrayXi
-            pos.resize(localData.index.size());
-            for (size_t i = 0; i < localData.index.size(); i++) {
-                pos(i) = localData.index[i];
-            }
+            // 将共享数据的索引转换为Eigen::ArrayXi
+            pos = view.index();
 
             return 0;
         }
@@ -798,6 +794,30 @@ namespace EMP {
         }
     }
 
+    int CouplingPart::waitForSharedData(std::string dataName, uint64_t lastVersion, int timeoutMs)
+    {
+        try {
+            if (sharedMemoryManager == nullptr) {
+                std::cerr << "SharedMemoryManager is not initialized" << std::endl;
+                return -1;
+            }
+
+            // 查找数据对象
+            SharedData* sharedData = sharedMemoryManager->findDataByName(dataName);
+            if (!sharedData) {
+                std::cerr << "Failed to find data: " << dataName << std::endl;
+                return -2;
+            }
+
+            uint64_t version = sharedMemoryManager->waitForNewVersion(sharedData, lastVersion, timeoutMs);
+            return (version != lastVersion) ? 0 : 1;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Exception in waitForSharedData: " << e.what() << std::endl;
+            return -3;
+        }
+    }
+
     int CouplingPart::writeDataToSharedDatas(std::string dataName, double& t, const ArrayXd& data, const ArrayXi& pos)
     {
         try {
@@ -213,6 +213,15 @@ namespace EMP {
 		 */
 		int readDataFromSharedDatas(std::string dataName, LocalData& data);
 		
+		/**
+		 * @brief 阻塞等待共享数据出现新版本，替代轮询版本号
+		 * @param dataName 数据名称
+		 * @param lastVersion 调用方已读取的版本号
+		 * @param timeoutMs 超时时间(毫秒)，小于0表示一直等待
+		 * @return 返回状态码，0表示有新版本，1表示超时
+		 */
+		int waitForSharedData(std::string dataName, uint64_t lastVersion, int timeoutMs = -1);
+		
 		/**
 		 * @brief 将数据写入共享数据
 		 * @param dataName 数据名称
@@ -0,0 +1,812 @@
+#include "SharedDataKernels.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <system_error>
+#include <new>
+
+namespace EMP {
+    namespace DataKernels {
+
+        // 通用转置的行分块大小，一块内所有分量的数据可以同时驻留在一级缓存中
+        static const size_t BLOCK_ROWS = 256;
+
+        // xxHash64 的常数
+        static const uint64_t PRIME1 = 11400714785074694791ULL;
+        static const uint64_t PRIME2 = 14029467366897019727ULL;
+        static const uint64_t PRIME3 = 1609587929392839161ULL;
+        static const uint64_t PRIME4 = 9650029242287828579ULL;
+        static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+        static inline uint64_t rotl(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        // 按字节读取，不要求对齐
+        static inline uint64_t read64(const unsigned char* p)
+        {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline uint32_t read32(const unsigned char* p)
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline uint64_t hashRound(uint64_t acc, uint64_t input)
+        {
+            acc += input * PRIME2;
+            acc = rotl(acc, 31);
+            return acc * PRIME1;
+        }
+
+        static inline uint64_t hashMerge(uint64_t acc, uint64_t lane)
+        {
+            acc ^= hashRound(0, lane);
+            return acc * PRIME1 + PRIME4;
+        }
+
+        void interleave(const double* const* components, size_t componentCount, size_t rowCount, double* out)
+        {
+            if (componentCount == 0 || rowCount == 0) {
+                return;
+            }
+
+            switch (componentCount) {
+            case 1: {
+                std::copy(components[0], components[0] + rowCount, out);
+                return;
+            }
+            case 2: {
+                const double* c0 = components[0];
+                const double* c1 = components[1];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    out[2 * i] = c0[i];
+                    out[2 * i + 1] = c1[i];
+                }
+                return;
+            }
+            case 3: {
+                const double* c0 = components[0];
+                const double* c1 = components[1];
+                const double* c2 = components[2];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    out[3 * i] = c0[i];
+                    out[3 * i + 1] = c1[i];
+                    out[3 * i + 2] = c2[i];
+                }
+                return;
+            }
+            case 4: {
+                const double* c0 = components[0];
+                const double* c1 = components[1];
+                const double* c2 = components[2];
+                const double* c3 = components[3];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    out[4 * i] = c0[i];
+                    out[4 * i + 1] = c1[i];
+                    out[4 * i + 2] = c2[i];
+                    out[4 * i + 3] = c3[i];
+                }
+                return;
+            }
+            default:
+                break;
+            }
+
+            // 分块转置：块内逐分量顺序读取，按步长写入
+            for (size_t begin = 0; begin < rowCount; begin += BLOCK_ROWS) {
+                size_t end = std::min(begin + BLOCK_ROWS, rowCount);
+                for (size_t c = 0; c < componentCount; ++c) {
+                    const double* src = components[c];
+                    double* dst = out + c;
+                    for (size_t i = begin; i < end; ++i) {
+                        dst[i * componentCount] = src[i];
+                    }
+                }
+            }
+        }
+
+        void deinterleave(const double* in, size_t componentCount, size_t rowCount, double* const* components)
+        {
+            if (componentCount == 0 || rowCount == 0) {
+                return;
+            }
+
+            switch (componentCount) {
+            case 1: {
+                std::copy(in, in + rowCount, components[0]);
+                return;
+            }
+            case 2: {
+                double* c0 = components[0];
+                double* c1 = components[1];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    c0[i] = in[2 * i];
+                    c1[i] = in[2 * i + 1];
+                }
+                return;
+            }
+            case 3: {
+                double* c0 = components[0];
+                double* c1 = components[1];
+                double* c2 = components[2];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    c0[i] = in[3 * i];
+                    c1[i] = in[3 * i + 1];
+                    c2[i] = in[3 * i + 2];
+                }
+                return;
+            }
+            case 4: {
+                double* c0 = components[0];
+                double* c1 = components[1];
+                double* c2 = components[2];
+                double* c3 = components[3];
+                for (size_t i = 0; i < rowCount; ++i) {
+                    c0[i] = in[4 * i];
+                    c1[i] = in[4 * i + 1];
+                    c2[i] = in[4 * i + 2];
+                    c3[i] = in[4 * i + 3];
+                }
+                return;
+            }
+            default:
+                break;
+            }
+
+            // 分块转置：块内按步长读取，逐分量顺序写入
+            for (size_t begin = 0; begin < rowCount; begin += BLOCK_ROWS) {
+                size_t end = std::min(begin + BLOCK_ROWS, rowCount);
+                for (size_t c = 0; c < componentCount; ++c) {
+                    const double* src = in + c;
+                    double* dst = components[c];
+                    for (size_t i = begin; i < end; ++i) {
+                        dst[i] = src[i * componentCount];
+                    }
+                }
+            }
+        }
+
+        void planarToInterleaved(const double* planar, size_t componentCount, size_t rowCount, double* interleaved)
+        {
+            std::vector<const double*> components(componentCount);
+            for (size_t c = 0; c < componentCount; ++c) {
+                components[c] = planar + c * rowCount;
+            }
+            interleave(components.data(), componentCount, rowCount, interleaved);
+        }
+
+        void interleavedToPlanar(const double* interleaved, size_t componentCount, size_t rowCount, double* planar)
+        {
+            std::vector<double*> components(componentCount);
+            for (size_t c = 0; c < componentCount; ++c) {
+                components[c] = planar + c * rowCount;
+            }
+            deinterleave(interleaved, componentCount, rowCount, components.data());
+        }
+
+        uint64_t hashBytes(const void* data, size_t bytes, uint64_t seed)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            const unsigned char* end = p + bytes;
+            uint64_t h;
+
+            if (bytes >= 32) {
+                // 4 路独立累加，每路处理 32 字节中的 8 字节
+                uint64_t v1 = seed + PRIME1 + PRIME2;
+                uint64_t v2 = seed + PRIME2;
+                uint64_t v3 = seed;
+                uint64_t v4 = seed - PRIME1;
+                const unsigned char* limit = end - 32;
+                do {
+                    v1 = hashRound(v1, read64(p));
+                    v2 = hashRound(v2, read64(p + 8));
+                    v3 = hashRound(v3, read64(p + 16));
+                    v4 = hashRound(v4, read64(p + 24));
+                    p += 32;
+                } while (p <= limit);
+
+                h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+                h = hashMerge(h, v1);
+                h = hashMerge(h, v2);
+                h = hashMerge(h, v3);
+                h = hashMerge(h, v4);
+            } else {
+                h = seed + PRIME5;
+            }
+            h += static_cast<uint64_t>(bytes);
+
+            // 剩余不足 32 字节的部分
+            for (; p + 8 <= end; p += 8) {
+                h ^= hashRound(0, read64(p));
+                h = rotl(h, 27) * PRIME1 + PRIME4;
+            }
+            if (p + 4 <= end) {
+                h ^= static_cast<uint64_t>(read32(p)) * PRIME1;
+                h = rotl(h, 23) * PRIME2 + PRIME3;
+                p += 4;
+            }
+            for (; p < end; ++p) {
+                h ^= static_cast<uint64_t>(*p) * PRIME5;
+                h = rotl(h, 11) * PRIME1;
+            }
+
+            // 雪崩
+            h ^= h >> 33;
+            h *= PRIME2;
+            h ^= h >> 29;
+            h *= PRIME3;
+            h ^= h >> 32;
+            return h;
+        }
+
+        // 统计量的一遍循环：4 路独立累加，判断有限值时不分支(v - v 仅对有限值为 0)，编译器可以向量化
+        template <bool Copy>
+        static void statsPass(const double* src, size_t count, double* dst, ValueStats& stats)
+        {
+            const size_t LANES = 4;
+            double lo[LANES], hi[LANES], sum[LANES], sq[LANES];
+            uint64_t finite[LANES];
+            for (size_t k = 0; k < LANES; ++k) {
+                lo[k] = std::numeric_limits<double>::infinity();
+                hi[k] = -std::numeric_limits<double>::infinity();
+                sum[k] = 0.0;
+                sq[k] = 0.0;
+                finite[k] = 0;
+            }
+
+            size_t i = 0;
+            for (; i + LANES <= count; i += LANES) {
+                for (size_t k = 0; k < LANES; ++k) {
+                    double v = src[i + k];
+                    if (Copy) {
+                        dst[i + k] = v;
+                    }
+                    bool ok = (v - v) == 0.0;
+                    double f = ok ? v : 0.0;
+                    lo[k] = ok && v < lo[k] ? v : lo[k];
+                    hi[k] = ok && v > hi[k] ? v : hi[k];
+                    sum[k] += f;
+                    sq[k] += f * f;
+                    finite[k] += ok ? 1 : 0;
+                }
+            }
+            for (; i < count; ++i) {
+                double v = src[i];
+                if (Copy) {
+                    dst[i] = v;
+                }
+                bool ok = (v - v) == 0.0;
+                double f = ok ? v : 0.0;
+                lo[0] = ok && v < lo[0] ? v : lo[0];
+                hi[0] = ok && v > hi[0] ? v : hi[0];
+                sum[0] += f;
+                sq[0] += f * f;
+                finite[0] += ok ? 1 : 0;
+            }
+
+            uint64_t finiteCount = 0;
+            for (size_t k = 0; k < LANES; ++k) {
+                stats.min = (std::min)(stats.min, lo[k]);
+                stats.max = (std::max)(stats.max, hi[k]);
+                stats.sum += sum[k];
+                stats.sumSquares += sq[k];
+                finiteCount += finite[k];
+            }
+            stats.count += finiteCount;
+            stats.nonFinite += count - finiteCount;
+        }
+
+        void copyWithStats(const double* src, size_t count, double* dst, ValueStats& stats)
+        {
+            statsPass<true>(src, count, dst, stats);
+        }
+
+        void accumulateStats(const double* src, size_t count, ValueStats& stats)
+        {
+            statsPass<false>(src, count, nullptr, stats);
+        }
+
+        void narrowToFloat(const double* src, size_t count, float* dst, size_t stride)
+        {
+            if (stride == 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = static_cast<float>(src[i]);
+                }
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[i * stride] = static_cast<float>(src[i]);
+            }
+        }
+
+        void widenFromFloat(const float* src, size_t count, double* dst, size_t stride)
+        {
+            if (stride == 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = static_cast<double>(src[i]);
+                }
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = static_cast<double>(src[i * stride]);
+            }
+        }
+
+        // bfloat16 为单精度的高 16 位
+        static inline uint16_t toBFloat16(double value)
+        {
+            float f = static_cast<float>(value);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+                // NaN：截断后可能变为 Inf，保留符号并置静默位
+                return static_cast<uint16_t>((bits >> 16) | 0x0040u);
+            }
+            bits += 0x7FFFu + ((bits >> 16) & 1u);
+            return static_cast<uint16_t>(bits >> 16);
+        }
+
+        static inline double fromBFloat16(uint16_t value)
+        {
+            uint32_t bits = static_cast<uint32_t>(value) << 16;
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return static_cast<double>(f);
+        }
+
+        void narrowToBFloat16(const double* src, size_t count, uint16_t* dst, size_t stride)
+        {
+            if (stride == 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = toBFloat16(src[i]);
+                }
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[i * stride] = toBFloat16(src[i]);
+            }
+        }
+
+        void widenFromBFloat16(const uint16_t* src, size_t count, double* dst, size_t stride)
+        {
+            if (stride == 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    dst[i] = fromBFloat16(src[i]);
+                }
+                return;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = fromBFloat16(src[i * stride]);
+            }
+        }
+
+        // 压缩数据头：模式、值个数、误差上限、分块大小，其后是各块的字节数和各块数据
+        static const uint8_t COMPRESS_RAW = 0;
+        static const uint8_t COMPRESS_QUANTIZED = 1;
+        static const size_t COMPRESS_HEADER_BYTES = 1 + 8 + 8 + 4;
+
+        // 超过该值的量化残差不再编码为整数，原样保存
+        static const double MAX_QUANTIZED = 1125899906842624.0; // 2^50
+
+        static inline void writeVarint(std::vector<uint8_t>& out, uint64_t v)
+        {
+            while (v >= 0x80) {
+                out.push_back(static_cast<uint8_t>(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(v));
+        }
+
+        static inline bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+        {
+            v = 0;
+            for (int shift = 0; shift < 64 && p < end; shift += 7) {
+                uint8_t b = *p++;
+                v |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        template <typename T>
+        static inline void appendValue(std::vector<uint8_t>& out, T v)
+        {
+            size_t pos = out.size();
+            out.resize(pos + sizeof(T));
+            std::memcpy(out.data() + pos, &v, sizeof(T));
+        }
+
+        template <typename T>
+        static inline T loadValue(const uint8_t* p)
+        {
+            T v;
+            std::memcpy(&v, p, sizeof(T));
+            return v;
+        }
+
+        // 压缩和解压共用的工作线程，第一次需要时创建，之后各次调用复用。
+        // 线程数不超过 CPU 核数；对象有意不析构，进程退出时线程随之结束，卸载动态库时不在加载器锁内等待线程
+        class BlockWorkerPool
+        {
+        public:
+            static BlockWorkerPool& instance()
+            {
+                static BlockWorkerPool* pool = new BlockWorkerPool();
+                return *pool;
+            }
+
+            // 在调用线程和最多 extra 个工作线程上同时执行 task，全部返回后返回
+            void run(size_t extra, const std::function<void()>& task)
+            {
+                std::mutex doneMutex;
+                std::condition_variable done;
+                size_t remaining = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    size_t limit = std::thread::hardware_concurrency();
+                    limit = limit > 1 ? limit - 1 : 0;
+                    try {
+                        while (threads_.size() < extra && threads_.size() < limit) {
+                            threads_.emplace_back([this]() { work(); });
+                        }
+                    }
+                    catch (const std::system_error&) {
+                        // 无法创建更多线程时使用已有的线程
+                    }
+                    remaining = extra < threads_.size() ? extra : threads_.size();
+                    for (size_t i = 0; i < remaining; ++i) {
+                        tasks_.push_back([&]() {
+                            task();
+                            // 持锁通知，调用线程返回后 done 即被销毁
+                            std::lock_guard<std::mutex> doneLock(doneMutex);
+                            --remaining;
+                            done.notify_one();
+                        });
+                    }
+                }
+                ready_.notify_all();
+                task();
+                std::unique_lock<std::mutex> lock(doneMutex);
+                done.wait(lock, [&]() { return remaining == 0; });
+            }
+
+        private:
+            BlockWorkerPool() = default;
+
+            void work()
+            {
+                for (;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        ready_.wait(lock, [this]() { return !tasks_.empty(); });
+                        task = std::move(tasks_.front());
+                        tasks_.pop_front();
+                    }
+                    task();
+                }
+            }
+
+            std::mutex mutex_;
+            std::condition_variable ready_;
+            std::deque<std::function<void()>> tasks_;
+            std::vector<std::thread> threads_;
+        };
+
+        // 由 threads 个线程分摊执行 work(block)，block 取 [0, blockCount)；任一块失败时返回 false。
+        // 调用线程参与执行，其余使用 BlockWorkerPool 中的线程
+        template <typename Work>
+        static bool parallelBlocks(size_t blockCount, unsigned threads, Work work)
+        {
+            if (threads == 0) {
+                threads = std::thread::hardware_concurrency();
+            }
+            size_t workers = threads < blockCount ? threads : blockCount;
+            std::atomic<size_t> next(0);
+            std::atomic<bool> ok(true);
+            auto run = [&]() {
+                try {
+                    for (size_t b = next++; b < blockCount && ok; b = next++) {
+                        if (!work(b)) {
+                            ok = false;
+                        }
+                    }
+                }
+                catch (...) {
+                    ok = false;
+                }
+            };
+            if (workers <= 1) {
+                run();
+                return ok;
+            }
+            BlockWorkerPool::instance().run(workers - 1, run);
+            return ok;
+        }
+
+        // 编码一块：编码 0 表示其后 8 字节为原值，否则为 zigzag(量化残差) + 1
+        static void encodeBlock(const double* src, size_t count, double errorBound, std::vector<uint8_t>& out)
+        {
+            const double step = 2.0 * errorBound;
+            double prev = 0.0;
+            out.clear();
+            out.reserve(count + count / 4);
+            for (size_t i = 0; i < count; ++i) {
+                double x = src[i];
+                double d = (x - prev) / step;
+                if (std::isfinite(d) && std::fabs(d) < MAX_QUANTIZED) {
+                    int64_t q = std::llround(d);
+                    double r = prev + step * static_cast<double>(q);
+                    if (std::fabs(x - r) <= errorBound) {
+                        uint64_t zz = (static_cast<uint64_t>(q) << 1) ^ static_cast<uint64_t>(q >> 63);
+                        writeVarint(out, zz + 1);
+                        prev = r;
+                        continue;
+                    }
+                }
+                out.push_back(0);
+                appendValue(out, x);
+                if (std::isfinite(x)) {
+                    prev = x;
+                }
+            }
+        }
+
+        static bool decodeBlock(const uint8_t* p, const uint8_t* end, size_t count, double errorBound, double* dst)
+        {
+            const double step = 2.0 * errorBound;
+            double prev = 0.0;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t code;
+                if (!readVarint(p, end, code)) {
+                    return false;
+                }
+                if (code == 0) {
+                    if (end - p < static_cast<ptrdiff_t>(sizeof(double))) {
+                        return false;
+                    }
+                    double x = loadValue<double>(p);
+                    p += sizeof(double);
+                    dst[i] = x;
+                    if (std::isfinite(x)) {
+                        prev = x;
+                    }
+                    continue;
+                }
+                uint64_t zz = code - 1;
+                int64_t q = static_cast<int64_t>(zz >> 1) ^ -static_cast<int64_t>(zz & 1);
+                prev = prev + step * static_cast<double>(q);
+                dst[i] = prev;
+            }
+            return p == end;
+        }
+
+        void compressValues(const double* src, size_t count, double errorBound, std::vector<uint8_t>& out, unsigned threads)
+        {
+            uint8_t mode = (errorBound > 0.0 && std::isfinite(errorBound)) ? COMPRESS_QUANTIZED : COMPRESS_RAW;
+            size_t blockCount = (count + COMPRESS_BLOCK_VALUES - 1) / COMPRESS_BLOCK_VALUES;
+
+            out.clear();
+            out.push_back(mode);
+            appendValue<uint64_t>(out, count);
+            appendValue<double>(out, mode == COMPRESS_QUANTIZED ? errorBound : 0.0);
+            appendValue<uint32_t>(out, static_cast<uint32_t>(COMPRESS_BLOCK_VALUES));
+
+            if (mode == COMPRESS_RAW) {
+                appendValue<uint64_t>(out, 0);
+                size_t pos = out.size();
+                out.resize(pos + count * sizeof(double));
+                if (count > 0) {
+                    std::memcpy(out.data() + pos, src, count * sizeof(double));
+                }
+                return;
+            }
+
+            std::vector<std::vector<uint8_t>> blocks(blockCount);
+            bool ok = parallelBlocks(blockCount, threads, [&](size_t b) {
+                size_t first = b * COMPRESS_BLOCK_VALUES;
+                size_t n = count - first < COMPRESS_BLOCK_VALUES ? count - first : COMPRESS_BLOCK_VALUES;
+                encodeBlock(src + first, n, errorBound, blocks[b]);
+                return true;
+            });
+            if (!ok) {
+                throw std::bad_alloc();
+            }
+
+            size_t total = out.size() + 8 + blockCount * sizeof(uint64_t);
+            for (const auto& block : blocks) {
+                total += block.size();
+            }
+            out.reserve(total);
+            appendValue<uint64_t>(out, blockCount);
+            for (const auto& block : blocks) {
+                appendValue<uint64_t>(out, block.size());
+            }
+            for (const auto& block : blocks) {
+                out.insert(out.end(), block.begin(), block.end());
+            }
+        }
+
+        bool decompressValues(const uint8_t* in, size_t bytes, std::vector<double>& out, unsigned threads)
+        {
+            if (bytes < COMPRESS_HEADER_BYTES + 8) {
+                return false;
+            }
+            const uint8_t* end = in + bytes;
+            uint8_t mode = in[0];
+            uint64_t count = loadValue<uint64_t>(in + 1);
+            double errorBound = loadValue<double>(in + 9);
+            uint32_t blockValues = loadValue<uint32_t>(in + 17);
+            uint64_t blockCount = loadValue<uint64_t>(in + COMPRESS_HEADER_BYTES);
+            const uint8_t* p = in + COMPRESS_HEADER_BYTES + 8;
+
+            // 先用剩余字节数检查 count，避免乘法溢出或按损坏的 count 分配内存
+            uint64_t remaining = static_cast<uint64_t>(end - p);
+            if (mode == COMPRESS_RAW) {
+                if (remaining % sizeof(double) != 0 || count != remaining / sizeof(double)) {
+                    return false;
+                }
+                out.resize(count);
+                if (count > 0) {
+                    std::memcpy(out.data(), p, count * sizeof(double));
+                }
+                return true;
+            }
+            // 每个值至少编码为 1 字节
+            if (mode != COMPRESS_QUANTIZED || blockValues == 0 || !(errorBound > 0.0)
+                || count > remaining
+                || blockCount != (count + blockValues - 1) / blockValues
+                || remaining / sizeof(uint64_t) < blockCount
+                || count > remaining - blockCount * sizeof(uint64_t)) {
+                return false;
+            }
+
+            // 各块的起始位置
+            std::vector<const uint8_t*> starts(blockCount + 1);
+            const uint8_t* data = p + blockCount * sizeof(uint64_t);
+            starts[0] = data;
+            for (uint64_t b = 0; b < blockCount; ++b) {
+                uint64_t blockBytes = loadValue<uint64_t>(p + b * sizeof(uint64_t));
+                if (blockBytes > static_cast<uint64_t>(end - starts[b])) {
+                    return false;
+                }
+                starts[b + 1] = starts[b] + blockBytes;
+            }
+            if (starts[blockCount] != end) {
+                return false;
+            }
+
+            out.resize(count);
+            return parallelBlocks(blockCount, threads, [&](size_t b) {
+                size_t first = b * blockValues;
+                size_t n = count - first < blockValues ? count - first : blockValues;
+                return decodeBlock(starts[b], starts[b + 1], n, errorBound, out.data() + first);
+            });
+        }
+
+        size_t findNonZeroRows(const double* const* components, size_t componentCount, size_t rowCount,
+            double tolerance, std::vector<size_t>* rows)
+        {
+            if (rows) {
+                rows->clear();
+            }
+            // 按分量逐块标记非零行，每个分量在块内顺序访问
+            unsigned char mask[BLOCK_ROWS];
+            size_t found = 0;
+            for (size_t first = 0; first < rowCount; first += BLOCK_ROWS) {
+                size_t n = rowCount - first < BLOCK_ROWS ? rowCount - first : BLOCK_ROWS;
+                std::memset(mask, 0, n);
+                for (size_t c = 0; c < componentCount; ++c) {
+                    const double* src = components[c] + first;
+                    for (size_t i = 0; i < n; ++i) {
+                        mask[i] |= static_cast<unsigned char>(!(std::fabs(src[i]) <= tolerance));
+                    }
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    if (mask[i]) {
+                        if (rows) {
+                            rows->push_back(first + i);
+                        }
+                        ++found;
+                    }
+                }
+            }
+            return found;
+        }
+
+        void gatherRows(const double* src, const size_t* rows, size_t count, double* dst)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = src[rows[i]];
+            }
+        }
+
+        void scatterRows(const double* src, const size_t* rows, size_t count, double* dst)
+        {
+            for (size_t i = 0; i < count; ++i) {
+                dst[rows[i]] = src[i];
+            }
+        }
+
+        size_t averageRows(const double* src, const size_t* offsets, const size_t* rows, size_t groupCount, double* dst,
+            bool missingAsZero)
+        {
+            const size_t missing = static_cast<size_t>(-1);
+            size_t emptyGroups = 0;
+            for (size_t k = 0; k < groupCount; ++k) {
+                size_t first = offsets[k];
+                size_t last = offsets[k + 1];
+                if (last - first == 1 && rows[first] != missing) {
+                    dst[k] = src[rows[first]];
+                    continue;
+                }
+                double sum = 0.0;
+                size_t present = 0;
+                for (size_t i = first; i < last; ++i) {
+                    if (rows[i] != missing) {
+                        sum += src[rows[i]];
+                        ++present;
+                    }
+                }
+                if (present == 0) {
+                    ++emptyGroups;
+                }
+                size_t divisor = missingAsZero ? last - first : present;
+                dst[k] = present > 0 ? sum / static_cast<double>(divisor) : 0.0;
+            }
+            return emptyGroups;
+        }
+
+        void encodeIndex(const int* index, size_t count, std::vector<uint8_t>& out)
+        {
+            out.clear();
+            out.reserve(8 + count + count / 8);
+            appendValue<uint64_t>(out, count);
+            int64_t prev = 0;
+            for (size_t i = 0; i < count; ++i) {
+                int64_t d = static_cast<int64_t>(index[i]) - prev;
+                writeVarint(out, (static_cast<uint64_t>(d) << 1) ^ static_cast<uint64_t>(d >> 63));
+                prev = index[i];
+            }
+        }
+
+        bool decodeIndex(const uint8_t* in, size_t bytes, std::vector<int>& out)
+        {
+            if (bytes < sizeof(uint64_t)) {
+                return false;
+            }
+            const uint8_t* p = in + sizeof(uint64_t);
+            const uint8_t* end = in + bytes;
+            uint64_t count = loadValue<uint64_t>(in);
+            if (count > bytes) {
+                return false; // 每个编号至少 1 字节
+            }
+            out.resize(count);
+            int64_t prev = 0;
+            for (uint64_t i = 0; i < count; ++i) {
+                uint64_t zz;
+                if (!readVarint(p, end, zz)) {
+                    return false;
+                }
+                prev += static_cast<int64_t>(zz >> 1) ^ -static_cast<int64_t>(zz & 1);
+                out[i] = static_cast<int>(prev);
+            }
+            return p == end;
+        }
+    }
+}
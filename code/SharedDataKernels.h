@@ -0,0 +1,104 @@
+#ifndef SHAREDDATAKERNELS_H
+#define SHAREDDATAKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "SolverHubDef.h"
+
+namespace EMP {
+
+    // 多分量数据在平面排列(按分量连续)与交错排列(按行交错，如 ux,uy,uz)之间转换的内核。
+    // 常见的 2/3/4 分量使用展开的循环，其余分量数按行分块转置，保证读写都在缓存内完成。
+    namespace DataKernels {
+
+        // 一组数值的统计量，NaN 和 Inf 只计入 nonFinite，不参与其他统计
+        struct ValueStats
+        {
+            double min;             // 有限值的最小值，没有有限值时为 +Inf
+            double max;             // 有限值的最大值，没有有限值时为 -Inf
+            double sum;             // 有限值之和
+            double sumSquares;      // 有限值的平方和
+            uint64_t count;         // 有限值的个数
+            uint64_t nonFinite;     // NaN 和 Inf 的个数
+
+            ValueStats() { reset(); }
+
+            void reset()
+            {
+                min = std::numeric_limits<double>::infinity();
+                max = -std::numeric_limits<double>::infinity();
+                sum = 0.0;
+                sumSquares = 0.0;
+                count = 0;
+                nonFinite = 0;
+            }
+
+            double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+            double l2Norm() const { return std::sqrt(sumSquares); }
+        };
+
+        // 将 componentCount 个分量指针指向的数据交错写入 out (大小 rowCount * componentCount)
+        SOLVERHUB_API void interleave(const double* const* components, size_t componentCount, size_t rowCount, double* out);
+
+        // 将交错排列的 in 拆分写入 componentCount 个分量指针
+        SOLVERHUB_API void deinterleave(const double* in, size_t componentCount, size_t rowCount, double* const* components);
+
+        // 平面排列 -> 交错排列
+        SOLVERHUB_API void planarToInterleaved(const double* planar, size_t componentCount, size_t rowCount, double* interleaved);
+
+        // 交错排列 -> 平面排列
+        SOLVERHUB_API void interleavedToPlanar(const double* interleaved, size_t componentCount, size_t rowCount, double* planar);
+
+        // 内容哈希(xxHash64 算法)：每次处理 32 字节，4 路累加互不依赖，可以流水并行，速度接近内存带宽。
+        // 以上一段的哈希作为 seed 可以把多段数据串联成一个哈希
+        SOLVERHUB_API uint64_t hashBytes(const void* data, size_t bytes, uint64_t seed = 0);
+
+        // 复制 count 个值到 dst，同一遍循环中把统计量累加到 stats
+        SOLVERHUB_API void copyWithStats(const double* src, size_t count, double* dst, ValueStats& stats);
+
+        // 只把 count 个值的统计量累加到 stats
+        SOLVERHUB_API void accumulateStats(const double* src, size_t count, ValueStats& stats);
+
+        // 双精度与单精度、bfloat16 之间的转换，stride 为降低精度一侧相邻元素的步长(以元素计)。
+        // 步长为 1 时是简单的逐元素循环，编译器可以向量化；bfloat16 按最近偶数舍入，NaN 保持为 NaN
+        SOLVERHUB_API void narrowToFloat(const double* src, size_t count, float* dst, size_t stride = 1);
+        SOLVERHUB_API void widenFromFloat(const float* src, size_t count, double* dst, size_t stride = 1);
+        SOLVERHUB_API void narrowToBFloat16(const double* src, size_t count, uint16_t* dst, size_t stride = 1);
+        SOLVERHUB_API void widenFromBFloat16(const uint16_t* src, size_t count, double* dst, size_t stride = 1);
+
+        // 有界误差的有损压缩：每个值以前一个重建值为预测，预测残差按 2 * errorBound 量化后以变长整数编码，
+        // 重建值与原值之差不超过 errorBound；超出量化范围的值和 NaN/Inf 原样保存。errorBound 不大于 0 时无损保存。
+        // 数据按 COMPRESS_BLOCK_VALUES 个值分块，各块独立编码，由 threads 个线程并行压缩和解压(0 表示按 CPU 核数)，
+        // 除调用线程外使用进程内复用的工作线程，工作线程总数不超过 CPU 核数。
+        // 输出自带长度和误差上限，解压时不需要额外信息
+        static const size_t COMPRESS_BLOCK_VALUES = 1 << 16;
+        SOLVERHUB_API void compressValues(const double* src, size_t count, double errorBound, std::vector<uint8_t>& out, unsigned threads = 0);
+
+        // 解压 compressValues 的输出，数据不完整或格式错误时返回 false
+        SOLVERHUB_API bool decompressValues(const uint8_t* in, size_t bytes, std::vector<double>& out, unsigned threads = 0);
+
+        // 稀疏表示：找出 componentCount 个分量中至少一个分量的绝对值大于 tolerance 的行(NaN/Inf 视为非零)，
+        // 行号按升序写入 rows(为 nullptr 时只计数)，返回行数
+        SOLVERHUB_API size_t findNonZeroRows(const double* const* components, size_t componentCount, size_t rowCount,
+            double tolerance, std::vector<size_t>* rows);
+
+        // 收集 dst[i] = src[rows[i]]，展开 dst[rows[i]] = src[i]；展开时 dst 的其余位置不改动，由调用方预先置零
+        SOLVERHUB_API void gatherRows(const double* src, const size_t* rows, size_t count, double* dst);
+        SOLVERHUB_API void scatterRows(const double* src, const size_t* rows, size_t count, double* dst);
+
+        // 分组平均：dst[k] 为 src 中行号为 rows[offsets[k]] 到 rows[offsets[k + 1] - 1] 的各行的平均值。行号为 SIZE_MAX 的成员
+        // 在 missingAsZero 为真时按 0 计入(如稀疏数据中未保存的全零行)，否则不计入组的大小；没有任何成员存在的组为 0，
+        // 返回这样的组数。每组只有一个成员时即为抽样
+        SOLVERHUB_API size_t averageRows(const double* src, const size_t* offsets, const size_t* rows, size_t groupCount, double* dst,
+            bool missingAsZero = false);
+
+        // 索引列的无损编码：相邻编号之差 zigzag 后以变长整数保存，连续编号每个只占 1 字节
+        SOLVERHUB_API void encodeIndex(const int* index, size_t count, std::vector<uint8_t>& out);
+        SOLVERHUB_API bool decodeIndex(const uint8_t* in, size_t bytes, std::vector<int>& out);
+    }
+}
+
+#endif // SHAREDDATAKERNELS_H
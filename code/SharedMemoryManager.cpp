@@ -1,19 +1,67 @@
 ﻿#include "SharedMemoryManager.h"
+#include "SharedMemoryPlanner.h"
 #include <iostream> // For std::cerr
 #include <fstream>  // For file operations
 #include <iomanip>  // For std::hex, std::setw, etc.
 #include <cstdint>  // For uint32_t, uint64_t
+#include <cstring>  // For std::strncpy
 #include <algorithm> // For std::max
-#include <boost/interprocess/shared_memory_object.hpp>
 #include <boost/interprocess/exceptions.hpp>
+#include <boost/version.hpp> // For BOOST_VERSION
 #include <filesystem> // For directory operations
+#include <thread>     // For std::this_thread::yield
+#ifdef _WIN32
+#include <Windows.h>  // For OpenProcess
+#else
+#include <cerrno>
+#include <signal.h>   // For kill
+#include <unistd.h>   // For getpid
+#endif
 
 namespace bip = boost::interprocess;
 namespace fs = std::filesystem;
 
 using namespace EMP;
 
-SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isCreator, const std::string& prefix, size_t control_memory_size, const std::string& logFilePath)
+// 本进程的进程号
+static int64_t currentProcessId() {
+#ifdef _WIN32
+	return static_cast<int64_t>(GetCurrentProcessId());
+#else
+	return static_cast<int64_t>(getpid());
+#endif
+}
+
+// 进程号为 pid 的进程是否仍在运行，无法确定时按仍在运行处理
+static bool processAlive(int64_t pid) {
+	if (pid <= 0) {
+		return true;
+	}
+#ifdef _WIN32
+	HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+	if (!process) {
+		return GetLastError() == ERROR_ACCESS_DENIED;
+	}
+	DWORD exitCode = 0;
+	bool alive = GetExitCodeProcess(process, &exitCode) && exitCode == STILL_ACTIVE;
+	CloseHandle(process);
+	return alive;
+#else
+	return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+// 各分量的行数，调用方已确认分量长度一致
+static uint64_t componentRows(const LocalData& local) {
+	return local.data.empty() ? 0 : local.data[0].size();
+}
+
+// 本线程在各管理器的各内存段内嵌套进行的读写层数。已在段内时再次进入不等待扩容，
+// 否则会与等待本线程离开的扩容方互相等待
+static thread_local std::map<std::pair<const void*, int>, int> threadSegmentDepth;
+
+SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isCreator, const std::string& prefix, size_t control_memory_size, const std::string& logFilePath,
+	const std::vector<SegmentPageSize>& segmentPageSizes)
 	: memoryName_(prefix.empty() ? memoryName : prefix + "_" + memoryName),
 	isCreator_(isCreator),
 	prefix_(prefix)
@@ -27,6 +75,10 @@ SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isC
 		}
 	}
 
+	for (size_t i = 0; i < segmentPageSizes.size() && i < SegmentCount; ++i) {
+		segmentPageSizes_[i] = static_cast<size_t>(segmentPageSizes[i]);
+	}
+
 	try {
 		// 创建或打开共享互斥锁，用于同步访问
 		std::string mutexName = prefix_.empty() ? memoryName_ + "_mutex" : prefix_ + "_" + memoryName_ + "_mutex";
@@ -36,10 +88,10 @@ SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isC
 		if (isCreator_) {
 			// 只创建控制数据内存段
 			std::string ctrlSegmentName = GenerateSegmentName(SharedMemorySuffix::CONTROL_SEGMENT);
-			bip::shared_memory_object::remove(ctrlSegmentName.c_str());
+			SharedSegment::remove(ctrlSegmentName.c_str());
 
 			// 创建控制数据内存段
-			controlSegment_ = std::make_shared<bip::managed_shared_memory>(
+			controlSegment_ = std::make_shared<SharedSegment>(
 				bip::create_only, ctrlSegmentName.c_str(), control_memory_size);
 
 			// 创建控制数据对象
@@ -57,7 +109,7 @@ SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isC
 			// 如果不是创建者，则连接到已存在的共享内存控制段
 			std::string ctrlSegmentName = GenerateSegmentName(SharedMemorySuffix::CONTROL_SEGMENT);
 			try {
-				controlSegment_ = std::make_shared<bip::managed_shared_memory>(
+				controlSegment_ = std::make_shared<SharedSegment>(
 					bip::open_only, ctrlSegmentName.c_str());
 
 				// 查找控制数据对象
@@ -82,6 +134,9 @@ SharedMemoryManager::SharedMemoryManager(const std::string& memoryName, bool isC
 		log(LogLevel::Error, "初始化共享内存管理器失败: " + std::string(e.what()));
 		throw;
 	}
+
+	// 登记为内存段的访问方，扩容方据此等待本管理器离开
+	claimSegmentUser();
 }
 
 // 生成共享内存段名称
@@ -92,11 +147,23 @@ std::string SharedMemoryManager::GenerateSegmentName(const std::string& suffix)
 // 析构函数
 SharedMemoryManager::~SharedMemoryManager() {
 	try {
+		stopCoarseRefresh();
+
+		// 注销本管理器登记的读取方，写入方不再等待它
+		unregisterReader();
+
+		// 持久化的内存段保留文件，先记下再释放控制数据
+		bool persistent[SegmentCount] = {};
+		for (int i = 0; i < SegmentCount; ++i) {
+			persistent[i] = isPersistentSegment(static_cast<SegmentId>(i));
+		}
+
 		// 释放资源
 		geos_.clear();
 		meshs_.clear();
 		datas_.clear();
 		defs_.clear();
+		releaseSegmentUser();
 		controlData_ = nullptr;
 
 		// 关闭所有内存段
@@ -105,24 +172,38 @@ SharedMemoryManager::~SharedMemoryManager() {
 		meshSegment_.reset();
 		dataSegment_.reset();
 		definitionSegment_.reset();
+		for (auto& retired : retiredSegments_) {
+			for (auto& entry : retired) {
+				if (entry.reservedBase) {
+					SharedSegment::unreserveAddressRange(entry.reservedBase, entry.reservedSize);
+				}
+			}
+			retired.clear();
+		}
 
 		// 如果是创建者，则删除共享内存段
 		if (isCreator_) {
 			std::string ctrlSegmentName = GenerateSegmentName(SharedMemorySuffix::CONTROL_SEGMENT);
-			bip::shared_memory_object::remove(ctrlSegmentName.c_str());
+			SharedSegment::remove(ctrlSegmentName.c_str());
 
 			// 尝试删除其他内存段（如果存在）
 			std::string geoSegmentName = GenerateSegmentName(SharedMemorySuffix::GEOMETRY_SEGMENT);
-			bip::shared_memory_object::remove(geoSegmentName.c_str());
+			if (!persistent[GeometrySegment]) {
+				SharedSegment::remove(geoSegmentName.c_str());
+			}
 
 			std::string meshSegmentName = GenerateSegmentName(SharedMemorySuffix::MESH_SEGMENT);
-			bip::shared_memory_object::remove(meshSegmentName.c_str());
+			if (!persistent[MeshSegment]) {
+				SharedSegment::remove(meshSegmentName.c_str());
+			}
 
 			std::string dataSegmentName = GenerateSegmentName(SharedMemorySuffix::DATA_SEGMENT);
-			bip::shared_memory_object::remove(dataSegmentName.c_str());
+			SharedSegment::remove(dataSegmentName.c_str());
 
 			std::string defSegmentName = GenerateSegmentName(SharedMemorySuffix::DEFINITION_SEGMENT);
-			bip::shared_memory_object::remove(defSegmentName.c_str());
+			if (!persistent[DefinitionSegment]) {
+				SharedSegment::remove(defSegmentName.c_str());
+			}
 
 			// 删除互斥锁
 			std::string mutexName = prefix_.empty() ? memoryName_ + "_mutex" : prefix_ + "_" + memoryName_ + "_mutex";
@@ -171,23 +252,33 @@ void SharedMemoryManager::createGeometrySegmentAndObjects() {
 			return;
 		}
 
-		// 计算总大小，增加10%作为额外空间
-		for (auto size : localCtrl.modelMemorySizes) {
-			totalSize += size;
+		// 控制数据中登记的大小(每个对象至少能容纳空对象本身)
+		for (size_t i = 0; i < localCtrl.modelNames.size(); ++i) {
+			size_t emptySize = SharedMemoryPlanner::namedObjectBytes(GeometrySegment, localCtrl.modelNames[i] + SharedMemorySuffix::GEOMETRY);
+			totalSize += (std::max)(static_cast<size_t>((std::max)(localCtrl.modelMemorySizes[i], 0)), emptySize);
 		}
-		totalSize = static_cast<size_t>(totalSize * 1.1);
 
-		// 如果总大小太小，使用默认大小
-		if (totalSize < 1024 * 1024) {
-			totalSize = 1024 * 1024;
+		if (plannedSegmentSizes_[GeometrySegment] > 0) {
+			// 已按规划精确计算，不再额外预留；规划后登记了更大的对象时按登记的大小
+			totalSize = (std::max)(plannedSegmentSizes_[GeometrySegment], SharedMemoryPlanner::segmentSize(totalSize, 0));
+			plannedSegmentSizes_[GeometrySegment] = totalSize;
+		}
+		else {
+			// 增加10%作为额外空间
+			totalSize = static_cast<size_t>(totalSize * 1.1);
+
+			// 如果总大小太小，使用默认大小
+			if (totalSize < 1024 * 1024) {
+				totalSize = 1024 * 1024;
+			}
 		}
 
 		// 创建几何数据内存段
 		std::string geoSegmentName = GenerateSegmentName(SharedMemorySuffix::GEOMETRY_SEGMENT);
-		bip::shared_memory_object::remove(geoSegmentName.c_str()); // 先移除现有的（如果存在）
+		removeSegment(GeometrySegment, geoSegmentName); // 先移除现有的（如果存在）
 
-		geometrySegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, geoSegmentName.c_str(), totalSize);
+		geometrySegment_ = createSegment(GeometrySegment, geoSegmentName, totalSize);
+		handleCache_[GeometrySegment].clear();
 
 		// 清空当前几何对象列表
 		geos_.clear();
@@ -230,23 +321,33 @@ void SharedMemoryManager::createMeshSegmentAndObjects() {
 			return;
 		}
 
-		// 计算总大小，增加10%作为额外空间
-		for (auto size : localCtrl.meshMemorySizes) {
-			totalSize += size;
+		// 控制数据中登记的大小(每个对象至少能容纳空对象本身)
+		for (size_t i = 0; i < localCtrl.meshNames.size(); ++i) {
+			size_t emptySize = SharedMemoryPlanner::namedObjectBytes(MeshSegment, localCtrl.meshNames[i] + SharedMemorySuffix::MESH);
+			totalSize += (std::max)(static_cast<size_t>((std::max)(localCtrl.meshMemorySizes[i], 0)), emptySize);
 		}
-		totalSize = static_cast<size_t>(totalSize * 1.1);
 
-		// 如果总大小太小，使用默认大小
-		if (totalSize < 1024 * 1024) {
-			totalSize = 1024 * 1024;
+		if (plannedSegmentSizes_[MeshSegment] > 0) {
+			// 已按规划精确计算，不再额外预留；规划后登记了更大的对象时按登记的大小
+			totalSize = (std::max)(plannedSegmentSizes_[MeshSegment], SharedMemoryPlanner::segmentSize(totalSize, 0));
+			plannedSegmentSizes_[MeshSegment] = totalSize;
+		}
+		else {
+			// 增加10%作为额外空间
+			totalSize = static_cast<size_t>(totalSize * 1.1);
+
+			// 如果总大小太小，使用默认大小
+			if (totalSize < 1024 * 1024) {
+				totalSize = 1024 * 1024;
+			}
 		}
 
 		// 创建网格数据内存段
 		std::string meshSegmentName = GenerateSegmentName(SharedMemorySuffix::MESH_SEGMENT);
-		bip::shared_memory_object::remove(meshSegmentName.c_str()); // 先移除现有的（如果存在）
+		removeSegment(MeshSegment, meshSegmentName); // 先移除现有的（如果存在）
 
-		meshSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, meshSegmentName.c_str(), totalSize);
+		meshSegment_ = createSegment(MeshSegment, meshSegmentName, totalSize);
+		handleCache_[MeshSegment].clear();
 
 		// 清空当前网格对象列表
 		meshs_.clear();
@@ -289,23 +390,33 @@ void SharedMemoryManager::createDataSegmentAndObjects() {
 			return;
 		}
 
-		// 计算总大小，增加10%作为额外空间
-		for (auto size : localCtrl.dataMemorySizes) {
-			totalSize += size;
+		// 控制数据中登记的大小(每个对象至少能容纳空对象本身)
+		for (size_t i = 0; i < localCtrl.dataNames.size(); ++i) {
+			size_t emptySize = SharedMemoryPlanner::namedObjectBytes(DataSegment, localCtrl.dataNames[i] + SharedMemorySuffix::DATA);
+			totalSize += (std::max)(static_cast<size_t>((std::max)(localCtrl.dataMemorySizes[i], 0)), emptySize);
 		}
-		totalSize = static_cast<size_t>(totalSize * 1.1);
 
-		// 如果总大小太小，使用默认大小
-		if (totalSize < 1024 * 1024) {
-			totalSize = 1024 * 1024;
+		if (plannedSegmentSizes_[DataSegment] > 0) {
+			// 已按规划精确计算，不再额外预留；规划后登记了更大的对象时按登记的大小
+			totalSize = (std::max)(plannedSegmentSizes_[DataSegment], SharedMemoryPlanner::segmentSize(totalSize, 0));
+			plannedSegmentSizes_[DataSegment] = totalSize;
+		}
+		else {
+			// 增加10%作为额外空间
+			totalSize = static_cast<size_t>(totalSize * 1.1);
+
+			// 如果总大小太小，使用默认大小
+			if (totalSize < 1024 * 1024) {
+				totalSize = 1024 * 1024;
+			}
 		}
 
 		// 创建计算数据内存段
 		std::string dataSegmentName = GenerateSegmentName(SharedMemorySuffix::DATA_SEGMENT);
-		bip::shared_memory_object::remove(dataSegmentName.c_str()); // 先移除现有的（如果存在）
+		removeSegment(DataSegment, dataSegmentName); // 先移除现有的（如果存在）
 
-		dataSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, dataSegmentName.c_str(), totalSize);
+		dataSegment_ = createSegment(DataSegment, dataSegmentName, totalSize);
+		handleCache_[DataSegment].clear();
 
 		// 清空当前计算数据对象列表
 		datas_.clear();
@@ -331,92 +442,128 @@ void SharedMemoryManager::createDataSegmentAndObjects() {
 
 // 内存大小估算函数
 
-// 估算几何对象所需的共享内存大小
+// 几何对象所需的共享内存大小：具名对象本身加上各字符串和向量的分配
 size_t SharedMemoryManager::estimateGeometryMemorySize(const LocalGeometry& localGeo) {
-	// 基础大小
-	size_t baseSize = sizeof(SharedGeometry);
+	return SharedMemoryPlanner::planGeometry(localGeo).totalBytes();
+}
 
-	// 向量开销
-	size_t vectorOverhead = 2 * sizeof(SharedMemoryVectorString); // 两个向量对象的开销
+// 网格对象所需的共享内存大小
+size_t SharedMemoryManager::estimateMeshMemorySize(const LocalMesh& localMesh) {
+	return SharedMemoryPlanner::planMesh(localMesh).totalBytes();
+}
 
-	// 计算所有几何体的内存需求
-	size_t totalElementsSize = 0;
+// 计算数据对象所需的共享内存大小(单缓冲，不含历史帧)
+size_t SharedMemoryManager::estimateDataMemorySize(const LocalData& localData, bool sparse, double zeroTolerance) {
+	return SharedMemoryPlanner::planData(localData, 0, 0, 0, Float64Precision, sparse, zeroTolerance).totalBytes();
+}
 
-	// 处理 shapeNames 和 shapeBrps 向量中的数据
-	for (size_t i = 0; i < localGeo.shapeNames.size(); i++) {
-		size_t nameSize = localGeo.shapeNames[i].size() + 1; // +1 for null terminator
-		size_t shapeBrpSize = localGeo.shapeBrps[i].size() + 1;
-		size_t stringOverhead = 2 * sizeof(SharedMemoryString); // 两个字符串对象的开销
+size_t SharedMemoryManager::estimateDataMemorySize(const LocalData& localData, const SharedData& config) {
+	return SharedMemoryPlanner::planData(localData, config).totalBytes();
+}
 
-		totalElementsSize += nameSize + shapeBrpSize + stringOverhead;
+// 按规划结果登记各对象所需的内存大小，并以规划的大小创建或扩容内存段
+bool SharedMemoryManager::applyMemoryPlan(const SharedMemoryPlanner& planner) {
+	if (!isCreator_) {
+		log(LogLevel::Error, "非Creator无法应用内存规划");
+		return false;
 	}
 
-	// 总大小 = 基础大小 + 向量开销 + 元素大小
-	size_t totalSize = baseSize + vectorOverhead + totalElementsSize;
-
-	// 添加额外的50%作为安全边际，因为多个几何体可能会导致内存分配更加频繁
-	return static_cast<size_t>(totalSize * 1.5);
-}
-
-// 估算网格对象所需的共享内存大小
-size_t SharedMemoryManager::estimateMeshMemorySize(const LocalMesh& localMesh) {
-	// 基础大小
-	size_t baseSize = sizeof(SharedMesh);
+	if (!controlData_) {
+		log(LogLevel::Error, "控制数据对象未初始化");
+		return false;
+	}
 
-	// 名称大小
-	size_t nameSize = localMesh.name.size() + 1;
-	size_t modelNameSize = localMesh.modelName.size() + 1;
+	try {
+		// 登记各对象的大小，名称列表决定 create*SegmentAndObjects 构造哪些对象
+		LocalControlData localCtrl;
+		getControlData(localCtrl);
 
-	// 网格元素数据大小
-	size_t nodesSize = localMesh.nodes.size() * sizeof(Node);
-	size_t edgesSize = localMesh.edges.size() * sizeof(Edge);
-	size_t trianglesSize = localMesh.triangles.size() * sizeof(Triangle);
-	size_t tetrahedronsSize = localMesh.tetrahedrons.size() * sizeof(Tetrahedron);
+		for (const auto& object : planner.objects()) {
+			std::vector<std::string>* names = nullptr;
+			std::vector<int>* sizes = nullptr;
+			switch (object.segment) {
+			case GeometrySegment: names = &localCtrl.modelNames; sizes = &localCtrl.modelMemorySizes; break;
+			case MeshSegment: names = &localCtrl.meshNames; sizes = &localCtrl.meshMemorySizes; break;
+			case DataSegment: names = &localCtrl.dataNames; sizes = &localCtrl.dataMemorySizes; break;
+			default: names = &localCtrl.definitionNames; sizes = &localCtrl.definitionMemorySizes; break;
+			}
 
-	// 考虑共享内存管理开销
-	size_t totalSize = baseSize + nameSize + modelNameSize +
-					   nodesSize + edgesSize + trianglesSize + tetrahedronsSize;
+			int size = static_cast<int>((std::min)(object.totalBytes(), static_cast<size_t>(std::numeric_limits<int>::max())));
+			auto it = std::find(names->begin(), names->end(), object.name);
+			if (it == names->end()) {
+				names->push_back(object.name);
+				sizes->push_back(size);
+			}
+			else {
+				sizes->resize(names->size(), 0);
+				(*sizes)[it - names->begin()] = size;
+			}
+		}
 
-	// 添加额外的20%作为安全边际
-	return static_cast<size_t>(totalSize * 1.2);
-}
+		// 本地副本的版本号与共享对象相同，需要标记为已修改才会写回
+		localCtrl.version = std::numeric_limits<uint64_t>::max();
+		updateControlData(localCtrl);
 
-// 估算计算数据对象所需的共享内存大小
-size_t SharedMemoryManager::estimateDataMemorySize(const LocalData& localData) {
-	// 基础大小
-	size_t baseSize = sizeof(SharedData);
+		// 控制数据中已登记但不在规划中的对象也会被构造，按登记的大小计入
+		auto unplannedBytes = [&](const std::vector<std::string>& names, const std::vector<int>& sizes) {
+			size_t bytes = 0;
+			for (size_t i = 0; i < names.size() && i < sizes.size(); ++i) {
+				bool planned = false;
+				for (const auto& object : planner.objects()) {
+					planned = planned || object.name == names[i];
+				}
+				if (!planned && sizes[i] > 0) {
+					bytes += static_cast<size_t>(sizes[i]);
+				}
+			}
+			return bytes;
+		};
+
+		for (int id = 0; id < SegmentCount; ++id) {
+			SegmentId segmentId = static_cast<SegmentId>(id);
+			SegmentPlan plan = planner.segmentPlan(segmentId);
+			if (plan.size == 0) {
+				continue;
+			}
 
-	// 名称大小
-	size_t nameSize = localData.name.size() + 1;
-	size_t meshNameSize = localData.meshName.size() + 1;
+			size_t extraBytes = 0;
+			switch (segmentId) {
+			case GeometrySegment: extraBytes = unplannedBytes(localCtrl.modelNames, localCtrl.modelMemorySizes); break;
+			case MeshSegment: extraBytes = unplannedBytes(localCtrl.meshNames, localCtrl.meshMemorySizes); break;
+			case DataSegment: extraBytes = unplannedBytes(localCtrl.dataNames, localCtrl.dataMemorySizes); break;
+			default: break;
+			}
+			plannedSegmentSizes_[id] = SharedMemoryPlanner::segmentSize(plan.objectBytes + extraBytes, plan.headroomBytes);
+
+			std::shared_ptr<SharedSegment>& segment = segmentRef(segmentId);
+			if (!segment) {
+				switch (segmentId) {
+				case GeometrySegment: createGeometrySegmentAndObjects(); break;
+				case MeshSegment: createMeshSegmentAndObjects(); break;
+				case DataSegment: createDataSegmentAndObjects(); break;
+				default: createDefinitionSegmentAndObjects(); break;
+				}
+			}
+			else if (segment->get_size() < plannedSegmentSizes_[id]) {
+				switch (segmentId) {
+				case GeometrySegment: recreateGeometrySegment(plannedSegmentSizes_[id]); break;
+				case MeshSegment: recreateMeshSegment(plannedSegmentSizes_[id]); break;
+				case DataSegment: recreateDataSegment(plannedSegmentSizes_[id]); break;
+				default: recreateDefinitionSegment(plannedSegmentSizes_[id]); break;
+				}
+			}
 
-	// 数据值大小
-	size_t indexSize = localData.index.size() * sizeof(int);
+			log(LogLevel::Info, "按规划设置" + segmentName(segmentId) + "内存段: " +
+				std::to_string(plannedSegmentSizes_[id]) + " 字节");
+		}
 
-	// 计算分量标题和单位的大小
-	size_t titlesSize = 0;
-	size_t unitsSize = 0;
-	for (const auto& title : localData.titles) {
-		titlesSize += title.size() + 1; // +1 for null terminator
-	}
-	for (const auto& unit : localData.units) {
-		unitsSize += unit.size() + 1; // +1 for null terminator
+		log(LogLevel::Info, "应用内存规划成功: " + std::to_string(planner.objects().size()) + " 个对象\n" + planner.report());
+		return true;
 	}
-
-	// 计算多分量数据的大小
-	size_t dataSize = 0;
-	for (const auto& componentData : localData.data) {
-		dataSize += componentData.size() * sizeof(double);
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "应用内存规划失败: " + std::string(e.what()));
+		throw;
 	}
-
-	size_t dimtagsSize = localData.dimtags.size() * sizeof(SharedMemoryPair);
-
-	// 考虑共享内存管理开销
-	size_t totalSize = baseSize + nameSize + meshNameSize +
-					   indexSize + dataSize + dimtagsSize + titlesSize + unitsSize;
-
-	// 添加额外的50%作为安全边际，因为多分量数据可能需要更多内存
-	return static_cast<size_t>(totalSize * 1.5);
 }
 
 // 获取各个内存段的使用情况
@@ -479,8 +626,7 @@ void SharedMemoryManager::LoadExistingGeometryObjects() {
 		try {
 			// 尝试连接到几何数据内存段
 			std::string geoSegmentName = GenerateSegmentName(SharedMemorySuffix::GEOMETRY_SEGMENT);
-			geometrySegment_ = std::make_shared<bip::managed_shared_memory>(
-				bip::open_only, geoSegmentName.c_str());
+			geometrySegment_ = openSegment(GeometrySegment, geoSegmentName);
 			log(LogLevel::Info, "连接到几何数据内存段: " + geoSegmentName);
 		}
 		catch (const bip::interprocess_exception& ex) {
@@ -518,8 +664,7 @@ void SharedMemoryManager::LoadExistingMeshObjects() {
 		try {
 			// 尝试连接到网格数据内存段
 			std::string meshSegmentName = GenerateSegmentName(SharedMemorySuffix::MESH_SEGMENT);
-			meshSegment_ = std::make_shared<bip::managed_shared_memory>(
-				bip::open_only, meshSegmentName.c_str());
+			meshSegment_ = openSegment(MeshSegment, meshSegmentName);
 			log(LogLevel::Info, "连接到网格数据内存段: " + meshSegmentName);
 		}
 		catch (const bip::interprocess_exception& ex) {
@@ -557,8 +702,7 @@ void SharedMemoryManager::LoadExistingDataObjects() {
 		try {
 			// 尝试连接到计算数据内存段
 			std::string dataSegmentName = GenerateSegmentName(SharedMemorySuffix::DATA_SEGMENT);
-			dataSegment_ = std::make_shared<bip::managed_shared_memory>(
-				bip::open_only, dataSegmentName.c_str());
+			dataSegment_ = openSegment(DataSegment, dataSegmentName);
 			log(LogLevel::Info, "连接到计算数据内存段: " + dataSegmentName);
 		}
 		catch (const bip::interprocess_exception& ex) {
@@ -654,11 +798,14 @@ void SharedMemoryManager::getControlData(LocalControlData& localData) {
 	}
 
 	try {
-		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
+		// 先尝试无锁的乐观读取，多次与写入冲突后再加锁复制
+		if (!readOptimistic(controlData_, localData, controlSegment_)) {
+			bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
 
-		// 使用共享对象的copyToLocal方法
-		controlData_->copyToLocal(localData);
+			// 使用共享对象的copyToLocal方法
+			controlData_->copyToLocal(localData);
+		}
+		noteConsumed(controlData_, localData.version);
 
 		log(LogLevel::Debug, "获取控制数据成功");
 	}
@@ -675,6 +822,12 @@ std::string SharedMemoryManager::GenerateUniqueObjectName(const std::string& bas
 
 // 根据名称查找几何对象
 SharedGeometry* SharedMemoryManager::findGeometryByName(const std::string& name) {
+	// 先查名称目录，主名称和已登记的几何体名称可直接命中
+	SharedGeometry* found = getGeometryByHandle(findHandle(GeometrySegment, name));
+	if (found) {
+		return found;
+	}
+
 	for (auto geo : geos_) {
 		// 检查每个几何对象的名称向量
 		for (const auto& geoName : geo->shapeNames) {
@@ -688,6 +841,12 @@ SharedGeometry* SharedMemoryManager::findGeometryByName(const std::string& name)
 
 // 根据名称查找网格对象
 SharedMesh* SharedMemoryManager::findMeshByName(const std::string& name) {
+	// 先查名称目录，未登记的名称再遍历对象列表
+	SharedMesh* found = getMeshByHandle(findHandle(MeshSegment, name));
+	if (found) {
+		return found;
+	}
+
 	for (auto mesh : meshs_) {
 		if (std::string(mesh->name.c_str()) == name) {
 			return mesh;
@@ -698,6 +857,12 @@ SharedMesh* SharedMemoryManager::findMeshByName(const std::string& name) {
 
 // 根据名称查找计算数据对象
 SharedData* SharedMemoryManager::findDataByName(const std::string& name) {
+	// 先查名称目录，未登记的名称再遍历对象列表
+	SharedData* found = getDataByHandle(findHandle(DataSegment, name));
+	if (found) {
+		return found;
+	}
+
 	for (auto data : datas_) {
 		if (std::string(data->name.c_str()) == name) {
 			return data;
@@ -706,6 +871,101 @@ SharedData* SharedMemoryManager::findDataByName(const std::string& name) {
 	return nullptr;
 }
 
+// 根据名称获取对象句柄
+SharedHandle SharedMemoryManager::getGeometryHandle(const std::string& name) {
+	return findHandle(GeometrySegment, name);
+}
+
+SharedHandle SharedMemoryManager::getMeshHandle(const std::string& name) {
+	return findHandle(MeshSegment, name);
+}
+
+SharedHandle SharedMemoryManager::getDataHandle(const std::string& name) {
+	return findHandle(DataSegment, name);
+}
+
+SharedHandle SharedMemoryManager::getDefinitionHandle(const std::string& name) {
+	return findHandle(DefinitionSegment, name);
+}
+
+// 根据句柄获取对象指针
+SharedGeometry* SharedMemoryManager::getGeometryByHandle(SharedHandle handle) {
+	return resolveHandle<SharedGeometry>(GeometrySegment, handle, SharedMemorySuffix::GEOMETRY);
+}
+
+SharedMesh* SharedMemoryManager::getMeshByHandle(SharedHandle handle) {
+	return resolveHandle<SharedMesh>(MeshSegment, handle, SharedMemorySuffix::MESH);
+}
+
+SharedData* SharedMemoryManager::getDataByHandle(SharedHandle handle) {
+	return resolveHandle<SharedData>(DataSegment, handle, SharedMemorySuffix::DATA);
+}
+
+SharedDefinitionList* SharedMemoryManager::getDefinitionByHandle(SharedHandle handle) {
+	return resolveHandle<SharedDefinitionList>(DefinitionSegment, handle, SharedMemorySuffix::DEFINITION);
+}
+
+// 在名称目录中查找句柄
+SharedHandle SharedMemoryManager::findHandle(SegmentId id, const std::string& name) {
+	if (!controlData_ || !controlSegment_) {
+		return INVALID_HANDLE;
+	}
+
+	for (int attempt = 0; optimisticReads_ && attempt < OPTIMISTIC_READ_RETRIES; ++attempt) {
+		uint64_t seq = controlData_->readBegin();
+		if (seq & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		SharedHandle handle = INVALID_HANDLE;
+		bool found = false;
+		beginOptimisticRead(controlSegment_->get_address(), controlSegment_->get_size());
+		try {
+			handle = controlData_->directory.find(id, name);
+			found = true;
+		}
+		catch (const std::exception&) {
+			// 目录正在更新，重试
+		}
+		endOptimisticRead();
+
+		if (found && controlData_->readValidate(seq)) {
+			return handle;
+		}
+	}
+
+	bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
+	return controlData_->directory.find(id, name);
+}
+
+// 句柄对应的名称列表项
+std::string SharedMemoryManager::handleName(SegmentId id, SharedHandle handle) {
+	if (!controlData_ || handle < 0) {
+		return "";
+	}
+
+	bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
+	const SharedMemoryVectorString* names = nullptr;
+	switch (id) {
+	case GeometrySegment:
+		names = &controlData_->sharedModelNames;
+		break;
+	case MeshSegment:
+		names = &controlData_->sharedMeshNames;
+		break;
+	case DataSegment:
+		names = &controlData_->sharedDataNames;
+		break;
+	default:
+		names = &controlData_->sharedDefinitionNames;
+		break;
+	}
+
+	size_t index = static_cast<size_t>(handle);
+	return index < names->size() ? std::string((*names)[index].c_str()) : "";
+}
+
 // 获取几何数据的指针列表
 const std::vector<SharedGeometry*>& SharedMemoryManager::getGeometry() const {
 	return geos_;
@@ -729,11 +989,18 @@ void SharedMemoryManager::getGeometry(SharedGeometry* geo, LocalGeometry& localG
 	}
 
 	try {
-		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(geo->mutex);
+		SegmentReadScope scope(this, GeometrySegment);
+		// 指针可能来自内存段扩容前的映射
+		geo = rebaseObject(geo, GeometrySegment);
 
-		// 使用共享对象的copyToLocal方法
-		geo->copyToLocal(localGeo);
+		// 先尝试无锁的乐观读取，多次与写入冲突后再加锁复制
+		if (!readOptimistic(geo, localGeo, geometrySegment_)) {
+			bip::scoped_lock<bip::interprocess_mutex> lock(geo->mutex);
+
+			// 使用共享对象的copyToLocal方法
+			geo->copyToLocal(localGeo);
+		}
+		noteConsumed(geo, localGeo.version);
 
 		// 更新日志消息，显示获取了多少个几何体
 		if (localGeo.shapeNames.empty()) {
@@ -757,8 +1024,12 @@ void SharedMemoryManager::updateMesh(SharedMesh* mesh, const LocalMesh& localMes
 	}
 
 	try {
+		// 内存段扩容期间等待，并换到当前映射中的对象
+		SegmentWriteScope scope(this, MeshSegment);
+		mesh = rebaseObject(mesh, MeshSegment);
+
 		// 检查内存空间是否足够
-		if (!checkAndUpdateMeshMemorySize(localMesh.name, localMesh)) {
+		if (!checkAndUpdateMeshMemorySize(localMesh.name, localMesh, mesh)) {
 			log(LogLevel::Warning, "内存空间不足，无法更新网格对象: " + localMesh.name);
 			return;
 		}
@@ -772,8 +1043,8 @@ void SharedMemoryManager::updateMesh(SharedMesh* mesh, const LocalMesh& localMes
 		// 使用共享对象的copyFromLocal方法
 		mesh->copyFromLocal(localMesh, allocator);
 
-		// 更新内存使用信息到控制数据
-		updateMemorySegmentInfo();
+		// 只记录写入，内存段统计按需发布
+		noteSegmentWrite(MeshSegment);
 
 		log(LogLevel::Debug, "更新网格对象成功: " + localMesh.name);
 	}
@@ -791,11 +1062,18 @@ void SharedMemoryManager::getMesh(SharedMesh* mesh, LocalMesh& localMesh) {
 	}
 
 	try {
-		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(mesh->mutex);
+		SegmentReadScope scope(this, MeshSegment);
+		// 指针可能来自内存段扩容前的映射
+		mesh = rebaseObject(mesh, MeshSegment);
 
-		// 使用共享对象的copyToLocal方法
-		mesh->copyToLocal(localMesh);
+		// 先尝试无锁的乐观读取，多次与写入冲突后再加锁复制
+		if (!readOptimistic(mesh, localMesh, meshSegment_)) {
+			bip::scoped_lock<bip::interprocess_mutex> lock(mesh->mutex);
+
+			// 使用共享对象的copyToLocal方法
+			mesh->copyToLocal(localMesh);
+		}
+		noteConsumed(mesh, localMesh.version);
 
 		log(LogLevel::Debug, "获取网格对象成功: " + localMesh.name);
 	}
@@ -807,31 +1085,97 @@ void SharedMemoryManager::getMesh(SharedMesh* mesh, LocalMesh& localMesh) {
 
 // 更新计算数据对象 - 使用完整的LocalData
 void SharedMemoryManager::updateData(SharedData* data, const LocalData& localData) {
+	auto companions = coarseCompanions_.find(localData.name);
+	if (companions == coarseCompanions_.end() || !data || !dataSegment_) {
+		updateDataObject(data, localData);
+		return;
+	}
+
+	// 写入后(已离开本次写入的内存段作用域)更新随写入更新的低分辨率副本，版本号未变说明没有写入
+	uint64_t before = rebaseObject(data, DataSegment)->version.load();
+	updateDataObject(data, localData);
+	uint64_t after = rebaseObject(data, DataSegment)->version.load();
+	if (after == before) {
+		return;
+	}
+
+	for (auto& companion : companions->second) {
+		if (companion.updateOnWrite) {
+			writeCoarseData(companion, localData, after);
+		}
+	}
+}
+
+void SharedMemoryManager::updateDataObject(SharedData* data, const LocalData& localData) {
 	if (!data || !dataSegment_) {
 		log(LogLevel::Error, "计算数据对象或内存段未初始化");
 		return;
 	}
 
+	if (!localData.hasUniformComponents()) {
+		log(LogLevel::Warning, "各分量长度不一致，无法更新计算数据对象: " + localData.name);
+		return;
+	}
+
 	try {
+		// 稀疏模式下先去掉全零行，之后的哈希、空间检查和复制都针对稀疏数据
+		LocalData sparseData;
+		const LocalData& written = sparseForWrite(rebaseObject(data, DataSegment), localData, sparseData);
+
+		// 内容和时刻与上次整体写入相同时直接返回，不等待读取方也不加锁；未开启跳过时不计算哈希
+		SharedData* current = rebaseObject(data, DataSegment);
+		uint64_t hash = current->skipUnchanged.load() ? SharedData::hashContent(written) : 0;
+		if (current->isUnchanged(hash, written.t)) {
+			log(LogLevel::Debug, "计算数据内容未变化，跳过写入: " + written.name);
+			return;
+		}
+
+		// 写入背压：等待最慢的读取方跟上，须在进入内存段写入之前，否则会阻塞扩容
+		if (backpressureLag_ > 0 && !waitForReaders(rebaseObject(data, DataSegment), backpressureLag_ - 1, backpressureTimeoutMs_)) {
+			log(LogLevel::Warning, "读取方未能及时读取，继续写入计算数据对象: " + written.name);
+		}
+
+		// 内存段扩容期间等待，并换到当前映射中的对象
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
 		// 检查内存空间是否足够
-		if (!checkAndUpdateDataMemorySize(localData.name, localData)) {
-			log(LogLevel::Warning, "内存空间不足，无法更新计算数据对象: " + localData.name);
+		if (!checkAndUpdateDataMemorySize(written.name, written, data)) {
+			log(LogLevel::Warning, "内存空间不足，无法更新计算数据对象: " + written.name);
 			return;
 		}
 
 		// 获取计算数据段的分配器
 		SharedMemoryAllocator<char> allocator = getAllocator<char>("data");
 
+		// 多缓冲模式：只在选槽和发布时短暂加锁，数据复制期间不阻塞读取方
+		if (data->isSlotted()) {
+			if (!updateDataSlotted(data, written, allocator, hash, componentRows(localData))) {
+				log(LogLevel::Warning, "后台槽仍被只读视图固定，放弃更新计算数据对象: " + written.name);
+			}
+			return;
+		}
+
 		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+
+		// 等待读取方释放零拷贝视图，加锁后不会再有新的视图固定
+		if (!waitForViewsReleased(data)) {
+			log(LogLevel::Warning, "零拷贝视图未释放，放弃更新计算数据对象: " + written.name);
+			return;
+		}
+		updateRetentionFloor(data);
 
 		// 使用共享对象的copyFromLocal方法
-		data->copyFromLocal(localData, allocator);
+		data->copyFromLocal(written, allocator, hash, componentRows(localData));
+		noteGroupWrite();
 
-		// 更新内存使用信息到控制数据
-		updateMemorySegmentInfo();
+		// 只记录写入，内存段统计按需发布
+		noteSegmentWrite(DataSegment);
+		placeDataNearWriter(data);
 
-		log(LogLevel::Debug, "更新计算数据对象成功: " + localData.name);
+		log(LogLevel::Debug, "更新计算数据对象成功: " + written.name);
 	}
 	catch (const std::exception& e) {
 		log(LogLevel::Error, "更新计算数据对象失败: " + std::string(e.what()));
@@ -847,11 +1191,31 @@ void SharedMemoryManager::getData(SharedData* data, LocalData& localData) {
 	}
 
 	try {
+		SegmentReadScope scope(this, DataSegment);
+		// 指针可能来自内存段扩容前的映射
+		data = rebaseObject(data, DataSegment);
+
+		// 先尝试无锁的乐观读取
+		if (readOptimistic(data, localData, dataSegment_)) {
+			noteConsumed(data, localData.version);
+			log(LogLevel::Debug, "获取计算数据对象成功: " + localData.name);
+			return;
+		}
+
+		// 多缓冲模式：加锁固定前台槽后即释放锁，在锁外复制数据
+		if (data->isSlotted()) {
+			getDataSlotted(data, localData);
+			noteConsumed(data, localData.version);
+			return;
+		}
+
 		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
 
 		// 使用共享对象的copyToLocal方法
 		data->copyToLocal(localData);
+		noteConsumed(data, localData.version);
 
 		log(LogLevel::Debug, "获取计算数据对象成功: " + localData.name);
 	}
@@ -861,59 +1225,2454 @@ void SharedMemoryManager::getData(SharedData* data, LocalData& localData) {
 	}
 }
 
-// 设置异常信息
-void SharedMemoryManager::setException(int type, int code, const std::string& message) {
-	if (!controlData_) {
-		log(LogLevel::Error, "控制数据对象未初始化");
+// 按句柄更新计算数据对象
+void SharedMemoryManager::updateData(SharedHandle handle, const LocalData& localData) {
+	SharedData* data = getDataByHandle(handle);
+	if (!data) {
+		log(LogLevel::Error, "无效的计算数据句柄: " + std::to_string(handle));
 		return;
 	}
+	updateData(data, localData);
+}
+
+// 按句柄获取计算数据对象
+void SharedMemoryManager::getData(SharedHandle handle, LocalData& localData) {
+	SharedData* data = getDataByHandle(handle);
+	if (!data) {
+		log(LogLevel::Error, "无效的计算数据句柄: " + std::to_string(handle));
+		return;
+	}
+	getData(data, localData);
+}
+
+// 局部更新计算数据对象
+bool SharedMemoryManager::updateDataRange(SharedData* data, size_t offset, size_t count,
+	const std::vector<std::vector<double>>& components) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
 
 	try {
-		// 获取控制数据段的分配器
-		SharedMemoryAllocator<char> allocator = getAllocator<char>();
+		data = rebaseObject(data, DataSegment);
 
-		// 设置异常信息
-		controlData_->exception.hasException.store(true);
-		controlData_->exception.exceptionType.store(type);
-		controlData_->exception.exceptionCode.store(code);
-		controlData_->exception.exceptionMessage = SharedMemoryString(message.c_str(), allocator);
+		// 多缓冲模式下槽只能整体发布：读出当前数据，改写对应行后整体写入
+		if (data->isSlotted()) {
+			LocalData localData;
+			getData(data, localData);
 
-		log(LogLevel::Warning, "设置异常信息: 类型=" + std::to_string(type) +
-							 ", 代码=" + std::to_string(code) +
-							 ", 消息=" + message);
+			size_t rows = localData.data.empty() ? 0 : localData.data[0].size();
+			if (offset + count > rows || components.size() > localData.data.size()) {
+				log(LogLevel::Warning, "局部更新超出计算数据的范围: " + localData.name);
+				return false;
+			}
+			for (size_t c = 0; c < components.size(); ++c) {
+				if (components[c].size() < count) {
+					log(LogLevel::Warning, "局部更新的分量数据不足: " + localData.name);
+					return false;
+				}
+				std::copy(components[c].begin(), components[c].begin() + count, localData.data[c].begin() + offset);
+			}
+
+			// copyFromLocal 只在版本号与共享对象不同时写入
+			localData.version = std::numeric_limits<uint64_t>::max();
+			updateData(data, localData);
+			return true;
+		}
+
+		SegmentWriteScope scope(this, DataSegment);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+
+		if (offset + count > data->data.rowCount || components.size() > data->data.componentCount) {
+			log(LogLevel::Warning, "局部更新超出计算数据的范围: " + std::string(data->name.c_str()));
+			return false;
+		}
+		for (const auto& component : components) {
+			if (component.size() < count) {
+				log(LogLevel::Warning, "局部更新的分量数据不足: " + std::string(data->name.c_str()));
+				return false;
+			}
+		}
+
+		// 原地改写，同样需要等待零拷贝视图释放
+		if (!waitForViewsReleased(data)) {
+			log(LogLevel::Warning, "零拷贝视图未释放，放弃局部更新: " + std::string(data->name.c_str()));
+			return false;
+		}
+		updateRetentionFloor(data);
+		data->writeRange(offset, count, components);
+		noteGroupWrite();
+
+		log(LogLevel::Debug, "局部更新计算数据对象成功: " + std::string(data->name.c_str()) +
+			", 行: " + std::to_string(offset) + " - " + std::to_string(offset + count));
+		return true;
 	}
 	catch (const std::exception& e) {
-		log(LogLevel::Error, "设置异常信息失败: " + std::string(e.what()));
+		log(LogLevel::Error, "局部更新计算数据对象失败: " + std::string(e.what()));
+		throw;
 	}
 }
 
-// 检查是否有异常
-bool SharedMemoryManager::hasException() const {
-	if (!controlData_) {
+bool SharedMemoryManager::updateDataRange(const std::string& name, size_t offset, size_t count,
+	const std::vector<std::vector<double>>& components) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
 		return false;
 	}
-	return controlData_->exception.hasException.load();
+	return updateDataRange(data, offset, count, components);
 }
 
-// 获取异常详情并清除异常标志
-std::tuple<int, int, std::string> SharedMemoryManager::getAndClearException() {
-	if (!controlData_ || !controlData_->exception.hasException.load()) {
-		return std::make_tuple(0, 0, "");
+// 增量读取计算数据对象
+std::vector<std::pair<size_t, size_t>> SharedMemoryManager::getDataChanges(SharedData* data, LocalData& localData) {
+	std::vector<std::pair<size_t, size_t>> ranges;
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return ranges;
 	}
 
-	// 获取异常信息
-	int type = controlData_->exception.exceptionType.load();
-	int code = controlData_->exception.exceptionCode.load();
-	std::string message = controlData_->exception.exceptionMessage.c_str();
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		{
+			bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+			lockObject(lock, data);
+			if (data->copyChangesToLocal(localData, ranges)) {
+				noteConsumed(data, localData.version);
+				log(LogLevel::Debug, "增量读取计算数据对象成功: " + std::string(data->name.c_str()) +
+					", 行范围数: " + std::to_string(ranges.size()));
+				return ranges;
+			}
+		}
 
-	// 清除异常标志
-	controlData_->exception.hasException.store(false);
-	controlData_->exception.exceptionType.store(0);
-	controlData_->exception.exceptionCode.store(0);
+		// 无法增量读取，退回整体读取
+		getData(data, localData);
+		size_t rows = localData.data.empty() ? 0 : localData.data[0].size();
+		ranges.assign(1, std::make_pair(static_cast<size_t>(0), rows));
+		return ranges;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "增量读取计算数据对象失败: " + std::string(e.what()));
+		throw;
+	}
+}
 
-	// 获取控制数据段的分配器并清空异常消息
-	SharedMemoryAllocator<char> allocator = getAllocator<char>();
-	controlData_->exception.exceptionMessage = SharedMemoryString("", allocator);
+std::vector<std::pair<size_t, size_t>> SharedMemoryManager::getDataChanges(const std::string& name, LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return std::vector<std::pair<size_t, size_t>>();
+	}
+	return getDataChanges(data, localData);
+}
+
+// 多缓冲模式下更新计算数据对象
+bool SharedMemoryManager::updateDataSlotted(SharedData* data, const LocalData& localData, SharedMemoryAllocator<char> allocator, uint64_t hash,
+	uint64_t denseRows) {
+	// 如果版本号相同，则不需要更新
+	if (localData.version == data->version.load()) {
+		return true;
+	}
+
+	// 第一步：加锁选取后台槽，后台槽仍被旧版本的读取方固定时在锁外等待其释放
+	int slot = -1;
+	if (!waitForWriteSlot(data, &slot)) {
+		return false;
+	}
+
+	// 第二步：在锁外填充后台槽，读取方此时仍可读取前台槽
+	try {
+		data->fillSlot(slot, localData, allocator, denseRows);
+	}
+	catch (...) {
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		data->abandonSlot(slot);
+		throw;
+	}
+
+	// 第三步：加锁复制元数据并发布
+	{
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+		updateRetentionFloor(data);
+		data->publishSlot(slot, localData, allocator, hash);
+	}
+	noteGroupWrite();
+
+	// 只记录写入，内存段统计按需发布
+	noteSegmentWrite(DataSegment);
+	placeDataNearWriter(data);
+
+	log(LogLevel::Debug, "更新计算数据对象成功: " + localData.name + ", 槽: " + std::to_string(slot));
+	return true;
+}
+
+// 多缓冲模式下获取计算数据对象
+void SharedMemoryManager::getDataSlotted(SharedData* data, LocalData& localData) {
+	// 如果版本号相同，则不需要更新
+	if (localData.version == data->version.load()) {
+		return;
+	}
+
+	// 固定前台槽并登记本进程，复制期间异常退出时写入方可以回收
+	int slot = -1;
+	int holder = -1;
+	{
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+		slot = data->pinFrontSlot(localData);
+		holder = data->registerViewHolder(currentProcessId(), slot);
+	}
+
+	try {
+		data->copySlotToLocal(slot, localData);
+	}
+	catch (...) {
+		data->releaseViewHolder(holder);
+		data->unpinSlot(slot);
+		throw;
+	}
+	data->releaseViewHolder(holder);
+	data->unpinSlot(slot);
+
+	log(LogLevel::Debug, "获取计算数据对象成功: " + localData.name + ", 槽: " + std::to_string(slot));
+}
+
+// 阻塞等待对象出现新版本
+uint64_t SharedMemoryManager::waitForNewVersion(SharedDataBase* obj, uint64_t lastSeen, int timeoutMs) {
+	if (!obj) {
+		log(LogLevel::Error, "等待的共享对象未初始化");
+		return lastSeen;
+	}
+
+	// 指针可能来自内存段扩容前的映射，旧映射释放后不能再访问
+	SegmentId id = objectSegment(obj);
+
+	try {
+		auto start = std::chrono::steady_clock::now();
+		bool spun = false;
+		while (true) {
+			// 分段等待：每段在内存段内等待，段之间离开内存段，使扩容或重建不必等到新版本到来；
+			// 下一段按新的纪元换到当前映射中的对象
+			int sliceMs = VERSION_WAIT_SLICE_MS;
+			if (timeoutMs >= 0) {
+				auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+				sliceMs = static_cast<int>((std::min)(static_cast<long long>(sliceMs), (std::max)(0LL, static_cast<long long>(timeoutMs - elapsedMs))));
+			}
+
+			uint64_t current = lastSeen;
+			{
+				std::unique_ptr<SegmentReadScope> scope;
+				if (id < SegmentCount) {
+					scope.reset(new SegmentReadScope(this, id));
+					obj = rebaseSharedObject(obj, id);
+				}
+
+				// 已有新版本时直接返回，不需要加锁
+				current = obj->version.load();
+				if (current != lastSeen) {
+					if (spun) {
+						obj->recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+							std::chrono::steady_clock::now() - start).count());
+					}
+					return current;
+				}
+
+				// 按等待策略先自旋、让出 CPU，新版本很快到来时不必进入条件变量
+				if (!spun) {
+					spun = true;
+					if (obj->spinWait([obj, lastSeen] { return obj->version.load() != lastSeen; })) {
+						obj->recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+							std::chrono::steady_clock::now() - start).count());
+						return obj->version.load();
+					}
+				}
+
+				bip::scoped_lock<bip::interprocess_mutex> lock(obj->mutex, bip::defer_lock);
+				lockObject(lock, obj);
+				current = obj->waitForVersion(lock, lastSeen, sliceMs);
+				if (current != lastSeen || (timeoutMs >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeoutMs))) {
+					obj->recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+						std::chrono::steady_clock::now() - start).count());
+					if (current == lastSeen) {
+						log(LogLevel::Debug, "等待新版本超时: " + std::string(obj->name.c_str()));
+					}
+					return current;
+				}
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "等待新版本失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+// 对象指针所在的内存段
+SegmentId SharedMemoryManager::objectSegment(const void* obj) {
+	const char* p = static_cast<const char*>(obj);
+	for (int i = 0; i < SegmentCount; ++i) {
+		SegmentId id = static_cast<SegmentId>(i);
+		std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+		if (segment) {
+			const char* base = static_cast<const char*>(segment->get_address());
+			if (p >= base && p < base + segment->get_size()) {
+				return id;
+			}
+		}
+		for (const auto& retired : retiredSegments_[id]) {
+			if (p >= retired.base && p < retired.base + retired.size) {
+				return id;
+			}
+		}
+	}
+	return SegmentCount;
+}
+
+// 按内存段中的对象类型换到当前映射，按名称查找时需要实际的类型
+SharedDataBase* SharedMemoryManager::rebaseSharedObject(SharedDataBase* obj, SegmentId id) {
+	switch (id) {
+	case GeometrySegment:
+		return rebaseObject(static_cast<SharedGeometry*>(obj), id);
+	case MeshSegment:
+		return rebaseObject(static_cast<SharedMesh*>(obj), id);
+	case DataSegment:
+		return rebaseObject(static_cast<SharedData*>(obj), id);
+	case DefinitionSegment:
+		return rebaseObject(static_cast<SharedDefinitionList*>(obj), id);
+	default:
+		return obj;
+	}
+}
+
+uint64_t SharedMemoryManager::waitForNewVersion(const std::string& name, uint64_t lastSeen, int timeoutMs) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return lastSeen;
+	}
+	return waitForNewVersion(data, lastSeen, timeoutMs);
+}
+
+// 设置计算数据对象的多分量排列方式
+bool SharedMemoryManager::setDataLayout(SharedData* data, DataLayout layout) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+
+		// 转置前等待所有读取方和写入方离开
+		if (!waitForViewsReleased(data)) {
+			return false;
+		}
+		while (data->slotsBusy()) {
+			std::this_thread::yield();
+		}
+
+		data->setLayout(layout);
+
+		log(LogLevel::Info, "设置计算数据对象排列方式: " + std::string(data->name.c_str()) +
+			(layout == InterleavedLayout ? ", 交错排列" : ", 平面排列"));
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据对象排列方式失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::setDataLayout(const std::string& name, DataLayout layout) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataLayout(data, layout);
+}
+
+// 设置计算数据对象的存储精度
+bool SharedMemoryManager::setDataPrecision(SharedData* data, DataPrecision precision) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+
+		// 转换前等待所有读取方和写入方离开
+		if (!waitForViewsReleased(data)) {
+			return false;
+		}
+		while (data->slotsBusy()) {
+			std::this_thread::yield();
+		}
+
+		data->setPrecision(precision);
+		noteSegmentWrite(DataSegment);
+
+		static const char* names[] = { "双精度", "单精度", "bfloat16" };
+		log(LogLevel::Info, "设置计算数据对象存储精度: " + std::string(data->name.c_str()) + ", " + names[precision]);
+		return true;
+	}
+	catch (const bip::bad_alloc&) {
+		log(LogLevel::Error, "内存空间不足，无法转换计算数据对象的存储精度: " + std::string(data->name.c_str()));
+		return false;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据对象存储精度失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::setDataPrecision(const std::string& name, DataPrecision precision) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataPrecision(data, precision);
+}
+
+// 启用或关闭乐观(无锁)读取
+void SharedMemoryManager::setOptimisticReads(bool enable) {
+	optimisticReads_ = enable;
+	log(LogLevel::Info, std::string("乐观读取已") + (enable ? "启用" : "关闭"));
+}
+
+// 设置计算数据对象的缓冲槽数
+bool SharedMemoryManager::setDataSlotCount(SharedData* data, uint32_t slotCount) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	if (slotCount != 0 && slotCount != 1 && slotCount != 2 && slotCount != 3) {
+		log(LogLevel::Error, "缓冲槽数只能为 1、2 或 3: " + std::to_string(slotCount));
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+
+		// 切换布局前等待所有读取方和写入方离开
+		if (!waitForViewsReleased(data)) {
+			return false;
+		}
+		while (data->slotsBusy()) {
+			std::this_thread::yield();
+		}
+
+		data->setSlotCount(slotCount);
+
+		log(LogLevel::Info, "设置计算数据对象缓冲槽数: " + std::string(data->name.c_str()) +
+			", 槽数: " + std::to_string(slotCount));
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据对象缓冲槽数失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::setDataSlotCount(const std::string& name, uint32_t slotCount) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataSlotCount(data, slotCount);
+}
+
+// 开始事务
+void SharedMemoryManager::beginTransaction() {
+	if (transactionOpen_) {
+		log(LogLevel::Warning, "已有进行中的事务，之前暂存的更新被放弃");
+	}
+	stagedData_.clear();
+	transactionOpen_ = true;
+}
+
+// 暂存计算数据对象的更新
+bool SharedMemoryManager::stageData(SharedData* data, const LocalData& localData) {
+	if (!transactionOpen_) {
+		log(LogLevel::Error, "没有进行中的事务");
+		return false;
+	}
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+	if (!localData.hasUniformComponents()) {
+		log(LogLevel::Warning, "各分量长度不一致，无法暂存计算数据: " + localData.name);
+		return false;
+	}
+
+	// 复制一份，调用方在提交前可以修改或释放 localData
+	stagedData_.push_back(std::make_pair(data, localData));
+	return true;
+}
+
+bool SharedMemoryManager::stageData(const std::string& name, const LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return stageData(data, localData);
+}
+
+// 提交事务
+uint64_t SharedMemoryManager::commitTransaction() {
+	if (!transactionOpen_) {
+		log(LogLevel::Error, "没有进行中的事务");
+		return 0;
+	}
+
+	std::vector<std::pair<SharedData*, LocalData>> staged;
+	staged.swap(stagedData_);
+	transactionOpen_ = false;
+
+	if (!controlData_ || !dataSegment_) {
+		log(LogLevel::Error, "控制数据对象或计算数据内存段未初始化");
+		return 0;
+	}
+
+	try {
+		// 稀疏模式的对象换成去掉全零行的数据，统计量仍按原来的行数计
+		std::vector<uint64_t> denseRows;
+		for (auto& item : staged) {
+			denseRows.push_back(componentRows(item.second));
+			LocalData sparse;
+			if (&sparseForWrite(rebaseObject(item.first, DataSegment), item.second, sparse) != &item.second) {
+				item.second = std::move(sparse);
+			}
+		}
+
+		SegmentWriteScope scope(this, DataSegment);
+
+		// 整个事务只检查一次剩余内存，不足时再逐个检查，以便记录各对象所需的空间并设置异常
+		size_t requiredSize = 0;
+		for (const auto& item : staged) {
+			requiredSize += SharedMemoryPlanner::updateBytes(*rebaseObject(item.first, DataSegment), item.second);
+		}
+		auto usage = getDataMemoryUsage();
+		if (usage.first - usage.second < requiredSize) {
+			for (const auto& item : staged) {
+				checkAndUpdateDataMemorySize(item.second.name, item.second, rebaseObject(item.first, DataSegment));
+			}
+			log(LogLevel::Warning, "内存空间不足，事务未提交");
+			return 0;
+		}
+
+		SharedMemoryAllocator<char> allocator = getAllocator<char>("data");
+
+		// 写入任何对象之前确认各对象的零拷贝视图都能释放、多缓冲对象都有可写入的后台槽，避免事务只提交一部分。
+		// 后台槽在锁外等待，提交时持有组锁和对象锁，不再等待
+		for (const auto& item : staged) {
+			SharedData* data = rebaseObject(item.first, DataSegment);
+			if (data->isSlotted()) {
+				if (!waitForWriteSlot(data)) {
+					log(LogLevel::Warning, "后台槽仍被只读视图固定，事务未提交: " + item.second.name);
+					return 0;
+				}
+				continue;
+			}
+			bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+			lockObject(lock, data);
+			if (!waitForViewsReleased(data)) {
+				log(LogLevel::Warning, "零拷贝视图未释放，事务未提交: " + item.second.name);
+				return 0;
+			}
+		}
+
+		bip::scoped_lock<bip::interprocess_mutex> groupLock(controlData_->groupMutex);
+		controlData_->groupSequence.fetch_add(1);
+
+		uint64_t groupVersion = 0;
+		try {
+			for (size_t i = 0; i < staged.size(); ++i) {
+				SharedData* data = rebaseObject(staged[i].first, DataSegment);
+				bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+				lockObject(lock, data);
+				if (!waitForViewsReleased(data)) {
+					throw std::runtime_error("零拷贝视图未释放: " + std::string(data->name.c_str()));
+				}
+				updateRetentionFloor(data);
+				data->copyFromLocal(staged[i].second, allocator, 0, denseRows[i]);
+			}
+			groupVersion = controlData_->groupVersion.fetch_add(1) + 1;
+		}
+		catch (...) {
+			// 已写入的对象无法回滚，但不能让组读取方一直等待
+			controlData_->groupSequence.fetch_add(1);
+			throw;
+		}
+		controlData_->groupSequence.fetch_add(1);
+		groupLock.unlock();
+
+		// 只记录写入，内存段统计按需发布
+		noteSegmentWrite(DataSegment);
+		for (const auto& item : staged) {
+			placeDataNearWriter(rebaseObject(item.first, DataSegment));
+		}
+
+		log(LogLevel::Debug, "提交事务成功: " + std::to_string(staged.size()) +
+			" 个计算数据对象, 组版本: " + std::to_string(groupVersion));
+		return groupVersion;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "提交事务失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+// 放弃暂存的更新
+void SharedMemoryManager::abortTransaction() {
+	stagedData_.clear();
+	transactionOpen_ = false;
+}
+
+// 一致地读取一组计算数据对象
+uint64_t SharedMemoryManager::getDataGroup(const std::vector<SharedData*>& datas, std::vector<LocalData>& localDatas) {
+	localDatas.resize(datas.size());
+	if (!controlData_) {
+		log(LogLevel::Error, "控制数据对象未初始化");
+		return 0;
+	}
+
+	// 先不加组锁读取，期间没有事务提交和写入才算一致
+	std::vector<uint64_t> versions(datas.size(), 0);
+	for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; ++attempt) {
+		uint64_t seq = controlData_->groupSequence.load();
+		if (seq & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// 复制前先确认各对象的版本在同一组序号下读到，已有提交或写入时不复制直接重试
+		uint64_t groupVersion = controlData_->groupVersion.load();
+		bool current = true;
+		for (size_t i = 0; i < datas.size() && current; ++i) {
+			current = datas[i] != nullptr;
+			if (current) {
+				versions[i] = rebaseObject(datas[i], DataSegment)->version.load();
+			}
+		}
+		if (!current || controlData_->groupSequence.load() != seq) {
+			continue;
+		}
+
+		// 只复制版本与本地副本不同的对象，重试时上一次已读到的对象不再复制
+		for (size_t i = 0; i < datas.size(); ++i) {
+			if (localDatas[i].version != versions[i]) {
+				getData(datas[i], localDatas[i]);
+			}
+		}
+		if (controlData_->groupSequence.load() == seq) {
+			return groupVersion;
+		}
+	}
+
+	// 冲突过多时持组锁读取，期间不会有事务提交
+	bip::scoped_lock<bip::interprocess_mutex> groupLock(controlData_->groupMutex);
+	for (size_t i = 0; i < datas.size(); ++i) {
+		getData(datas[i], localDatas[i]);
+	}
+	return controlData_->groupVersion.load();
+}
+
+uint64_t SharedMemoryManager::getDataGroup(const std::vector<std::string>& names, std::vector<LocalData>& localDatas) {
+	std::vector<SharedData*> datas;
+	datas.reserve(names.size());
+	for (const auto& name : names) {
+		SharedData* data = findDataByName(name);
+		if (!data) {
+			log(LogLevel::Warning, "未找到计算数据对象: " + name);
+			return 0;
+		}
+		datas.push_back(data);
+	}
+	return getDataGroup(datas, localDatas);
+}
+
+// 登记为读取方
+int SharedMemoryManager::registerReader(const std::string& readerName) {
+	if (!controlData_) {
+		log(LogLevel::Error, "控制数据对象未初始化");
+		return -1;
+	}
+	if (readerName.empty() || readerName.size() >= SharedControlData::READER_NAME_SIZE) {
+		log(LogLevel::Error, "读取方名称为空或过长: " + readerName);
+		return -1;
+	}
+
+	if (readerId_ >= 0) {
+		unregisterReader();
+	}
+
+	try {
+		bip::scoped_lock<bip::named_mutex> lock(*sharedMutex_);
+		uint32_t mask = controlData_->readerMask.load();
+
+		// 同名读取方仍在登记表中时沿用其编号，游标随之保留
+		for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+			if ((mask & (1u << i)) && readerName == controlData_->readerNames[i]) {
+				readerId_ = static_cast<int>(i);
+				readerGeneration_ = controlData_->readerGenerations[i].load();
+				controlData_->readerPids[i].store(currentProcessId());
+				log(LogLevel::Info, "沿用已登记的读取方: " + readerName + ", 编号: " + std::to_string(i));
+				return readerId_;
+			}
+		}
+
+		// 回收已退出但未注销的读取方占用的编号
+		for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+			if ((mask & (1u << i)) && !processAlive(controlData_->readerPids[i].load())) {
+				log(LogLevel::Warning, "回收已退出的读取方: " + std::string(controlData_->readerNames[i]));
+				mask &= ~(1u << i);
+			}
+		}
+		controlData_->readerMask.store(mask);
+
+		for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+			if (mask & (1u << i)) {
+				continue;
+			}
+
+			// 新分配的编号代数加一，各对象上该编号的旧游标随之失效；代数 0 留给未初始化的游标
+			readerGeneration_ = (controlData_->readerGenerations[i].load() + 1) & 0xFFFF;
+			if (readerGeneration_ == 0) {
+				readerGeneration_ = 1;
+			}
+			controlData_->readerGenerations[i].store(readerGeneration_);
+			controlData_->readerPids[i].store(currentProcessId());
+			std::strncpy(controlData_->readerNames[i], readerName.c_str(), SharedControlData::READER_NAME_SIZE - 1);
+			controlData_->readerNames[i][SharedControlData::READER_NAME_SIZE - 1] = '\0';
+			controlData_->readerMask.store(mask | (1u << i));
+
+			readerId_ = static_cast<int>(i);
+			log(LogLevel::Info, "登记读取方: " + readerName + ", 编号: " + std::to_string(i));
+			return readerId_;
+		}
+
+		log(LogLevel::Warning, "读取方登记表已满，无法登记: " + readerName);
+		return -1;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "登记读取方失败: " + std::string(e.what()));
+		return -1;
+	}
+}
+
+// 注销本管理器登记的读取方
+void SharedMemoryManager::unregisterReader() {
+	if (readerId_ < 0 || !controlData_) {
+		readerId_ = -1;
+		return;
+	}
+
+	try {
+		bip::scoped_lock<bip::named_mutex> lock(*sharedMutex_);
+
+		// 编号可能已被其他进程按名称注销并重新分配，代数不符时不再处理
+		uint32_t bit = 1u << readerId_;
+		if (controlData_->readerGenerations[readerId_].load() == readerGeneration_) {
+			controlData_->readerMask.fetch_and(~bit);
+			log(LogLevel::Info, "注销读取方: " + std::string(controlData_->readerNames[readerId_]));
+		}
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "注销读取方失败: " + std::string(e.what()));
+	}
+	readerId_ = -1;
+}
+
+// 注销指定名称的读取方
+bool SharedMemoryManager::unregisterReader(const std::string& readerName) {
+	if (!controlData_) {
+		log(LogLevel::Error, "控制数据对象未初始化");
+		return false;
+	}
+
+	try {
+		bip::scoped_lock<bip::named_mutex> lock(*sharedMutex_);
+		uint32_t mask = controlData_->readerMask.load();
+		for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+			if ((mask & (1u << i)) && readerName == controlData_->readerNames[i]) {
+				controlData_->readerMask.fetch_and(~(1u << i));
+				if (readerId_ == static_cast<int>(i)) {
+					readerId_ = -1;
+				}
+				log(LogLevel::Info, "注销读取方: " + readerName);
+				return true;
+			}
+		}
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "注销读取方失败: " + std::string(e.what()));
+		return false;
+	}
+
+	log(LogLevel::Warning, "未找到读取方: " + readerName);
+	return false;
+}
+
+int SharedMemoryManager::getReaderId() const {
+	return readerId_;
+}
+
+// 显式记录本读取方已读到的版本
+void SharedMemoryManager::markConsumed(SharedDataBase* obj, uint64_t readVersion) {
+	if (readerId_ < 0) {
+		log(LogLevel::Warning, "尚未登记为读取方，忽略已读记录");
+		return;
+	}
+	ObjectReadScope scope(this, obj);
+	noteConsumed(obj, readVersion);
+}
+
+// 订阅对象
+bool SharedMemoryManager::subscribeReader(SharedDataBase* obj) {
+	if (!obj || readerId_ < 0) {
+		log(LogLevel::Warning, "对象未初始化或尚未登记为读取方，无法订阅");
+		return false;
+	}
+	ObjectReadScope scope(this, obj);
+	// 已订阅时保留原游标，否则从当前版本开始计算落后的版本数
+	if (!obj->hasConsumer(static_cast<uint32_t>(readerId_), readerGeneration_)) {
+		noteConsumed(obj, obj->version.load());
+	}
+	return true;
+}
+
+// 取消订阅对象
+bool SharedMemoryManager::unsubscribeReader(SharedDataBase* obj) {
+	if (!obj || readerId_ < 0) {
+		log(LogLevel::Warning, "对象未初始化或尚未登记为读取方，无法取消订阅");
+		return false;
+	}
+	ObjectReadScope scope(this, obj);
+	obj->clearConsumer(static_cast<uint32_t>(readerId_));
+	return true;
+}
+
+// 仍在运行的登记读取方
+uint32_t SharedMemoryManager::liveReaderMask() {
+	if (!controlData_) {
+		return 0;
+	}
+	uint32_t mask = controlData_->readerMask.load();
+	for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+		if ((mask & (1u << i)) && !processAlive(controlData_->readerPids[i].load())) {
+			mask &= ~(1u << i);
+		}
+	}
+	return mask;
+}
+
+// 所有登记读取方在对象上的游标
+std::vector<SharedMemoryManager::ReaderCursor> SharedMemoryManager::getReaderCursors(SharedDataBase* obj) {
+	std::vector<ReaderCursor> cursors;
+	if (!obj || !controlData_) {
+		return cursors;
+	}
+
+	ObjectReadScope scope(this, obj);
+	uint32_t mask = controlData_->readerMask.load();
+	for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+		if (!(mask & (1u << i))) {
+			continue;
+		}
+		uint32_t generation = controlData_->readerGenerations[i].load();
+		ReaderCursor cursor;
+		cursor.readerId = static_cast<int>(i);
+		cursor.name = controlData_->readerNames[i];
+		cursor.version = obj->consumedVersion(i, generation);
+		cursor.subscribed = obj->hasConsumer(i, generation);
+		cursor.alive = processAlive(controlData_->readerPids[i].load());
+		cursors.push_back(cursor);
+	}
+	return cursors;
+}
+
+// 订阅了对象的运行中读取方中最旧的已读版本
+uint64_t SharedMemoryManager::slowestReaderVersion(SharedDataBase* obj) {
+	if (!obj) {
+		return 0;
+	}
+	ObjectReadScope scope(this, obj);
+	return slowestReaderVersion(obj, liveReaderMask());
+}
+
+uint64_t SharedMemoryManager::slowestReaderVersion(SharedDataBase* obj, uint32_t liveMask) {
+	if (!obj) {
+		return 0;
+	}
+
+	uint64_t slowest = obj->version.load();
+	if (!controlData_) {
+		return slowest;
+	}
+
+	// 只读原子量，不加锁；登记表在遍历期间变化时结果可能略旧，调用方按需重试。
+	// 从未读取也未订阅本对象的读取方不拖慢本对象
+	uint32_t mask = liveMask & controlData_->readerMask.load();
+	for (uint32_t i = 0; i < SharedDataBase::MAX_READERS; ++i) {
+		uint32_t generation = controlData_->readerGenerations[i].load();
+		if ((mask & (1u << i)) && obj->hasConsumer(i, generation)) {
+			slowest = (std::min)(slowest, obj->consumedVersion(i, generation));
+		}
+	}
+	return slowest;
+}
+
+// 等待读取方跟上
+bool SharedMemoryManager::waitForReaders(SharedDataBase* obj, uint64_t maxLag, int timeoutMs) {
+	if (!obj) {
+		log(LogLevel::Error, "等待的共享对象未初始化");
+		return false;
+	}
+
+	// 指针可能来自内存段扩容前的映射，旧映射释放后不能再访问
+	SegmentId id = objectSegment(obj);
+
+	// 读取方不通知写入方，按等待策略自旋、让出 CPU 后定时重新检查；进程存活只在开始时检查一次。
+	// 与 waitForNewVersion 相同地分段等待，段之间离开内存段，不阻塞扩容
+	uint32_t liveMask = liveReaderMask();
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		int sliceMs = VERSION_WAIT_SLICE_MS;
+		if (timeoutMs >= 0) {
+			auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			sliceMs = static_cast<int>((std::min)(static_cast<long long>(sliceMs), (std::max)(0LL, static_cast<long long>(timeoutMs - elapsedMs))));
+		}
+
+		ObjectReadScope scope(this, obj, id);
+		if (waitUntil(obj, [this, obj, maxLag, liveMask] { return obj->version.load() - slowestReaderVersion(obj, liveMask) <= maxLag; }, sliceMs)) {
+			return true;
+		}
+		if (timeoutMs >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(timeoutMs)) {
+			log(LogLevel::Debug, "等待读取方超时: " + std::string(obj->name.c_str()));
+			return false;
+		}
+	}
+}
+
+// 设置写入背压
+void SharedMemoryManager::setReaderBackpressure(uint64_t maxLag, int timeoutMs) {
+	backpressureLag_ = maxLag;
+	backpressureTimeoutMs_ = timeoutMs;
+}
+
+// 设置计算数据对象的多版本保留
+bool SharedMemoryManager::setDataRetention(SharedData* data, uint32_t depth, uint32_t capacity) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+	if (depth > SharedVersionStore::MAX_VERSIONS) {
+		log(LogLevel::Warning, "保留的版本数超过上限 " + std::to_string(SharedVersionStore::MAX_VERSIONS) +
+			": " + std::string(data->name.c_str()));
+		return false;
+	}
+	if (capacity == 0) {
+		capacity = 2 * depth > SharedVersionStore::MAX_VERSIONS ? SharedVersionStore::MAX_VERSIONS : 2 * depth;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		updateRetentionFloor(data);
+		data->setRetention(depth, capacity);
+
+		log(LogLevel::Info, "设置计算数据对象多版本保留: " + std::string(data->name.c_str()) +
+			", 保留: " + std::to_string(depth) + ", 上限: " + std::to_string(depth ? capacity : 0));
+		return true;
+	}
+	catch (const bip::bad_alloc&) {
+		log(LogLevel::Warning, "计算数据内存段空间不足，无法启用多版本保留: " + std::string(data->name.c_str()));
+		return false;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据对象多版本保留失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::setDataRetention(const std::string& name, uint32_t depth, uint32_t capacity) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataRetention(data, depth, capacity);
+}
+
+// 按版本号读取计算数据对象
+bool SharedMemoryManager::getDataVersion(SharedData* data, uint64_t version, LocalData& localData) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		if (data->copyVersionToLocal(version, localData)) {
+			return true;
+		}
+
+		// 未启用保留时当前版本仍可读取
+		if (version == data->version.load() && !data->isSlotted()) {
+			data->copyToLocal(localData);
+			return true;
+		}
+
+		log(LogLevel::Debug, "计算数据对象未保留版本 " + std::to_string(version) + ": " + std::string(data->name.c_str()));
+		return false;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "按版本读取计算数据对象失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::getDataVersion(const std::string& name, uint64_t version, LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataVersion(data, version, localData);
+}
+
+// 仍保留的版本号
+std::vector<uint64_t> SharedMemoryManager::getRetainedVersions(SharedData* data) {
+	if (!data) {
+		return std::vector<uint64_t>();
+	}
+
+	SegmentReadScope scope(this, DataSegment);
+	data = rebaseObject(data, DataSegment);
+	bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+	return data->versions ? data->versions->versions() : std::vector<uint64_t>();
+}
+
+// 设置是否跳过内容未变化的写入
+void SharedMemoryManager::setSkipUnchangedWrites(SharedData* data, bool enable) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return;
+	}
+
+	data = rebaseObject(data, DataSegment);
+	data->skipUnchanged.store(enable);
+	log(LogLevel::Info, std::string(enable ? "开启" : "关闭") + "跳过内容未变化的写入: " + std::string(data->name.c_str()));
+}
+
+bool SharedMemoryManager::setSkipUnchangedWrites(const std::string& name, bool enable) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	setSkipUnchangedWrites(data, enable);
+	return true;
+}
+
+// 共享数据的内容哈希
+uint64_t SharedMemoryManager::getContentHash(SharedData* data) {
+	if (!data) {
+		return 0;
+	}
+	return rebaseObject(data, DataSegment)->contentHash.load();
+}
+
+// 比较内容哈希，不复制共享数据
+bool SharedMemoryManager::isContentEqual(SharedData* data, const LocalData& localData) {
+	uint64_t hash = getContentHash(data);
+	if (hash == 0) {
+		return false;
+	}
+	LocalData sparseData;
+	return hash == SharedData::hashContent(sparseForWrite(rebaseObject(data, DataSegment), localData, sparseData));
+}
+
+// 设置各几何位置对应的行范围
+bool SharedMemoryManager::setDataRegions(SharedData* data, const std::vector<SharedDataRegion>& regions) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+		data->regions.assign(regions.begin(), regions.end());
+		noteSegmentWrite(DataSegment);
+
+		log(LogLevel::Info, "设置计算数据行范围: " + std::string(data->name.c_str()) + ", 几何位置数: " + std::to_string(regions.size()));
+		return true;
+	}
+	catch (const bip::bad_alloc&) {
+		log(LogLevel::Error, "内存空间不足，无法设置计算数据行范围: " + std::string(data->name.c_str()));
+		return false;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据行范围失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+bool SharedMemoryManager::setDataRegions(const std::string& name, const std::vector<SharedDataRegion>& regions) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataRegions(data, regions);
+}
+
+// 按 dimtag 读取子集
+bool SharedMemoryManager::getDataSubset(SharedData* data, const std::vector<std::pair<int, int>>& dimtags, LocalData& localData) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+
+		// 稀疏模式只保存非零行及其索引值，不保留稠密数据的行号，行范围无法换算为存储行
+		if (data->sparse.load()) {
+			log(LogLevel::Warning, "稀疏模式的计算数据不支持按几何位置读取子集，请按索引值读取: " + std::string(data->name.c_str()));
+			return false;
+		}
+
+		// 由行范围展开为行号
+		std::vector<size_t> rows;
+		for (const auto& dimtag : dimtags) {
+			auto region = std::find_if(data->regions.begin(), data->regions.end(), [&dimtag](const SharedDataRegion& r) {
+				return r.dim == dimtag.first && r.tag == dimtag.second;
+			});
+			if (region == data->regions.end()) {
+				log(LogLevel::Warning, "计算数据未设置几何位置的行范围: " + std::string(data->name.c_str()) +
+					", (" + std::to_string(dimtag.first) + ", " + std::to_string(dimtag.second) + ")");
+				return false;
+			}
+			for (uint64_t k = 0; k < region->count; ++k) {
+				rows.push_back(static_cast<size_t>(region->offset + k));
+			}
+		}
+
+		data->copyRowsToLocal(rows, localData);
+		localData.dimtags = dimtags;
+
+		log(LogLevel::Debug, "读取计算数据子集成功: " + localData.name + ", 行数: " + std::to_string(rows.size()));
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "读取计算数据子集失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+bool SharedMemoryManager::getDataSubset(const std::string& name, const std::vector<std::pair<int, int>>& dimtags, LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataSubset(data, dimtags, localData);
+}
+
+// 按索引值读取子集
+bool SharedMemoryManager::getDataSubset(SharedData* data, const std::vector<int>& ids, LocalData& localData) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+
+		// 索引列变化或未知时重建映射
+		IndexLookup& lookup = indexLookups_[data];
+		uint64_t indexHash = data->indexHash.load();
+		if (indexHash == 0 || lookup.indexHash != indexHash) {
+			const SharedMemoryVector<int>& index = data->currentIndex();
+			lookup.rows.clear();
+			lookup.rows.reserve(index.size());
+			for (size_t row = 0; row < index.size(); ++row) {
+				lookup.rows.emplace(index[row], row);
+			}
+			lookup.indexHash = indexHash;
+		}
+
+		// 稀疏模式下查不到的索引值是被省略的全零行，记录存在的行在输出中的位置，稍后补零
+		bool sparse = data->sparse.load();
+		std::vector<size_t> rows, targets;
+		rows.reserve(ids.size());
+		for (size_t i = 0; i < ids.size(); ++i) {
+			auto it = lookup.rows.find(ids[i]);
+			if (it != lookup.rows.end()) {
+				rows.push_back(it->second);
+				targets.push_back(i);
+			}
+		}
+
+		data->copyRowsToLocal(rows, localData);
+		if (sparse) {
+			localData.index = ids;
+			for (auto& component : localData.data) {
+				std::vector<double> dense(ids.size(), 0.0);
+				for (size_t k = 0; k < targets.size(); ++k) {
+					dense[targets[k]] = component[k];
+				}
+				component.swap(dense);
+			}
+		}
+
+		log(LogLevel::Debug, "读取计算数据子集成功: " + localData.name + ", 行数: " + std::to_string(rows.size()));
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "读取计算数据子集失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+bool SharedMemoryManager::getDataSubset(const std::string& name, const std::vector<int>& ids, LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataSubset(data, ids, localData);
+}
+
+// 设置稀疏模式
+void SharedMemoryManager::setDataSparse(SharedData* data, bool enable, double zeroTolerance) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return;
+	}
+
+	data = rebaseObject(data, DataSegment);
+	data->sparseTolerance.store(zeroTolerance);
+	data->sparse.store(enable);
+	log(LogLevel::Info, std::string(enable ? "开启" : "关闭") + "计算数据对象的稀疏模式: " + std::string(data->name.c_str()));
+}
+
+bool SharedMemoryManager::setDataSparse(const std::string& name, bool enable, double zeroTolerance) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	setDataSparse(data, enable, zeroTolerance);
+	return true;
+}
+
+// 读取并展开为稠密数据
+bool SharedMemoryManager::getDataDense(SharedData* data, const std::vector<int>& denseIndex, LocalData& localData) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		// 读到新对象中：localData 的版本号可能与共享对象相同，getData 会跳过复制
+		LocalData sparseData;
+		getData(data, sparseData);
+		sparseData.toDense(denseIndex, localData);
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "展开计算数据对象失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+bool SharedMemoryManager::getDataDense(const std::string& name, const std::vector<int>& denseIndex, LocalData& localData) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataDense(data, denseIndex, localData);
+}
+
+// 稀疏模式的对象去掉全零行
+const LocalData& SharedMemoryManager::sparseForWrite(SharedData* data, const LocalData& localData, LocalData& sparse) {
+	if (!data->sparse.load()) {
+		return localData;
+	}
+	localData.toSparse(sparse, data->sparseTolerance.load());
+	return sparse;
+}
+
+// 计算数据对象的名称
+std::string SharedMemoryManager::dataObjectName(SharedData* data) {
+	data = rebaseObject(data, DataSegment);
+	std::string name = data->name.c_str();
+	if (!name.empty()) {
+		return name;
+	}
+
+	// 尚未写入的对象没有名称，datas_ 与控制数据中的名称列表顺序一致
+	LocalControlData localCtrl;
+	getControlData(localCtrl);
+	for (size_t i = 0; i < datas_.size() && i < localCtrl.dataNames.size(); ++i) {
+		if (datas_[i] == data) {
+			return localCtrl.dataNames[i];
+		}
+	}
+	return name;
+}
+
+// 登记低分辨率副本
+bool SharedMemoryManager::setDataCoarsening(SharedData* data, SharedData* coarse, const DataCoarsening& coarsening, bool updateOnWrite) {
+	if (!data || !coarse || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+	return setDataCoarsening(dataObjectName(data), dataObjectName(coarse), coarsening, updateOnWrite);
+}
+
+bool SharedMemoryManager::setDataCoarsening(const std::string& name, const std::string& coarseName, const DataCoarsening& coarsening,
+	bool updateOnWrite) {
+	if (!findDataByName(name) || !findDataByName(coarseName)) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + (findDataByName(name) ? coarseName : name));
+		return false;
+	}
+	if (name == coarseName) {
+		log(LogLevel::Error, "低分辨率副本不能是计算数据对象本身: " + name);
+		return false;
+	}
+
+	// 副本链不能成环：从 coarseName 出发沿已登记的副本能回到 name 时拒绝
+	std::vector<std::string> pending(1, coarseName);
+	std::set<std::string> visited;
+	while (!pending.empty()) {
+		std::string current = pending.back();
+		pending.pop_back();
+		if (current == name) {
+			log(LogLevel::Error, "低分辨率副本不能形成循环: " + name + " -> " + coarseName);
+			return false;
+		}
+		auto found = coarseCompanions_.find(current);
+		if (!visited.insert(current).second || found == coarseCompanions_.end()) {
+			continue;
+		}
+		for (const auto& companion : found->second) {
+			pending.push_back(companion.coarseName);
+		}
+	}
+
+	// 分组的起止位置必须单调且覆盖全部成员
+	const auto& offsets = coarsening.offsets;
+	bool valid = offsets.size() == coarsening.coarseIndex.size() + 1 && offsets.front() == 0 &&
+		offsets.back() == coarsening.members.size();
+	for (size_t k = 1; valid && k < offsets.size(); ++k) {
+		valid = offsets[k - 1] <= offsets[k];
+	}
+	if (!valid) {
+		log(LogLevel::Error, "低分辨率副本的分组无效: " + coarseName);
+		return false;
+	}
+
+	CoarseCompanion companion;
+	companion.coarseName = coarseName;
+	companion.coarsening = coarsening;
+	companion.updateOnWrite = updateOnWrite;
+
+	auto& companions = coarseCompanions_[name];
+	auto it = std::find_if(companions.begin(), companions.end(),
+		[&](const CoarseCompanion& c) { return c.coarseName == coarseName; });
+	if (it != companions.end()) {
+		*it = std::move(companion);
+	}
+	else {
+		companions.push_back(std::move(companion));
+	}
+
+	log(LogLevel::Info, "登记低分辨率副本: " + name + " -> " + coarseName + ", " +
+		std::to_string(coarsening.coarseIndex.size()) + " 行");
+	return true;
+}
+
+void SharedMemoryManager::clearDataCoarsening(const std::string& name) {
+	coarseCompanions_.erase(name);
+}
+
+// 由精细数据生成并写入一个副本
+bool SharedMemoryManager::writeCoarseData(CoarseCompanion& companion, const LocalData& fine, uint64_t fineVersion, bool sparse) {
+	SharedData* coarse = findDataByName(companion.coarseName);
+	if (!coarse) {
+		log(LogLevel::Warning, "未找到低分辨率副本对象: " + companion.coarseName);
+		return false;
+	}
+
+	try {
+		// 没有索引列时成员即为行号
+		bool positional = fine.index.empty();
+		size_t rowCount = positional && !fine.data.empty() ? fine.data[0].size() : fine.index.size();
+		for (const auto& component : fine.data) {
+			rowCount = (std::min)(rowCount, component.size());
+		}
+
+		// 索引列变化时重新解析各成员在精细数据中的行号
+		uint64_t indexHash = DataKernels::hashBytes(fine.index.data(), positional ? 0 : rowCount * sizeof(int), rowCount) | 1;
+		const DataCoarsening& coarsening = companion.coarsening;
+		bool remapped = indexHash != companion.indexHash;
+		if (remapped) {
+			companion.rows.resize(coarsening.members.size());
+			if (positional) {
+				for (size_t i = 0; i < coarsening.members.size(); ++i) {
+					int member = coarsening.members[i];
+					companion.rows[i] = member >= 0 && static_cast<size_t>(member) < rowCount ? static_cast<size_t>(member) : static_cast<size_t>(-1);
+				}
+			} else {
+				std::unordered_map<int, size_t> rows;
+				rows.reserve(rowCount);
+				for (size_t i = 0; i < rowCount; ++i) {
+					rows.emplace(fine.index[i], i);
+				}
+				for (size_t i = 0; i < coarsening.members.size(); ++i) {
+					auto it = rows.find(coarsening.members[i]);
+					companion.rows[i] = it != rows.end() ? it->second : static_cast<size_t>(-1);
+				}
+			}
+			companion.indexHash = indexHash;
+		}
+
+		LocalData coarseData(companion.coarseName, fine.meshName);
+		coarseData.isFieldData = fine.isFieldData;
+		coarseData.type = fine.type;
+		coarseData.t = fine.t;
+		coarseData.sysTimeStamp = fine.sysTimeStamp;
+		coarseData.dimtags = fine.dimtags;
+		coarseData.titles = fine.titles;
+		coarseData.units = fine.units;
+		coarseData.index = coarsening.coarseIndex;
+		coarseData.data.resize(fine.data.size());
+		size_t emptyGroups = 0;
+		for (size_t c = 0; c < fine.data.size(); ++c) {
+			coarseData.data[c].resize(coarsening.coarseIndex.size());
+			emptyGroups = DataKernels::averageRows(fine.data[c].data(), coarsening.offsets.data(), companion.rows.data(),
+				coarsening.coarseIndex.size(), coarseData.data[c].data(), sparse);
+		}
+
+		// 成员是否存在只随索引列变化，重新解析时提示一次
+		if (remapped && emptyGroups > 0 && !sparse) {
+			log(LogLevel::Warning, "低分辨率副本中有 " + std::to_string(emptyGroups) + " 组的成员在精细数据中都不存在，按 0 写入: " +
+				companion.coarseName);
+		}
+
+		// 副本的版本号由共享对象递增，本地版本号只需与之不同。
+		// 直接写入副本对象，副本自身登记的副本由 refreshCoarseData 按其版本更新
+		coarseData.version = std::numeric_limits<uint64_t>::max();
+		updateDataObject(coarse, coarseData);
+		companion.refreshedVersion = fineVersion;
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "更新低分辨率副本失败: " + companion.coarseName + ", " + std::string(e.what()));
+		return false;
+	}
+}
+
+// 精细数据有新版本时重新生成低分辨率副本
+size_t SharedMemoryManager::refreshCoarseData() {
+	size_t refreshed = 0;
+	for (auto& entry : coarseCompanions_) {
+		SharedData* data = findDataByName(entry.first);
+		if (!data) {
+			continue;
+		}
+
+		uint64_t version = rebaseObject(data, DataSegment)->version.load();
+		bool stale = false;
+		for (const auto& companion : entry.second) {
+			stale = stale || companion.refreshedVersion != version;
+		}
+		if (!stale) {
+			continue;
+		}
+
+		LocalData fine;
+		getData(data, fine);
+		bool sparse = rebaseObject(data, DataSegment)->sparse.load();
+		for (auto& companion : entry.second) {
+			if (companion.refreshedVersion != fine.version && writeCoarseData(companion, fine, fine.version, sparse)) {
+				++refreshed;
+			}
+		}
+	}
+	return refreshed;
+}
+
+// 启动后台更新线程
+bool SharedMemoryManager::startCoarseRefresh(int intervalMs) {
+	stopCoarseRefresh();
+
+	try {
+		auto refresher = std::make_unique<SharedMemoryManager>(memoryName_, false, prefix_);
+		refresher->LoadExistingDataObjects();
+		size_t count = 0;
+		for (const auto& entry : coarseCompanions_) {
+			for (const auto& companion : entry.second) {
+				if (!companion.updateOnWrite) {
+					refresher->coarseCompanions_[entry.first].push_back(companion);
+					++count;
+				}
+			}
+		}
+		if (count == 0) {
+			log(LogLevel::Warning, "没有需要后台更新的低分辨率副本");
+			return false;
+		}
+		coarseRefresher_ = std::move(refresher);
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "启动低分辨率副本的后台更新失败: " + std::string(e.what()));
+		return false;
+	}
+
+	coarseThreadStop_ = false;
+	SharedMemoryManager* refresher = coarseRefresher_.get();
+	coarseThread_ = std::thread([this, refresher, intervalMs]() {
+		std::unique_lock<std::mutex> lock(coarseThreadMutex_);
+		while (!coarseThreadStop_) {
+			lock.unlock();
+			try {
+				refresher->refreshCoarseData();
+			}
+			catch (const std::exception& e) {
+				refresher->log(LogLevel::Error, "后台更新低分辨率副本失败: " + std::string(e.what()));
+			}
+			lock.lock();
+			coarseThreadWake_.wait_for(lock, std::chrono::milliseconds(intervalMs), [this]() { return coarseThreadStop_; });
+		}
+	});
+
+	log(LogLevel::Info, "启动低分辨率副本的后台更新，间隔 " + std::to_string(intervalMs) + " 毫秒");
+	return true;
+}
+
+void SharedMemoryManager::stopCoarseRefresh() {
+	if (coarseThread_.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(coarseThreadMutex_);
+			coarseThreadStop_ = true;
+		}
+		coarseThreadWake_.notify_all();
+		coarseThread_.join();
+	}
+	coarseRefresher_.reset();
+}
+
+// 读取写入时统计的各分量统计量
+bool SharedMemoryManager::getDataStats(SharedData* data, SharedFieldStats& stats, uint64_t* version) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+
+	SegmentReadScope scope(this, DataSegment);
+	data = rebaseObject(data, DataSegment);
+	uint64_t statsVersion = 0;
+	bool copied = false;
+
+	// 统计量只有几百个字节，先按顺序锁不加锁读取，与写入冲突过多时再加锁
+	for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES && !copied; ++attempt) {
+		uint64_t seq = data->readBegin();
+		if (seq & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+		stats = data->stats;
+		statsVersion = data->version.load();
+		copied = data->readValidate(seq);
+	}
+	if (!copied) {
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex, bip::defer_lock);
+		lockObject(lock, data);
+		stats = data->stats;
+		statsVersion = data->version.load();
+	}
+
+	if (version) {
+		*version = statsVersion;
+	}
+	return stats.componentCount > 0;
+}
+
+bool SharedMemoryManager::getDataStats(const std::string& name, SharedFieldStats& stats, uint64_t* version) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataStats(data, stats, version);
+}
+
+// 按最慢读取方的游标设置多版本保留的回收下限
+void SharedMemoryManager::updateRetentionFloor(SharedData* data) {
+	if (!data->versions) {
+		return;
+	}
+
+	// 没有登记的读取方时只保留最新的 depth 个版本
+	if (!controlData_ || controlData_->readerMask.load() == 0) {
+		data->versions->collectBelow.store(std::numeric_limits<uint64_t>::max());
+		return;
+	}
+
+	// 每个读取方都还能读到自己最近读取的版本及之前的 depth - 1 个版本
+	uint64_t slowest = slowestReaderVersion(data);
+	uint64_t lookback = data->versions->depth - 1;
+	data->versions->collectBelow.store(slowest > lookback ? slowest - lookback : 0);
+}
+
+// 设置计算数据对象的历史帧容量
+bool SharedMemoryManager::setDataHistory(SharedData* data, uint32_t capacity) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		data->history.setCapacity(capacity);
+
+		log(LogLevel::Info, "设置计算数据对象历史帧数: " + std::string(data->name.c_str()) +
+			", 帧数: " + std::to_string(capacity));
+		return true;
+	}
+	catch (const bip::bad_alloc&) {
+		log(LogLevel::Warning, "计算数据内存段空间不足，无法调整历史帧数: " + std::string(data->name.c_str()));
+		return false;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置计算数据对象历史帧数失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::setDataHistory(const std::string& name, uint32_t capacity) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return setDataHistory(data, capacity);
+}
+
+// 追加一帧历史数据
+bool SharedMemoryManager::appendDataFrame(SharedData* data, double t, const std::vector<std::vector<double>>& components) {
+	if (!data || !dataSegment_) {
+		log(LogLevel::Error, "计算数据对象或内存段未初始化");
+		return false;
+	}
+
+	try {
+		SegmentWriteScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		if (data->history.capacity == 0) {
+			log(LogLevel::Warning, "计算数据对象未启用历史帧: " + std::string(data->name.c_str()));
+			return false;
+		}
+
+		// 第一次追加或帧的形状改变时才分配空间，先检查剩余内存是否足够
+		bool allocating = data->history.needsAllocation(components);
+		if (allocating) {
+			size_t rows = components.empty() ? 0 : components[0].size();
+			size_t requiredSize = static_cast<size_t>(data->history.capacity) *
+				(components.size() * rows + 1) * sizeof(double);
+			auto usage = getDataMemoryUsage();
+			if (usage.first - usage.second < requiredSize) {
+				std::stringstream msg;
+				msg << "计算数据内存段空间不足，历史帧需要 " << requiredSize << " 字节，"
+					<< "可用 " << (usage.first - usage.second) << " 字节";
+				setException(EMP::EXCEPT_DATAPROCESS, 3, msg.str());
+
+				// 登记含历史帧的对象大小，扩容时按此重建内存段
+				recordDataMemorySize(std::string(data->name.c_str()),
+					SharedMemoryPlanner::namedObjectBytes(DataSegment, std::string(data->name.c_str()) + SharedMemorySuffix::DATA) +
+					SharedMemoryPlanner::payloadBytes(*data) + requiredSize);
+
+				log(LogLevel::Warning, "计算数据内存段空间不足，无法分配历史帧: " + std::string(data->name.c_str()));
+				return false;
+			}
+		}
+
+		if (!data->history.append(t, components)) {
+			log(LogLevel::Warning, "追加历史帧失败，时刻须晚于最新帧且各分量长度一致: " + std::string(data->name.c_str()));
+			return false;
+		}
+
+		if (allocating) {
+			noteSegmentWrite(DataSegment);
+			placeDataNearWriter(data);
+		}
+
+		log(LogLevel::Debug, "追加历史帧成功: " + std::string(data->name.c_str()) + ", t = " + std::to_string(t));
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "追加历史帧失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::appendDataFrame(const std::string& name, double t, const std::vector<std::vector<double>>& components) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return appendDataFrame(data, t, components);
+}
+
+// 当前保存的历史帧数
+size_t SharedMemoryManager::getDataFrameCount(SharedData* data) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return 0;
+	}
+
+	SegmentReadScope scope(this, DataSegment);
+	data = rebaseObject(data, DataSegment);
+	bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+	return data->history.size();
+}
+
+size_t SharedMemoryManager::getDataFrameCount(const std::string& name) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return 0;
+	}
+	return getDataFrameCount(data);
+}
+
+// 读取第 k 帧历史数据
+bool SharedMemoryManager::getDataFrame(SharedData* data, int k, double& t, std::vector<std::vector<double>>& components) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		return data->history.frame(k, t, components);
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "读取历史帧失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::getDataFrame(const std::string& name, int k, double& t, std::vector<std::vector<double>>& components) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataFrame(data, k, t, components);
+}
+
+// 读取时刻 t 的历史数据
+bool SharedMemoryManager::getDataAtTime(SharedData* data, double t, std::vector<std::vector<double>>& components, bool extrapolate) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return false;
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		data = rebaseObject(data, DataSegment);
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		return data->history.atTime(t, components, extrapolate);
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "读取历史数据失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+bool SharedMemoryManager::getDataAtTime(const std::string& name, double t, std::vector<std::vector<double>>& components, bool extrapolate) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	return getDataAtTime(data, t, components, extrapolate);
+}
+
+// 获取计算数据对象的零拷贝只读视图
+SharedDataView SharedMemoryManager::getDataView(SharedData* data) {
+	if (!data) {
+		log(LogLevel::Error, "计算数据对象未初始化");
+		return SharedDataView();
+	}
+
+	try {
+		SegmentReadScope scope(this, DataSegment);
+		// 指针可能来自内存段扩容前的映射
+		data = rebaseObject(data, DataSegment);
+		if (data->precision != Float64Precision) {
+			log(LogLevel::Error, "降低精度存储的计算数据对象不支持零拷贝视图: " + std::string(data->name.c_str()));
+			return SharedDataView();
+		}
+
+		// 视图持有当前映射的引用，映射退役后保留到视图释放
+		SharedDataView view(data, dataSegment_, currentProcessId());
+		noteConsumed(data, view.getVersion());
+		log(LogLevel::Debug, "获取计算数据视图成功: " + std::string(data->name.c_str()) +
+			", 版本: " + std::to_string(view.getVersion()));
+		return view;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "获取计算数据视图失败: " + std::string(e.what()));
+		throw;
+	}
+}
+
+SharedDataView SharedMemoryManager::getDataView(const std::string& name) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return SharedDataView();
+	}
+	return getDataView(data);
+}
+
+void SharedMemoryManager::setViewReleaseTimeout(int timeoutMs) {
+	viewReleaseTimeoutMs_ = timeoutMs;
+}
+
+// 等待对象上的所有只读视图释放
+bool SharedMemoryManager::waitForViewsReleased(SharedDataBase* obj) {
+	if (!obj || obj->viewPins.load() == 0) {
+		return true;
+	}
+
+	// 调用方持有对象锁，回收时不再加锁
+	log(LogLevel::Debug, "等待只读视图释放: " + std::string(obj->name.c_str()));
+	return waitForViewRelease(obj,
+		[obj] { return obj->viewPins.load() == 0; },
+		[this, obj] { recoverViewPins(obj); });
+}
+
+// 等待多缓冲对象出现可写入的后台槽
+bool SharedMemoryManager::waitForWriteSlot(SharedData* data, int* slot) {
+	// 每次检查只短暂加锁，等待期间读取方可以继续固定和释放槽
+	auto ready = [data, slot] {
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		if (slot) {
+			*slot = data->acquireWriteSlot();
+			return *slot >= 0;
+		}
+		return data->hasWriteSlot();
+	};
+	if (ready()) {
+		return true;
+	}
+
+	log(LogLevel::Debug, "等待后台槽释放: " + std::string(data->name.c_str()));
+	return waitForViewRelease(data, ready, [this, data] {
+		bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+		recoverViewPins(data);
+	});
+}
+
+// 分段等待固定计数释放
+bool SharedMemoryManager::waitForViewRelease(SharedDataBase* obj, const std::function<bool()>& released,
+	const std::function<void()>& recover) {
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		// 分段等待，每段结束时回收已退出进程的计数，持有方异常退出时不会一直等待
+		int sliceMs = VIEW_RECOVER_INTERVAL_MS;
+		if (viewReleaseTimeoutMs_ >= 0) {
+			auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+			sliceMs = static_cast<int>((std::min)(static_cast<long long>(sliceMs), (std::max)(0LL, static_cast<long long>(viewReleaseTimeoutMs_ - elapsedMs))));
+		}
+		if (waitUntil(obj, released, sliceMs)) {
+			return true;
+		}
+
+		recover();
+		if (released()) {
+			return true;
+		}
+		if (viewReleaseTimeoutMs_ >= 0 && std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(viewReleaseTimeoutMs_)) {
+			log(LogLevel::Warning, "只读视图未在 " + std::to_string(viewReleaseTimeoutMs_) + " 毫秒内释放: " + std::string(obj->name.c_str()));
+			return false;
+		}
+	}
+}
+
+// 回收已退出进程遗留的视图和槽固定计数
+void SharedMemoryManager::recoverViewPins(SharedDataBase* obj) {
+	for (uint32_t i = 0; i < SharedDataBase::MAX_VIEW_HOLDERS; ++i) {
+		if (obj->viewHolderPins[i].load() == 0 || processAlive(obj->viewHolderPids[i].load())) {
+			continue;
+		}
+
+		// 持有方已退出，不会再释放这些计数；新的固定在锁内登记，不会同时占用该项
+		uint32_t pins = obj->viewHolderPins[i].exchange(0);
+		int32_t slot = obj->viewHolderSlots[i].load();
+		if (slot >= 0 && slot < static_cast<int32_t>(SharedData::MAX_SLOTS)) {
+			// 只有计算数据对象有槽，登记了槽的对象必为 SharedData
+			static_cast<SharedData*>(obj)->slots[slot].readers.fetch_sub(pins);
+		} else {
+			obj->viewPins.fetch_sub(pins);
+		}
+		log(LogLevel::Warning, "回收已退出进程 " + std::to_string(obj->viewHolderPids[i].load()) + " 遗留的 " +
+			std::to_string(pins) + " 个只读视图: " + std::string(obj->name.c_str()));
+	}
+}
+
+// 按对象的等待策略加锁
+void SharedMemoryManager::lockObject(bip::scoped_lock<bip::interprocess_mutex>& lock, const SharedDataBase* obj) {
+	// 没有竞争时直接返回，只统计确实发生的等待
+	if (lock.try_lock()) {
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	if (!obj->spinWait([&lock] { return lock.try_lock(); })) {
+		lock.lock();
+	}
+	obj->recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count());
+}
+
+// 设置对象上的等待策略
+void SharedMemoryManager::setWaitPolicy(SharedDataBase* obj, const WaitPolicy& policy) {
+	if (!obj) {
+		log(LogLevel::Error, "共享对象未初始化");
+		return;
+	}
+
+	ObjectReadScope scope(this, obj);
+	obj->setWaitPolicy(policy);
+	log(LogLevel::Info, "设置等待策略: " + std::string(obj->name.c_str()) +
+		", 自旋: " + std::to_string(policy.spinMicros) + " us, 让出: " + std::to_string(policy.yieldMicros) +
+		" us" + (policy.adaptive ? ", 自适应" : ""));
+}
+
+bool SharedMemoryManager::setWaitPolicy(const std::string& name, const WaitPolicy& policy) {
+	SharedData* data = findDataByName(name);
+	if (!data) {
+		log(LogLevel::Warning, "未找到计算数据对象: " + name);
+		return false;
+	}
+	setWaitPolicy(data, policy);
+	return true;
+}
+
+WaitPolicy SharedMemoryManager::getWaitPolicy(SharedDataBase* obj) {
+	if (!obj) {
+		return WaitPolicy();
+	}
+	ObjectReadScope scope(this, obj);
+	return obj->getWaitPolicy();
+}
+
+uint32_t SharedMemoryManager::getAverageWaitMicros(SharedDataBase* obj) {
+	if (!obj) {
+		return 0;
+	}
+	ObjectReadScope scope(this, obj);
+	return obj->waitAverageMicros.load();
+}
+
+// 内存段的引用
+std::shared_ptr<SharedSegment>& SharedMemoryManager::segmentRef(SegmentId id) {
+	switch (id) {
+	case GeometrySegment:
+		return geometrySegment_;
+	case MeshSegment:
+		return meshSegment_;
+	case DataSegment:
+		return dataSegment_;
+	default:
+		return definitionSegment_;
+	}
+}
+
+// 按构造时指定的页大小创建内存段
+std::shared_ptr<SharedSegment> SharedMemoryManager::createSegment(SegmentId id, const std::string& name, size_t size) {
+	size_t pageSize = segmentPageSizes_[id];
+	std::string directory = persistentDirectory(id);
+	std::shared_ptr<SharedSegment> segment;
+	if (!directory.empty()) {
+		// 持久化的内存段为普通文件，另外留出校验记录的空间，记录在提交前保持未提交状态
+		segment = std::make_shared<SharedSegment>(bip::create_only, name.c_str(), size + PERSISTENT_RECORD_RESERVE, directory);
+		SharedSegmentRecord* record = segment->construct<SharedSegmentRecord>(SharedSegmentRecord::NAME)();
+		record->layout = segmentLayoutSignature();
+		log(LogLevel::Info, "创建持久化内存段: " + directory + "/" + name);
+	}
+	else {
+		segment = std::make_shared<SharedSegment>(bip::create_only, name.c_str(), size, pageSize);
+	}
+
+	// 记录实际的后备存储，其他进程只按记录打开，不会误用遗留的同名文件
+	controlData_->segmentHugePageSizes[id].store(segment->isHugePage() ? segment->getPageSize() : 0);
+
+	if (pageSize > SharedSegment::defaultPageSize() && segment->getPageSize() != pageSize) {
+		log(LogLevel::Warning, "内存段 " + name + " 未能使用 " + std::to_string(pageSize) +
+			" 字节大页，已回退到 " + std::to_string(segment->getPageSize()) + " 字节页");
+	}
+	else if (segment->isHugePage()) {
+		log(LogLevel::Info, "内存段 " + name + " 使用 " + std::to_string(segment->getPageSize()) + " 字节大页");
+	}
+
+	// 重建的内存段沿用控制数据中记录的 NUMA 策略
+	if (getSegmentNumaPolicy(id) != NumaDefault) {
+		applySegmentNumaPolicy(id, *segment);
+	}
+	return segment;
+}
+
+// 打开内存段，持久化的内存段打开其目录下的文件
+std::shared_ptr<SharedSegment> SharedMemoryManager::openSegment(SegmentId id, const std::string& name) {
+	std::string directory = persistentDirectory(id);
+	if (!directory.empty()) {
+		return std::make_shared<SharedSegment>(bip::open_only, name.c_str(), directory);
+	}
+	return std::make_shared<SharedSegment>(bip::open_only, name.c_str(), static_cast<size_t>(controlData_->segmentHugePageSizes[id].load()));
+}
+
+// 删除内存段，持久化的内存段删除其文件
+void SharedMemoryManager::removeSegment(SegmentId id, const std::string& name) {
+	SharedSegment::remove(name.c_str(), persistentDirectory(id));
+}
+
+// 内存段的名称
+std::string SharedMemoryManager::segmentName(SegmentId id) {
+	switch (id) {
+	case GeometrySegment:
+		return GenerateSegmentName(SharedMemorySuffix::GEOMETRY_SEGMENT);
+	case MeshSegment:
+		return GenerateSegmentName(SharedMemorySuffix::MESH_SEGMENT);
+	case DataSegment:
+		return GenerateSegmentName(SharedMemorySuffix::DATA_SEGMENT);
+	default:
+		return GenerateSegmentName(SharedMemorySuffix::DEFINITION_SEGMENT);
+	}
+}
+
+// 重新加载内存段中的对象指针
+void SharedMemoryManager::reloadSegmentObjects(SegmentId id) {
+	switch (id) {
+	case GeometrySegment:
+		LoadExistingGeometryObjects();
+		break;
+	case MeshSegment:
+		LoadExistingMeshObjects();
+		break;
+	case DataSegment:
+		LoadExistingDataObjects();
+		break;
+	default:
+		LoadExistingDefinitionObjects();
+		break;
+	}
+}
+
+// 将当前映射移入旧映射列表
+void SharedMemoryManager::retireSegment(SegmentId id) {
+	std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+	if (!segment) {
+		return;
+	}
+
+	RetiredSegment retired;
+	retired.segment = segment;
+	retired.base = static_cast<const char*>(segment->get_address());
+	retired.size = segment->get_size();
+	for (auto it = segment->named_begin(); it != segment->named_end(); ++it) {
+		retired.names.emplace(it->value(), it->name());
+	}
+	retiredSegments_[id].push_back(std::move(retired));
+	segment.reset();
+	handleCache_[id].clear();
+	if (id == DataSegment) {
+		numaPlacements_.clear();
+	}
+	segmentRecords_[id] = nullptr;
+}
+
+// 释放不再使用的旧映射
+void SharedMemoryManager::releaseRetiredSegments(SegmentId id) {
+	// 本管理器还有读写进行中时，其中的指针可能仍指向旧映射
+	if (localAccesses_[id].load() != 0) {
+		return;
+	}
+
+	// 只读视图持有所在映射的引用，视图全部释放后才解除映射
+	for (auto& retired : retiredSegments_[id]) {
+		if (retired.segment && retired.segment.use_count() == 1) {
+			void* address = retired.segment->mappedAddress();
+			size_t bytes = retired.segment->mappedSize();
+			retired.segment.reset();
+			if (SharedSegment::reserveAddressRange(address, bytes)) {
+				retired.reservedBase = address;
+				retired.reservedSize = bytes;
+			}
+		}
+	}
+}
+
+// 在访问登记表中占用一项
+void SharedMemoryManager::claimSegmentUser() {
+	if (!controlData_ || segmentUserSlot_ >= 0) {
+		return;
+	}
+
+	int64_t pid = currentProcessId();
+	for (uint32_t i = 0; i < SharedControlData::MAX_SEGMENT_USERS; ++i) {
+		int64_t owner = controlData_->segmentUserPids[i].load();
+		if (owner != 0 && processAlive(owner)) {
+			continue;
+		}
+
+		// 空项或已退出进程留下的项：先占用再清除遗留的计数
+		if (controlData_->segmentUserPids[i].compare_exchange_strong(owner, pid)) {
+			for (int j = 0; j < SegmentCount; ++j) {
+				controlData_->segmentUserAccesses[i][j].store(0);
+			}
+			segmentUserSlot_ = static_cast<int>(i);
+			return;
+		}
+	}
+	log(LogLevel::Warning, "内存段访问登记表已满，本管理器退出时遗留的计数无法被识别");
+}
+
+// 释放访问登记表中的项
+void SharedMemoryManager::releaseSegmentUser() {
+	if (!controlData_ || segmentUserSlot_ < 0) {
+		return;
+	}
+	for (int j = 0; j < SegmentCount; ++j) {
+		controlData_->segmentUserAccesses[segmentUserSlot_][j].store(0);
+	}
+	controlData_->segmentUserPids[segmentUserSlot_].store(0);
+	segmentUserSlot_ = -1;
+}
+
+// 开始扩容或重建内存段：置扩容标志后等待各进程离开该段
+bool SharedMemoryManager::beginSegmentResize(SegmentId id) {
+	if (!controlData_) {
+		return true;
+	}
+
+	// 上一次扩容尚未结束(或其扩容方已退出)时先等待
+	waitForSegmentResize(id);
+	controlData_->segmentGrowOwners[id].store(currentProcessId());
+	controlData_->segmentGrowing[id].store(true);
+	resizingSegment_[id] = true;
+
+	// 仍在段内的访问数，已退出进程的登记项不计
+	auto activeAccesses = [this, id] {
+		uint64_t active = controlData_->segmentAccesses[id].load();
+		for (uint32_t i = 0; i < SharedControlData::MAX_SEGMENT_USERS; ++i) {
+			uint32_t count = controlData_->segmentUserAccesses[i][id].load();
+			if (count != 0 && processAlive(controlData_->segmentUserPids[i].load())) {
+				active += count;
+			}
+		}
+		return active;
+	};
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SEGMENT_RESIZE_TIMEOUT_MS);
+	while (activeAccesses() != 0) {
+		if (std::chrono::steady_clock::now() >= deadline) {
+			resizingSegment_[id] = false;
+			controlData_->segmentGrowing[id].store(false);
+			controlData_->segmentGrowOwners[id].store(0);
+			log(LogLevel::Warning, "等待各进程离开内存段超时: " + segmentName(id));
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+// 结束扩容或重建内存段：映射发生变化时递增段纪元，再放行读写方
+void SharedMemoryManager::endSegmentResize(SegmentId id, bool changed) {
+	if (!controlData_) {
+		return;
+	}
+
+	if (changed) {
+		segmentEpochs_[id] = controlData_->segmentEpochs[id].fetch_add(1) + 1;
+	}
+	resizingSegment_[id] = false;
+	controlData_->segmentGrowOwners[id].store(0);
+	controlData_->segmentGrowing[id].store(false);
+}
+
+// 等待其他进程的扩容结束
+void SharedMemoryManager::waitForSegmentResize(SegmentId id) {
+	auto start = std::chrono::steady_clock::now();
+	bool warned = false;
+	while (controlData_->segmentGrowing[id].load()) {
+		// 扩容方在扩容途中退出时清除其标志，内存段按其退出前的状态继续使用
+		if (!processAlive(controlData_->segmentGrowOwners[id].load())) {
+			bool growing = true;
+			if (controlData_->segmentGrowing[id].compare_exchange_strong(growing, false)) {
+				log(LogLevel::Warning, "扩容方已退出，清除内存段的扩容标志: " + segmentName(id));
+			}
+			break;
+		}
+		if (!warned && std::chrono::steady_clock::now() - start > std::chrono::milliseconds(SEGMENT_RESIZE_TIMEOUT_MS)) {
+			log(LogLevel::Warning, "等待内存段扩容的时间过长: " + segmentName(id));
+			warned = true;
+		}
+		std::this_thread::yield();
+	}
+}
+
+// 读写方进入内存段
+void SharedMemoryManager::enterSegmentAccess(SegmentId id) {
+	if (!controlData_) {
+		return;
+	}
+
+	localAccesses_[id].fetch_add(1);
+	int& depth = threadSegmentDepth[std::make_pair(static_cast<const void*>(this), static_cast<int>(id))];
+	std::atomic<uint32_t>& count = segmentUserSlot_ >= 0 ?
+		controlData_->segmentUserAccesses[segmentUserSlot_][id] : controlData_->segmentAccesses[id];
+
+	// 先登记再检查扩容标志，避免与 beginSegmentResize 交错时漏掉对方。
+	// 本管理器自己在扩容、或本线程已在段内时直接进入
+	while (true) {
+		bool bypass = resizingSegment_[id] || depth > 0;
+		if (!bypass) {
+			waitForSegmentResize(id);
+		}
+		count.fetch_add(1);
+		if (bypass || !controlData_->segmentGrowing[id].load()) {
+			break;
+		}
+		count.fetch_sub(1);
+	}
+	++depth;
+
+	refreshSegment(id);
+}
+
+// 读写方离开内存段
+void SharedMemoryManager::leaveSegmentAccess(SegmentId id) {
+	if (!controlData_) {
+		return;
+	}
+
+	std::atomic<uint32_t>& count = segmentUserSlot_ >= 0 ?
+		controlData_->segmentUserAccesses[segmentUserSlot_][id] : controlData_->segmentAccesses[id];
+	count.fetch_sub(1);
+	--threadSegmentDepth[std::make_pair(static_cast<const void*>(this), static_cast<int>(id))];
+
+	// 本管理器的读写全部结束后释放不再使用的旧映射
+	if (localAccesses_[id].fetch_sub(1) == 1 && !retiredSegments_[id].empty()) {
+		releaseRetiredSegments(id);
+	}
+}
+
+// 写入方进入内存段
+void SharedMemoryManager::enterSegmentWrite(SegmentId id) {
+	enterSegmentAccess(id);
+	if (!controlData_) {
+		return;
+	}
+
+	// 提交后的写入使持久化内存段的提交失效，直到 creator 再次提交
+	if (SharedSegmentRecord* record = segmentRecord(id)) {
+		if (record->committed.load() != 0) {
+			record->committed.store(0);
+		}
+	}
+}
+
+// 写入方离开内存段
+void SharedMemoryManager::leaveSegmentWrite(SegmentId id) {
+	leaveSegmentAccess(id);
+}
+
+// 原地扩容内存段
+bool SharedMemoryManager::growSegment(SegmentId id, size_t newSize) {
+	if (!isCreator_) {
+		log(LogLevel::Error, "非Creator无法扩容共享内存段");
+		return false;
+	}
+
+	std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+	if (!segment || !controlData_) {
+		log(LogLevel::Error, "内存段或控制数据对象未初始化");
+		return false;
+	}
+
+	size_t oldSize = segment->get_size();
+	if (newSize <= oldSize) {
+		return true;
+	}
+
+	std::string name = segmentName(id);
+	if (!beginSegmentResize(id)) {
+		log(LogLevel::Warning, "内存段仍在使用，放弃原地扩容: " + name);
+		return false;
+	}
+
+	bool grown = false;
+	try {
+		// 离线扩容：各进程已停止访问该段，本进程先解除自己的映射(被只读视图引用的旧映射保留到视图释放)，
+		// 再扩展底层对象并在尾部追加空闲块，最后重新映射；已有对象不移动
+		retireSegment(id);
+		releaseRetiredSegments(id);
+		grown = SharedSegment::grow(name.c_str(), newSize - oldSize, persistentDirectory(id),
+			static_cast<size_t>(controlData_->segmentHugePageSizes[id].load()));
+		reloadSegmentObjects(id);
+
+		// 扩展出的部分沿用 NUMA 策略
+		if (grown && segmentRef(id) && getSegmentNumaPolicy(id) != NumaDefault) {
+			applySegmentNumaPolicy(id, *segmentRef(id));
+		}
+
+		// 扩容失败时本进程重新映射的仍是原来的段，其他进程的映射不受影响
+		endSegmentResize(id, grown || !segmentRef(id));
+		if (!grown) {
+			log(LogLevel::Warning, "原地扩容内存段失败: " + name);
+			return false;
+		}
+
+		log(LogLevel::Info, "原地扩容内存段: " + name + ", " + std::to_string(oldSize) +
+			" -> " + std::to_string(newSize) + " 字节, 纪元: " + std::to_string(segmentEpochs_[id]));
+		return segmentRef(id) != nullptr;
+	}
+	catch (const std::exception& e) {
+		endSegmentResize(id, grown || !segmentRef(id));
+		log(LogLevel::Warning, "原地扩容内存段失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+// 段纪元变化时重新映射内存段
+void SharedMemoryManager::refreshSegment(SegmentId id) {
+	if (!controlData_) {
+		return;
+	}
+
+	uint64_t epoch = controlData_->segmentEpochs[id].load();
+	if (epoch == segmentEpochs_[id]) {
+		return;
+	}
+
+	// 扩容进行中时等待完成，纪元在扩容结束前递增；本管理器自己在扩容时不等待
+	if (!resizingSegment_[id]) {
+		waitForSegmentResize(id);
+	}
+
+	segmentEpochs_[id] = controlData_->segmentEpochs[id].load();
+	retireSegment(id);
+	reloadSegmentObjects(id);
+
+	log(LogLevel::Info, "内存段已重新映射: " + segmentName(id) + ", 纪元: " + std::to_string(segmentEpochs_[id]));
+}
+
+// 设置异常信息
+void SharedMemoryManager::setException(int type, int code, const std::string& message) {
+	if (!controlData_) {
+		log(LogLevel::Error, "控制数据对象未初始化");
+		return;
+	}
+
+	try {
+		// 获取控制数据段的分配器
+		SharedMemoryAllocator<char> allocator = getAllocator<char>();
+
+		// 设置异常信息
+		controlData_->exception.hasException.store(true);
+		controlData_->exception.exceptionType.store(type);
+		controlData_->exception.exceptionCode.store(code);
+		controlData_->exception.exceptionMessage = SharedMemoryString(message.c_str(), allocator);
+
+		log(LogLevel::Warning, "设置异常信息: 类型=" + std::to_string(type) +
+							 ", 代码=" + std::to_string(code) +
+							 ", 消息=" + message);
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "设置异常信息失败: " + std::string(e.what()));
+	}
+}
+
+// 检查是否有异常
+bool SharedMemoryManager::hasException() const {
+	if (!controlData_) {
+		return false;
+	}
+	return controlData_->exception.hasException.load();
+}
+
+// 获取异常详情并清除异常标志
+std::tuple<int, int, std::string> SharedMemoryManager::getAndClearException() {
+	if (!controlData_ || !controlData_->exception.hasException.load()) {
+		return std::make_tuple(0, 0, "");
+	}
+
+	// 获取异常信息
+	int type = controlData_->exception.exceptionType.load();
+	int code = controlData_->exception.exceptionCode.load();
+	std::string message = controlData_->exception.exceptionMessage.c_str();
+
+	// 清除异常标志
+	controlData_->exception.hasException.store(false);
+	controlData_->exception.exceptionType.store(0);
+	controlData_->exception.exceptionCode.store(0);
+
+	// 获取控制数据段的分配器并清空异常消息
+	SharedMemoryAllocator<char> allocator = getAllocator<char>();
+	controlData_->exception.exceptionMessage = SharedMemoryString("", allocator);
 
 	log(LogLevel::Info, "获取并清除异常信息: 类型=" + std::to_string(type) +
 					   ", 代码=" + std::to_string(code) +
@@ -940,43 +3699,470 @@ void SharedMemoryManager::updateMemorySegmentInfo() {
 	}
 
 	try {
+		// 先统计各内存段使用情况，再锁定控制数据写入
+		auto controlUsage = getControlMemoryUsage();
+		auto geoUsage = getGeometryMemoryUsage();
+		auto meshUsage = getMeshMemoryUsage();
+		auto dataUsage = getDataMemoryUsage();
+		auto defUsage = getDefinitionMemoryUsage();
+
 		// 锁定控制数据
 		bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
+		controlData_->beginWrite();
 
 		// 更新控制数据段信息
-		auto controlUsage = getControlMemoryUsage();
 		controlData_->controlSegmentTotalSize = controlUsage.first;
 		controlData_->controlSegmentFreeSize = controlUsage.first - controlUsage.second;
 
-		// 更新几何数据段信息
-		auto geoUsage = getGeometryMemoryUsage();
-		controlData_->geometrySegmentTotalSize = geoUsage.first;
-		controlData_->geometrySegmentFreeSize = geoUsage.first - geoUsage.second;
+		// 更新几何数据段信息
+		controlData_->geometrySegmentTotalSize = geoUsage.first;
+		controlData_->geometrySegmentFreeSize = geoUsage.first - geoUsage.second;
+
+		// 更新网格数据段信息
+		controlData_->meshSegmentTotalSize = meshUsage.first;
+		controlData_->meshSegmentFreeSize = meshUsage.first - meshUsage.second;
+
+		// 更新计算数据段信息
+		controlData_->dataSegmentTotalSize = dataUsage.first;
+		controlData_->dataSegmentFreeSize = dataUsage.first - dataUsage.second;
+
+		// 更新模型参数数据段信息
+		controlData_->definitionSegmentTotalSize = defUsage.first;
+		controlData_->definitionSegmentFreeSize = defUsage.first - defUsage.second;
+		controlData_->endWrite();
+		lock.unlock();
+
+		// 记录本次发布时的写入计数，并推迟下一次定时发布
+		publishedWriteTotal_ = totalSegmentWrites();
+		nextStatsPublish_ = std::chrono::steady_clock::now() + statsInterval_;
+
+		log(LogLevel::Debug, "更新共享内存段大小信息成功");
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "更新共享内存段大小信息失败: " + std::string(e.what()));
+	}
+}
+
+// 获取单个内存段的使用统计，直接读取内存段头部，不访问控制数据
+SharedMemoryManager::SegmentStats SharedMemoryManager::getSegmentStats(SegmentId id) const {
+	SegmentStats stats;
+	if (id < 0 || id >= SegmentCount) {
+		return stats;
+	}
+
+	std::pair<size_t, size_t> usage;
+	switch (id) {
+	case GeometrySegment: usage = getGeometryMemoryUsage(); break;
+	case MeshSegment: usage = getMeshMemoryUsage(); break;
+	case DataSegment: usage = getDataMemoryUsage(); break;
+	default: usage = getDefinitionMemoryUsage(); break;
+	}
+
+	stats.totalSize = usage.first;
+	stats.freeSize = usage.first - usage.second;
+	stats.writeCount = segmentWriteCounts_[id].load(std::memory_order_relaxed);
+	return stats;
+}
+
+// 自上次发布后有写入(或 force 为 true)时，把各内存段统计发布到控制数据
+bool SharedMemoryManager::refreshMemorySegmentInfo(bool force) {
+	if (!force && totalSegmentWrites() == publishedWriteTotal_) {
+		return false;
+	}
+
+	updateMemorySegmentInfo();
+	return true;
+}
+
+// 设置写入路径上自动发布统计的最小间隔，0 表示只在显式刷新时发布
+void SharedMemoryManager::setMemoryStatsInterval(unsigned int intervalMs) {
+	statsInterval_ = std::chrono::milliseconds(intervalMs);
+	nextStatsPublish_ = std::chrono::steady_clock::now() + statsInterval_;
+	log(LogLevel::Debug, "设置内存段统计发布间隔: " + std::to_string(intervalMs) + " ms");
+}
+
+// 记录一次内存段写入，只有到达发布间隔时才访问控制数据
+void SharedMemoryManager::noteSegmentWrite(SegmentId id) {
+	segmentWriteCounts_[id].fetch_add(1, std::memory_order_relaxed);
+
+	if (statsInterval_.count() > 0 && std::chrono::steady_clock::now() >= nextStatsPublish_) {
+		updateMemorySegmentInfo();
+	}
+}
+
+// 事务之外的计算数据写入完成后组序号加 2(奇偶不变)，正在一致读取一组对象的读取方据此重试
+void SharedMemoryManager::noteGroupWrite() {
+	if (controlData_) {
+		controlData_->groupSequence.fetch_add(2);
+	}
+}
+
+// 本进程对所有内存段的写入总数
+uint64_t SharedMemoryManager::totalSegmentWrites() const {
+	uint64_t total = 0;
+	for (int i = 0; i < SegmentCount; ++i) {
+		total += segmentWriteCounts_[i].load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+// 设置内存段的 NUMA 策略，记录到控制数据并应用到当前映射
+bool SharedMemoryManager::setSegmentNumaPolicy(SegmentId id, SegmentNumaPolicy policy, int node) {
+	if (id < 0 || id >= SegmentCount || !controlData_) {
+		log(LogLevel::Error, "内存段编号无效或控制数据对象未初始化");
+		return false;
+	}
+
+	if (policy == NumaBind && (node < 0 || node >= SharedSegment::numaNodeCount())) {
+		log(LogLevel::Error, "绑定的 NUMA 节点无效: " + std::to_string(node) +
+			", 节点数: " + std::to_string(SharedSegment::numaNodeCount()));
+		return false;
+	}
+
+	controlData_->segmentNumaNodes[id].store(policy == NumaBind ? node : -1);
+	controlData_->segmentNumaPolicies[id].store(static_cast<uint32_t>(policy));
+	numaPlacements_.clear();
+
+	if (segmentRef(id)) {
+		applySegmentNumaPolicy(id, *segmentRef(id));
+	}
+	return true;
+}
+
+// 内存段当前的 NUMA 策略
+SegmentNumaPolicy SharedMemoryManager::getSegmentNumaPolicy(SegmentId id, int* node) const {
+	if (id < 0 || id >= SegmentCount || !controlData_) {
+		return NumaDefault;
+	}
+
+	if (node) {
+		*node = controlData_->segmentNumaNodes[id].load();
+	}
+	return static_cast<SegmentNumaPolicy>(controlData_->segmentNumaPolicies[id].load());
+}
+
+// 内存段各页所在的节点
+SegmentNumaInfo SharedMemoryManager::getSegmentNumaInfo(SegmentId id) {
+	std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+	if (!segment) {
+		return SegmentNumaInfo();
+	}
+	return segment->numaInfo();
+}
+
+// 所有内存段的策略和各节点页数
+std::string SharedMemoryManager::getNumaReport() {
+	static const char* policyNames[] = { "default", "interleave", "bind", "first-touch" };
+
+	std::stringstream report;
+	report << "NUMA 节点数: " << SharedSegment::numaNodeCount()
+		<< ", 当前节点: " << SharedSegment::currentNumaNode() << "\n";
+
+	for (int i = 0; i < SegmentCount; ++i) {
+		SegmentId id = static_cast<SegmentId>(i);
+		if (!segmentRef(id)) {
+			continue;
+		}
+
+		int node = -1;
+		SegmentNumaPolicy policy = getSegmentNumaPolicy(id, &node);
+		SegmentNumaInfo info = getSegmentNumaInfo(id);
+
+		report << segmentName(id) << ": 策略 " << policyNames[policy];
+		if (policy == NumaBind) {
+			report << "(节点 " << node << ")";
+		}
+		report << ", 页大小 " << info.pageSize << ", 已分配 " << info.residentPages << "/" << info.totalPages << " 页";
+		for (size_t n = 0; n < info.nodePages.size(); ++n) {
+			report << ", 节点" << n << ": " << info.nodePages[n];
+		}
+		report << "\n";
+	}
+	return report.str();
+}
+
+// 按控制数据中记录的策略设置内存段的映射
+void SharedMemoryManager::applySegmentNumaPolicy(SegmentId id, SharedSegment& segment) {
+	int node = -1;
+	SegmentNumaPolicy policy = getSegmentNumaPolicy(id, &node);
+	if (!segment.setNumaPolicy(policy, node)) {
+		log(LogLevel::Warning, "设置内存段 NUMA 策略失败(平台或内核不支持): " + segmentName(id));
+		return;
+	}
+
+	log(LogLevel::Debug, "设置内存段 NUMA 策略: " + segmentName(id) + ", 策略: " +
+		std::to_string(policy) + ", 节点: " + std::to_string(node));
+}
+
+// 把计算数据对象的索引、数据、各槽和历史帧所在的页放到本进程所在节点
+void SharedMemoryManager::placeDataNearWriter(SharedData* data) {
+	if (!controlData_ || !dataSegment_ ||
+		controlData_->segmentNumaPolicies[DataSegment].load() != static_cast<uint32_t>(NumaFirstTouch)) {
+		return;
+	}
+
+	// 对象的空间重新分配或本进程换到其他节点后才需要再次放置
+	int node = SharedSegment::currentNumaNode();
+	const void* payload = data->isSlotted() ? data->slots[0].data.storage() : data->data.storage();
+	NumaPlacement& placement = numaPlacements_[data];
+	if (placement.payload == payload && placement.node == node) {
+		return;
+	}
+	placement.payload = payload;
+	placement.node = node;
+
+	auto place = [&](const void* addr, size_t bytes) {
+		if (bytes != 0) {
+			dataSegment_->placeRange(addr, bytes, node);
+		}
+	};
+	place(data->index.data(), data->index.size() * sizeof(int));
+	place(data->data.storage(), data->data.storageBytes());
+	for (uint32_t i = 0; i < data->slotCount && i < SharedData::MAX_SLOTS; ++i) {
+		place(data->slots[i].index.data(), data->slots[i].index.size() * sizeof(int));
+		place(data->slots[i].data.storage(), data->slots[i].data.storageBytes());
+	}
+	place(data->history.values.data(), data->history.values.size() * sizeof(double));
+}
+
+// 以 caseDirectory 下的文件作为指定内存段的后备存储
+bool SharedMemoryManager::enablePersistentSegments(const std::string& caseDirectory, const std::vector<SegmentId>& segments) {
+	if (!isCreator_) {
+		log(LogLevel::Error, "非Creator无法设置持久化内存段");
+		return false;
+	}
+
+	if (!controlData_ || caseDirectory.empty()) {
+		log(LogLevel::Error, "控制数据对象未初始化或持久化目录为空");
+		return false;
+	}
+
+	for (SegmentId id : segments) {
+		if (id < 0 || id >= SegmentCount || id == DataSegment) {
+			log(LogLevel::Error, "只有几何、网格和模型参数内存段可以持久化");
+			return false;
+		}
+	}
+
+	try {
+		fs::create_directories(caseDirectory);
+
+		bip::scoped_lock<bip::named_mutex> lock(*sharedMutex_);
+		controlData_->persistentDirectory = SharedMemoryString(caseDirectory.c_str(), getAllocator<char>("control"));
+		for (int i = 0; i < SegmentCount; ++i) {
+			controlData_->segmentPersistent[i].store(false);
+		}
+		for (SegmentId id : segments) {
+			controlData_->segmentPersistent[id].store(true);
+			if (segmentRef(id) && !segmentRef(id)->isPersistent()) {
+				log(LogLevel::Warning, segmentName(id) + " 已作为共享内存创建，重建后才会持久化");
+			}
+		}
+
+		log(LogLevel::Info, "启用持久化内存段, 目录: " + caseDirectory);
+		return true;
+	}
+	catch (const std::exception& e) {
+		log(LogLevel::Error, "启用持久化内存段失败: " + std::string(e.what()));
+		return false;
+	}
+}
+
+// 内存段是否以文件持久化
+bool SharedMemoryManager::isPersistentSegment(SegmentId id) const {
+	return controlData_ && id >= 0 && id < SegmentCount && controlData_->segmentPersistent[id].load();
+}
+
+// 持久化内存段的目录
+std::string SharedMemoryManager::persistentDirectory(SegmentId id) const {
+	if (!isPersistentSegment(id)) {
+		return std::string();
+	}
+	return std::string(controlData_->persistentDirectory.c_str());
+}
+
+// 持久化内存段中的校验记录
+SharedSegmentRecord* SharedMemoryManager::segmentRecord(SegmentId id) {
+	if (segmentRecords_[id]) {
+		return segmentRecords_[id];
+	}
+
+	std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+	if (!segment || !segment->isPersistent()) {
+		return nullptr;
+	}
+	segmentRecords_[id] = segment->find<SharedSegmentRecord>(SharedSegmentRecord::NAME).first;
+	return segmentRecords_[id];
+}
+
+// 共享对象布局的签名：各共享对象的大小、分配器的对齐和 boost 版本，任一改变后旧文件不能再直接打开
+uint64_t SharedMemoryManager::segmentLayoutSignature() {
+	const uint64_t values[] = {
+		PERSISTENT_FORMAT_VERSION,
+		BOOST_VERSION,
+		sizeof(void*),
+		SharedSegment::HEADER_SIZE,
+		sizeof(SharedSegmentRecord),
+		sizeof(SharedGeometry),
+		sizeof(SharedMesh),
+		sizeof(SharedDefinitionList),
+		sizeof(Node),
+		sizeof(Edge),
+		sizeof(Triangle),
+		sizeof(Tetrahedron)
+	};
+
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (uint64_t value : values) {
+		for (int i = 0; i < 8; ++i) {
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+// 打开上次运行留下的内存段文件，校验通过时加载其中的对象
+bool SharedMemoryManager::openPersistentSegment(SegmentId id, uint64_t fingerprint) {
+	if (!isCreator_) {
+		log(LogLevel::Error, "非Creator无法打开持久化内存段");
+		return false;
+	}
+
+	if (!isPersistentSegment(id)) {
+		log(LogLevel::Error, segmentName(id) + " 未启用持久化");
+		return false;
+	}
+
+	std::string name = segmentName(id);
+	std::string directory = persistentDirectory(id);
+	if (!SharedSegment::exists(name.c_str(), directory)) {
+		log(LogLevel::Info, "没有可复用的持久化内存段: " + directory + "/" + name);
+		return false;
+	}
+
+	try {
+		std::shared_ptr<SharedSegment> segment = std::make_shared<SharedSegment>(bip::open_only, name.c_str(), directory);
+		SharedSegmentRecord* record = segment->find<SharedSegmentRecord>(SharedSegmentRecord::NAME).first;
+		if (!record || record->magic != SharedSegmentRecord::MAGIC || record->layout != segmentLayoutSignature()) {
+			log(LogLevel::Info, "持久化内存段的共享对象布局与本程序不一致，需要重新生成: " + name);
+			return false;
+		}
+		if (record->committed.load() == 0 || record->fingerprint != fingerprint) {
+			log(LogLevel::Info, "持久化内存段未完整提交或指纹不一致，需要重新生成: " + name);
+			return false;
+		}
+
+		// 换入文件中的内存段并加载对象，校验失败时恢复原来的映射和本段的对象列表，其他段不受影响
+		std::shared_ptr<SharedSegment>& current = segmentRef(id);
+		std::shared_ptr<SharedSegment> previous = current;
+		SharedSegmentRecord* previousRecord = segmentRecords_[id];
+		std::vector<SharedGeometry*> previousGeos = geos_;
+		std::vector<SharedMesh*> previousMeshs = meshs_;
+		std::vector<SharedDefinitionList*> previousDefs = defs_;
+		auto restore = [&]() {
+			current = previous;
+			handleCache_[id].clear();
+			segmentRecords_[id] = previousRecord;
+			switch (id) {
+			case GeometrySegment: geos_ = previousGeos; break;
+			case MeshSegment: meshs_ = previousMeshs; break;
+			default: defs_ = previousDefs; break;
+			}
+		};
+
+		current = segment;
+		handleCache_[id].clear();
+		segmentRecords_[id] = record;
+		try {
+			reloadSegmentObjects(id);
+		}
+		catch (...) {
+			restore();
+			throw;
+		}
 
-		// 更新网格数据段信息
-		auto meshUsage = getMeshMemoryUsage();
-		controlData_->meshSegmentTotalSize = meshUsage.first;
-		controlData_->meshSegmentFreeSize = meshUsage.first - meshUsage.second;
+		// 控制数据中登记的对象须都在文件中，上次运行遗留的锁和计数一并重置
+		LocalControlData localCtrl;
+		getControlData(localCtrl);
+		size_t expected = 0;
+		std::vector<SharedDataBase*> objects;
+		switch (id) {
+		case GeometrySegment:
+			expected = localCtrl.modelNames.size();
+			objects.assign(geos_.begin(), geos_.end());
+			break;
+		case MeshSegment:
+			expected = localCtrl.meshNames.size();
+			objects.assign(meshs_.begin(), meshs_.end());
+			break;
+		default:
+			expected = 1;
+			objects.assign(defs_.begin(), defs_.end());
+			break;
+		}
+		if (objects.size() != expected) {
+			log(LogLevel::Info, "持久化内存段缺少控制数据中登记的对象，需要重新生成: " + name);
+			restore();
+			return false;
+		}
 
-		// 更新计算数据段信息
-		auto dataUsage = getDataMemoryUsage();
-		controlData_->dataSegmentTotalSize = dataUsage.first;
-		controlData_->dataSegmentFreeSize = dataUsage.first - dataUsage.second;
+		// 校验通过后才换下原来的映射
+		if (previous) {
+			current = previous;
+			retireSegment(id);
+			current = segment;
+			segmentRecords_[id] = record;
+		}
+		for (SharedDataBase* object : objects) {
+			object->resetTransientState();
+		}
 
-		// 更新模型参数数据段信息
-		auto defUsage = getDefinitionMemoryUsage();
-		controlData_->definitionSegmentTotalSize = defUsage.first;
-		controlData_->definitionSegmentFreeSize = defUsage.first - defUsage.second;
+		if (getSegmentNumaPolicy(id) != NumaDefault) {
+			applySegmentNumaPolicy(id, *current);
+		}
+		updateMemorySegmentInfo();
 
-		log(LogLevel::Debug, "更新共享内存段大小信息成功");
+		log(LogLevel::Info, "复用持久化内存段: " + directory + "/" + name + ", 对象数: " + std::to_string(objects.size()));
+		return true;
 	}
 	catch (const std::exception& e) {
-		log(LogLevel::Error, "更新共享内存段大小信息失败: " + std::string(e.what()));
+		log(LogLevel::Warning, "打开持久化内存段失败，需要重新生成: " + std::string(e.what()));
+		return false;
 	}
 }
 
+// 记录指纹并写回文件
+bool SharedMemoryManager::commitPersistentSegment(SegmentId id, uint64_t fingerprint) {
+	if (!isCreator_) {
+		log(LogLevel::Error, "非Creator无法提交持久化内存段");
+		return false;
+	}
+
+	std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+	SharedSegmentRecord* record = segmentRecord(id);
+	if (!segment || !record) {
+		log(LogLevel::Error, segmentName(id) + " 不是持久化内存段或尚未创建");
+		return false;
+	}
+
+	// 先写回内容，再写回提交标记，中途退出时文件保持未提交状态
+	record->fingerprint = fingerprint;
+	if (!segment->flush()) {
+		log(LogLevel::Warning, "写回持久化内存段失败: " + segmentName(id));
+		return false;
+	}
+	record->committed.store(1);
+	segment->flush();
+
+	log(LogLevel::Info, "提交持久化内存段: " + segmentName(id) + ", 指纹: " + std::to_string(fingerprint));
+	return true;
+}
+
 // 检查几何对象所需内存空间是否足够，不足则设置异常
-bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& name, const LocalGeometry& localGeo) {
+bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& name, const LocalGeometry& localGeo,
+	const SharedGeometry* existing) {
 	if (!controlData_) {
 		log(LogLevel::Error, "控制数据对象未初始化");
 		return false;
@@ -1031,11 +4217,10 @@ bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& na
 		return false;
 	}
 
-	// 更新内存段信息
-	updateMemorySegmentInfo();
-
-	// 检查剩余内存是否足够
-	size_t requiredSize = estimateGeometryMemorySize(localGeo);
+	// 检查剩余内存是否足够(直接读取内存段，不需要先刷新控制数据)。
+	// 更新已有对象时只需要容器增长的部分，整个对象的大小用于登记到控制数据
+	size_t objectSize = estimateGeometryMemorySize(localGeo);
+	size_t requiredSize = existing ? SharedMemoryPlanner::updateBytes(*existing, localGeo) : objectSize;
 	auto usage = getGeometryMemoryUsage();
 
 	if (usage.first - usage.second < requiredSize) {
@@ -1054,9 +4239,9 @@ bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& na
 		bool found = false;
 		for (size_t i = 0; i < localCtrl.modelNames.size(); ++i) {
 			if (localCtrl.modelNames[i] == name) {
-				if (localCtrl.modelMemorySizes[i] < requiredSize) {
+				if (localCtrl.modelMemorySizes[i] < objectSize) {
 					// 更新需要的内存大小
-					localCtrl.modelMemorySizes[i] = requiredSize;
+					localCtrl.modelMemorySizes[i] = objectSize;
 				}
 				found = true;
 				break;
@@ -1066,11 +4251,12 @@ bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& na
 		if (!found) {
 			// 添加新的记录
 			localCtrl.modelNames.push_back(name);
-			localCtrl.modelMemorySizes.push_back(requiredSize);
+			localCtrl.modelMemorySizes.push_back(objectSize);
 		}
 
-		// 更新控制数据
+		// 更新控制数据，并同步发布当前的内存段统计
 		updateControlData(localCtrl);
+		updateMemorySegmentInfo();
 
 		log(LogLevel::Warning, "几何内存段空间不足");
 		return false;
@@ -1080,7 +4266,8 @@ bool SharedMemoryManager::checkAndUpdateGeometryMemorySize(const std::string& na
 }
 
 // 检查网格对象所需内存空间是否足够，不足则设置异常
-bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name, const LocalMesh& localMesh) {
+bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name, const LocalMesh& localMesh,
+	const SharedMesh* existing) {
 	if (!controlData_) {
 		log(LogLevel::Error, "控制数据对象未初始化");
 		return false;
@@ -1135,11 +4322,10 @@ bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name,
 		return false;
 	}
 
-	// 更新内存段信息
-	updateMemorySegmentInfo();
-
-	// 检查剩余内存是否足够
-	size_t requiredSize = estimateMeshMemorySize(localMesh);
+	// 检查剩余内存是否足够(直接读取内存段，不需要先刷新控制数据)。
+	// 更新已有对象时只需要容器增长的部分，整个对象的大小用于登记到控制数据
+	size_t objectSize = estimateMeshMemorySize(localMesh);
+	size_t requiredSize = existing ? SharedMemoryPlanner::updateBytes(*existing, localMesh) : objectSize;
 	auto usage = getMeshMemoryUsage();
 
 	if (usage.first - usage.second < requiredSize) {
@@ -1158,9 +4344,9 @@ bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name,
 		bool found = false;
 		for (size_t i = 0; i < localCtrl.meshNames.size(); ++i) {
 			if (localCtrl.meshNames[i] == name) {
-				if (localCtrl.meshMemorySizes[i] < requiredSize) {
+				if (localCtrl.meshMemorySizes[i] < objectSize) {
 					// 更新需要的内存大小
-					localCtrl.meshMemorySizes[i] = requiredSize;
+					localCtrl.meshMemorySizes[i] = objectSize;
 				}
 				found = true;
 				break;
@@ -1170,11 +4356,12 @@ bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name,
 		if (!found) {
 			// 添加新的记录
 			localCtrl.meshNames.push_back(name);
-			localCtrl.meshMemorySizes.push_back(requiredSize);
+			localCtrl.meshMemorySizes.push_back(objectSize);
 		}
 
-		// 更新控制数据
+		// 更新控制数据，并同步发布当前的内存段统计
 		updateControlData(localCtrl);
+		updateMemorySegmentInfo();
 
 		log(LogLevel::Warning, "网格内存段空间不足");
 		return false;
@@ -1184,7 +4371,8 @@ bool SharedMemoryManager::checkAndUpdateMeshMemorySize(const std::string& name,
 }
 
 // 检查计算数据对象所需内存空间是否足够，不足则设置异常
-bool SharedMemoryManager::checkAndUpdateDataMemorySize(const std::string& name, const LocalData& localData) {
+bool SharedMemoryManager::checkAndUpdateDataMemorySize(const std::string& name, const LocalData& localData,
+	const SharedData* existing) {
 	if (!controlData_) {
 		log(LogLevel::Error, "控制数据对象未初始化");
 		return false;
@@ -1197,53 +4385,35 @@ bool SharedMemoryManager::checkAndUpdateDataMemorySize(const std::string& name,
 		// 先计算需要的内存大小
 		size_t requiredSize = estimateDataMemorySize(localData);
 
-		// 更新到控制数据
+		// 查找是否已存在同名对象的内存大小记录
 		LocalControlData localCtrl;
 		getControlData(localCtrl);
-
-		// 查找是否已存在同名对象的内存大小记录
-		bool found = false;
-		for (size_t i = 0; i < localCtrl.dataNames.size(); ++i) {
-			if (localCtrl.dataNames[i] == name) {
-				if (localCtrl.dataMemorySizes[i] < requiredSize) {
-					// 更新需要的内存大小
-					localCtrl.dataMemorySizes[i] = requiredSize;
-
-					// 设置异常，提示需要更大的内存空间
-					std::stringstream msg;
-					msg << "计算数据对象 " << name << " 需要更大的内存空间: " << requiredSize << " 字节";
-					setException(EMP::EXCEPT_DATAPROCESS, 1, msg.str());
-
-					// 更新控制数据
-					updateControlData(localCtrl);
-				}
-				found = true;
-				break;
+		auto it = std::find(localCtrl.dataNames.begin(), localCtrl.dataNames.end(), name);
+		if (it != localCtrl.dataNames.end()) {
+			size_t i = it - localCtrl.dataNames.begin();
+			if (i >= localCtrl.dataMemorySizes.size() || static_cast<size_t>(localCtrl.dataMemorySizes[i]) < requiredSize) {
+				// 设置异常，提示需要更大的内存空间
+				std::stringstream msg;
+				msg << "计算数据对象 " << name << " 需要更大的内存空间: " << requiredSize << " 字节";
+				setException(EMP::EXCEPT_DATAPROCESS, 1, msg.str());
 			}
 		}
-
-		if (!found) {
-			// 添加新的记录
-			localCtrl.dataNames.push_back(name);
-			localCtrl.dataMemorySizes.push_back(requiredSize);
-
+		else {
 			// 设置异常，提示需要创建内存空间
 			std::stringstream msg;
 			msg << "需要为计算数据对象 " << name << " 创建内存空间: " << requiredSize << " 字节";
 			setException(EMP::EXCEPT_DATAPROCESS, 2, msg.str());
-
-			// 更新控制数据
-			updateControlData(localCtrl);
 		}
 
+		// 更新到控制数据
+		recordDataMemorySize(name, requiredSize);
 		return false;
 	}
 
-	// 更新内存段信息
-	updateMemorySegmentInfo();
-
-	// 检查剩余内存是否足够
-	size_t requiredSize = estimateDataMemorySize(localData);
+	// 检查剩余内存是否足够(直接读取内存段，不需要先刷新控制数据)。
+	// 更新已有对象时只需要容器增长的部分，整个对象的大小用于登记到控制数据
+	size_t objectSize = existing ? estimateDataMemorySize(localData, *existing) : estimateDataMemorySize(localData);
+	size_t requiredSize = existing ? SharedMemoryPlanner::updateBytes(*existing, localData) : objectSize;
 	auto usage = getDataMemoryUsage();
 
 	if (usage.first - usage.second < requiredSize) {
@@ -1254,31 +4424,9 @@ bool SharedMemoryManager::checkAndUpdateDataMemorySize(const std::string& name,
 			<< "总大小 " << usage.first << " 字节";
 		setException(EMP::EXCEPT_DATAPROCESS, 3, msg.str());
 
-		// 更新需要的内存大小到控制数据
-		LocalControlData localCtrl;
-		getControlData(localCtrl);
-
-		// 查找是否已存在同名对象的内存大小记录
-		bool found = false;
-		for (size_t i = 0; i < localCtrl.dataNames.size(); ++i) {
-			if (localCtrl.dataNames[i] == name) {
-				if (localCtrl.dataMemorySizes[i] < requiredSize) {
-					// 更新需要的内存大小
-					localCtrl.dataMemorySizes[i] = requiredSize;
-				}
-				found = true;
-				break;
-			}
-		}
-
-		if (!found) {
-			// 添加新的记录
-			localCtrl.dataNames.push_back(name);
-			localCtrl.dataMemorySizes.push_back(requiredSize);
-		}
-
-		// 更新控制数据
-		updateControlData(localCtrl);
+		// 更新需要的内存大小到控制数据，并同步发布当前的内存段统计
+		recordDataMemorySize(name, objectSize);
+		updateMemorySegmentInfo();
 
 		log(LogLevel::Warning, "计算数据内存段空间不足");
 		return false;
@@ -1287,6 +4435,30 @@ bool SharedMemoryManager::checkAndUpdateDataMemorySize(const std::string& name,
 	return true;
 }
 
+void SharedMemoryManager::recordDataMemorySize(const std::string& name, size_t objectSize) {
+	LocalControlData localCtrl;
+	getControlData(localCtrl);
+
+	int size = static_cast<int>((std::min)(objectSize, static_cast<size_t>(std::numeric_limits<int>::max())));
+	auto it = std::find(localCtrl.dataNames.begin(), localCtrl.dataNames.end(), name);
+	if (it == localCtrl.dataNames.end()) {
+		localCtrl.dataNames.push_back(name);
+		localCtrl.dataMemorySizes.push_back(size);
+	}
+	else {
+		localCtrl.dataMemorySizes.resize(localCtrl.dataNames.size(), 0);
+		int& recorded = localCtrl.dataMemorySizes[it - localCtrl.dataNames.begin()];
+		if (recorded >= size) {
+			return;
+		}
+		recorded = size;
+	}
+
+	// 本地副本的版本号与共享对象相同，需要标记为已修改才会写回
+	localCtrl.version = std::numeric_limits<uint64_t>::max();
+	updateControlData(localCtrl);
+}
+
 // 重新创建几何内存段，增加大小
 bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 	if (!isCreator_) {
@@ -1299,6 +4471,7 @@ bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 		return false;
 	}
 
+	bool resizing = false;
 	try {
 		// 先获取控制数据中的信息
 		LocalControlData localCtrl;
@@ -1323,6 +4496,20 @@ bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 
 		log(LogLevel::Info, "重新创建几何内存段, 新大小: " + std::to_string(finalSize) + " 字节");
 
+		// 优先原地扩容，已有对象的段内偏移不变，其他进程按段纪元重新映射即可
+		if (geometrySegment_ && finalSize > geometrySegment_->get_size() && growSegment(GeometrySegment, finalSize)) {
+			updateMemorySegmentInfo();
+			log(LogLevel::Info, "几何内存段原地扩容成功，当前大小: " + std::to_string(finalSize) + " 字节");
+			return true;
+		}
+
+		// 无法原地扩容时重建内存段，期间暂停所有读写方
+		if (!beginSegmentResize(GeometrySegment)) {
+			log(LogLevel::Warning, "内存段仍在使用，无法重建: " + segmentName(GeometrySegment));
+			return false;
+		}
+		resizing = true;
+
 		// 保存当前所有几何对象的本地副本
 		std::vector<LocalGeometry> localGeos;
 		for (auto geo : geos_) {
@@ -1334,12 +4521,11 @@ bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 		// 移除旧的几何内存段
 		std::string geoSegmentName = GenerateSegmentName(SharedMemorySuffix::GEOMETRY_SEGMENT);
 		geos_.clear();
-		geometrySegment_.reset();
-		bip::shared_memory_object::remove(geoSegmentName.c_str());
+		retireSegment(GeometrySegment);
+		removeSegment(GeometrySegment, geoSegmentName);
 
 		// 创建新的几何内存段
-		geometrySegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, geoSegmentName.c_str(), finalSize);
+		geometrySegment_ = createSegment(GeometrySegment, geoSegmentName, finalSize);
 
 		// 重新创建所有几何对象
 		for (const auto& name : localCtrl.modelNames) {
@@ -1349,6 +4535,10 @@ bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 			geos_.push_back(geo);
 		}
 
+		// 新内存段就绪后通知其他进程重新映射，再恢复对象内容
+		endSegmentResize(GeometrySegment, true);
+		resizing = false;
+
 		// 恢复几何对象的内容
 		for (size_t i = 0; i < localGeos.size() && i < geos_.size(); ++i) {
 			updateGeometry(geos_[i], localGeos[i]);
@@ -1362,6 +4552,9 @@ bool SharedMemoryManager::recreateGeometrySegment(size_t newSize) {
 	}
 	catch (const std::exception& e) {
 		log(LogLevel::Error, "重新创建几何内存段失败: " + std::string(e.what()));
+		if (resizing) {
+			endSegmentResize(GeometrySegment, true);
+		}
 		return false;
 	}
 }
@@ -1378,6 +4571,7 @@ bool SharedMemoryManager::recreateMeshSegment(size_t newSize) {
 		return false;
 	}
 
+	bool resizing = false;
 	try {
 		// 先获取控制数据中的信息
 		LocalControlData localCtrl;
@@ -1402,6 +4596,20 @@ bool SharedMemoryManager::recreateMeshSegment(size_t newSize) {
 
 		log(LogLevel::Info, "重新创建网格内存段, 新大小: " + std::to_string(finalSize) + " 字节");
 
+		// 优先原地扩容，已有对象的段内偏移不变，其他进程按段纪元重新映射即可
+		if (meshSegment_ && finalSize > meshSegment_->get_size() && growSegment(MeshSegment, finalSize)) {
+			updateMemorySegmentInfo();
+			log(LogLevel::Info, "网格内存段原地扩容成功，当前大小: " + std::to_string(finalSize) + " 字节");
+			return true;
+		}
+
+		// 无法原地扩容时重建内存段，期间暂停所有读写方
+		if (!beginSegmentResize(MeshSegment)) {
+			log(LogLevel::Warning, "内存段仍在使用，无法重建: " + segmentName(MeshSegment));
+			return false;
+		}
+		resizing = true;
+
 		// 保存当前所有网格对象的本地副本
 		std::vector<LocalMesh> localMeshs;
 		for (auto mesh : meshs_) {
@@ -1413,12 +4621,11 @@ bool SharedMemoryManager::recreateMeshSegment(size_t newSize) {
 		// 移除旧的网格内存段
 		std::string meshSegmentName = GenerateSegmentName(SharedMemorySuffix::MESH_SEGMENT);
 		meshs_.clear();
-		meshSegment_.reset();
-		bip::shared_memory_object::remove(meshSegmentName.c_str());
+		retireSegment(MeshSegment);
+		removeSegment(MeshSegment, meshSegmentName);
 
 		// 创建新的网格内存段
-		meshSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, meshSegmentName.c_str(), finalSize);
+		meshSegment_ = createSegment(MeshSegment, meshSegmentName, finalSize);
 
 		// 重新创建所有网格对象
 		for (const auto& name : localCtrl.meshNames) {
@@ -1428,6 +4635,10 @@ bool SharedMemoryManager::recreateMeshSegment(size_t newSize) {
 			meshs_.push_back(mesh);
 		}
 
+		// 新内存段就绪后通知其他进程重新映射，再恢复对象内容
+		endSegmentResize(MeshSegment, true);
+		resizing = false;
+
 		// 恢复网格对象的内容
 		for (size_t i = 0; i < localMeshs.size() && i < meshs_.size(); ++i) {
 			updateMesh(meshs_[i], localMeshs[i]);
@@ -1441,6 +4652,9 @@ bool SharedMemoryManager::recreateMeshSegment(size_t newSize) {
 	}
 	catch (const std::exception& e) {
 		log(LogLevel::Error, "重新创建网格内存段失败: " + std::string(e.what()));
+		if (resizing) {
+			endSegmentResize(MeshSegment, true);
+		}
 		return false;
 	}
 }
@@ -1457,6 +4671,7 @@ bool SharedMemoryManager::recreateDataSegment(size_t newSize) {
 		return false;
 	}
 
+	bool resizing = false;
 	try {
 		// 先获取控制数据中的信息
 		LocalControlData localCtrl;
@@ -1481,23 +4696,80 @@ bool SharedMemoryManager::recreateDataSegment(size_t newSize) {
 
 		log(LogLevel::Info, "重新创建计算数据内存段, 新大小: " + std::to_string(finalSize) + " 字节");
 
-		// 保存当前所有计算数据对象的本地副本
-		std::vector<LocalData> localDatas;
+		// 优先原地扩容，已有对象的段内偏移不变，其他进程按段纪元重新映射即可
+		if (dataSegment_ && finalSize > dataSegment_->get_size() && growSegment(DataSegment, finalSize)) {
+			updateMemorySegmentInfo();
+			log(LogLevel::Info, "计算数据内存段原地扩容成功，当前大小: " + std::to_string(finalSize) + " 字节");
+			return true;
+		}
+
+		// 无法原地扩容时重建内存段，期间暂停所有读写方
+		if (!beginSegmentResize(DataSegment)) {
+			log(LogLevel::Warning, "内存段仍在使用，无法重建: " + segmentName(DataSegment));
+			return false;
+		}
+		resizing = true;
+
+		// 保存当前所有计算数据对象的本地副本和配置，重建后按原配置恢复。
+		// 保留的旧版本和局部更新记录不随之恢复；版本号保持不变，读取方的游标和低分辨率副本仍然有效
+		struct SavedData {
+			LocalData content;
+			uint64_t version = 0;
+			DataLayout layout = PlanarLayout;
+			DataPrecision precision = Float64Precision;
+			uint32_t slotCount = 0;
+			uint32_t retentionDepth = 0;
+			uint32_t retentionCapacity = 0;
+			bool skipUnchanged = false;
+			bool sparse = false;
+			double sparseTolerance = 0.0;
+			std::vector<SharedDataRegion> regions;
+			uint32_t historyCapacity = 0;
+			std::vector<std::pair<double, std::vector<std::vector<double>>>> frames;
+		};
+		std::vector<SavedData> savedDatas;
 		for (auto data : datas_) {
-			LocalData localData;
-			getData(data, localData);
-			localDatas.push_back(localData);
+			SavedData saved;
+			getData(data, saved.content);
+			{
+				bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
+				saved.version = data->version.load();
+				saved.layout = data->layout;
+				saved.precision = data->precision;
+				saved.slotCount = data->slotCount;
+				if (data->versions) {
+					saved.retentionDepth = data->versions->depth;
+					saved.retentionCapacity = data->versions->capacity;
+				}
+				saved.skipUnchanged = data->skipUnchanged.load();
+				saved.sparse = data->sparse.load();
+				saved.sparseTolerance = data->sparseTolerance.load();
+				saved.regions.assign(data->regions.begin(), data->regions.end());
+				saved.historyCapacity = data->history.capacity;
+			}
+			size_t frameCount = getDataFrameCount(data);
+			for (size_t k = 0; k < frameCount; ++k) {
+				std::pair<double, std::vector<std::vector<double>>> frame;
+				if (getDataFrame(data, static_cast<int>(k), frame.first, frame.second)) {
+					saved.frames.push_back(std::move(frame));
+				}
+			}
+			savedDatas.push_back(std::move(saved));
 		}
 
-		// 移除旧的计算数据内存段
+		// 移除旧的计算数据内存段前，等待只读视图全部释放
+		for (auto data : datas_) {
+			if (!waitForViewsReleased(data)) {
+				throw std::runtime_error("零拷贝视图未释放: " + std::string(data->name.c_str()));
+			}
+		}
 		std::string dataSegmentName = GenerateSegmentName(SharedMemorySuffix::DATA_SEGMENT);
 		datas_.clear();
-		dataSegment_.reset();
-		bip::shared_memory_object::remove(dataSegmentName.c_str());
+		retireSegment(DataSegment);
+		removeSegment(DataSegment, dataSegmentName);
 
 		// 创建新的计算数据内存段
-		dataSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, dataSegmentName.c_str(), finalSize);
+		dataSegment_ = createSegment(DataSegment, dataSegmentName, finalSize);
 
 		// 重新创建所有计算数据对象
 		for (const auto& name : localCtrl.dataNames) {
@@ -1507,9 +4779,41 @@ bool SharedMemoryManager::recreateDataSegment(size_t newSize) {
 			datas_.push_back(data);
 		}
 
-		// 恢复计算数据对象的内容
-		for (size_t i = 0; i < localDatas.size() && i < datas_.size(); ++i) {
-			updateData(datas_[i], localDatas[i]);
+		// 新内存段就绪后通知其他进程重新映射，再恢复对象内容
+		endSegmentResize(DataSegment, true);
+		resizing = false;
+
+		// 先恢复配置再恢复内容，内容按原来的精度、排列和槽数写入，版本号与重建前相同
+		for (size_t i = 0; i < savedDatas.size() && i < datas_.size(); ++i) {
+			SharedData* data = datas_[i];
+			const SavedData& saved = savedDatas[i];
+			setDataLayout(data, saved.layout);
+			setDataPrecision(data, saved.precision);
+			if (saved.slotCount >= 2) {
+				setDataSlotCount(data, saved.slotCount);
+			}
+			if (saved.retentionDepth > 0) {
+				setDataRetention(data, saved.retentionDepth, saved.retentionCapacity);
+			}
+			if (saved.sparse) {
+				setDataSparse(data, true, saved.sparseTolerance);
+			}
+
+			if (saved.version > 0) {
+				data->version.store(saved.version - 1);
+				updateData(data, saved.content);
+			}
+			setSkipUnchangedWrites(data, saved.skipUnchanged);
+			if (!saved.regions.empty()) {
+				setDataRegions(data, saved.regions);
+			}
+
+			if (saved.historyCapacity > 0) {
+				setDataHistory(data, saved.historyCapacity);
+				for (const auto& frame : saved.frames) {
+					appendDataFrame(data, frame.first, frame.second);
+				}
+			}
 		}
 
 		// 更新内存段信息到控制数据
@@ -1520,6 +4824,9 @@ bool SharedMemoryManager::recreateDataSegment(size_t newSize) {
 	}
 	catch (const std::exception& e) {
 		log(LogLevel::Error, "重新创建计算数据内存段失败: " + std::string(e.what()));
+		if (resizing) {
+			endSegmentResize(DataSegment, true);
+		}
 		return false;
 	}
 }
@@ -1639,8 +4946,9 @@ void SharedMemoryManager::autoAdjustMemorySegments() {
 				}
 			}
 		} else {
-			// 没有异常，检查内存段的使用情况，如果接近满载则增加大小
-			if (geometrySegment_) {
+			// 没有异常，检查内存段的使用情况，如果接近满载则增加大小。
+			// 按规划创建的内存段已精确容纳各对象，使用率高是预期的，只在出现空间不足异常时扩容
+			if (geometrySegment_ && plannedSegmentSizes_[GeometrySegment] == 0) {
 				auto usage = getGeometryMemoryUsage();
 				// 如果可用空间低于20%，则扩容到当前大小的2倍
 				if (usage.first > 0 && (usage.first - usage.second) < usage.first * 0.2) {
@@ -1650,7 +4958,7 @@ void SharedMemoryManager::autoAdjustMemorySegments() {
 				}
 			}
 
-			if (meshSegment_) {
+			if (meshSegment_ && plannedSegmentSizes_[MeshSegment] == 0) {
 				auto usage = getMeshMemoryUsage();
 				// 如果可用空间低于20%，则扩容到当前大小的2倍
 				if (usage.first > 0 && (usage.first - usage.second) < usage.first * 0.2) {
@@ -1660,7 +4968,7 @@ void SharedMemoryManager::autoAdjustMemorySegments() {
 				}
 			}
 
-			if (dataSegment_) {
+			if (dataSegment_ && plannedSegmentSizes_[DataSegment] == 0) {
 				auto usage = getDataMemoryUsage();
 				// 如果可用空间低于20%，则扩容到当前大小的2倍
 				if (usage.first > 0 && (usage.first - usage.second) < usage.first * 0.2) {
@@ -1670,7 +4978,7 @@ void SharedMemoryManager::autoAdjustMemorySegments() {
 				}
 			}
 
-			if (definitionSegment_) {
+			if (definitionSegment_ && plannedSegmentSizes_[DefinitionSegment] == 0) {
 				auto usage = getDefinitionMemoryUsage();
 				// 如果可用空间低于20%，则扩容到当前大小的2倍
 				if (usage.first > 0 && (usage.first - usage.second) < usage.first * 0.2) {
@@ -1697,9 +5005,13 @@ void SharedMemoryManager::updateGeometry(SharedGeometry* geo, const LocalGeometr
 	}
 
 	try {
+		// 内存段扩容期间等待，并换到当前映射中的对象
+		SegmentWriteScope scope(this, GeometrySegment);
+		geo = rebaseObject(geo, GeometrySegment);
+
 		// 检查内存空间是否足够
 		std::string primaryName = localGeo.getPrimaryName();
-		if (!checkAndUpdateGeometryMemorySize(primaryName, localGeo)) {
+		if (!checkAndUpdateGeometryMemorySize(primaryName, localGeo, geo)) {
 			log(LogLevel::Warning, "内存空间不足，无法更新几何对象: " + primaryName);
 			return;
 		}
@@ -1712,9 +5024,13 @@ void SharedMemoryManager::updateGeometry(SharedGeometry* geo, const LocalGeometr
 
 		// 使用共享对象的copyFromLocal方法
 		geo->copyFromLocal(localGeo, allocator);
+		lock.unlock();
 
-		// 更新内存使用信息到控制数据
-		updateMemorySegmentInfo();
+		// 将各几何体名称登记到名称目录，按任一名称查找都不需要遍历
+		registerGeometryNames(primaryName, localGeo.shapeNames);
+
+		// 只记录写入，内存段统计按需发布
+		noteSegmentWrite(GeometrySegment);
 
 		// 更新日志消息，包含几何体数量信息
 		log(LogLevel::Debug, "更新几何对象成功: " + std::to_string(localGeo.shapeNames.size()) +
@@ -1726,6 +5042,43 @@ void SharedMemoryManager::updateGeometry(SharedGeometry* geo, const LocalGeometr
 	}
 }
 
+// 将几何体名称登记到名称目录
+void SharedMemoryManager::registerGeometryNames(const std::string& primaryName, const std::vector<std::string>& shapeNames) {
+	if (!controlData_) {
+		return;
+	}
+
+	SharedHandle handle = findHandle(GeometrySegment, primaryName);
+	if (handle == INVALID_HANDLE) {
+		return;
+	}
+
+	// 只有出现新名称时才加锁写入控制数据
+	std::vector<std::string> missing;
+	for (const auto& shapeName : shapeNames) {
+		if (findHandle(GeometrySegment, shapeName) != handle) {
+			missing.push_back(shapeName);
+		}
+	}
+	if (missing.empty()) {
+		return;
+	}
+
+	SharedMemoryAllocator<char> allocator = getAllocator<char>();
+	bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
+	controlData_->beginWrite();
+	try {
+		for (const auto& shapeName : missing) {
+			controlData_->directory.insert(GeometrySegment, shapeName, handle, allocator);
+		}
+	}
+	catch (...) {
+		controlData_->endWrite();
+		throw;
+	}
+	controlData_->endWrite();
+}
+
 // 创建模型参数对象共享内存段和对象
 void SharedMemoryManager::createDefinitionSegmentAndObjects() {
 	if (!isCreator_) {
@@ -1739,15 +5092,16 @@ void SharedMemoryManager::createDefinitionSegmentAndObjects() {
 		LocalControlData localCtrl;
 		getControlData(localCtrl);
 
-		// 暂时使用默认大小，因为模型参数使用较少内存
-		totalSize = 1024 * 1024; // 1MB 默认大小
+		// 未规划时使用默认大小，因为模型参数使用较少内存
+		totalSize = plannedSegmentSizes_[DefinitionSegment] > 0 ? plannedSegmentSizes_[DefinitionSegment]
+			: 1024 * 1024; // 1MB 默认大小
 
 		// 创建模型参数数据内存段
 		std::string defSegmentName = GenerateSegmentName(SharedMemorySuffix::DEFINITION_SEGMENT);
-		bip::shared_memory_object::remove(defSegmentName.c_str()); // 先移除现有的（如果存在）
+		removeSegment(DefinitionSegment, defSegmentName); // 先移除现有的（如果存在）
 
-		definitionSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, defSegmentName.c_str(), totalSize);
+		definitionSegment_ = createSegment(DefinitionSegment, defSegmentName, totalSize);
+		handleCache_[DefinitionSegment].clear();
 
 		// 清空当前模型参数对象列表
 		defs_.clear();
@@ -1775,8 +5129,7 @@ void SharedMemoryManager::LoadExistingDefinitionObjects() {
 		try {
 			// 尝试连接到模型参数数据内存段
 			std::string defSegmentName = GenerateSegmentName(SharedMemorySuffix::DEFINITION_SEGMENT);
-			definitionSegment_ = std::make_shared<bip::managed_shared_memory>(
-				bip::open_only, defSegmentName.c_str());
+			definitionSegment_ = openSegment(DefinitionSegment, defSegmentName);
 			log(LogLevel::Info, "连接到模型参数数据内存段: " + defSegmentName);
 		}
 		catch (const bip::interprocess_exception& ex) {
@@ -1802,40 +5155,9 @@ void SharedMemoryManager::LoadExistingDefinitionObjects() {
 	}
 }
 
-// 估算模型参数对象所需的共享内存大小
+// 模型参数对象所需的共享内存大小
 size_t SharedMemoryManager::estimateDefinitionMemorySize(const LocalDefinitionList& localDef) {
-	// 基础大小
-	size_t baseSize = sizeof(SharedDefinitionList);
-
-	// 名称和描述大小
-	size_t nameSize = localDef.name.size() + 1;
-	size_t descriptionSize = localDef.description.size() + 1;
-
-	// 计算所有参数的总大小
-	size_t totalParameterCount = 0;
-	size_t totalParameterNameSize = 0;
-
-	for (const auto& def : localDef.definitions) {
-		totalParameterCount += def.parameterNames.size();
-
-		// 计算所有参数名称的大小
-		for (const auto& paramName : def.parameterNames) {
-			totalParameterNameSize += paramName.size() + 1;
-		}
-	}
-
-	// 计算各个向量的大小
-	size_t idsSize = localDef.definitions.size() * sizeof(int);
-	size_t indicesSize = localDef.definitions.size() * sizeof(int) * 2; // 开始索引和参数数量
-	size_t parameterValuesSize = totalParameterCount * sizeof(double);
-	size_t parameterNamesSize = totalParameterNameSize + totalParameterCount * sizeof(SharedMemoryString);
-
-	// 考虑共享内存管理开销
-	size_t totalSize = baseSize + nameSize + descriptionSize +
-					   idsSize + indicesSize + parameterValuesSize + parameterNamesSize;
-
-	// 添加额外的20%作为安全边际
-	return static_cast<size_t>(totalSize * 1.2);
+	return SharedMemoryPlanner::planDefinition(localDef).totalBytes();
 }
 
 // 返回模型参数共享内存段的总大小和已使用大小
@@ -1848,6 +5170,12 @@ std::pair<size_t, size_t> SharedMemoryManager::getDefinitionMemoryUsage() const
 
 // 根据名称查找模型参数对象
 SharedDefinitionList* SharedMemoryManager::findDefinitionByName(const std::string& name) {
+	// 先查名称目录，未登记的名称再遍历对象列表
+	SharedDefinitionList* found = getDefinitionByHandle(findHandle(DefinitionSegment, name));
+	if (found) {
+		return found;
+	}
+
 	for (auto def : defs_) {
 		if (std::string(def->name.c_str()) == name) {
 			return def;
@@ -1869,8 +5197,12 @@ void SharedMemoryManager::updateDefinition(SharedDefinitionList* def, const Loca
 	}
 
 	try {
+		// 内存段扩容期间等待，并换到当前映射中的对象
+		SegmentWriteScope scope(this, DefinitionSegment);
+		def = rebaseObject(def, DefinitionSegment);
+
 		// 检查内存空间是否足够
-		if (!checkAndUpdateDefinitionMemorySize(localDef.name, localDef)) {
+		if (!checkAndUpdateDefinitionMemorySize(localDef.name, localDef, def)) {
 			log(LogLevel::Warning, "内存空间不足，无法更新模型参数对象: " + localDef.name);
 			return;
 		}
@@ -1884,8 +5216,8 @@ void SharedMemoryManager::updateDefinition(SharedDefinitionList* def, const Loca
 		// 使用共享对象的copyFromLocal方法
 		def->copyFromLocal(localDef, allocator);
 
-		// 更新内存使用信息到控制数据
-		updateMemorySegmentInfo();
+		// 只记录写入，内存段统计按需发布
+		noteSegmentWrite(DefinitionSegment);
 
 		log(LogLevel::Debug, "更新模型参数对象成功: " + localDef.name +
 			", 包含 " + std::to_string(localDef.definitions.size()) + " 组参数");
@@ -1904,11 +5236,18 @@ void SharedMemoryManager::getDefinition(SharedDefinitionList* def, LocalDefiniti
 	}
 
 	try {
-		// 加锁保护并复制数据
-		bip::scoped_lock<bip::interprocess_mutex> lock(def->mutex);
+		SegmentReadScope scope(this, DefinitionSegment);
+		// 指针可能来自内存段扩容前的映射
+		def = rebaseObject(def, DefinitionSegment);
 
-		// 使用共享对象的copyToLocal方法
-		def->copyToLocal(localDef);
+		// 先尝试无锁的乐观读取，多次与写入冲突后再加锁复制
+		if (!readOptimistic(def, localDef, definitionSegment_)) {
+			bip::scoped_lock<bip::interprocess_mutex> lock(def->mutex);
+
+			// 使用共享对象的copyToLocal方法
+			def->copyToLocal(localDef);
+		}
+		noteConsumed(def, localDef.version);
 
 		log(LogLevel::Debug, "获取模型参数对象成功: " + localDef.name +
 			", 包含 " + std::to_string(localDef.definitions.size()) + " 组参数");
@@ -1920,7 +5259,8 @@ void SharedMemoryManager::getDefinition(SharedDefinitionList* def, LocalDefiniti
 }
 
 // 检查模型参数对象所需内存空间是否足够，不足则设置异常
-bool SharedMemoryManager::checkAndUpdateDefinitionMemorySize(const std::string& name, const LocalDefinitionList& localDef) {
+bool SharedMemoryManager::checkAndUpdateDefinitionMemorySize(const std::string& name, const LocalDefinitionList& localDef,
+	const SharedDefinitionList* existing) {
 	if (!controlData_) {
 		log(LogLevel::Error, "控制数据对象未初始化");
 		return false;
@@ -1938,11 +5278,10 @@ bool SharedMemoryManager::checkAndUpdateDefinitionMemorySize(const std::string&
 		return false;
 	}
 
-	// 更新内存段信息
-	updateMemorySegmentInfo();
-
-	// 检查剩余内存是否足够
-	size_t requiredSize = estimateDefinitionMemorySize(localDef);
+	// 检查剩余内存是否足够(直接读取内存段，不需要先刷新控制数据)。
+	// 更新已有对象时只需要容器增长的部分，整个对象的大小用于登记到控制数据
+	size_t objectSize = estimateDefinitionMemorySize(localDef);
+	size_t requiredSize = existing ? SharedMemoryPlanner::updateBytes(*existing, localDef) : objectSize;
 	auto usage = getDefinitionMemoryUsage();
 
 	if (usage.first - usage.second < requiredSize) {
@@ -1952,6 +5291,7 @@ bool SharedMemoryManager::checkAndUpdateDefinitionMemorySize(const std::string&
 			<< "可用 " << (usage.first - usage.second) << " 字节，"
 			<< "总大小 " << usage.first << " 字节";
 		setException(EMP::EXCEPT_DEFINITION, 2, msg.str());
+		updateMemorySegmentInfo();
 
 		log(LogLevel::Warning, "模型参数内存段空间不足");
 		return false;
@@ -1972,6 +5312,7 @@ bool SharedMemoryManager::recreateDefinitionSegment(size_t newSize) {
 		return false;
 	}
 
+	bool resizing = false;
 	try {
 		// 如果总大小太小，使用默认大小
 		if (newSize < 1024 * 1024) {
@@ -1980,6 +5321,20 @@ bool SharedMemoryManager::recreateDefinitionSegment(size_t newSize) {
 
 		log(LogLevel::Info, "重新创建模型参数内存段, 新大小: " + std::to_string(newSize) + " 字节");
 
+		// 优先原地扩容，已有对象的段内偏移不变，其他进程按段纪元重新映射即可
+		if (definitionSegment_ && newSize > definitionSegment_->get_size() && growSegment(DefinitionSegment, newSize)) {
+			updateMemorySegmentInfo();
+			log(LogLevel::Info, "模型参数内存段原地扩容成功，当前大小: " + std::to_string(newSize) + " 字节");
+			return true;
+		}
+
+		// 无法原地扩容时重建内存段，期间暂停所有读写方
+		if (!beginSegmentResize(DefinitionSegment)) {
+			log(LogLevel::Warning, "内存段仍在使用，无法重建: " + segmentName(DefinitionSegment));
+			return false;
+		}
+		resizing = true;
+
 		// 保存当前所有模型参数对象的本地副本
 		std::vector<LocalDefinitionList> localDefs;
 		for (auto def : defs_) {
@@ -1991,12 +5346,11 @@ bool SharedMemoryManager::recreateDefinitionSegment(size_t newSize) {
 		// 移除旧的模型参数内存段
 		std::string defSegmentName = GenerateSegmentName(SharedMemorySuffix::DEFINITION_SEGMENT);
 		defs_.clear();
-		definitionSegment_.reset();
-		bip::shared_memory_object::remove(defSegmentName.c_str());
+		retireSegment(DefinitionSegment);
+		removeSegment(DefinitionSegment, defSegmentName);
 
 		// 创建新的模型参数内存段
-		definitionSegment_ = std::make_shared<bip::managed_shared_memory>(
-			bip::create_only, defSegmentName.c_str(), newSize);
+		definitionSegment_ = createSegment(DefinitionSegment, defSegmentName, newSize);
 
 		// 重新创建所有模型参数对象
 		for (const auto& localDef : localDefs) {
@@ -2014,6 +5368,10 @@ bool SharedMemoryManager::recreateDefinitionSegment(size_t newSize) {
 			defs_.push_back(def);
 		}
 
+		// 新内存段就绪后通知其他进程重新映射，再恢复对象内容
+		endSegmentResize(DefinitionSegment, true);
+		resizing = false;
+
 		// 恢复模型参数对象的内容
 		for (size_t i = 0; i < localDefs.size() && i < defs_.size(); ++i) {
 			updateDefinition(defs_[i], localDefs[i]);
@@ -2027,6 +5385,9 @@ bool SharedMemoryManager::recreateDefinitionSegment(size_t newSize) {
 	}
 	catch (const std::exception& e) {
 		log(LogLevel::Error, "重新创建模型参数内存段失败: " + std::string(e.what()));
+		if (resizing) {
+			endSegmentResize(DefinitionSegment, true);
+		}
 		return false;
 	}
 }
@@ -2104,7 +5465,7 @@ bool SharedMemoryManager::saveToFile(const std::string& filePath, bool binaryFor
 // 将特定类型的共享内存段保存到文件
 bool SharedMemoryManager::saveSegmentToFile(const std::string& filePath, const std::string& segmentType, bool binaryFormat) {
     try {
-        std::shared_ptr<bip::managed_shared_memory> segment;
+        std::shared_ptr<SharedSegment> segment;
         std::vector<std::string> objectNames;
 
         // 根据段类型选择对应的内存段和对象列表
@@ -2217,7 +5578,7 @@ bool SharedMemoryManager::saveSegmentToFile(const std::string& filePath, const s
 bool SharedMemoryManager::saveObjectToFile(const std::string& filePath, const std::string& objectName, bool binaryFormat) {
     try {
         // 查找对象所在的内存段
-        std::shared_ptr<bip::managed_shared_memory> segment;
+        std::shared_ptr<SharedSegment> segment;
 
         // 尝试在各个内存段中查找对象
         if (controlSegment_) {
@@ -2282,7 +5643,7 @@ bool SharedMemoryManager::saveObjectToFile(const std::string& filePath, const st
 }
 
 // 内部辅助函数：将对象写入已打开的文件流
-bool SharedMemoryManager::saveObjectToFile(std::ofstream& file, std::shared_ptr<bip::managed_shared_memory> segment,
+bool SharedMemoryManager::saveObjectToFile(std::ofstream& file, std::shared_ptr<SharedSegment> segment,
                                            const std::string& objectName, bool binaryFormat) {
     try {
         // 获取对象数据
@@ -2514,7 +5875,7 @@ bool SharedMemoryManager::loadSegmentFromFile(const std::string& filePath, const
         }
 
         // 确保有对应的内存段
-        std::shared_ptr<bip::managed_shared_memory> segment;
+        std::shared_ptr<SharedSegment> segment;
         if (segmentType == "control") {
             segment = controlSegment_;
         }
@@ -2591,7 +5952,7 @@ bool SharedMemoryManager::loadObjectFromFile(const std::string& filePath, const
         }
 
         // 查找对象所在的内存段
-        std::shared_ptr<bip::managed_shared_memory> segment;
+        std::shared_ptr<SharedSegment> segment;
 
         if (objectName == "ControlData") {
             segment = controlSegment_;
@@ -2785,7 +6146,7 @@ bool SharedMemoryManager::loadObjectFromFile(const std::string& filePath, const
 }
 
 // 内部辅助函数：从已打开的文件流读取对象
-bool SharedMemoryManager::loadObjectFromFile(std::ifstream& file, std::shared_ptr<bip::managed_shared_memory> segment,
+bool SharedMemoryManager::loadObjectFromFile(std::ifstream& file, std::shared_ptr<SharedSegment> segment,
                                             bool binaryFormat) {
     try {
         std::string objectName;
@@ -2929,6 +6290,38 @@ bool SharedMemoryManager::loadObjectFromFile(std::ifstream& file, std::shared_pt
     }
 }
 
+// 快照名中的时间戳，格式为 YYYYMMDD_HHMMSS_ms，按字符串比较即按时间先后
+static std::string snapshotTimestamp() {
+    auto now = std::chrono::system_clock::now();
+    auto timeT = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()) % 1000;
+
+    std::stringstream ss;
+    ss << std::put_time(std::localtime(&timeT), "%Y%m%d_%H%M%S")
+       << "_" << std::setfill('0') << std::setw(3) << ms.count();
+    return ss.str();
+}
+
+// 数据名称转为快照文件名：字母、数字和 '.'、'_'、'-' 以外的字节写成 %XX，
+// 名称中的 '/'、'\'、':' 等不会改变文件位置，不同名称对应不同文件名。恢复时名称从文件内容读取
+static std::string snapshotFileName(const std::string& name) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string fileName;
+    for (unsigned char c : name) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+            || c == '.' || c == '_' || c == '-') {
+            fileName += static_cast<char>(c);
+        }
+        else {
+            fileName += '%';
+            fileName += hex[c >> 4];
+            fileName += hex[c & 0xF];
+        }
+    }
+    return fileName;
+}
+
 // 创建共享内存快照(保存所有共享内存段)用于undo/redo操作
 bool SharedMemoryManager::createSnapshot(const std::string& snapshotDir) {
     try {
@@ -2941,16 +6334,7 @@ bool SharedMemoryManager::createSnapshot(const std::string& snapshotDir) {
         }
 
         // 生成快照文件名（使用时间戳）
-        auto now = std::chrono::system_clock::now();
-        auto timeT = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-
-        std::stringstream ss;
-        ss << snapshotDir << "/snapshot_" << std::put_time(std::localtime(&timeT), "%Y%m%d_%H%M%S")
-           << "_" << std::setfill('0') << std::setw(3) << ms.count();
-
-        std::string snapshotPath = ss.str();
+        std::string snapshotPath = snapshotDir + "/snapshot_" + snapshotTimestamp();
 
         // 保存所有共享内存段
         return saveToFile(snapshotPath, true); // 使用二进制格式保存
@@ -3012,6 +6396,87 @@ bool SharedMemoryManager::restoreSnapshot(const std::string& snapshotDir) {
     }
 }
 
+// 创建计算数据的压缩快照
+bool SharedMemoryManager::createCompressedSnapshot(const std::string& snapshotDir,
+    const std::map<std::string, std::vector<double>>& errorBounds, unsigned threads) {
+    try {
+        fs::path snapshotPath = fs::path(snapshotDir) / ("compressed_" + snapshotTimestamp());
+        if (!fs::exists(snapshotPath) && !fs::create_directories(snapshotPath)) {
+            log(LogLevel::Error, "无法创建快照目录: " + snapshotPath.string());
+            return false;
+        }
+
+        static const std::vector<double> lossless;
+        for (auto data : datas_) {
+            // getData 在本地版本号与共享对象相同时不复制，每个对象使用新的 LocalData
+            LocalData localData;
+            getData(data, localData);
+            auto it = errorBounds.find(localData.name);
+            const std::vector<double>& bounds = it != errorBounds.end() ? it->second : lossless;
+
+            std::string filePath = (snapshotPath / (snapshotFileName(localData.name) + ".emz")).string();
+            if (!localData.saveCompressed(filePath, bounds, threads)) {
+                log(LogLevel::Error, "保存压缩数据失败: " + filePath);
+                return false;
+            }
+        }
+
+        log(LogLevel::Info, "已创建压缩快照: " + snapshotPath.string());
+        return true;
+    }
+    catch (const std::exception& e) {
+        log(LogLevel::Error, "创建压缩快照时发生异常: " + std::string(e.what()));
+        return false;
+    }
+}
+
+// 从最新的压缩快照恢复计算数据
+bool SharedMemoryManager::restoreCompressedSnapshot(const std::string& snapshotDir, unsigned threads) {
+    try {
+        if (!fs::exists(snapshotDir)) {
+            log(LogLevel::Error, "快照目录不存在: " + snapshotDir);
+            return false;
+        }
+
+        // 目录名中的时间戳按字符串比较即按时间先后
+        fs::path latestSnapshot;
+        for (const auto& entry : fs::directory_iterator(snapshotDir)) {
+            std::string dirName = entry.path().filename().string();
+            if (entry.is_directory() && dirName.find("compressed_") == 0
+                && (latestSnapshot.empty() || dirName > latestSnapshot.filename().string())) {
+                latestSnapshot = entry.path();
+            }
+        }
+        if (latestSnapshot.empty()) {
+            log(LogLevel::Error, "在目录中找不到压缩快照: " + snapshotDir);
+            return false;
+        }
+
+        log(LogLevel::Info, "正在恢复压缩快照: " + latestSnapshot.string());
+        LocalData localData;
+        for (const auto& entry : fs::directory_iterator(latestSnapshot)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".emz") {
+                continue;
+            }
+            if (!localData.loadCompressed(entry.path().string(), threads)) {
+                log(LogLevel::Error, "读取压缩数据失败: " + entry.path().string());
+                return false;
+            }
+            SharedData* data = findDataByName(localData.name);
+            if (!data) {
+                log(LogLevel::Warning, "共享内存中没有数据对象，跳过: " + localData.name);
+                continue;
+            }
+            updateData(data, localData);
+        }
+        return true;
+    }
+    catch (const std::exception& e) {
+        log(LogLevel::Error, "恢复压缩快照时发生异常: " + std::string(e.what()));
+        return false;
+    }
+}
+
 // 从控制数据中获取几何模型名称列表
 void SharedMemoryManager::getControlDataModelNames(std::vector<std::string>& modelNames) {
     if (!controlData_) {
@@ -3072,6 +6537,9 @@ void SharedMemoryManager::getDataTypeInfo(SharedData* data, bool& isFieldData, D
     }
 
     try {
+        SegmentReadScope scope(this, DataSegment);
+        data = rebaseObject(data, DataSegment);
+
         // 加锁保护并获取数据
         bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
 
@@ -3092,6 +6560,9 @@ void SharedMemoryManager::getDataMeshName(SharedData* data, std::string& meshNam
     }
 
     try {
+        SegmentReadScope scope(this, DataSegment);
+        data = rebaseObject(data, DataSegment);
+
         // 加锁保护并获取数据
         bip::scoped_lock<bip::interprocess_mutex> lock(data->mutex);
 
@@ -3115,8 +6586,10 @@ void SharedMemoryManager::updateControlDataDt(double dt) {
         bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
 
         // 更新时间步长
+        controlData_->beginWrite();
         controlData_->dt = dt;
         controlData_->version.store(controlData_->version.load() + 1);
+        controlData_->endWrite();
 
         log(LogLevel::Debug, "更新时间步长成功：dt = " + std::to_string(dt));
     }
@@ -3137,8 +6610,10 @@ void SharedMemoryManager::updateControlDataTime(double t) {
         bip::scoped_lock<bip::interprocess_mutex> lock(controlData_->mutex);
 
         // 更新当前时间
+        controlData_->beginWrite();
         controlData_->t = t;
         controlData_->version.store(controlData_->version.load() + 1);
+        controlData_->endWrite();
 
         log(LogLevel::Debug, "更新当前时间成功：t = " + std::to_string(t));
     }
@@ -2,6 +2,7 @@
 #define SHAREDMEMORYMANAGER_H
 
 #include "SharedMemoryStruct.h"
+#include "SharedSegment.h"
 #include "SharedMemoryLogger.h"
 #include <boost/interprocess/sync/scoped_lock.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
@@ -14,8 +15,18 @@
 #include <cstdint>
 #include <fstream>
 #include <functional>
+#include <map>
+#include <unordered_map>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace EMP {
+    class SharedMemoryPlanner;
+
     // 统一的后缀定义
     namespace SharedMemorySuffix {
         // 内存段后缀
@@ -53,9 +64,11 @@ namespace EMP {
     public:
         // 构造函数，增加前缀参数用于保证名称唯一性
         // 增加日志文件路径参数，如果为空则不创建日志
+        // segmentPageSizes 按 SegmentId 指定几何、网格、计算数据和模型参数内存段的页大小，未指定的使用默认页
         SharedMemoryManager(const std::string& memoryName, bool isCreator = false,
             const std::string& prefix = "", size_t control_memory_size = 1024 * 1024,
-            const std::string& logFilePath = "");
+            const std::string& logFilePath = "",
+            const std::vector<SegmentPageSize>& segmentPageSizes = {});
 
         ~SharedMemoryManager();
 
@@ -102,6 +115,19 @@ namespace EMP {
         // 根据名称查找模型参数对象
         SharedDefinitionList* findDefinitionByName(const std::string& name);
 
+        // 根据名称获取对象句柄，未登记时返回 INVALID_HANDLE。
+        // 句柄在所有进程中一致，调用方可缓存后反复使用，避免每次按名称查找
+        SharedHandle getGeometryHandle(const std::string& name);
+        SharedHandle getMeshHandle(const std::string& name);
+        SharedHandle getDataHandle(const std::string& name);
+        SharedHandle getDefinitionHandle(const std::string& name);
+
+        // 根据句柄获取对象指针，句柄无效时返回 nullptr
+        SharedGeometry* getGeometryByHandle(SharedHandle handle);
+        SharedMesh* getMeshByHandle(SharedHandle handle);
+        SharedData* getDataByHandle(SharedHandle handle);
+        SharedDefinitionList* getDefinitionByHandle(SharedHandle handle);
+
         // 获取分配器 - 根据类型选择不同的共享内存段
         template <typename T>
         SharedMemoryAllocator<T> getAllocator(const std::string& type = "") {
@@ -148,6 +174,241 @@ namespace EMP {
         // 获取计算数据对象 - 使用完整的LocalData
         void getData(SharedData* data, LocalData& localData);
 
+        // 按句柄更新/获取计算数据对象
+        void updateData(SharedHandle handle, const LocalData& localData);
+        void getData(SharedHandle handle, LocalData& localData);
+
+        // 局部更新计算数据对象：只改写从 offset 开始的 count 行，components[c] 为第 c 个分量的新值，
+        // 可以只给出前几个分量。行范围必须在已有数据之内，返回是否写入
+        bool updateDataRange(SharedData* data, size_t offset, size_t count, const std::vector<std::vector<double>>& components);
+        bool updateDataRange(const std::string& name, size_t offset, size_t count, const std::vector<std::vector<double>>& components);
+
+        // 增量读取：只复制 localData.version 之后改写过的行，返回改写过的行范围 (offset, count)。
+        // 期间有过整体写入或局部更新记录已被覆盖时退回整体读取，返回覆盖全部行的范围
+        std::vector<std::pair<size_t, size_t>> getDataChanges(SharedData* data, LocalData& localData);
+        std::vector<std::pair<size_t, size_t>> getDataChanges(const std::string& name, LocalData& localData);
+
+        // 获取计算数据对象的零拷贝只读视图，视图存活期间写入方会等待
+        SharedDataView getDataView(SharedData* data);
+        SharedDataView getDataView(const std::string& name);
+
+        // 写入方等待视图释放的上限(毫秒)，超过后放弃本次写入并记录警告，小于 0 表示一直等待。
+        // 等待期间定期回收已退出进程遗留的视图固定计数
+        void setViewReleaseTimeout(int timeoutMs);
+
+        // 等待视图释放的默认上限(毫秒)
+        static constexpr int DEFAULT_VIEW_RELEASE_TIMEOUT_MS = 5000;
+
+        // 阻塞等待对象版本号不同于 lastSeen，写入方发布新版本时直接唤醒等待方，无需轮询。
+        // timeoutMs 小于 0 表示一直等待；返回当前版本号，超时返回时等于 lastSeen
+        uint64_t waitForNewVersion(SharedDataBase* obj, uint64_t lastSeen, int timeoutMs = -1);
+        uint64_t waitForNewVersion(const std::string& name, uint64_t lastSeen, int timeoutMs = -1);
+
+        // 设置计算数据对象的多分量排列方式(平面或交错)，已有数据原地转置
+        bool setDataLayout(SharedData* data, DataLayout layout);
+        bool setDataLayout(const std::string& name, DataLayout layout);
+
+        // 设置计算数据对象的存储精度，已有数据原地转换。单精度和 bfloat16 使内存段中的数据量减半或更少，
+        // 读写接口仍为 double，写入和读取时转换；降低精度存储的对象不支持零拷贝视图
+        bool setDataPrecision(SharedData* data, DataPrecision precision);
+        bool setDataPrecision(const std::string& name, DataPrecision precision);
+
+        // 启用或关闭乐观(无锁)读取，默认启用
+        void setOptimisticReads(bool enable);
+
+        // 设置计算数据对象的缓冲槽数：1 为单缓冲(默认)，2 或 3 为多缓冲。
+        // 多缓冲模式下写入方填充后台槽后原子发布，读写互不阻塞，但共享内存占用按槽数增加
+        bool setDataSlotCount(SharedData* data, uint32_t slotCount);
+        bool setDataSlotCount(const std::string& name, uint32_t slotCount);
+
+        // ========== 多对象事务 ==========
+
+        // 开始事务。之后 stageData 暂存的更新在 commitTransaction 时一次发布，
+        // 读取方用 getDataGroup 读取时不会看到只更新了一部分的一组数据。事务属于本管理器，不要跨线程使用
+        void beginTransaction();
+
+        // 暂存计算数据对象的更新，复制 localData，调用方之后可以修改或释放
+        bool stageData(SharedData* data, const LocalData& localData);
+        bool stageData(const std::string& name, const LocalData& localData);
+
+        // 提交事务：一次检查内存，依次写入所有暂存的对象后发布新的组版本并返回；内存不足或没有进行中的事务时返回 0
+        uint64_t commitTransaction();
+
+        // 放弃暂存的更新
+        void abortTransaction();
+
+        // 一致地读取一组计算数据对象，localDatas 与 datas 一一对应，返回读到的组版本
+        uint64_t getDataGroup(const std::vector<SharedData*>& datas, std::vector<LocalData>& localDatas);
+        uint64_t getDataGroup(const std::vector<std::string>& names, std::vector<LocalData>& localDatas);
+
+        // ========== 读取方游标 ==========
+
+        // 各读取方在一个共享对象上的游标
+        struct ReaderCursor {
+            int readerId;           // 读取方编号
+            std::string name;       // 登记的读取方名称
+            uint64_t version;       // 最近读到的版本，0 表示尚未读取
+            bool subscribed;        // 是否订阅了该对象(读取过或显式订阅)
+            bool alive;             // 登记的进程是否仍在运行
+        };
+
+        // 以 readerName 登记为读取方，之后本管理器的 getXxx 和只读视图在各对象上记录读到的版本。
+        // 同名读取方已登记时(例如进程重启)沿用其编号和游标。返回读取方编号，登记表已满时返回 -1
+        int registerReader(const std::string& readerName);
+
+        // 注销本管理器登记的读取方，析构时自动调用
+        void unregisterReader();
+
+        // 注销指定名称的读取方，用于清理已退出但未注销的读取方
+        bool unregisterReader(const std::string& readerName);
+
+        // 本管理器登记的读取方编号，未登记时为 -1
+        int getReaderId() const;
+
+        // 显式记录本读取方已读到 readVersion，用于不经过本管理器的读取
+        void markConsumed(SharedDataBase* obj, uint64_t readVersion);
+
+        // 本读取方订阅对象，从对象的当前版本开始计入背压和多版本保留；读取过的对象自动订阅
+        bool subscribeReader(SharedDataBase* obj);
+
+        // 本读取方取消订阅对象，之后不再拖慢该对象的写入方
+        bool unsubscribeReader(SharedDataBase* obj);
+
+        // 所有登记读取方在对象上的游标
+        std::vector<ReaderCursor> getReaderCursors(SharedDataBase* obj);
+
+        // 订阅了对象且进程仍在运行的读取方中最旧的已读版本；没有这样的读取方时返回对象的当前版本
+        uint64_t slowestReaderVersion(SharedDataBase* obj);
+
+        // 等待订阅对象的读取方落后对象当前版本不超过 maxLag 个版本，timeoutMs 小于 0 表示一直等待；返回是否满足
+        bool waitForReaders(SharedDataBase* obj, uint64_t maxLag, int timeoutMs = -1);
+
+        // 写入背压：maxLag 大于 0 时，updateData 写入前等待最慢的订阅读取方落后不超过 maxLag - 1 个版本，
+        // 写入后落后不超过 maxLag；等待超过 timeoutMs 后记录警告并照常写入，小于 0 表示一直等待。
+        // maxLag 为 0 表示关闭(默认)
+        void setReaderBackpressure(uint64_t maxLag, int timeoutMs = DEFAULT_BACKPRESSURE_TIMEOUT_MS);
+
+        // 写入背压的默认等待上限(毫秒)
+        static constexpr int DEFAULT_BACKPRESSURE_TIMEOUT_MS = 1000;
+
+        // ========== 内容哈希 ==========
+
+        // 开启后，与共享数据内容(索引、分量数据和元数据)和时刻 t 都相同的整体写入不复制、不增加版本号，
+        // 读取方因此不会重新读取。边界条件、冻结区域等每步重写但很少变化的数据宜开启；未开启时写入不计算内容哈希
+        void setSkipUnchangedWrites(SharedData* data, bool enable);
+        bool setSkipUnchangedWrites(const std::string& name, bool enable);
+
+        // 共享数据的内容哈希，0 表示未知(尚未整体写入、之后有过局部更新或写入时未开启跳过)
+        uint64_t getContentHash(SharedData* data);
+
+        // localData 与共享数据的内容是否相同，只计算 localData 的哈希，不复制共享数据
+        bool isContentEqual(SharedData* data, const LocalData& localData);
+
+        // ========== 子集读取 ==========
+
+        // 设置计算数据中各几何位置(dimtag)对应的行范围，之后可以按 dimtag 只读取这些行。
+        // 行范围保存在共享对象中，所有读取方共用；整体写入改变了行的排列后需要重新设置
+        bool setDataRegions(SharedData* data, const std::vector<SharedDataRegion>& regions);
+        bool setDataRegions(const std::string& name, const std::vector<SharedDataRegion>& regions);
+
+        // 只读取 dimtags 对应的行(如流固耦合的湿表面)，按 dimtags 的顺序输出；没有设置行范围的 dimtag 返回 false。
+        // 子集的版本号与整体数据相同，不要再用同一个 LocalData 调用 getData；稀疏模式的对象不保留稠密行号，返回 false
+        bool getDataSubset(SharedData* data, const std::vector<std::pair<int, int>>& dimtags, LocalData& localData);
+        bool getDataSubset(const std::string& name, const std::vector<std::pair<int, int>>& dimtags, LocalData& localData);
+
+        // 只读取索引值在 ids 中的行，按 ids 的顺序输出，不存在的索引值跳过；稀疏模式下不存在的索引值视为省略的全零行，输出零。
+        // 本进程缓存索引值到行号的映射，索引列不变时重复读取无需重建
+        bool getDataSubset(SharedData* data, const std::vector<int>& ids, LocalData& localData);
+        bool getDataSubset(const std::string& name, const std::vector<int>& ids, LocalData& localData);
+
+        // ========== 稀疏模式 ==========
+
+        // 设置计算数据对象的稀疏模式：开启后整体写入只保存至少一个分量的绝对值大于 zeroTolerance 的行，
+        // 接触压力、源项、热流等大部分为零的场只占用非零行的空间。从下一次整体写入起生效，
+        // 读取得到稀疏数据，局部更新的行号按保存的行计
+        void setDataSparse(SharedData* data, bool enable, double zeroTolerance = 0.0);
+        bool setDataSparse(const std::string& name, bool enable, double zeroTolerance = 0.0);
+
+        // 读取计算数据并展开到 denseIndex 给出的各行(通常为网格的全部结点或单元编号)，未保存的行为 0
+        bool getDataDense(SharedData* data, const std::vector<int>& denseIndex, LocalData& localData);
+        bool getDataDense(const std::string& name, const std::vector<int>& denseIndex, LocalData& localData);
+
+        // ========== 低分辨率副本 ==========
+
+        // 为计算数据登记低分辨率副本 coarse，coarse 是控制数据中登记的另一个计算数据对象，按低分辨率数据规划大小。
+        // updateOnWrite 为真时本进程每次用 updateData 整体写入后立即按 coarsening 更新副本；否则由 refreshCoarseData
+        // 或 startCoarseRefresh 启动的后台线程更新，写入方不付出额外时间。界面、监视器等轻量客户端只读取副本即可
+        bool setDataCoarsening(SharedData* data, SharedData* coarse, const DataCoarsening& coarsening, bool updateOnWrite = true);
+        bool setDataCoarsening(const std::string& name, const std::string& coarseName, const DataCoarsening& coarsening,
+            bool updateOnWrite = true);
+
+        // 取消计算数据的全部低分辨率副本
+        void clearDataCoarsening(const std::string& name);
+
+        // 精细数据有新版本时重新生成其低分辨率副本，返回更新的副本数
+        size_t refreshCoarseData();
+
+        // 启动后台线程，每 intervalMs 毫秒更新一次 updateOnWrite 为假的副本(通常在 hub 进程中调用)。
+        // 线程使用独立的管理器连接同一组内存段，启动之后登记的副本在重新启动后生效
+        bool startCoarseRefresh(int intervalMs = 100);
+        void stopCoarseRefresh();
+
+        // ========== 写入时统计 ==========
+
+        // 最近一次整体写入时统计的各分量统计量(最小值、最大值、均值、L2 范数、NaN/Inf 个数)，
+        // 只读取数据头，不复制整个场。version 返回统计量对应的版本；尚未整体写入或之后有过局部更新时返回 false。
+        // 稀疏模式的对象按写入时的稠密行数统计，省略的行按 0 计入
+        bool getDataStats(SharedData* data, SharedFieldStats& stats, uint64_t* version = nullptr);
+        bool getDataStats(const std::string& name, SharedFieldStats& stats, uint64_t* version = nullptr);
+
+        // ========== 等待策略 ==========
+
+        // 设置对象上的等待策略，所有进程在该对象上的等待(新版本、加锁、视图释放、读取方跟上、多缓冲选槽)都按此进行。
+        // 默认不自旋也不让出 CPU，直接阻塞；全局力、力矩等小对象宜先自旋，大的场数据宜尽快阻塞，把 CPU 留给求解器
+        void setWaitPolicy(SharedDataBase* obj, const WaitPolicy& policy);
+        bool setWaitPolicy(const std::string& name, const WaitPolicy& policy);
+        WaitPolicy getWaitPolicy(SharedDataBase* obj);
+
+        // 对象上近期等待时间的指数平均(微秒)，只在 adaptive 策略下统计
+        uint32_t getAverageWaitMicros(SharedDataBase* obj);
+
+        // ========== 多版本保留 ==========
+
+        // 设置计算数据对象保留的版本：每个登记的读取方都能读到自己最近读取的版本及之前的 depth - 1 个版本，
+        // 没有读取方时保留最新的 depth 个版本；capacity 为最多保留的版本数(0 表示 2 * depth)，读取方落后太多时覆盖最旧的版本。
+        // depth 为 0 时关闭并释放空间，最多保留 SharedVersionStore::MAX_VERSIONS 个版本
+        bool setDataRetention(SharedData* data, uint32_t depth, uint32_t capacity = 0);
+        bool setDataRetention(const std::string& name, uint32_t depth, uint32_t capacity = 0);
+
+        // 按版本号读取计算数据对象，版本已被回收或从未保留时返回 false。不移动本读取方的游标
+        bool getDataVersion(SharedData* data, uint64_t version, LocalData& localData);
+        bool getDataVersion(const std::string& name, uint64_t version, LocalData& localData);
+
+        // 仍保留的版本号，从旧到新
+        std::vector<uint64_t> getRetainedVersions(SharedData* data);
+
+        // ========== 耦合历史帧 ==========
+
+        // 设置计算数据对象保存的历史帧数，0 表示关闭；保留已有历史中最新的帧，帧数不变时不做任何事
+        bool setDataHistory(SharedData* data, uint32_t capacity);
+        bool setDataHistory(const std::string& name, uint32_t capacity);
+
+        // 追加一帧历史数据，t 必须晚于最新帧；帧空间在数据段中一次分配，之后追加不再分配
+        bool appendDataFrame(SharedData* data, double t, const std::vector<std::vector<double>>& components);
+        bool appendDataFrame(const std::string& name, double t, const std::vector<std::vector<double>>& components);
+
+        // 当前保存的历史帧数
+        size_t getDataFrameCount(SharedData* data);
+        size_t getDataFrameCount(const std::string& name);
+
+        // 读取第 k 帧历史数据：k >= 0 从最旧的帧数起，k < 0 从最新的帧倒数
+        bool getDataFrame(SharedData* data, int k, double& t, std::vector<std::vector<double>>& components);
+        bool getDataFrame(const std::string& name, int k, double& t, std::vector<std::vector<double>>& components);
+
+        // 读取时刻 t 的历史数据：在两帧之间时线性插值，晚于最新帧时 extrapolate 为真则线性外推
+        bool getDataAtTime(SharedData* data, double t, std::vector<std::vector<double>>& components, bool extrapolate = false);
+        bool getDataAtTime(const std::string& name, double t, std::vector<std::vector<double>>& components, bool extrapolate = false);
+
         // 更新模型参数对象 - 使用完整的LocalDefinitionList
         void updateDefinition(SharedDefinitionList* def, const LocalDefinitionList& localDef);
 
@@ -155,19 +416,28 @@ namespace EMP {
         void getDefinition(SharedDefinitionList* def, LocalDefinitionList& localDef);
 
         // ========== 内存大小估算函数 ==========
+        // 按分配器的块头和对齐规则精确计算，见 SharedMemoryPlanner
 
-        // 估算几何对象所需的共享内存大小
+        // 几何对象所需的共享内存大小
         static size_t estimateGeometryMemorySize(const LocalGeometry& localGeo);
 
-        // 估算网格对象所需的共享内存大小
+        // 网格对象所需的共享内存大小
         static size_t estimateMeshMemorySize(const LocalMesh& localMesh);
 
-        // 估算计算数据对象所需的共享内存大小
-        static size_t estimateDataMemorySize(const LocalData& localData);
+        // 计算数据对象所需的共享内存大小，sparse 为真时按稀疏模式只计非零行
+        static size_t estimateDataMemorySize(const LocalData& localData, bool sparse = false, double zeroTolerance = 0.0);
+
+        // 以 localData 更新已有计算数据对象 config 后所需的共享内存大小，
+        // 计入其多缓冲槽、历史帧、多版本保留、存储精度和稀疏模式
+        static size_t estimateDataMemorySize(const LocalData& localData, const SharedData& config);
 
-        // 估算模型参数对象所需的共享内存大小
+        // 模型参数对象所需的共享内存大小
         static size_t estimateDefinitionMemorySize(const LocalDefinitionList& localDef);
 
+        // 按规划结果登记各对象所需的内存大小，并以规划的大小创建内存段(仅creator在运行开始前调用)。
+        // 已存在且小于规划大小的内存段会被扩容，之后 create*SegmentAndObjects 也使用规划的大小
+        bool applyMemoryPlan(const SharedMemoryPlanner& planner);
+
         // ========== 共享内存段管理函数 ==========
 
         // 返回控制共享内存段的总大小和已使用大小
@@ -185,9 +455,59 @@ namespace EMP {
         // 返回模型参数共享内存段的总大小和已使用大小
         std::pair<size_t, size_t> getDefinitionMemoryUsage() const;
 
-        // 更新所有内存段大小信息到控制数据
+        // 立即把所有内存段大小信息写入控制数据(需要锁定控制数据)
         void updateMemorySegmentInfo();
 
+        // 内存段使用统计
+        struct SegmentStats {
+            size_t totalSize = 0;     // 总大小
+            size_t freeSize = 0;      // 可用大小
+            uint64_t writeCount = 0;  // 本进程对该段的写入次数
+        };
+
+        // 获取内存段使用统计，直接读取内存段，不访问控制数据
+        SegmentStats getSegmentStats(SegmentId id) const;
+
+        // 按需刷新控制数据中的内存段统计：自上次发布后没有写入且 force 为 false 时不做任何事，返回是否发布
+        bool refreshMemorySegmentInfo(bool force = false);
+
+        // 设置写入路径自动发布统计的最小间隔(毫秒)，0 表示只在 refreshMemorySegmentInfo 时发布
+        void setMemoryStatsInterval(unsigned int intervalMs);
+
+        // ========== NUMA 放置 ==========
+
+        // 设置内存段的 NUMA 策略：NumaInterleave 在所有节点间交错，NumaBind 绑定到 node，
+        // NumaFirstTouch 把各计算数据对象的页放在写入它的进程所在节点。策略记录在控制数据中，
+        // 内存段重建或扩容后自动重新应用；非 Linux 平台只记录策略
+        bool setSegmentNumaPolicy(SegmentId id, SegmentNumaPolicy policy, int node = -1);
+
+        // 内存段当前的 NUMA 策略及绑定的节点
+        SegmentNumaPolicy getSegmentNumaPolicy(SegmentId id, int* node = nullptr) const;
+
+        // 内存段各页所在的节点
+        SegmentNumaInfo getSegmentNumaInfo(SegmentId id);
+
+        // 所有内存段的策略和各节点页数
+        std::string getNumaReport();
+
+        // ========== 持久化内存段 ==========
+
+        // 以 caseDirectory 下的文件作为几何、网格和模型参数内存段(或 segments 中指定的内存段)的后备存储，
+        // 文件在进程退出后保留(仅creator在创建这些内存段前调用，计算数据内存段不能持久化)
+        bool enablePersistentSegments(const std::string& caseDirectory,
+            const std::vector<SegmentId>& segments = { GeometrySegment, MeshSegment, DefinitionSegment });
+
+        // 内存段是否以文件持久化
+        bool isPersistentSegment(SegmentId id) const;
+
+        // 打开上次运行留下的内存段文件(仅creator)：文件的共享对象布局与本程序一致、内容已完整提交、
+        // 指纹等于 fingerprint，且控制数据中登记的对象都在文件中时加载其中的对象并返回 true，调用方可跳过重新生成；
+        // 否则返回 false，调用方照常创建内存段并生成内容
+        bool openPersistentSegment(SegmentId id, uint64_t fingerprint);
+
+        // 内存段内容已完整生成(仅creator)：记录指纹并写回文件，之后的运行可以直接打开。提交后再有写入时提交失效
+        bool commitPersistentSegment(SegmentId id, uint64_t fingerprint);
+
         // 从控制数据中获取几何模型名称列表
         void getControlDataModelNames(std::vector<std::string>& modelNames);
 
@@ -206,17 +526,25 @@ namespace EMP {
         // 更新控制数据中的当前时间
         void updateControlDataTime(double t);
 
-        // 检查几何对象所需内存空间是否足够，不足则设置异常
-        bool checkAndUpdateGeometryMemorySize(const std::string& name, const LocalGeometry& localGeo);
+        // 检查几何对象所需内存空间是否足够，不足则设置异常。
+        // 给出 existing 时只检查更新已有对象还需要的空间，否则按整个对象的大小检查(下同)
+        bool checkAndUpdateGeometryMemorySize(const std::string& name, const LocalGeometry& localGeo,
+            const SharedGeometry* existing = nullptr);
 
         // 检查网格对象所需内存空间是否足够，不足则设置异常
-        bool checkAndUpdateMeshMemorySize(const std::string& name, const LocalMesh& localMesh);
+        bool checkAndUpdateMeshMemorySize(const std::string& name, const LocalMesh& localMesh,
+            const SharedMesh* existing = nullptr);
 
         // 检查计算数据对象所需内存空间是否足够，不足则设置异常
-        bool checkAndUpdateDataMemorySize(const std::string& name, const LocalData& localData);
+        bool checkAndUpdateDataMemorySize(const std::string& name, const LocalData& localData,
+            const SharedData* existing = nullptr);
+
+        // 把计算数据对象所需的内存大小登记到控制数据，已登记的较大值保留
+        void recordDataMemorySize(const std::string& name, size_t objectSize);
 
         // 检查模型参数对象所需内存空间是否足够，不足则设置异常
-        bool checkAndUpdateDefinitionMemorySize(const std::string& name, const LocalDefinitionList& localDef);
+        bool checkAndUpdateDefinitionMemorySize(const std::string& name, const LocalDefinitionList& localDef,
+            const SharedDefinitionList* existing = nullptr);
 
         // 重新创建几何内存段，增加大小
         bool recreateGeometrySegment(size_t newSize);
@@ -233,6 +561,17 @@ namespace EMP {
         // Creator根据控制数据中的信息，自动调整内存段大小
         void autoAdjustMemorySegments();
 
+        // 原地扩容内存段到 newSize 字节(仅creator调用)。按离线扩容的方式进行：先停止所有进程在该段内的读写，
+        // 本进程解除映射后扩展底层对象，再重新映射；完成后段纪元加一，其他进程在下一次访问时自动重新映射，
+        // 已有对象的段内偏移不变。等待读写方离开超时(SEGMENT_RESIZE_TIMEOUT_MS)时放弃扩容并返回 false
+        bool growSegment(SegmentId id, size_t newSize);
+
+        // 扩容或重建内存段时等待各进程离开该段的上限(毫秒)
+        static constexpr int SEGMENT_RESIZE_TIMEOUT_MS = 10000;
+
+        // 段纪元发生变化时重新映射该内存段并重新加载对象指针
+        void refreshSegment(SegmentId id);
+
         // ========== 异常处理函数 ==========
 
 	    // 设置异常信息
@@ -281,6 +620,15 @@ namespace EMP {
         // 恢复共享内存快照(仅creator调用)
         bool restoreSnapshot(const std::string& snapshotDir);
 
+        // 创建计算数据的压缩快照：在 snapshotDir 下新建 compressed_<时间戳> 目录，每个计算数据对象保存为一个
+        // <名称>.emz 文件(见 LocalData::saveCompressed)。errorBounds 按数据名给出各分量允许的绝对误差，
+        // 未列出的数据无损保存。threads 为压缩线程数，0 表示按 CPU 核数
+        bool createCompressedSnapshot(const std::string& snapshotDir,
+            const std::map<std::string, std::vector<double>>& errorBounds = {}, unsigned threads = 0);
+
+        // 从 snapshotDir 中最新的压缩快照恢复计算数据对象的内容，快照中有而共享内存中没有的数据被跳过
+        bool restoreCompressedSnapshot(const std::string& snapshotDir, unsigned threads = 0);
+
 	private:
 		// 生成唯一的对象名称
 		std::string GenerateUniqueObjectName(const std::string& baseName);
@@ -306,6 +654,308 @@ namespace EMP {
         // 记录信息到日志
         void log(LogLevel level, const std::string& message);
 
+        // 等待对象上的所有只读视图释放，调用方需持有对象的互斥锁；超过 viewReleaseTimeoutMs_ 时返回 false
+        bool waitForViewsReleased(SharedDataBase* obj);
+
+        // 等待多缓冲对象出现可写入的后台槽，调用方不能持有对象的互斥锁。
+        // slot 不为空时在锁内占用该槽并返回槽号；超过 viewReleaseTimeoutMs_ 时返回 false
+        bool waitForWriteSlot(SharedData* data, int* slot = nullptr);
+
+        // 分段等待 released() 为真，每段结束时调用 recover() 回收已退出进程遗留的固定计数；超过 viewReleaseTimeoutMs_ 时返回 false
+        bool waitForViewRelease(SharedDataBase* obj, const std::function<bool()>& released, const std::function<void()>& recover);
+
+        // 回收持有方进程已退出的视图和槽固定计数，调用方需持有对象的互斥锁
+        void recoverViewPins(SharedDataBase* obj);
+
+        // 按对象的等待策略加锁：自旋和让出 CPU 期间反复尝试加锁，之后阻塞加锁
+        void lockObject(bip::scoped_lock<bip::interprocess_mutex>& lock, const SharedDataBase* obj);
+
+        // 按对象的等待策略等待 ready() 为真：自旋、让出 CPU 后每隔 WAIT_POLL_MICROS 微秒检查一次。
+        // timeoutMs 小于 0 表示一直等待；返回 ready() 是否为真
+        template <typename Ready>
+        bool waitUntil(const SharedDataBase* obj, Ready ready, int timeoutMs = -1) {
+            bool adaptive = obj->waitAdaptive.load(std::memory_order_relaxed);
+            auto start = std::chrono::steady_clock::now();
+
+            bool done = obj->spinWait(ready);
+            if (!done) {
+                auto deadline = start + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+                while (!(done = ready())) {
+                    if (timeoutMs >= 0 && std::chrono::steady_clock::now() >= deadline) {
+                        break;
+                    }
+                    std::this_thread::sleep_for(std::chrono::microseconds(WAIT_POLL_MICROS));
+                }
+            }
+
+            if (adaptive) {
+                obj->recordWait(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+            return done;
+        }
+
+        // 内存段的引用和名称
+        std::shared_ptr<SharedSegment>& segmentRef(SegmentId id);
+        std::string segmentName(SegmentId id);
+
+        // 按构造时指定的页大小创建内存段，大页不可用时记录回退；持久化的内存段创建为文件
+        std::shared_ptr<SharedSegment> createSegment(SegmentId id, const std::string& name, size_t size);
+
+        // 打开和删除内存段，持久化的内存段对应其目录下的文件
+        std::shared_ptr<SharedSegment> openSegment(SegmentId id, const std::string& name);
+        void removeSegment(SegmentId id, const std::string& name);
+
+        // 持久化内存段的目录，未持久化时为空
+        std::string persistentDirectory(SegmentId id) const;
+
+        // 持久化内存段中的校验记录，未持久化时为 nullptr
+        SharedSegmentRecord* segmentRecord(SegmentId id);
+
+        // 共享对象布局的签名，写入持久化内存段用于判断文件能否被本程序直接打开
+        static uint64_t segmentLayoutSignature();
+
+        // 重新加载内存段中的对象指针
+        void reloadSegmentObjects(SegmentId id);
+
+        // 将当前映射移入旧映射列表并记下其中各命名对象的地址，之后仍可把旧指针换到当前映射中的同名对象
+        void retireSegment(SegmentId id);
+
+        // 本管理器在该段内的读写全部结束后，释放不再被只读视图引用的旧映射
+        void releaseRetiredSegments(SegmentId id);
+
+        // 在控制数据的访问登记表中占用和释放一项，已退出进程占用的项被回收
+        void claimSegmentUser();
+        void releaseSegmentUser();
+
+        // 扩容或重建内存段前后调用：置扩容标志并等待各进程离开该段，超时后清除标志并返回 false；
+        // 结束时递增段纪元
+        bool beginSegmentResize(SegmentId id);
+        void endSegmentResize(SegmentId id, bool changed);
+
+        // 等待其他进程的扩容结束；扩容方已退出时清除其留下的扩容标志
+        void waitForSegmentResize(SegmentId id);
+
+        // 读写方进入/离开内存段，扩容进行中时等待；本管理器自己进行扩容时直接进入
+        void enterSegmentAccess(SegmentId id);
+        void leaveSegmentAccess(SegmentId id);
+
+        // 写入方进入/离开内存段，进入时使持久化内存段的提交失效
+        void enterSegmentWrite(SegmentId id);
+        void leaveSegmentWrite(SegmentId id);
+
+        class SegmentReadScope {
+        public:
+            SegmentReadScope(SharedMemoryManager* manager, SegmentId id) : manager_(manager), id_(id) {
+                manager_->enterSegmentAccess(id_);
+            }
+            ~SegmentReadScope() {
+                manager_->leaveSegmentAccess(id_);
+            }
+        private:
+            SharedMemoryManager* manager_;
+            SegmentId id_;
+        };
+
+        class SegmentWriteScope {
+        public:
+            SegmentWriteScope(SharedMemoryManager* manager, SegmentId id) : manager_(manager), id_(id) {
+                manager_->enterSegmentWrite(id_);
+            }
+            ~SegmentWriteScope() {
+                manager_->leaveSegmentWrite(id_);
+            }
+        private:
+            SharedMemoryManager* manager_;
+            SegmentId id_;
+        };
+
+        // 按对象所在的内存段进入读取范围并把 obj 换到当前映射，用于不区分对象类型的公开接口；
+        // 分段等待时由调用方先记下内存段，离开范围后旧映射可能已经释放
+        class ObjectReadScope {
+        public:
+            ObjectReadScope(SharedMemoryManager* manager, SharedDataBase*& obj)
+                : ObjectReadScope(manager, obj, manager->objectSegment(obj)) {
+            }
+            ObjectReadScope(SharedMemoryManager* manager, SharedDataBase*& obj, SegmentId id) : manager_(manager), id_(id) {
+                if (id_ < SegmentCount) {
+                    manager_->enterSegmentAccess(id_);
+                    obj = manager_->rebaseSharedObject(obj, id_);
+                }
+            }
+            ~ObjectReadScope() {
+                if (id_ < SegmentCount) {
+                    manager_->leaveSegmentAccess(id_);
+                }
+            }
+        private:
+            SharedMemoryManager* manager_;
+            SegmentId id_;
+        };
+
+        // 在控制数据的名称目录中查找句柄，先乐观读取，冲突时加锁
+        SharedHandle findHandle(SegmentId id, const std::string& name);
+
+        // 句柄对应的名称列表项
+        std::string handleName(SegmentId id, SharedHandle handle);
+
+        // 将几何体名称登记为主名称对应的句柄
+        void registerGeometryNames(const std::string& primaryName, const std::vector<std::string>& shapeNames);
+
+        // 句柄到对象指针：先查本进程缓存，未命中时按对象名在内存段中查找并缓存
+        template <typename T>
+        T* resolveHandle(SegmentId id, SharedHandle handle, const char* suffix) {
+            refreshSegment(id);
+
+            if (handle < 0) {
+                return nullptr;
+            }
+
+            std::vector<void*>& cache = handleCache_[id];
+            size_t index = static_cast<size_t>(handle);
+            if (index < cache.size() && cache[index]) {
+                return static_cast<T*>(cache[index]);
+            }
+
+            std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+            std::string name = handleName(id, handle);
+            if (!segment || name.empty()) {
+                return nullptr;
+            }
+
+            T* obj = segment->find<T>((name + suffix).c_str()).first;
+            if (obj) {
+                if (index >= cache.size()) {
+                    cache.resize(index + 1, nullptr);
+                }
+                cache[index] = obj;
+            }
+            return obj;
+        }
+
+        // 对象指针所在的内存段，当前映射和旧映射都不包含时返回 SegmentCount
+        SegmentId objectSegment(const void* obj);
+
+        // 按内存段 id 中的对象类型将可能来自旧映射的基类指针换到当前映射中的同名对象
+        SharedDataBase* rebaseSharedObject(SharedDataBase* obj, SegmentId id);
+
+        // 将可能来自旧映射的对象指针转换为当前映射中的同名对象
+        template <typename T>
+        T* rebaseObject(T* obj, SegmentId id) {
+            refreshSegment(id);
+
+            std::shared_ptr<SharedSegment>& segment = segmentRef(id);
+            if (!obj || !segment) {
+                return obj;
+            }
+
+            const char* p = reinterpret_cast<const char*>(obj);
+            const char* base = static_cast<const char*>(segment->get_address());
+            if (p >= base && p < base + segment->get_size()) {
+                return obj;
+            }
+
+            // 旧映射可能已经释放，按退役时记下的对象名到当前映射中查找；新近的映射优先
+            for (auto it = retiredSegments_[id].rbegin(); it != retiredSegments_[id].rend(); ++it) {
+                if (p >= it->base && p < it->base + it->size) {
+                    auto name = it->names.find(obj);
+                    if (name != it->names.end()) {
+                        T* found = segment->find<T>(name->second.c_str()).first;
+                        if (found) {
+                            return found;
+                        }
+                    }
+                    break;
+                }
+            }
+            return obj;
+        }
+
+        // 乐观读取：不加锁直接复制对象，复制前后顺序锁计数一致才算成功；
+        // 连续 OPTIMISTIC_READ_RETRIES 次与写入冲突时返回 false，由调用方退回加锁读取
+        template <typename SharedT, typename LocalT>
+        bool readOptimistic(const SharedT* obj, LocalT& local, const std::shared_ptr<SharedSegment>& segment) {
+            if (!optimisticReads_ || !obj || !segment) {
+                return false;
+            }
+
+            for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; ++attempt) {
+                uint64_t seq = obj->readBegin();
+                if (seq & 1) {
+                    // 写入进行中
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // 版本号未变化时无需复制
+                if (local.version == obj->version.load() && obj->readValidate(seq)) {
+                    return true;
+                }
+
+                bool copied = false;
+                beginOptimisticRead(segment->get_address(), segment->get_size());
+                try {
+                    obj->copyToLocal(local);
+                    copied = true;
+                }
+                catch (const std::exception&) {
+                    // 读到了写入中途的数据，重试
+                }
+                endOptimisticRead();
+
+                if (copied && obj->readValidate(seq)) {
+                    return true;
+                }
+
+                // 本次复制的内容无效，确保下次复制不会因为版本号相同而被跳过
+                local.version = std::numeric_limits<uint64_t>::max();
+            }
+            return false;
+        }
+
+        // 整体写入计算数据对象，updateData 在此之后更新低分辨率副本
+        void updateDataObject(SharedData* data, const LocalData& localData);
+
+        // 计算数据对象的名称，对象尚未写入时按控制数据中的登记顺序查找
+        std::string dataObjectName(SharedData* data);
+
+        // 稀疏模式的对象返回去掉全零行后写入 sparse 的数据，其他对象返回 localData 本身
+        const LocalData& sparseForWrite(SharedData* data, const LocalData& localData, LocalData& sparse);
+
+        // 多缓冲模式下的计算数据读写；没有可写入的后台槽且超过 viewReleaseTimeoutMs_ 时放弃写入并返回 false
+        bool updateDataSlotted(SharedData* data, const LocalData& localData, SharedMemoryAllocator<char> allocator, uint64_t hash,
+            uint64_t denseRows = 0);
+        void getDataSlotted(SharedData* data, LocalData& localData);
+
+        // 记录一次内存段写入，到达发布间隔时才刷新控制数据中的统计
+        void noteSegmentWrite(SegmentId id);
+
+        // 记录一次事务之外的计算数据写入，使正在读取一组对象的 getDataGroup 重试
+        void noteGroupWrite();
+        uint64_t totalSegmentWrites() const;
+
+        // 按控制数据中记录的策略设置内存段映射的 NUMA 策略
+        void applySegmentNumaPolicy(SegmentId id, SharedSegment& segment);
+
+        // NumaFirstTouch 策略下把计算数据对象的页放到本进程所在节点，对象的空间未重新分配时只放置一次
+        void placeDataNearWriter(SharedData* data);
+
+        // 按最慢读取方的游标设置多版本保留的回收下限(需持有对象的互斥锁)
+        void updateRetentionFloor(SharedData* data);
+
+        // 仍在运行的登记读取方的位掩码，已退出的读取方不计入背压和多版本保留
+        uint32_t liveReaderMask();
+
+        // 在 liveMask 中且订阅了对象的读取方中最旧的已读版本
+        uint64_t slowestReaderVersion(SharedDataBase* obj, uint32_t liveMask);
+
+        // 本管理器已登记为读取方时，记录在对象上读到的版本
+        void noteConsumed(const SharedDataBase* obj, uint64_t readVersion) {
+            if (readerId_ >= 0 && obj) {
+                obj->markConsumed(static_cast<uint32_t>(readerId_), readerGeneration_, readVersion);
+            }
+        }
+
         // 共用基础变量
         std::string memoryName_;
         std::shared_ptr<bip::named_mutex> sharedMutex_;
@@ -313,12 +963,112 @@ namespace EMP {
         std::string prefix_;
         std::unique_ptr<SharedMemoryLogger> logger_;
 
+        // 乐观读取开关及冲突重试次数
+        static const int OPTIMISTIC_READ_RETRIES = 16;
+
+        // 没有通知机制的等待在阻塞阶段的检查间隔(微秒)
+        static constexpr int WAIT_POLL_MICROS = 50;
+
+        // 等待视图释放期间检查持有方进程是否退出的间隔(毫秒)
+        static constexpr int VIEW_RECOVER_INTERVAL_MS = 1000;
+
+        // 等待新版本或读取方时每段在内存段内停留的上限(毫秒)，段之间扩容或重建可以进行
+        static constexpr int VERSION_WAIT_SLICE_MS = 100;
+
+        // 持久化内存段为校验记录预留的空间，以及文件格式的版本
+        static const size_t PERSISTENT_RECORD_RESERVE = 1024;
+        static const uint64_t PERSISTENT_FORMAT_VERSION = 1;
+        bool optimisticReads_ = true;
+
+        // 本管理器登记的读取方编号和代数，以及写入背压的设置
+        int readerId_ = -1;
+        uint32_t readerGeneration_ = 0;
+        uint64_t backpressureLag_ = 0;
+        int backpressureTimeoutMs_ = DEFAULT_BACKPRESSURE_TIMEOUT_MS;
+        int viewReleaseTimeoutMs_ = DEFAULT_VIEW_RELEASE_TIMEOUT_MS;
+
+        // 进行中的事务及其暂存的更新
+        bool transactionOpen_ = false;
+        std::vector<std::pair<SharedData*, LocalData>> stagedData_;
+
         // 单独的共享内存段
-        std::shared_ptr<bip::managed_shared_memory> controlSegment_;
-        std::shared_ptr<bip::managed_shared_memory> geometrySegment_;
-        std::shared_ptr<bip::managed_shared_memory> meshSegment_;
-        std::shared_ptr<bip::managed_shared_memory> dataSegment_;
-        std::shared_ptr<bip::managed_shared_memory> definitionSegment_;
+        std::shared_ptr<SharedSegment> controlSegment_;
+        std::shared_ptr<SharedSegment> geometrySegment_;
+        std::shared_ptr<SharedSegment> meshSegment_;
+        std::shared_ptr<SharedSegment> dataSegment_;
+        std::shared_ptr<SharedSegment> definitionSegment_;
+
+        // 本进程当前映射对应的段纪元，以及扩容/重建前的旧映射。旧映射在本管理器的读写结束且没有视图引用后释放，
+        // 其地址空间保留(reservedBase)以免被之后的映射复用，对象名保留用于转换调用方仍持有的旧指针
+        struct RetiredSegment {
+            std::shared_ptr<SharedSegment> segment;
+            const char* base;
+            size_t size;
+            std::unordered_map<const void*, std::string> names;
+            void* reservedBase = nullptr;
+            size_t reservedSize = 0;
+        };
+        uint64_t segmentEpochs_[SegmentCount] = {};
+        std::vector<RetiredSegment> retiredSegments_[SegmentCount];
+
+        // 本管理器在控制数据访问登记表中的项(-1 表示未占到)、正在进行的扩容，以及本管理器在各段内进行中的读写数
+        int segmentUserSlot_ = -1;
+        bool resizingSegment_[SegmentCount] = {};
+        std::atomic<uint32_t> localAccesses_[SegmentCount] = {};
+
+        // 句柄到对象指针的缓存，内存段重新映射时清空
+        std::vector<void*> handleCache_[SegmentCount];
+
+        // 构造时指定的各内存段页大小
+        size_t segmentPageSizes_[SegmentCount] = {};
+
+        // 本进程已放置到所在节点的计算数据对象，记录放置时的数据地址和节点
+        struct NumaPlacement {
+            const void* payload = nullptr;
+            int node = -1;
+        };
+        std::map<const SharedData*, NumaPlacement> numaPlacements_;
+
+        // 本进程缓存的索引值到行号的映射，indexHash 与共享对象不一致时重建
+        struct IndexLookup {
+            uint64_t indexHash = 0;
+            std::unordered_map<int, size_t> rows;
+        };
+        std::map<const SharedData*, IndexLookup> indexLookups_;
+
+        // 按精细数据名登记的低分辨率副本。rows 为 members 对应的精细数据行号(不存在时为 SIZE_MAX)，
+        // 按哈希为 indexHash 的索引列解析；refreshedVersion 为副本对应的精细数据版本
+        struct CoarseCompanion {
+            std::string coarseName;
+            DataCoarsening coarsening;
+            bool updateOnWrite = true;
+            uint64_t indexHash = 0;
+            std::vector<size_t> rows;
+            uint64_t refreshedVersion = 0;
+        };
+        std::map<std::string, std::vector<CoarseCompanion>> coarseCompanions_;
+
+        // 由版本为 fineVersion 的精细数据生成并写入一个副本；sparse 为真时 fine 是稀疏模式保存的数据，缺少的成员是全零行
+        bool writeCoarseData(CoarseCompanion& companion, const LocalData& fine, uint64_t fineVersion, bool sparse = false);
+
+        // 后台更新线程及其使用的独立管理器(管理器不是线程安全的，不能与调用方共用)
+        std::unique_ptr<SharedMemoryManager> coarseRefresher_;
+        std::thread coarseThread_;
+        std::mutex coarseThreadMutex_;
+        std::condition_variable coarseThreadWake_;
+        bool coarseThreadStop_ = false;
+
+        // 持久化内存段校验记录的缓存，内存段重新映射时清空
+        SharedSegmentRecord* segmentRecords_[SegmentCount] = {};
+
+        // applyMemoryPlan 规划的各内存段大小，0 表示未规划
+        size_t plannedSegmentSizes_[SegmentCount] = {};
+
+        // 各内存段的写入计数(进程内)，以及统计发布的间隔和状态
+        std::atomic<uint64_t> segmentWriteCounts_[SegmentCount] = {};
+        uint64_t publishedWriteTotal_ = 0;
+        std::chrono::milliseconds statsInterval_{ 1000 };
+        std::chrono::steady_clock::time_point nextStatsPublish_;
 
         // 共享对象指针
         SharedControlData* controlData_ = nullptr;
@@ -328,11 +1078,11 @@ namespace EMP {
         std::vector<SharedDefinitionList*> defs_;
 
         // 内部辅助函数：将对象写入已打开的文件流
-        bool saveObjectToFile(std::ofstream& file, std::shared_ptr<bip::managed_shared_memory> segment,
+        bool saveObjectToFile(std::ofstream& file, std::shared_ptr<SharedSegment> segment,
                              const std::string& objectName, bool binaryFormat);
 
         // 内部辅助函数：从已打开的文件流读取对象
-        bool loadObjectFromFile(std::ifstream& file, std::shared_ptr<bip::managed_shared_memory> segment,
+        bool loadObjectFromFile(std::ifstream& file, std::shared_ptr<SharedSegment> segment,
                                bool binaryFormat);
     };
 }
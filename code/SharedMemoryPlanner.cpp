@@ -0,0 +1,541 @@
+#include "SharedMemoryPlanner.h"
+#include "SharedMemoryManager.h"
+#include <boost/interprocess/managed_heap_memory.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+
+namespace EMP {
+
+    namespace {
+
+        // 与共享内存段使用相同分配算法和名称索引的进程内堆，用于测量段头和具名对象的固定开销
+        typedef bip::basic_managed_heap_memory<char, bip::rbtree_best_fit<bip::mutex_family>, bip::iset_index> ProbeHeap;
+        static_assert(std::is_same<ProbeHeap::segment_manager, bip::managed_shared_memory::segment_manager>::value,
+            "探测堆必须与共享内存段使用相同的段管理器");
+
+        typedef bip::managed_shared_memory::segment_manager::memory_algorithm MemoryAlgorithm;
+
+        // 探测堆大小，足够构造任一空的共享对象
+        const size_t PROBE_HEAP_SIZE = 64 * 1024;
+
+        size_t roundUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        // 分配器和字符串的常量只测量一次
+        struct ProbeConstants
+        {
+            size_t segmentOverhead;       // 段头和分配器管理结构
+            size_t minBlockBytes;         // 最小块
+            size_t internalBufferChars;   // 字符串内部缓冲的字符数(含结尾的 0)
+
+            ProbeConstants()
+            {
+                ProbeHeap probe(PROBE_HEAP_SIZE);
+                segmentOverhead = probe.get_size() - probe.get_free_memory();
+
+                size_t before = probe.get_free_memory();
+                void* block = probe.allocate(1);
+                minBlockBytes = before - probe.get_free_memory();
+                probe.deallocate(block);
+
+                SharedMemoryString empty{ SharedMemoryAllocator<char>(probe.get_segment_manager()) };
+                internalBufferChars = empty.capacity() + 1;
+            }
+        };
+
+        const ProbeConstants& probeConstants()
+        {
+            static const ProbeConstants constants;
+            return constants;
+        }
+
+        // 多版本保留的存储对象(匿名构造，不含各版本的数据)占用的字节数
+        size_t versionStoreBytes()
+        {
+            static const size_t bytes = [] {
+                ProbeHeap probe(PROBE_HEAP_SIZE);
+                size_t before = probe.get_free_memory();
+                probe.construct<SharedVersionStore>(bip::anonymous_instance)(probe.get_segment_manager());
+                return before - probe.get_free_memory();
+            }();
+            return bytes;
+        }
+
+        // 在探测堆中构造一个空的 T，返回占用的字节数
+        template <typename T>
+        size_t probeNamedObject(const std::string& objectName)
+        {
+            ProbeHeap probe(PROBE_HEAP_SIZE);
+            size_t before = probe.get_free_memory();
+            probe.construct<T>(objectName.c_str())(probe.get_segment_manager());
+            return before - probe.get_free_memory();
+        }
+
+        // 容器分配的累加器
+        struct PayloadCounter
+        {
+            size_t bytes = 0;
+            size_t count = 0;
+
+            void add(size_t allocated)
+            {
+                if (allocated > 0) {
+                    bytes += allocated;
+                    ++count;
+                }
+            }
+            void addVector(size_t elementCount, size_t elementSize)
+            {
+                if (elementCount > 0) {
+                    add(SharedMemoryPlanner::allocationBytes(elementCount * elementSize));
+                }
+            }
+            void addString(const std::string& value)
+            {
+                add(SharedMemoryPlanner::stringBytes(value.size()));
+            }
+        };
+
+        // 已在共享内存中的容器按当前容量计算
+        template <typename T>
+        size_t sharedVectorBytes(const SharedMemoryVector<T>& values)
+        {
+            return values.capacity() > 0 ? SharedMemoryPlanner::allocationBytes(values.capacity() * sizeof(T)) : 0;
+        }
+
+        size_t sharedStringBytes(const SharedMemoryString& value)
+        {
+            if (value.capacity() + 1 <= probeConstants().internalBufferChars) {
+                return 0;
+            }
+            return SharedMemoryPlanner::allocationBytes(value.capacity() + 1);
+        }
+
+        size_t sharedStringsBytes(const SharedMemoryVectorString& values)
+        {
+            size_t bytes = sharedVectorBytes(values);
+            for (const auto& value : values) {
+                bytes += sharedStringBytes(value);
+            }
+            return bytes;
+        }
+
+        // 多分量数据的行数取最长的分量，与 SharedFieldBuffer::assign 一致
+        size_t fieldValueCount(const LocalData& localData)
+        {
+            size_t rows = 0;
+            for (const auto& component : localData.data) {
+                rows = (std::max)(rows, component.size());
+            }
+            return rows * localData.data.size();
+        }
+
+        // 计算数据的容器分配，historyFrames 为 0 时不含历史帧，retainedVersions 为 0 时不含多版本保留
+        // 多分量数据按 precision 存储时的分配，双精度与其他精度分别存放在 values 和 packed 中
+        void addFieldValues(PayloadCounter& payload, size_t valueCount, DataPrecision precision)
+        {
+            if (precision == Float64Precision) {
+                payload.addVector(valueCount, sizeof(double));
+            } else {
+                payload.addVector(valueCount * SharedFieldBuffer::elementBytes(precision), sizeof(char));
+            }
+        }
+
+        // 稀疏模式下保存的行数，与 LocalData::toSparse 一致
+        size_t sparseRowCount(const LocalData& localData, double zeroTolerance)
+        {
+            size_t rowCount = localData.index.empty() && !localData.data.empty() ? localData.data[0].size() : localData.index.size();
+            std::vector<const double*> components(localData.data.size());
+            for (size_t c = 0; c < localData.data.size(); ++c) {
+                rowCount = (std::min)(rowCount, localData.data[c].size());
+                components[c] = localData.data[c].data();
+            }
+            return DataKernels::findNonZeroRows(components.data(), components.size(), rowCount, zeroTolerance, nullptr);
+        }
+
+        PayloadCounter dataPayload(const LocalData& localData, uint32_t slotCount, uint32_t historyFrames,
+            uint32_t retainedVersions = 0, DataPrecision precision = Float64Precision, bool sparse = false, double zeroTolerance = 0.0)
+        {
+            PayloadCounter payload;
+            payload.addString(localData.name);
+            payload.addString(localData.meshName);
+
+            // 标题和单位各保存 titles.size() 个，多缓冲模式下各槽另有一份
+            size_t payloadCopies = slotCount >= 2 ? slotCount : 1;
+            size_t titleCopies = slotCount >= 2 ? slotCount + 1 : 1;
+            for (size_t k = 0; k < titleCopies; ++k) {
+                payload.addVector(localData.titles.size(), sizeof(SharedMemoryString));
+                payload.addVector(localData.titles.size(), sizeof(SharedMemoryString));
+                for (size_t i = 0; i < localData.titles.size(); ++i) {
+                    payload.addString(localData.titles[i]);
+                    if (i < localData.units.size()) {
+                        payload.addString(localData.units[i]);
+                    }
+                }
+            }
+            payload.addVector(localData.dimtags.size(), sizeof(SharedMemoryPair));
+
+            // 多缓冲模式下索引和多分量数据存放在各个槽中
+            size_t indexCount = localData.index.size();
+            size_t valueCount = fieldValueCount(localData);
+            if (sparse) {
+                indexCount = sparseRowCount(localData, zeroTolerance);
+                valueCount = indexCount * localData.data.size();
+            }
+            for (size_t i = 0; i < payloadCopies; ++i) {
+                payload.addVector(indexCount, sizeof(int));
+                addFieldValues(payload, valueCount, precision);
+            }
+
+            if (historyFrames > 0) {
+                payload.addVector(historyFrames, sizeof(double));
+                payload.addVector(static_cast<size_t>(historyFrames) * valueCount, sizeof(double));
+            }
+
+            // 每个保留的版本各有一份索引和多分量数据
+            if (retainedVersions > 0) {
+                payload.add(versionStoreBytes());
+                for (uint32_t i = 0; i < retainedVersions; ++i) {
+                    payload.addVector(indexCount, sizeof(int));
+                    addFieldValues(payload, valueCount, precision);
+                }
+            }
+            return payload;
+        }
+
+        PayloadCounter geometryPayload(const LocalGeometry& localGeo)
+        {
+            PayloadCounter payload;
+            payload.addString(localGeo.name);
+            payload.addVector(localGeo.shapeNames.size(), sizeof(SharedMemoryString));
+            payload.addVector(localGeo.shapeNames.size(), sizeof(SharedMemoryString));
+            for (size_t i = 0; i < localGeo.shapeNames.size(); ++i) {
+                payload.addString(localGeo.shapeNames[i]);
+                payload.addString(localGeo.shapeBrps[i]);
+            }
+            return payload;
+        }
+
+        PayloadCounter meshPayload(const LocalMesh& localMesh)
+        {
+            PayloadCounter payload;
+            payload.addString(localMesh.name);
+            payload.addString(localMesh.modelName);
+            payload.addVector(localMesh.nodes.size(), sizeof(Node));
+            payload.addVector(localMesh.edges.size(), sizeof(Edge));
+            payload.addVector(localMesh.triangles.size(), sizeof(Triangle));
+            payload.addVector(localMesh.tetrahedrons.size(), sizeof(Tetrahedron));
+            return payload;
+        }
+
+        PayloadCounter definitionPayload(const LocalDefinitionList& localDef)
+        {
+            PayloadCounter payload;
+            payload.addString(localDef.name);
+            payload.addString(localDef.description);
+
+            size_t parameterCount = 0;
+            for (const auto& def : localDef.definitions) {
+                parameterCount += def.parameterNames.size();
+                for (const auto& parameterName : def.parameterNames) {
+                    payload.addString(parameterName);
+                }
+            }
+            payload.addVector(localDef.definitions.size(), sizeof(int));
+            payload.addVector(parameterCount, sizeof(SharedMemoryString));
+            payload.addVector(parameterCount, sizeof(double));
+            payload.addVector(localDef.definitions.size(), sizeof(int));
+            payload.addVector(localDef.definitions.size(), sizeof(int));
+            return payload;
+        }
+
+        // 整体赋值的字符串先构造新串再释放旧串，同一时刻最多多出一个
+        size_t transientStringBytes(std::initializer_list<const std::string*> values)
+        {
+            size_t bytes = 0;
+            for (const std::string* value : values) {
+                bytes = (std::max)(bytes, SharedMemoryPlanner::stringBytes(value->size()));
+            }
+            return bytes;
+        }
+
+        PlannedObject makePlannedObject(SegmentId segment, const std::string& name, const std::string& suffix,
+            const PayloadCounter& payload, size_t transientBytes)
+        {
+            PlannedObject object;
+            object.segment = segment;
+            object.name = name;
+            object.objectBytes = SharedMemoryPlanner::namedObjectBytes(segment, name + suffix);
+            object.payloadBytes = payload.bytes;
+            object.allocationCount = payload.count;
+            object.transientBytes = transientBytes;
+            return object;
+        }
+
+        size_t updateBytesFor(size_t newPayload, size_t currentPayload, size_t transientBytes)
+        {
+            // 容器增长时按最坏情况计：新空间全部分配完后旧空间才释放
+            return newPayload > currentPayload ? newPayload : transientBytes;
+        }
+
+        const char* segmentLabel(SegmentId id)
+        {
+            switch (id) {
+            case GeometrySegment: return "几何";
+            case MeshSegment: return "网格";
+            case DataSegment: return "计算数据";
+            case DefinitionSegment: return "模型参数";
+            default: return "未知";
+            }
+        }
+    }
+
+    //================ 分配器模型 ================
+    size_t SharedMemoryPlanner::allocationBytes(size_t userBytes)
+    {
+        // 与 rbtree_best_fit::priv_get_total_units 一致：已分配块的头部与前一块共用一个 size_type，
+        // 其余部分按 Alignment 对齐，且不小于一个最小块
+        const size_t alignment = MemoryAlgorithm::Alignment;
+        const size_t usableByPrevious = sizeof(MemoryAlgorithm::size_type);
+        const size_t allocatedCtrlBytes = MemoryAlgorithm::PayloadPerAllocation + usableByPrevious;
+
+        size_t bytes = (std::max)(userBytes, usableByPrevious);
+        size_t total = roundUp(bytes - usableByPrevious, alignment) + allocatedCtrlBytes;
+        return (std::max)(total, probeConstants().minBlockBytes);
+    }
+
+    size_t SharedMemoryPlanner::stringBytes(size_t length)
+    {
+        // 短字符串存放在内部缓冲中；长字符串按 boost::container::basic_string 的增长策略，
+        // 容量取 内部缓冲的两倍 与 内部缓冲 + 长度 + 1 中的较大者
+        size_t internalChars = probeConstants().internalBufferChars;
+        if (length < internalChars) {
+            return 0;
+        }
+        return allocationBytes((std::max)(2 * internalChars, internalChars + length + 1));
+    }
+
+    size_t SharedMemoryPlanner::segmentOverhead()
+    {
+        return probeConstants().segmentOverhead;
+    }
+
+    size_t SharedMemoryPlanner::segmentSize(size_t objectBytes, size_t headroomBytes)
+    {
+        // SharedSegment 在段管理器之前保留段头(按 Alignment 对齐的初始化标志)
+        size_t size = SharedSegment::HEADER_SIZE + segmentOverhead() + objectBytes + headroomBytes;
+        return roundUp(size, bip::mapped_region::get_page_size());
+    }
+
+    size_t SharedMemoryPlanner::namedObjectBytes(SegmentId id, const std::string& objectName)
+    {
+        // 占用只与对象类型和名称长度有关，按 (内存段, 名称长度) 缓存
+        static std::mutex cacheMutex;
+        static std::map<std::pair<int, size_t>, size_t> cache;
+
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto key = std::make_pair(static_cast<int>(id), objectName.size());
+        auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+
+        size_t bytes = 0;
+        switch (id) {
+        case GeometrySegment: bytes = probeNamedObject<SharedGeometry>(objectName); break;
+        case MeshSegment: bytes = probeNamedObject<SharedMesh>(objectName); break;
+        case DataSegment: bytes = probeNamedObject<SharedData>(objectName); break;
+        case DefinitionSegment: bytes = probeNamedObject<SharedDefinitionList>(objectName); break;
+        default: return 0;
+        }
+        cache[key] = bytes;
+        return bytes;
+    }
+
+    //================ 对象占用 ================
+    PlannedObject SharedMemoryPlanner::planGeometry(const LocalGeometry& localGeo)
+    {
+        // 几何对象按主几何体名称登记和构造
+        return makePlannedObject(GeometrySegment, localGeo.getPrimaryName(), SharedMemorySuffix::GEOMETRY,
+            geometryPayload(localGeo), transientStringBytes({ &localGeo.name }));
+    }
+
+    PlannedObject SharedMemoryPlanner::planMesh(const LocalMesh& localMesh)
+    {
+        return makePlannedObject(MeshSegment, localMesh.name, SharedMemorySuffix::MESH,
+            meshPayload(localMesh), transientStringBytes({ &localMesh.name, &localMesh.modelName }));
+    }
+
+    PlannedObject SharedMemoryPlanner::planData(const LocalData& localData, uint32_t slotCount, uint32_t historyFrames,
+        uint32_t retainedVersions, DataPrecision precision, bool sparse, double zeroTolerance)
+    {
+        return makePlannedObject(DataSegment, localData.name, SharedMemorySuffix::DATA,
+            dataPayload(localData, slotCount, historyFrames, retainedVersions, precision, sparse, zeroTolerance),
+            transientStringBytes({ &localData.name, &localData.meshName }));
+    }
+
+    PlannedObject SharedMemoryPlanner::planData(const LocalData& localData, const SharedData& config)
+    {
+        uint32_t retainedVersions = config.versions ? config.versions->capacity : 0;
+        return planData(localData, config.slotCount, config.history.capacity, retainedVersions, config.precision,
+            config.sparse.load(), config.sparseTolerance.load());
+    }
+
+    PlannedObject SharedMemoryPlanner::planDefinition(const LocalDefinitionList& localDef)
+    {
+        // 模型参数段目前只有一个默认对象
+        PlannedObject object = makePlannedObject(DefinitionSegment, "DefaultDefinition", SharedMemorySuffix::DEFINITION,
+            definitionPayload(localDef), transientStringBytes({ &localDef.name, &localDef.description }));
+        object.name = localDef.name;
+        return object;
+    }
+
+    size_t SharedMemoryPlanner::payloadBytes(const SharedGeometry& geo)
+    {
+        return sharedStringBytes(geo.name) + sharedStringsBytes(geo.shapeNames) + sharedStringsBytes(geo.shapeBrps);
+    }
+
+    size_t SharedMemoryPlanner::payloadBytes(const SharedMesh& mesh)
+    {
+        return sharedStringBytes(mesh.name) + sharedStringBytes(mesh.modelName) +
+            sharedVectorBytes(mesh.nodes) + sharedVectorBytes(mesh.Edges) +
+            sharedVectorBytes(mesh.Triangles) + sharedVectorBytes(mesh.Tetrahedrons);
+    }
+
+    size_t SharedMemoryPlanner::payloadBytes(const SharedData& data)
+    {
+        // 历史帧由 appendDataFrame 单独分配，保留的版本由 SharedVersionStore 管理，均不计入
+        size_t bytes = sharedStringBytes(data.name) + sharedStringBytes(data.meshName) +
+            sharedStringsBytes(data.titles) + sharedStringsBytes(data.units) +
+            sharedVectorBytes(data.dimtags) + sharedVectorBytes(data.index) +
+            sharedVectorBytes(data.data.values) + sharedVectorBytes(data.data.packed);
+        for (uint32_t i = 0; i < SharedData::MAX_SLOTS; ++i) {
+            bytes += sharedVectorBytes(data.slots[i].index) +
+                sharedVectorBytes(data.slots[i].data.values) + sharedVectorBytes(data.slots[i].data.packed) +
+                sharedStringsBytes(data.slots[i].titles) + sharedStringsBytes(data.slots[i].units);
+        }
+        return bytes;
+    }
+
+    size_t SharedMemoryPlanner::payloadBytes(const SharedDefinitionList& def)
+    {
+        return sharedStringBytes(def.name) + sharedStringBytes(def.description) +
+            sharedVectorBytes(def.ids) + sharedStringsBytes(def.parameterNames) +
+            sharedVectorBytes(def.parameterValues) + sharedVectorBytes(def.definitionStartIndices) +
+            sharedVectorBytes(def.definitionParameterCounts);
+    }
+
+    size_t SharedMemoryPlanner::updateBytes(const SharedGeometry& geo, const LocalGeometry& localGeo)
+    {
+        return updateBytesFor(geometryPayload(localGeo).bytes, payloadBytes(geo),
+            transientStringBytes({ &localGeo.name }));
+    }
+
+    size_t SharedMemoryPlanner::updateBytes(const SharedMesh& mesh, const LocalMesh& localMesh)
+    {
+        return updateBytesFor(meshPayload(localMesh).bytes, payloadBytes(mesh),
+            transientStringBytes({ &localMesh.name, &localMesh.modelName }));
+    }
+
+    size_t SharedMemoryPlanner::updateBytes(const SharedData& data, const LocalData& localData)
+    {
+        size_t bytes = updateBytesFor(dataPayload(localData, data.slotCount, 0, 0, data.precision).bytes, payloadBytes(data),
+            transientStringBytes({ &localData.name, &localData.meshName }));
+
+        // 多版本保留时新版本可能占用一个尚未分配的空位，按最坏情况计
+        if (data.versions) {
+            PayloadCounter retained;
+            retained.addVector(localData.index.size(), sizeof(int));
+            addFieldValues(retained, fieldValueCount(localData), data.precision);
+            bytes += retained.bytes;
+        }
+        return bytes;
+    }
+
+    size_t SharedMemoryPlanner::updateBytes(const SharedDefinitionList& def, const LocalDefinitionList& localDef)
+    {
+        return updateBytesFor(definitionPayload(localDef).bytes, payloadBytes(def),
+            transientStringBytes({ &localDef.name, &localDef.description }));
+    }
+
+    //================ 规划 ================
+    void SharedMemoryPlanner::addGeometry(const LocalGeometry& localGeo)
+    {
+        objects_.push_back(planGeometry(localGeo));
+    }
+
+    void SharedMemoryPlanner::addMesh(const LocalMesh& localMesh)
+    {
+        objects_.push_back(planMesh(localMesh));
+    }
+
+    void SharedMemoryPlanner::addData(const LocalData& localData, uint32_t slotCount, uint32_t historyFrames,
+        uint32_t retainedVersions, DataPrecision precision, bool sparse, double zeroTolerance)
+    {
+        objects_.push_back(planData(localData, slotCount, historyFrames, retainedVersions, precision, sparse, zeroTolerance));
+    }
+
+    void SharedMemoryPlanner::addDefinition(const LocalDefinitionList& localDef)
+    {
+        objects_.push_back(planDefinition(localDef));
+    }
+
+    void SharedMemoryPlanner::clear()
+    {
+        objects_.clear();
+    }
+
+    const std::vector<PlannedObject>& SharedMemoryPlanner::objects() const
+    {
+        return objects_;
+    }
+
+    SegmentPlan SharedMemoryPlanner::segmentPlan(SegmentId id) const
+    {
+        SegmentPlan plan;
+        bool hasObjects = false;
+        for (const auto& object : objects_) {
+            if (object.segment != id) {
+                continue;
+            }
+            hasObjects = true;
+            plan.objectBytes += object.totalBytes();
+            plan.headroomBytes = (std::max)(plan.headroomBytes, object.transientBytes);
+        }
+
+        if (!hasObjects) {
+            return plan;
+        }
+        plan.fixedBytes = segmentOverhead();
+        plan.size = segmentSize(plan.objectBytes, plan.headroomBytes);
+        return plan;
+    }
+
+    std::string SharedMemoryPlanner::report() const
+    {
+        std::ostringstream out;
+        for (int id = 0; id < SegmentCount; ++id) {
+            SegmentPlan plan = segmentPlan(static_cast<SegmentId>(id));
+            if (plan.size == 0) {
+                continue;
+            }
+
+            out << segmentLabel(static_cast<SegmentId>(id)) << "内存段: " << plan.size << " 字节 (固定开销 "
+                << plan.fixedBytes << ", 对象 " << plan.objectBytes << ", 临时空间 " << plan.headroomBytes << ")\n";
+            for (const auto& object : objects_) {
+                if (object.segment != id) {
+                    continue;
+                }
+                out << "  " << object.name << ": " << object.totalBytes() << " 字节 (对象 " << object.objectBytes
+                    << ", 容器 " << object.payloadBytes << ", 分配 " << object.allocationCount << " 次)\n";
+            }
+        }
+        return out.str();
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef SHAREDMEMORYPLANNER_H
+#define SHAREDMEMORYPLANNER_H
+
+#include <string>
+#include <vector>
+#include "SharedMemoryStruct.h"
+
+namespace EMP {
+
+    // 规划中的单个共享对象的内存占用，均为分配器实际占用的字节数(含块头和对齐)
+    struct SOLVERHUB_API PlannedObject
+    {
+        SegmentId segment;          // 所在内存段
+        std::string name;           // 对象名(不含后缀)
+        size_t objectBytes;         // 具名对象本身，含名称和索引节点
+        size_t payloadBytes;        // 对象内各容器的分配
+        size_t allocationCount;     // 容器的分配次数
+        size_t transientBytes;      // 更新时先分配新字符串再释放旧字符串所需的临时空间
+
+        size_t totalBytes() const { return objectBytes + payloadBytes; }
+    };
+
+    // 单个内存段的规划结果
+    struct SOLVERHUB_API SegmentPlan
+    {
+        size_t fixedBytes = 0;      // 段头和分配器的管理结构
+        size_t objectBytes = 0;     // 段内所有对象之和
+        size_t headroomBytes = 0;   // 更新时的临时空间
+        size_t size = 0;            // 创建内存段时使用的大小(按页对齐)，段内没有对象时为 0
+    };
+
+    /// 共享内存段的容量规划器。
+    /// 按 rbtree_best_fit 分配器的块头、最小块和对齐规则，以及各共享对象 copyFromLocal 的分配方式，
+    /// 精确计算每个对象的占用；运行开始前由配置的几何、网格、计算数据和模型参数规划各内存段的大小，
+    /// 各对象在规划范围内更新时不会再出现空间不足和运行期间的扩容。
+    class SOLVERHUB_API SharedMemoryPlanner
+    {
+    public:
+        // 添加待规划的对象
+        void addGeometry(const LocalGeometry& localGeo);
+        void addMesh(const LocalMesh& localMesh);
+        // slotCount 为多缓冲槽数(0 为单缓冲)，historyFrames 为历史帧容量(0 为不保存历史)，
+        // retainedVersions 为多版本保留的版本数上限(0 为不保留)，precision 为多分量数据的存储精度，
+        // sparse 为真时按稀疏模式只计 localData 中绝对值大于 zeroTolerance 的行，非零行会增加时应以最多的一步规划
+        void addData(const LocalData& localData, uint32_t slotCount = 0, uint32_t historyFrames = 0, uint32_t retainedVersions = 0,
+            DataPrecision precision = Float64Precision, bool sparse = false, double zeroTolerance = 0.0);
+        void addDefinition(const LocalDefinitionList& localDef);
+        void clear();
+
+        // 各对象的规划结果
+        const std::vector<PlannedObject>& objects() const;
+
+        // 内存段的规划结果
+        SegmentPlan segmentPlan(SegmentId id) const;
+
+        // 逐段、逐对象的占用明细
+        std::string report() const;
+
+        // ========== 分配器模型 ==========
+
+        // 申请 userBytes 字节时分配器实际占用的字节数
+        static size_t allocationBytes(size_t userBytes);
+
+        // 长度为 length 的共享字符串在内部缓冲之外分配的字节数，短字符串为 0
+        static size_t stringBytes(size_t length);
+
+        // 内存段的固定开销：段头、分配器管理结构和末尾块
+        static size_t segmentOverhead();
+
+        // 容纳 objectBytes 个对象字节并保留 headroomBytes 临时空间所需的内存段大小(按页对齐)
+        static size_t segmentSize(size_t objectBytes, size_t headroomBytes);
+
+        // 在 id 对应的内存段中以 objectName(含后缀)构造一个空对象所占用的字节数
+        static size_t namedObjectBytes(SegmentId id, const std::string& objectName);
+
+        // ========== 对象占用 ==========
+
+        static PlannedObject planGeometry(const LocalGeometry& localGeo);
+        static PlannedObject planMesh(const LocalMesh& localMesh);
+        static PlannedObject planData(const LocalData& localData, uint32_t slotCount = 0, uint32_t historyFrames = 0,
+            uint32_t retainedVersions = 0, DataPrecision precision = Float64Precision, bool sparse = false, double zeroTolerance = 0.0);
+        // 按已有共享对象当前的多缓冲、历史帧、多版本保留、精度和稀疏模式规划
+        static PlannedObject planData(const LocalData& localData, const SharedData& config);
+        static PlannedObject planDefinition(const LocalDefinitionList& localDef);
+
+        // 已在共享内存中的对象当前持有的容器空间
+        static size_t payloadBytes(const SharedGeometry& geo);
+        static size_t payloadBytes(const SharedMesh& mesh);
+        static size_t payloadBytes(const SharedData& data);
+        static size_t payloadBytes(const SharedDefinitionList& def);
+
+        // 用本地数据更新已有对象时还需要的剩余空间：容器总量不增长时只需要临时空间
+        static size_t updateBytes(const SharedGeometry& geo, const LocalGeometry& localGeo);
+        static size_t updateBytes(const SharedMesh& mesh, const LocalMesh& localMesh);
+        static size_t updateBytes(const SharedData& data, const LocalData& localData);
+        static size_t updateBytes(const SharedDefinitionList& def, const LocalDefinitionList& localDef);
+
+    private:
+        std::vector<PlannedObject> objects_;
+    };
+}
+
+#endif // SHAREDMEMORYPLANNER_H
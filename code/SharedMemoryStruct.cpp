@@ -3,7 +3,13 @@
 #include <iostream>
 #include <algorithm>
 #include <ctime>
+#include <cstring>
 #include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "SharedDataKernels.h"
 
 namespace EMP {
     //================ LocalDataBase 实现 ================
@@ -49,18 +55,51 @@ namespace EMP {
     {
         version.store(0);
         writing.store(false);
+        sequence.store(0);
+        waiters.store(0);
+        writeStartVersion = 0;
         dataRead.store(true); // 初始设为已读
+        viewPins.store(0);
+        for (uint32_t i = 0; i < MAX_VIEW_HOLDERS; ++i) {
+            viewHolderPids[i].store(0);
+            viewHolderSlots[i].store(-1);
+            viewHolderPins[i].store(0);
+        }
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerCursors[i].store(0);
+        }
+        waitSpinMicros.store(0);
+        waitYieldMicros.store(0);
+        waitAdaptive.store(false);
+        waitAverageMicros.store(0);
         sysTimeStamp = std::time(nullptr);
     }
 
     SharedDataBase::SharedDataBase(const SharedDataBase& other)
         : version(other.version.load()),
         writing(other.writing.load()),
+        sequence(0),
+        waiters(0),
+        writeStartVersion(0),
         dataRead(other.dataRead.load()),
+        viewPins(0),
+        waitSpinMicros(other.waitSpinMicros.load()),
+        waitYieldMicros(other.waitYieldMicros.load()),
+        waitAdaptive(other.waitAdaptive.load()),
+        waitAverageMicros(other.waitAverageMicros.load()),
         sysTimeStamp(other.sysTimeStamp),
         name(other.name),
         dataType(other.dataType)
     {
+        // 游标和视图持有方属于原对象，副本从未读取开始
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerCursors[i].store(0);
+        }
+        for (uint32_t i = 0; i < MAX_VIEW_HOLDERS; ++i) {
+            viewHolderPids[i].store(0);
+            viewHolderSlots[i].store(-1);
+            viewHolderPins[i].store(0);
+        }
     }
 
     SharedDataBase& SharedDataBase::operator=(const SharedDataBase& other)
@@ -68,6 +107,9 @@ namespace EMP {
         version.store(other.version.load());
         writing.store(other.writing.load());
         dataRead.store(other.dataRead.load());
+        waitSpinMicros.store(other.waitSpinMicros.load());
+        waitYieldMicros.store(other.waitYieldMicros.load());
+        waitAdaptive.store(other.waitAdaptive.load());
         sysTimeStamp = other.sysTimeStamp;
         name = other.name;
         dataType = other.dataType;
@@ -82,6 +124,214 @@ namespace EMP {
         dataType = type;
     }
 
+    void SharedDataBase::beginWrite() {
+        writeStartVersion = version.load();
+        writing.store(true);
+        sequence.fetch_add(1, std::memory_order_relaxed);
+        // 保证后续的数据写入不会被重排到计数变为奇数之前
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void SharedDataBase::endWrite() {
+        sequence.fetch_add(1, std::memory_order_release);
+        writing.store(false);
+
+        // 只在确有新版本且有人等待时唤醒
+        if (version.load() != writeStartVersion && waiters.load() > 0) {
+            versionChanged.notify_all();
+        }
+    }
+
+    uint64_t SharedDataBase::waitForVersion(bip::scoped_lock<bip::interprocess_mutex>& lock, uint64_t lastSeen, int timeoutMs) {
+        boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() +
+            boost::posix_time::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+
+        waiters.fetch_add(1);
+        while (version.load() == lastSeen) {
+            if (timeoutMs < 0) {
+                versionChanged.wait(lock);
+            }
+            else if (!versionChanged.timed_wait(lock, deadline)) {
+                break; // 超时
+            }
+        }
+        waiters.fetch_sub(1);
+
+        return version.load();
+    }
+
+    uint64_t SharedDataBase::readBegin() const {
+        return sequence.load(std::memory_order_acquire);
+    }
+
+    bool SharedDataBase::readValidate(uint64_t seq) const {
+        // 保证之前的数据读取不会被重排到再次读取计数之后
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (seq & 1) == 0 && sequence.load(std::memory_order_relaxed) == seq;
+    }
+
+    WaitPolicy SharedDataBase::getWaitPolicy() const {
+        WaitPolicy policy;
+        policy.spinMicros = waitSpinMicros.load();
+        policy.yieldMicros = waitYieldMicros.load();
+        policy.adaptive = waitAdaptive.load();
+        return policy;
+    }
+
+    void SharedDataBase::setWaitPolicy(const WaitPolicy& policy) {
+        waitSpinMicros.store(policy.spinMicros);
+        waitYieldMicros.store(policy.yieldMicros);
+        waitAdaptive.store(policy.adaptive);
+        waitAverageMicros.store(0);
+    }
+
+    uint32_t SharedDataBase::effectiveSpinMicros() const {
+        uint32_t spinMicros = waitSpinMicros.load(std::memory_order_relaxed);
+        if (!waitAdaptive.load(std::memory_order_relaxed)) {
+            return spinMicros;
+        }
+
+        // 等待通常在自旋时长内结束时自旋到平均等待时间的两倍，否则自旋只会浪费 CPU
+        uint32_t average = waitAverageMicros.load(std::memory_order_relaxed);
+        if (average > spinMicros) {
+            return 0;
+        }
+        return (std::min)(spinMicros, 2 * average + 1);
+    }
+
+    void SharedDataBase::recordWait(uint64_t micros) const {
+        if (!waitAdaptive.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        // 指数平均，新样本权重 1/8；多个进程同时更新时丢失个别样本无关紧要
+        uint32_t sample = static_cast<uint32_t>((std::min)(micros, uint64_t(UINT32_MAX / 2)));
+        uint32_t average = waitAverageMicros.load(std::memory_order_relaxed);
+        int64_t next = int64_t(average) + (int64_t(sample) - int64_t(average)) / 8;
+        waitAverageMicros.store(static_cast<uint32_t>(next), std::memory_order_relaxed);
+    }
+
+    int SharedDataBase::registerViewHolder(int64_t holderPid, int32_t slot) const {
+        if (holderPid <= 0) {
+            return -1;
+        }
+        // 新的登记都在锁内进行，不会争用空闲项；已有项的计数可能同时被释放，归零后仍属于同一持有方
+        for (uint32_t i = 0; i < MAX_VIEW_HOLDERS; ++i) {
+            if (viewHolderPins[i].load() > 0 && viewHolderPids[i].load() == holderPid && viewHolderSlots[i].load() == slot) {
+                viewHolderPins[i].fetch_add(1);
+                return static_cast<int>(i);
+            }
+        }
+        for (uint32_t i = 0; i < MAX_VIEW_HOLDERS; ++i) {
+            if (viewHolderPins[i].load() == 0) {
+                viewHolderPids[i].store(holderPid);
+                viewHolderSlots[i].store(slot);
+                viewHolderPins[i].fetch_add(1);
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void SharedDataBase::releaseViewHolder(int holder) const {
+        if (holder >= 0 && holder < static_cast<int>(MAX_VIEW_HOLDERS)) {
+            viewHolderPins[holder].fetch_sub(1);
+        }
+    }
+
+    void SharedDataBase::markConsumed(uint32_t reader, uint32_t generation, uint64_t readVersion) const {
+        if (reader >= MAX_READERS) {
+            return;
+        }
+        uint64_t mask = (uint64_t(1) << READER_GENERATION_SHIFT) - 1;
+        readerCursors[reader].store((uint64_t(generation) << READER_GENERATION_SHIFT) | (readVersion & mask),
+            std::memory_order_release);
+    }
+
+    uint64_t SharedDataBase::consumedVersion(uint32_t reader, uint32_t generation) const {
+        if (reader >= MAX_READERS) {
+            return 0;
+        }
+        uint64_t cursor = readerCursors[reader].load(std::memory_order_acquire);
+        if ((cursor >> READER_GENERATION_SHIFT) != (generation & 0xFFFF)) {
+            return 0;
+        }
+        return cursor & ((uint64_t(1) << READER_GENERATION_SHIFT) - 1);
+    }
+
+    bool SharedDataBase::hasConsumer(uint32_t reader, uint32_t generation) const {
+        if (reader >= MAX_READERS) {
+            return false;
+        }
+        // 游标初始为 0，登记的代数从 1 开始，因此从未读取过的读取方代数不会相符
+        uint64_t cursor = readerCursors[reader].load(std::memory_order_acquire);
+        return cursor != 0 && (cursor >> READER_GENERATION_SHIFT) == (generation & 0xFFFF);
+    }
+
+    void SharedDataBase::clearConsumer(uint32_t reader) const {
+        if (reader < MAX_READERS) {
+            readerCursors[reader].store(0, std::memory_order_release);
+        }
+    }
+
+    void SharedDataBase::resetTransientState() {
+        // 上次运行可能在持锁或写入途中退出，锁和条件变量重新构造
+        new (&mutex) bip::interprocess_mutex();
+        new (&versionChanged) bip::interprocess_condition();
+        writing.store(false);
+        if (sequence.load() & 1) {
+            sequence.fetch_add(1);
+        }
+        waiters.store(0);
+        viewPins.store(0);
+        for (uint32_t i = 0; i < MAX_VIEW_HOLDERS; ++i) {
+            viewHolderPids[i].store(0);
+            viewHolderSlots[i].store(-1);
+            viewHolderPins[i].store(0);
+        }
+        waitAverageMicros.store(0);
+
+        // 读取方登记表随控制数据重建，上次运行留下的游标不再有效
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerCursors[i].store(0);
+        }
+    }
+
+    //================ 乐观读取校验 ================
+    // 当前线程正在乐观读取的内存段地址范围，为空表示不在乐观读取中
+    static thread_local const char* optimisticReadBegin = nullptr;
+    static thread_local const char* optimisticReadEnd = nullptr;
+
+    void beginOptimisticRead(const void* segmentBase, size_t segmentSize) {
+        optimisticReadBegin = static_cast<const char*>(segmentBase);
+        optimisticReadEnd = optimisticReadBegin + segmentSize;
+    }
+
+    void endOptimisticRead() {
+        optimisticReadBegin = nullptr;
+        optimisticReadEnd = nullptr;
+    }
+
+    void checkSharedRange(const void* ptr, size_t count, size_t elementSize) {
+        if (!optimisticReadBegin || count == 0) {
+            return;
+        }
+
+        const char* p = static_cast<const char*>(ptr);
+        size_t available = static_cast<size_t>(optimisticReadEnd - optimisticReadBegin);
+        if (p < optimisticReadBegin || p >= optimisticReadEnd ||
+            count > available / elementSize ||
+            count * elementSize > static_cast<size_t>(optimisticReadEnd - p)) {
+            throw SharedReadConflict("共享容器地址越界，对象正在被写入");
+        }
+    }
+
+    std::string toLocalString(const SharedMemoryString& s) {
+        // 短字符串存放在对象内部，长字符串存放在段内，两种情况都需要整体落在段内
+        checkSharedRange(s.data(), s.size(), sizeof(char));
+        return std::string(s.data(), s.size());
+    }
+
     //================ MeshInfo 实现 ================
     MeshInfo::MeshInfo() {
         myNbNodes = 0;
@@ -259,7 +509,7 @@ namespace EMP {
         // 确保所有分量数据长度一致
         size_t maxSize = 0;
         for (const auto& comp : data) {
-            maxSize = max(maxSize, comp.size());
+            maxSize = (std::max)(maxSize, comp.size());
         }
 
         // 将所有分量数据长度调整为相同
@@ -729,6 +979,290 @@ namespace EMP {
         }
     }
 
+    // 复制除索引列和分量数据以外的内容
+    static void copyLocalMeta(const LocalData& from, LocalData& to)
+    {
+        to.name = from.name;
+        to.sysTimeStamp = from.sysTimeStamp;
+        to.version = from.version;
+        to.dataType = from.dataType;
+        to.meshName = from.meshName;
+        to.isFieldData = from.isFieldData;
+        to.type = from.type;
+        to.t = from.t;
+        to.dimtags = from.dimtags;
+        to.titles = from.titles;
+        to.units = from.units;
+    }
+
+    bool LocalData::hasUniformComponents() const {
+        for (const auto& component : data) {
+            if (component.size() != data[0].size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LocalData::toSparse(LocalData& sparse, double zeroTolerance) const {
+        size_t rowCount = index.empty() && !data.empty() ? data[0].size() : index.size();
+        std::vector<const double*> components(data.size());
+        for (size_t c = 0; c < data.size(); ++c) {
+            rowCount = (std::min)(rowCount, data[c].size());
+            components[c] = data[c].data();
+        }
+
+        std::vector<size_t> rows;
+        DataKernels::findNonZeroRows(components.data(), components.size(), rowCount, zeroTolerance, &rows);
+
+        LocalData result;
+        copyLocalMeta(*this, result);
+        result.index.resize(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            result.index[i] = index.empty() ? static_cast<int>(rows[i]) : index[rows[i]];
+        }
+        result.data.resize(data.size());
+        for (size_t c = 0; c < data.size(); ++c) {
+            result.data[c].resize(rows.size());
+            DataKernels::gatherRows(components[c], rows.data(), rows.size(), result.data[c].data());
+        }
+        sparse = std::move(result);
+    }
+
+    void LocalData::toDense(const std::vector<int>& denseIndex, LocalData& dense) const {
+        std::unordered_map<int, size_t> denseRows;
+        denseRows.reserve(denseIndex.size());
+        for (size_t i = 0; i < denseIndex.size(); ++i) {
+            denseRows.emplace(denseIndex[i], i);
+        }
+
+        // 稀疏行在稠密数据中的位置
+        size_t rowCount = index.size();
+        for (const auto& component : data) {
+            rowCount = (std::min)(rowCount, component.size());
+        }
+        std::vector<size_t> sparseRows, targetRows;
+        sparseRows.reserve(rowCount);
+        targetRows.reserve(rowCount);
+        for (size_t i = 0; i < rowCount; ++i) {
+            auto it = denseRows.find(index[i]);
+            if (it != denseRows.end()) {
+                sparseRows.push_back(i);
+                targetRows.push_back(it->second);
+            }
+        }
+        bool contiguous = sparseRows.size() == rowCount;
+
+        LocalData result;
+        copyLocalMeta(*this, result);
+        result.index = denseIndex;
+        result.data.resize(data.size());
+        std::vector<double> gathered;
+        for (size_t c = 0; c < data.size(); ++c) {
+            result.data[c].assign(denseIndex.size(), 0.0);
+            const double* src = data[c].data();
+            if (!contiguous) {
+                gathered.resize(sparseRows.size());
+                DataKernels::gatherRows(src, sparseRows.data(), sparseRows.size(), gathered.data());
+                src = gathered.data();
+            }
+            DataKernels::scatterRows(src, targetRows.data(), targetRows.size(), result.data[c].data());
+        }
+        dense = std::move(result);
+    }
+
+    //================ DataCoarsening 实现 ================
+    DataCoarsening DataCoarsening::sampling(const std::vector<int>& ids) {
+        DataCoarsening coarsening;
+        coarsening.coarseIndex = ids;
+        coarsening.members = ids;
+        coarsening.offsets.resize(ids.size() + 1);
+        for (size_t k = 0; k <= ids.size(); ++k) {
+            coarsening.offsets[k] = k;
+        }
+        return coarsening;
+    }
+
+    DataCoarsening DataCoarsening::averaging(const std::vector<int>& coarseIndex, const std::vector<std::vector<int>>& groups) {
+        if (groups.size() != coarseIndex.size()) {
+            throw std::invalid_argument("分组数与低分辨率索引行数不一致: " + std::to_string(groups.size()) +
+                " != " + std::to_string(coarseIndex.size()));
+        }
+
+        DataCoarsening coarsening;
+        coarsening.coarseIndex = coarseIndex;
+        coarsening.offsets.reserve(coarseIndex.size() + 1);
+        coarsening.offsets.push_back(0);
+        for (size_t k = 0; k < coarseIndex.size(); ++k) {
+            coarsening.members.insert(coarsening.members.end(), groups[k].begin(), groups[k].end());
+            coarsening.offsets.push_back(coarsening.members.size());
+        }
+        return coarsening;
+    }
+
+    // 压缩文件的标识和格式版本
+    static const char COMPRESSED_MAGIC[4] = { 'E', 'M', 'P', 'Z' };
+    static const uint32_t COMPRESSED_FORMAT_VERSION = 1;
+
+    template <typename T>
+    static void writeBinary(std::ofstream& file, T v)
+    {
+        file.write(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    template <typename T>
+    static T readBinary(std::ifstream& file)
+    {
+        T v{};
+        if (!file.read(reinterpret_cast<char*>(&v), sizeof(T))) {
+            throw std::runtime_error("文件不完整");
+        }
+        return v;
+    }
+
+    static void writeBinaryString(std::ofstream& file, const std::string& s)
+    {
+        writeBinary<uint32_t>(file, static_cast<uint32_t>(s.size()));
+        file.write(s.data(), s.size());
+    }
+
+    static std::string readBinaryString(std::ifstream& file)
+    {
+        std::string s(readBinary<uint32_t>(file), '\0');
+        if (!file.read(&s[0], s.size())) {
+            throw std::runtime_error("文件不完整");
+        }
+        return s;
+    }
+
+    static void writeBinaryBlob(std::ofstream& file, const std::vector<uint8_t>& blob)
+    {
+        writeBinary<uint64_t>(file, blob.size());
+        file.write(reinterpret_cast<const char*>(blob.data()), blob.size());
+    }
+
+    static void readBinaryBlob(std::ifstream& file, std::vector<uint8_t>& blob)
+    {
+        uint64_t bytes = readBinary<uint64_t>(file);
+        blob.resize(bytes);
+        if (!file.read(reinterpret_cast<char*>(blob.data()), bytes)) {
+            throw std::runtime_error("文件不完整");
+        }
+    }
+
+    bool LocalData::saveCompressed(const std::string& filePath, const std::vector<double>& errorBounds, unsigned threads) const {
+        try {
+            std::ofstream file(filePath, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            file.write(COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC));
+            writeBinary<uint32_t>(file, COMPRESSED_FORMAT_VERSION);
+
+            // 元数据
+            writeBinaryString(file, name);
+            writeBinaryString(file, meshName);
+            writeBinary<uint8_t>(file, isFieldData ? 1 : 0);
+            writeBinary<int32_t>(file, static_cast<int32_t>(type));
+            writeBinary<double>(file, t);
+            writeBinary<int64_t>(file, static_cast<int64_t>(sysTimeStamp));
+            writeBinary<uint64_t>(file, version);
+            writeBinary<uint32_t>(file, static_cast<uint32_t>(dimtags.size()));
+            for (const auto& dt : dimtags) {
+                writeBinary<int32_t>(file, dt.first);
+                writeBinary<int32_t>(file, dt.second);
+            }
+
+            // 索引列
+            std::vector<uint8_t> blob;
+            DataKernels::encodeIndex(index.data(), index.size(), blob);
+            writeBinaryBlob(file, blob);
+
+            // 各分量：标题、单位和压缩后的数据
+            writeBinary<uint32_t>(file, static_cast<uint32_t>(data.size()));
+            for (size_t c = 0; c < data.size(); ++c) {
+                double errorBound = 0.0;
+                if (!errorBounds.empty()) {
+                    errorBound = c < errorBounds.size() ? errorBounds[c] : errorBounds.back();
+                }
+                writeBinaryString(file, c < titles.size() ? titles[c] : std::string());
+                writeBinaryString(file, c < units.size() ? units[c] : std::string());
+                DataKernels::compressValues(data[c].data(), data[c].size(), errorBound, blob, threads);
+                writeBinaryBlob(file, blob);
+            }
+
+            file.close();
+            return !file.fail();
+        } catch (const std::exception& e) {
+            std::cerr << "Error in saveCompressed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    bool LocalData::loadCompressed(const std::string& filePath, unsigned threads) {
+        try {
+            std::ifstream file(filePath, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+
+            char magic[sizeof(COMPRESSED_MAGIC)] = {};
+            file.read(magic, sizeof(magic));
+            if (!file || std::memcmp(magic, COMPRESSED_MAGIC, sizeof(magic)) != 0) {
+                std::cerr << "Error in loadCompressed: 不是压缩数据文件: " << filePath << std::endl;
+                return false;
+            }
+            uint32_t formatVersion = readBinary<uint32_t>(file);
+            if (formatVersion != COMPRESSED_FORMAT_VERSION) {
+                std::cerr << "Error in loadCompressed: 不支持的文件格式版本 " << formatVersion << std::endl;
+                return false;
+            }
+
+            // 先读入临时对象，文件损坏时不改动当前数据
+            LocalData loaded;
+            loaded.name = readBinaryString(file);
+            loaded.meshName = readBinaryString(file);
+            loaded.isFieldData = readBinary<uint8_t>(file) != 0;
+            loaded.type = static_cast<DataGeoType>(readBinary<int32_t>(file));
+            loaded.t = readBinary<double>(file);
+            loaded.sysTimeStamp = static_cast<time_t>(readBinary<int64_t>(file));
+            loaded.version = readBinary<uint64_t>(file);
+            uint32_t dimtagCount = readBinary<uint32_t>(file);
+            for (uint32_t i = 0; i < dimtagCount; ++i) {
+                int dim = readBinary<int32_t>(file);
+                int tag = readBinary<int32_t>(file);
+                loaded.dimtags.emplace_back(dim, tag);
+            }
+
+            std::vector<uint8_t> blob;
+            readBinaryBlob(file, blob);
+            if (!DataKernels::decodeIndex(blob.data(), blob.size(), loaded.index)) {
+                throw std::runtime_error("索引列数据损坏");
+            }
+
+            uint32_t componentCount = readBinary<uint32_t>(file);
+            loaded.titles.resize(componentCount);
+            loaded.units.resize(componentCount);
+            loaded.data.resize(componentCount);
+            for (uint32_t c = 0; c < componentCount; ++c) {
+                loaded.titles[c] = readBinaryString(file);
+                loaded.units[c] = readBinaryString(file);
+                readBinaryBlob(file, blob);
+                if (!DataKernels::decompressValues(blob.data(), blob.size(), loaded.data[c], threads)) {
+                    throw std::runtime_error("分量数据损坏: " + loaded.titles[c]);
+                }
+            }
+
+            loaded.setDataType(DataType::CALCULATION_DATA);
+            *this = std::move(loaded);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Error in loadCompressed: " << e.what() << std::endl;
+            return false;
+        }
+    }
+
     //================ LocalControlData 实现 ================
     LocalControlData::LocalControlData()
         : LocalDataBase(),
@@ -831,7 +1365,7 @@ namespace EMP {
             return;
         }
 
-        writing.store(true);
+        beginWrite();
         version.store(version.load() + 1);
 
         // 设置基础属性
@@ -841,6 +1375,8 @@ namespace EMP {
         // 处理所有几何体数据
         shapeNames.clear();
         shapeBrps.clear();
+        shapeNames.reserve(local.shapeNames.size());
+        shapeBrps.reserve(local.shapeNames.size());
 
         for (size_t i = 0; i < local.shapeNames.size(); i++) {
             const std::string& localName = local.shapeNames[i];
@@ -851,7 +1387,7 @@ namespace EMP {
         }
 
         dataRead.store(false); // 标记为未读
-        writing.store(false);
+        endWrite();
     }
 
     void SharedGeometry::copyToLocal(LocalGeometry& local) const
@@ -863,7 +1399,7 @@ namespace EMP {
         }
 
         // 设置基础属性
-        local.name = std::string(name.c_str());
+        local.name = toLocalString(name);
         local.sysTimeStamp = sysTimeStamp;
         local.version = version.load(); // 更新本地版本号
 
@@ -872,9 +1408,11 @@ namespace EMP {
         local.shapeBrps.clear();
 
         // 复制所有几何体数据
-        for (size_t i = 0; i < shapeNames.size(); i++) {
-            local.shapeNames.push_back(std::string(shapeNames[i].c_str()));
-            local.shapeBrps.push_back(std::string(shapeBrps[i].c_str()));
+        checkSharedContainer(shapeNames);
+        checkSharedContainer(shapeBrps);
+        for (size_t i = 0; i < shapeNames.size() && i < shapeBrps.size(); i++) {
+            local.shapeNames.push_back(toLocalString(shapeNames[i]));
+            local.shapeBrps.push_back(toLocalString(shapeBrps[i]));
         }
 
         dataRead.store(true); // 标记为已读
@@ -943,7 +1481,7 @@ namespace EMP {
             return;
         }
 
-        writing.store(true);
+        beginWrite();
         version.store(version.load() + 1);
 
         // 设置基础属性
@@ -990,7 +1528,7 @@ namespace EMP {
         }
 
         dataRead.store(false); // 标记为未读
-        writing.store(false);
+        endWrite();
     }
 
     void SharedDefinitionList::copyToLocal(LocalDefinitionList& local) const
@@ -1002,17 +1540,23 @@ namespace EMP {
         }
 
         // 设置基础属性
-        local.name = std::string(name.c_str());
+        local.name = toLocalString(name);
         local.sysTimeStamp = sysTimeStamp;
         local.version = version.load(); // 更新本地版本号
         local.dataType = dataType;
-        local.description = std::string(description.c_str());
+        local.description = toLocalString(description);
 
         // 清空定义列表
         local.definitions.clear();
 
+        checkSharedContainer(ids);
+        checkSharedContainer(definitionStartIndices);
+        checkSharedContainer(definitionParameterCounts);
+        checkSharedContainer(parameterNames);
+        checkSharedContainer(parameterValues);
+
         // 重建所有定义
-        for (size_t i = 0; i < ids.size(); i++) {
+        for (size_t i = 0; i < ids.size() && i < definitionStartIndices.size() && i < definitionParameterCounts.size(); i++) {
             Definition def;
             def.id = ids[i];
 
@@ -1023,10 +1567,11 @@ namespace EMP {
             // 复制参数
             for (int j = 0; j < paramCount; j++) {
                 int paramIndex = startIndex + j;
-                if (paramIndex < parameterNames.size() && paramIndex < parameterValues.size()) {
-                    def.parameterNames.push_back(std::string(parameterNames[paramIndex].c_str()));
-                    def.parameterValues.push_back(parameterValues[paramIndex]);
+                if (paramIndex < 0 || paramIndex >= parameterNames.size() || paramIndex >= parameterValues.size()) {
+                    break; // 参数索引连续，越界后后续参数也都越界
                 }
+                def.parameterNames.push_back(toLocalString(parameterNames[paramIndex]));
+                def.parameterValues.push_back(parameterValues[paramIndex]);
             }
 
             // 添加到定义列表
@@ -1078,7 +1623,7 @@ namespace EMP {
             return;
         }
 
-        writing.store(true);
+        beginWrite();
         version.store(version.load() + 1);
 
         // 设置基础属性
@@ -1117,7 +1662,7 @@ namespace EMP {
         }
 
         dataRead.store(false); // 标记为未读
-        writing.store(false);
+        endWrite();
     }
 
     void SharedMesh::copyToLocal(LocalMesh& local) const
@@ -1129,11 +1674,16 @@ namespace EMP {
         }
 
         // 设置基础属性
-        local.name = std::string(name.c_str());
+        local.name = toLocalString(name);
         local.sysTimeStamp = sysTimeStamp;
         local.version = version.load(); // 更新本地版本号
         local.dataType = dataType;
-        local.modelName = std::string(modelName.c_str());
+        local.modelName = toLocalString(modelName);
+
+        checkSharedContainer(nodes);
+        checkSharedContainer(Edges);
+        checkSharedContainer(Triangles);
+        checkSharedContainer(Tetrahedrons);
 
         // 复制节点数据 - 优化：先预分配空间
         local.nodes.clear();
@@ -1166,195 +1716,1733 @@ namespace EMP {
         dataRead.store(true); // 标记为已读
     }
 
-    //================ SharedData 实现 ================
-    SharedData::SharedData(bip::managed_shared_memory::segment_manager* segment_manager)
-        : SharedDataBase(segment_manager, DataType::CALCULATION_DATA),
-        meshName(SharedMemoryAllocator<char>(segment_manager)),
-        index(SharedMemoryAllocator<int>(segment_manager)),
-        data(SharedMemoryAllocator<SharedMemoryVector<double>>(segment_manager)),
-        dimtags(SharedMemoryAllocator<SharedMemoryPair>(segment_manager)),
-        titles(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
-        units(SharedMemoryAllocator<SharedMemoryString>(segment_manager))
+    //================ SharedFieldBuffer 实现 ================
+    SharedFieldBuffer::SharedFieldBuffer(bip::managed_shared_memory::segment_manager* segment_manager)
+        : layout(PlanarLayout),
+        precision(Float64Precision),
+        componentCount(0),
+        rowCount(0),
+        values(SharedMemoryAllocator<double>(segment_manager)),
+        packed(SharedMemoryAllocator<char>(segment_manager))
     {
-        isFieldData = true;
-        t = 0.0;
-        type = VertexData;
-        setDataType(DataType::CALCULATION_DATA);
     }
 
-    SharedData::SharedData(const SharedData& other)
-        : SharedDataBase(other),
-        t(other.t),
-        type(other.type),
-        meshName(other.meshName),
-        index(other.index),
-        data(other.data),
-        dimtags(other.dimtags),
-        titles(other.titles),
-        units(other.units),
-        isFieldData(other.isFieldData)
+    SharedFieldBuffer::SharedFieldBuffer(const SharedFieldBuffer& other)
+        : layout(other.layout),
+        precision(other.precision),
+        componentCount(other.componentCount),
+        rowCount(other.rowCount),
+        values(other.values),
+        packed(other.packed)
     {
-        setDataType(DataType::CALCULATION_DATA);
     }
 
-    SharedData& SharedData::operator=(const SharedData& other)
+    SharedFieldBuffer& SharedFieldBuffer::operator=(const SharedFieldBuffer& other)
     {
-        SharedDataBase::operator=(other);
-        t = other.t;
-        type = other.type;
-        meshName = other.meshName;
-        index = other.index;
-        data = other.data;
-        dimtags = other.dimtags;
-        titles = other.titles;
-        units = other.units;
-        isFieldData = other.isFieldData;
+        layout = other.layout;
+        precision = other.precision;
+        componentCount = other.componentCount;
+        rowCount = other.rowCount;
+        values = other.values;
+        packed = other.packed;
         return *this;
     }
 
-    void SharedData::copyFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator)
+    size_t SharedFieldBuffer::elementBytes(DataPrecision precision)
     {
-        // 如果版本号相同，则不需要更新
-        if (local.version == version.load()) {
-            // 直接返回，不做任何更改
-            return;
+        switch (precision) {
+        case Float32Precision:
+            return sizeof(float);
+        case BFloat16Precision:
+            return sizeof(uint16_t);
+        default:
+            return sizeof(double);
         }
+    }
 
-        writing.store(true);
-        version.store(version.load() + 1);
+    bool SharedFieldBuffer::isReduced() const
+    {
+        return precision != Float64Precision;
+    }
 
-        // 设置基础属性
-        name = SharedMemoryString(local.name.c_str(), allocator);
-        sysTimeStamp = local.sysTimeStamp;
-        dataType = local.dataType;
-        meshName = SharedMemoryString(local.meshName.c_str(), allocator);
-        isFieldData = local.isFieldData;
-        type = local.type;
-        t = local.t;
+    bool SharedFieldBuffer::empty() const
+    {
+        return componentCount == 0;
+    }
 
-        // 复制索引数据 - 优化：先预分配空间
-        index.clear();
-        index.reserve(local.index.size());
-        for (const auto& idx : local.index) {
-            index.push_back(idx);
-        }
+    void SharedFieldBuffer::clear()
+    {
+        componentCount = 0;
+        rowCount = 0;
+        values.clear();
+        packed.clear();
+    }
 
-        // 复制分量标题和单位
-        titles.clear();
-        units.clear();
-        titles.reserve(local.titles.size());
-        units.reserve(local.units.size());
-        for (size_t i = 0; i < local.titles.size(); ++i) {
-            titles.push_back(SharedMemoryString(local.titles[i].c_str(), allocator));
-            if (i < local.units.size()) {
-                units.push_back(SharedMemoryString(local.units[i].c_str(), allocator));
-            } else {
-                units.push_back(SharedMemoryString("", allocator));
-            }
-        }
+    void SharedFieldBuffer::shrinkToFit()
+    {
+        values.shrink_to_fit();
+        packed.shrink_to_fit();
+    }
 
-        // 复制多分量数据 - 优化：先预分配空间
-        data.clear();
-        data.reserve(local.data.size());
+    const void* SharedFieldBuffer::storage() const
+    {
+        return isReduced() ? static_cast<const void*>(packed.data()) : static_cast<const void*>(values.data());
+    }
 
-        // 创建分配器用于内部向量
-        SharedMemoryAllocator<double> doubleAllocator(allocator.get_segment_manager());
+    size_t SharedFieldBuffer::storageBytes() const
+    {
+        return isReduced() ? packed.size() : values.size() * sizeof(double);
+    }
+
+    const double* SharedFieldBuffer::componentData(size_t c) const
+    {
+        if (c >= componentCount || rowCount == 0 || isReduced()) {
+            return nullptr;
+        }
+        return values.data() + (layout == InterleavedLayout ? c : c * rowCount);
+    }
+
+    double* SharedFieldBuffer::componentData(size_t c)
+    {
+        if (c >= componentCount || rowCount == 0 || isReduced()) {
+            return nullptr;
+        }
+        return values.data() + (layout == InterleavedLayout ? c : c * rowCount);
+    }
+
+    size_t SharedFieldBuffer::componentStride() const
+    {
+        return layout == InterleavedLayout ? componentCount : 1;
+    }
+
+    // 降低精度存储时第 row 行、分量 c 的元素序号
+    static size_t elementOffset(const SharedFieldBuffer& buffer, size_t c, size_t row)
+    {
+        return buffer.layout == InterleavedLayout ? row * buffer.componentCount + c : c * buffer.rowCount + row;
+    }
+
+    // 把 count 个双精度值按精度写入 dst 起的降低精度存储，stride 为相邻元素的步长
+    static void packValues(const double* src, size_t count, DataPrecision precision, char* dst, size_t stride)
+    {
+        if (precision == Float32Precision) {
+            DataKernels::narrowToFloat(src, count, reinterpret_cast<float*>(dst), stride);
+        } else {
+            DataKernels::narrowToBFloat16(src, count, reinterpret_cast<uint16_t*>(dst), stride);
+        }
+    }
+
+    static void unpackValues(const char* src, size_t count, DataPrecision precision, double* dst, size_t stride)
+    {
+        if (precision == Float32Precision) {
+            DataKernels::widenFromFloat(reinterpret_cast<const float*>(src), count, dst, stride);
+        } else {
+            DataKernels::widenFromBFloat16(reinterpret_cast<const uint16_t*>(src), count, dst, stride);
+        }
+    }
+
+    void SharedFieldBuffer::readComponent(size_t c, size_t offset, size_t count, double* out) const
+    {
+        size_t stride = componentStride();
+        if (isReduced()) {
+            size_t bytes = elementBytes(precision);
+            unpackValues(packed.data() + elementOffset(*this, c, offset) * bytes, count, precision, out, stride);
+            return;
+        }
+
+        const double* src = componentData(c) + offset * stride;
+        if (stride == 1) {
+            std::copy(src, src + count, out);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = src[i * stride];
+            }
+        }
+    }
+
+    void SharedFieldBuffer::writeComponent(size_t c, size_t offset, size_t count, const double* in)
+    {
+        size_t stride = componentStride();
+        if (isReduced()) {
+            size_t bytes = elementBytes(precision);
+            packValues(in, count, precision, packed.data() + elementOffset(*this, c, offset) * bytes, stride);
+            return;
+        }
+
+        double* dst = componentData(c) + offset * stride;
+        if (stride == 1) {
+            std::copy(in, in + count, dst);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i * stride] = in[i];
+            }
+        }
+    }
+
+    void SharedFieldBuffer::gatherComponent(size_t c, const std::vector<size_t>& rows, double* out) const
+    {
+        if (isReduced()) {
+            size_t bytes = elementBytes(precision);
+            for (size_t i = 0; i < rows.size(); ++i) {
+                unpackValues(packed.data() + elementOffset(*this, c, rows[i]) * bytes, 1, precision, out + i, 1);
+            }
+            return;
+        }
+
+        const double* src = componentData(c);
+        size_t stride = componentStride();
+        for (size_t i = 0; i < rows.size(); ++i) {
+            out[i] = src[rows[i] * stride];
+        }
+    }
+
+    void SharedFieldBuffer::assign(const std::vector<std::vector<double>>& components, DataLayout newLayout,
+        DataPrecision newPrecision, SharedFieldStats* stats)
+    {
+        // 分量长度不一致时补齐会写入原本没有的 0，读取方无法区分，直接拒绝
+        size_t rows = components.empty() ? 0 : components[0].size();
+        for (const auto& component : components) {
+            if (component.size() != rows) {
+                throw std::invalid_argument("各分量长度不一致");
+            }
+        }
+
+        // 切换精度时释放另一种存储的空间
+        if (newPrecision != precision) {
+            if (newPrecision == Float64Precision) {
+                packed.clear();
+                packed.shrink_to_fit();
+            } else {
+                values.clear();
+                values.shrink_to_fit();
+            }
+        }
+
+        layout = newLayout;
+        precision = newPrecision;
+        componentCount = static_cast<uint32_t>(components.size());
+        rowCount = rows;
+
+        // 统计写入的值
+        size_t statCount = 0;
+        if (stats) {
+            statCount = componentCount < SharedFieldStats::MAX_COMPONENTS ? componentCount : SharedFieldStats::MAX_COMPONENTS;
+            stats->componentCount = static_cast<uint32_t>(statCount);
+            stats->rowCount = rowCount;
+            for (size_t c = 0; c < SharedFieldStats::MAX_COMPONENTS; ++c) {
+                stats->components[c].reset();
+            }
+        }
+
+        // 降低精度存储：按分量统计后转换写入，交错排列时按步长写入；0 的各种精度表示均为全零字节
+        if (isReduced()) {
+            for (size_t c = 0; c < statCount; ++c) {
+                DataKernels::accumulateStats(components[c].data(), components[c].size(), stats->components[c]);
+            }
+
+            size_t bytes = elementBytes(precision);
+            packed.resize(componentCount * rowCount * bytes);
+            for (size_t c = 0; c < componentCount; ++c) {
+                packValues(components[c].data(), components[c].size(), precision,
+                    packed.data() + elementOffset(*this, c, 0) * bytes, componentStride());
+            }
+            return;
+        }
+
+        values.resize(componentCount * rowCount);
+
+        if (layout == InterleavedLayout && componentCount > 1) {
+            // 交错写入按步长访问，统计单独按分量顺序读取一遍
+            for (size_t c = 0; c < statCount; ++c) {
+                DataKernels::accumulateStats(components[c].data(), components[c].size(), stats->components[c]);
+            }
+
+            std::vector<const double*> pointers(componentCount);
+            for (size_t c = 0; c < componentCount; ++c) {
+                pointers[c] = components[c].data();
+            }
+            DataKernels::interleave(pointers.data(), componentCount, rowCount, values.data());
+            return;
+        }
+
+        // 平面排列：每个分量一次整体复制，需要统计的分量在复制的同时统计
+        for (size_t c = 0; c < componentCount; ++c) {
+            double* dst = values.data() + c * rowCount;
+            if (c < statCount) {
+                DataKernels::copyWithStats(components[c].data(), components[c].size(), dst, stats->components[c]);
+            } else {
+                std::copy(components[c].begin(), components[c].end(), dst);
+            }
+        }
+    }
+
+    void SharedFieldBuffer::extract(std::vector<std::vector<double>>& components) const
+    {
+        if (isReduced()) {
+            checkSharedContainer(packed);
+            if (static_cast<uint64_t>(componentCount) * rowCount * elementBytes(precision) > packed.size()) {
+                // 只有乐观读取时才会读到不一致的计数
+                throw SharedReadConflict("分量个数与数据长度不一致");
+            }
+
+            components.resize(componentCount);
+            for (size_t c = 0; c < componentCount; ++c) {
+                components[c].resize(rowCount);
+                readComponent(c, 0, rowCount, components[c].data());
+            }
+            return;
+        }
+
+        checkSharedContainer(values);
+        if (static_cast<uint64_t>(componentCount) * rowCount > values.size()) {
+            // 只有乐观读取时才会读到不一致的计数
+            throw SharedReadConflict("分量个数与数据长度不一致");
+        }
+
+        components.resize(componentCount);
+        if (layout == InterleavedLayout && componentCount > 1) {
+            std::vector<double*> pointers(componentCount);
+            for (size_t c = 0; c < componentCount; ++c) {
+                components[c].resize(rowCount);
+                pointers[c] = components[c].data();
+            }
+            DataKernels::deinterleave(values.data(), componentCount, rowCount, pointers.data());
+            return;
+        }
+
+        for (size_t c = 0; c < componentCount; ++c) {
+            const double* src = values.data() + c * rowCount;
+            components[c].assign(src, src + rowCount);
+        }
+    }
+
+    void SharedFieldBuffer::setLayout(DataLayout newLayout)
+    {
+        if (newLayout == layout) {
+            return;
+        }
+
+        // 降低精度的值转回双精度再写回是无损的，按新的排列方式重新写入即可
+        if (isReduced()) {
+            std::vector<std::vector<double>> components;
+            extract(components);
+            assign(components, newLayout, precision);
+            return;
+        }
+
+        if (componentCount > 1 && rowCount > 0) {
+            std::vector<double> temp(values.begin(), values.end());
+            if (newLayout == InterleavedLayout) {
+                DataKernels::planarToInterleaved(temp.data(), componentCount, rowCount, values.data());
+            } else {
+                DataKernels::interleavedToPlanar(temp.data(), componentCount, rowCount, values.data());
+            }
+        }
+        layout = newLayout;
+    }
+
+    void SharedFieldBuffer::setPrecision(DataPrecision newPrecision)
+    {
+        if (newPrecision == precision) {
+            return;
+        }
+
+        std::vector<std::vector<double>> components;
+        extract(components);
+        assign(components, layout, newPrecision);
+    }
+
+    //================ SharedDataSlot 实现 ================
+    SharedFrameRing::SharedFrameRing(bip::managed_shared_memory::segment_manager* segment_manager)
+        : capacity(0),
+        componentCount(0),
+        rowCount(0),
+        frameCount(0),
+        times(SharedMemoryAllocator<double>(segment_manager)),
+        values(SharedMemoryAllocator<double>(segment_manager))
+    {
+    }
+
+    SharedFrameRing::SharedFrameRing(const SharedFrameRing& other)
+        : capacity(other.capacity),
+        componentCount(other.componentCount),
+        rowCount(other.rowCount),
+        frameCount(other.frameCount),
+        times(other.times),
+        values(other.values)
+    {
+    }
+
+    SharedFrameRing& SharedFrameRing::operator=(const SharedFrameRing& other)
+    {
+        capacity = other.capacity;
+        componentCount = other.componentCount;
+        rowCount = other.rowCount;
+        frameCount = other.frameCount;
+        times = other.times;
+        values = other.values;
+        return *this;
+    }
+
+    void SharedFrameRing::setCapacity(uint32_t newCapacity)
+    {
+        if (newCapacity == capacity) {
+            return;
+        }
+
+        // 关闭或尚未追加过帧时只释放旧空间，帧的形状在第一次追加时确定
+        size_t keep = std::min<size_t>(size(), newCapacity);
+        if (keep == 0 || times.size() != capacity) {
+            capacity = newCapacity;
+            componentCount = 0;
+            rowCount = 0;
+            frameCount = 0;
+            SharedMemoryVector<double>(times.get_allocator()).swap(times);
+            SharedMemoryVector<double>(values.get_allocator()).swap(values);
+            return;
+        }
+
+        // 保留最新的 keep 帧，按从旧到新放在新空间的前 keep 个槽位；分配失败时原有帧不变
+        size_t frameValues = static_cast<size_t>(componentCount) * rowCount;
+        SharedMemoryVector<double> newTimes(newCapacity, 0.0, times.get_allocator());
+        SharedMemoryVector<double> newValues(static_cast<size_t>(newCapacity) * frameValues, 0.0, values.get_allocator());
+        size_t first = size() - keep;
+        for (size_t k = 0; k < keep; ++k) {
+            size_t slot = slotOf(first + k);
+            newTimes[k] = times[slot];
+            std::copy(slotData(slot), slotData(slot) + frameValues, newValues.begin() + k * frameValues);
+        }
+
+        times.swap(newTimes);
+        values.swap(newValues);
+        capacity = newCapacity;
+        frameCount = keep;
+    }
+
+    size_t SharedFrameRing::size() const
+    {
+        return static_cast<size_t>(std::min<uint64_t>(frameCount, capacity));
+    }
+
+    size_t SharedFrameRing::slotOf(size_t k) const
+    {
+        return static_cast<size_t>((frameCount - size() + k) % capacity);
+    }
+
+    const double* SharedFrameRing::slotData(size_t slot) const
+    {
+        return values.data() + slot * componentCount * rowCount;
+    }
+
+    bool SharedFrameRing::needsAllocation(const std::vector<std::vector<double>>& components) const
+    {
+        if (components.size() != componentCount || times.size() != capacity) {
+            return true;
+        }
+        for (const auto& component : components) {
+            if (component.size() != rowCount) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool SharedFrameRing::append(double t, const std::vector<std::vector<double>>& components)
+    {
+        if (capacity == 0 || components.empty()) {
+            return false;
+        }
+
+        if (needsAllocation(components)) {
+            size_t rows = components[0].size();
+            for (const auto& component : components) {
+                if (component.size() != rows) {
+                    return false;
+                }
+            }
+
+            componentCount = static_cast<uint32_t>(components.size());
+            rowCount = rows;
+            frameCount = 0;
+            times.assign(capacity, 0.0);
+            values.assign(static_cast<size_t>(capacity) * componentCount * rowCount, 0.0);
+        }
+        else if (frameCount > 0 && times[slotOf(size() - 1)] >= t) {
+            // 时刻必须递增
+            return false;
+        }
+
+        size_t slot = static_cast<size_t>(frameCount % capacity);
+        double* dst = values.data() + slot * componentCount * rowCount;
+        for (size_t c = 0; c < componentCount; ++c) {
+            std::copy(components[c].begin(), components[c].end(), dst + c * rowCount);
+        }
+        times[slot] = t;
+        ++frameCount;
+        return true;
+    }
+
+    bool SharedFrameRing::frame(int k, double& t, std::vector<std::vector<double>>& components) const
+    {
+        long long n = static_cast<long long>(size());
+        long long i = k < 0 ? n + k : k;
+        if (i < 0 || i >= n) {
+            return false;
+        }
+
+        size_t slot = slotOf(static_cast<size_t>(i));
+        const double* src = slotData(slot);
+        components.resize(componentCount);
+        for (size_t c = 0; c < componentCount; ++c) {
+            components[c].assign(src + c * rowCount, src + (c + 1) * rowCount);
+        }
+        t = times[slot];
+        return true;
+    }
+
+    bool SharedFrameRing::atTime(double t, std::vector<std::vector<double>>& components, bool extrapolate) const
+    {
+        size_t n = size();
+        if (n == 0) {
+            return false;
+        }
+
+        double first = times[slotOf(0)];
+        double last = times[slotOf(n - 1)];
+        if (t < first || (t > last && (!extrapolate || n < 2))) {
+            return false;
+        }
+        if (n == 1) {
+            double frameTime;
+            return frame(0, frameTime, components);
+        }
+
+        // 找到 t 所在区间 [times[i], times[i + 1]]，晚于最新帧时使用最后一个区间外推
+        size_t i = n - 2;
+        while (i > 0 && times[slotOf(i)] > t) {
+            --i;
+        }
+
+        double t0 = times[slotOf(i)];
+        double t1 = times[slotOf(i + 1)];
+        double w = (t - t0) / (t1 - t0);
+        const double* a = slotData(slotOf(i));
+        const double* b = slotData(slotOf(i + 1));
+
+        components.resize(componentCount);
+        for (size_t c = 0; c < componentCount; ++c) {
+            components[c].resize(rowCount);
+            size_t base = c * rowCount;
+            for (size_t r = 0; r < rowCount; ++r) {
+                components[c][r] = a[base + r] + w * (b[base + r] - a[base + r]);
+            }
+        }
+        return true;
+    }
+
+    SharedFieldStats::SharedFieldStats()
+    {
+        clear();
+    }
+
+    void SharedFieldStats::clear()
+    {
+        componentCount = 0;
+        rowCount = 0;
+        for (uint32_t c = 0; c < MAX_COMPONENTS; ++c) {
+            components[c].reset();
+        }
+    }
+
+    void SharedFieldStats::addImplicitZeros(uint64_t denseRows)
+    {
+        if (denseRows <= rowCount) {
+            return;
+        }
+
+        uint64_t zeros = denseRows - rowCount;
+        for (uint32_t c = 0; c < componentCount; ++c) {
+            components[c].count += zeros;
+            components[c].min = (std::min)(components[c].min, 0.0);
+            components[c].max = (std::max)(components[c].max, 0.0);
+        }
+        rowCount = denseRows;
+    }
+
+    SharedDataSlot::SharedDataSlot(bip::managed_shared_memory::segment_manager* segment_manager)
+        : index(SharedMemoryAllocator<int>(segment_manager)),
+        data(segment_manager),
+        titles(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
+        units(SharedMemoryAllocator<SharedMemoryString>(segment_manager))
+    {
+        version.store(0);
+        readers.store(0);
+        writing.store(false);
+        t = 0.0;
+    }
+
+    SharedDataSlot::SharedDataSlot(const SharedDataSlot& other)
+        : version(other.version.load()),
+        readers(0),
+        writing(false),
+        t(other.t),
+        index(other.index),
+        data(other.data),
+        titles(other.titles),
+        units(other.units),
+        stats(other.stats)
+    {
+    }
+
+    SharedDataSlot& SharedDataSlot::operator=(const SharedDataSlot& other)
+    {
+        version.store(other.version.load());
+        t = other.t;
+        index = other.index;
+        data = other.data;
+        titles = other.titles;
+        units = other.units;
+        stats = other.stats;
+        return *this;
+    }
+
+    //================ SharedVersionStore 实现 ================
+    SharedRetainedVersion::SharedRetainedVersion(bip::managed_shared_memory::segment_manager* segment_manager)
+        : version(0),
+        t(0.0),
+        index(SharedMemoryAllocator<int>(segment_manager)),
+        data(segment_manager)
+    {
+    }
+
+    bool SharedRetainedVersion::allocated() const
+    {
+        return index.capacity() > 0 || data.values.capacity() > 0 || data.packed.capacity() > 0;
+    }
+
+    void SharedRetainedVersion::release()
+    {
+        version = 0;
+        index.clear();
+        index.shrink_to_fit();
+        data.clear();
+        data.shrinkToFit();
+    }
+
+    SharedVersionStore::SharedVersionStore(bip::managed_shared_memory::segment_manager* segment_manager)
+        : depth(0),
+        capacity(0),
+        evictedCount(0),
+        entries{ SharedRetainedVersion(segment_manager), SharedRetainedVersion(segment_manager),
+            SharedRetainedVersion(segment_manager), SharedRetainedVersion(segment_manager),
+            SharedRetainedVersion(segment_manager), SharedRetainedVersion(segment_manager),
+            SharedRetainedVersion(segment_manager), SharedRetainedVersion(segment_manager) }
+    {
+        collectBelow.store(0);
+    }
+
+    void SharedVersionStore::configure(uint32_t newDepth, uint32_t newCapacity)
+    {
+        depth = newDepth > MAX_VERSIONS ? MAX_VERSIONS : (newDepth == 0 ? 1 : newDepth);
+        capacity = newCapacity > MAX_VERSIONS ? MAX_VERSIONS : (newCapacity < depth ? depth : newCapacity);
+        evictedCount = 0;
+        for (uint32_t i = 0; i < MAX_VERSIONS; ++i) {
+            entries[i].release();
+        }
+    }
+
+    bool SharedVersionStore::retain(uint64_t version, double t, const SharedMemoryVector<int>& index, const SharedFieldBuffer& data)
+    {
+        if (capacity == 0 || version == 0) {
+            return false;
+        }
+
+        // 回收：不在最新 depth 个版本之内(连同 version)且低于回收下限的版本
+        uint64_t floor = collectBelow.load();
+        int target = -1;
+        for (uint32_t i = 0; i < capacity; ++i) {
+            SharedRetainedVersion& entry = entries[i];
+            bool collectible = entry.version == 0 ||
+                (entry.version + depth <= version && entry.version < floor);
+            if (!collectible) {
+                continue;
+            }
+            entry.version = 0;
+
+            // 优先重复使用已有空间的空位
+            if (target < 0 || (!entries[target].allocated() && entry.allocated())) {
+                target = static_cast<int>(i);
+            }
+        }
+
+        // 没有可回收的空位时覆盖最旧的版本
+        if (target < 0) {
+            target = 0;
+            for (uint32_t i = 1; i < capacity; ++i) {
+                if (entries[i].version < entries[target].version) {
+                    target = static_cast<int>(i);
+                }
+            }
+            ++evictedCount;
+        }
+
+        // 选中之外的空位释放空间，读取方跟上之后保留的空间回落到 depth 份
+        for (uint32_t i = 0; i < capacity; ++i) {
+            if (static_cast<int>(i) != target && entries[i].version == 0 && entries[i].allocated()) {
+                entries[i].release();
+            }
+        }
+
+        SharedRetainedVersion& entry = entries[target];
+        try {
+            entry.index.assign(index.begin(), index.end());
+            entry.data = data;
+        }
+        catch (const bip::bad_alloc&) {
+            entry.release();
+            return false;
+        }
+        entry.t = t;
+        entry.version = version;
+        return true;
+    }
+
+    const SharedRetainedVersion* SharedVersionStore::find(uint64_t version) const
+    {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            if (version != 0 && entries[i].version == version) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<uint64_t> SharedVersionStore::versions() const
+    {
+        std::vector<uint64_t> result;
+        for (uint32_t i = 0; i < capacity; ++i) {
+            if (entries[i].version != 0) {
+                result.push_back(entries[i].version);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    //================ SharedData 实现 ================
+    // 复制索引和多分量数据到共享内存
+    static void copyPayloadFromLocal(const LocalData& local, SharedMemoryVector<int>& index,
+        SharedFieldBuffer& data, DataLayout layout, DataPrecision precision, SharedFieldStats* stats = nullptr,
+        uint64_t denseRows = 0)
+    {
+        index.assign(local.index.begin(), local.index.end());
+        data.assign(local.data, layout, precision, stats);
+        if (stats) {
+            stats->addImplicitZeros(denseRows);
+        }
+    }
+
+    // 从共享内存复制索引和多分量数据
+    static void copyPayloadToLocal(const SharedMemoryVector<int>& index,
+        const SharedFieldBuffer& data, LocalData& local)
+    {
+        checkSharedContainer(index);
+        local.index.assign(index.begin(), index.end());
+        data.extract(local.data);
+    }
+
+    // 按行号从共享内存收集索引和多分量数据，没有索引列的数据只收集分量
+    static void gatherRowsToLocal(const SharedMemoryVector<int>& index, const SharedFieldBuffer& data,
+        const std::vector<size_t>& rows, LocalData& local)
+    {
+        checkSharedContainer(index);
+        for (size_t row : rows) {
+            if (row >= data.rowCount) {
+                throw std::out_of_range("子集行号超出计算数据的范围");
+            }
+        }
+
+        local.index.clear();
+        if (index.size() >= data.rowCount) {
+            local.index.reserve(rows.size());
+            for (size_t row : rows) {
+                local.index.push_back(index[row]);
+            }
+        }
+
+        local.data.resize(data.componentCount);
+        for (size_t c = 0; c < data.componentCount; ++c) {
+            local.data[c].resize(rows.size());
+            data.gatherComponent(c, rows, local.data[c].data());
+        }
+    }
+
+    SharedData::SharedData(bip::managed_shared_memory::segment_manager* segment_manager)
+        : SharedDataBase(segment_manager, DataType::CALCULATION_DATA),
+        meshName(SharedMemoryAllocator<char>(segment_manager)),
+        index(SharedMemoryAllocator<int>(segment_manager)),
+        data(segment_manager),
+        dimtags(SharedMemoryAllocator<SharedMemoryPair>(segment_manager)),
+        titles(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
+        units(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
+        layout(PlanarLayout),
+        precision(Float64Precision),
+        slots{ SharedDataSlot(segment_manager), SharedDataSlot(segment_manager), SharedDataSlot(segment_manager) },
+        history(segment_manager),
+        versions(nullptr),
+        regions(SharedMemoryAllocator<SharedDataRegion>(segment_manager))
+    {
+        isFieldData = true;
+        t = 0.0;
+        type = VertexData;
+        slotCount = 0;
+        frontSlot.store(0);
+        fullWriteVersion = 0;
+        dirtyCount = 0;
+        contentHash.store(0);
+        skipUnchanged.store(false);
+        indexHash.store(0);
+        sparse.store(false);
+        sparseTolerance.store(0.0);
+        setDataType(DataType::CALCULATION_DATA);
+    }
+
+    SharedData::SharedData(const SharedData& other)
+        : SharedDataBase(other),
+        t(other.t),
+        type(other.type),
+        meshName(other.meshName),
+        index(other.index),
+        data(other.data),
+        dimtags(other.dimtags),
+        titles(other.titles),
+        units(other.units),
+        isFieldData(other.isFieldData),
+        layout(other.layout),
+        precision(other.precision),
+        slotCount(other.slotCount),
+        frontSlot(other.frontSlot.load()),
+        slots{ other.slots[0], other.slots[1], other.slots[2] },
+        fullWriteVersion(other.fullWriteVersion),
+        dirtyCount(other.dirtyCount),
+        history(other.history),
+        versions(nullptr),
+        contentHash(other.contentHash.load()),
+        skipUnchanged(other.skipUnchanged.load()),
+        stats(other.stats),
+        regions(other.regions),
+        indexHash(other.indexHash.load()),
+        sparse(other.sparse.load()),
+        sparseTolerance(other.sparseTolerance.load())
+    {
+        std::copy(other.dirtyRanges, other.dirtyRanges + MAX_DIRTY_RANGES, dirtyRanges);
+        setDataType(DataType::CALCULATION_DATA);
+    }
+
+    SharedData::~SharedData()
+    {
+        setRetention(0, 0);
+    }
+
+    SharedData& SharedData::operator=(const SharedData& other)
+    {
+        SharedDataBase::operator=(other);
+        t = other.t;
+        type = other.type;
+        meshName = other.meshName;
+        index = other.index;
+        data = other.data;
+        dimtags = other.dimtags;
+        titles = other.titles;
+        units = other.units;
+        isFieldData = other.isFieldData;
+        layout = other.layout;
+        precision = other.precision;
+        slotCount = other.slotCount;
+        frontSlot.store(other.frontSlot.load());
+        for (uint32_t i = 0; i < MAX_SLOTS; ++i) {
+            slots[i] = other.slots[i];
+        }
+        fullWriteVersion = other.fullWriteVersion;
+        dirtyCount = other.dirtyCount;
+        std::copy(other.dirtyRanges, other.dirtyRanges + MAX_DIRTY_RANGES, dirtyRanges);
+        history = other.history;
+        contentHash.store(other.contentHash.load());
+        skipUnchanged.store(other.skipUnchanged.load());
+        stats = other.stats;
+        regions = other.regions;
+        indexHash.store(other.indexHash.load());
+        sparse.store(other.sparse.load());
+        sparseTolerance.store(other.sparseTolerance.load());
+        return *this;
+    }
+
+    // 复制分量标题和单位，单位比标题少时补空字符串
+    static void copyTitlesFromLocal(const LocalData& local, SharedMemoryVectorString& titles,
+        SharedMemoryVectorString& units, SharedMemoryAllocator<char> allocator)
+    {
+        titles.clear();
+        units.clear();
+        titles.reserve(local.titles.size());
+        units.reserve(local.titles.size());
+        for (size_t i = 0; i < local.titles.size(); ++i) {
+            titles.push_back(SharedMemoryString(local.titles[i].c_str(), allocator));
+            if (i < local.units.size()) {
+                units.push_back(SharedMemoryString(local.units[i].c_str(), allocator));
+            } else {
+                units.push_back(SharedMemoryString("", allocator));
+            }
+        }
+    }
+
+    void SharedData::copyMetaFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator)
+    {
+        // 设置基础属性
+        name = SharedMemoryString(local.name.c_str(), allocator);
+        sysTimeStamp = local.sysTimeStamp;
+        dataType = local.dataType;
+        meshName = SharedMemoryString(local.meshName.c_str(), allocator);
+        isFieldData = local.isFieldData;
+        type = local.type;
+        t = local.t;
+
+        // 复制分量标题和单位
+        copyTitlesFromLocal(local, titles, units, allocator);
+
+        // 复制几何位置数据 - 优化：先预分配空间
+        dimtags.clear();
+        dimtags.reserve(local.dimtags.size());
+        for (const auto& dimtag : local.dimtags) {
+            dimtags.push_back(SharedMemoryPair(dimtag.first, dimtag.second));
+        }
+    }
+
+    void SharedData::copyMetaToLocal(LocalData& local) const
+    {
+        // 设置基础属性
+        local.name = toLocalString(name);
+        local.sysTimeStamp = sysTimeStamp;
+        local.dataType = dataType;
+        local.meshName = toLocalString(meshName);
+        local.isFieldData = isFieldData;
+        local.type = type;
+        local.t = t;
+
+        // 复制分量标题和单位
+        checkSharedContainer(titles);
+        checkSharedContainer(units);
+        local.titles.clear();
+        local.units.clear();
+        local.titles.reserve(titles.size());
+        local.units.reserve(units.size());
+        for (size_t i = 0; i < titles.size(); ++i) {
+            local.titles.push_back(toLocalString(titles[i]));
+            if (i < units.size()) {
+                local.units.push_back(toLocalString(units[i]));
+            } else {
+                local.units.push_back("");
+            }
+        }
+
+        // 复制几何位置数据 - 优化：先预分配空间
+        checkSharedContainer(dimtags);
+        local.dimtags.clear();
+        local.dimtags.reserve(dimtags.size());
+        for (const auto& dimtag : dimtags) {
+            local.dimtags.push_back(std::make_pair(dimtag.first, dimtag.second));
+        }
+    }
+
+    uint64_t SharedData::hashContent(const LocalData& local)
+    {
+        using DataKernels::hashBytes;
+
+        // 变长部分先计入长度，避免不同的切分得到相同的字节序列
+        auto hashString = [](const std::string& str, uint64_t seed) {
+            uint64_t size = str.size();
+            return hashBytes(str.data(), str.size(), hashBytes(&size, sizeof(size), seed));
+        };
+
+        uint64_t header[3] = { static_cast<uint64_t>(local.isFieldData), static_cast<uint64_t>(local.type), local.titles.size() };
+        uint64_t h = hashBytes(header, sizeof(header));
+        h = hashString(local.meshName, h);
+        for (size_t i = 0; i < local.titles.size(); ++i) {
+            h = hashString(local.titles[i], h);
+            h = hashString(i < local.units.size() ? local.units[i] : std::string(), h);
+        }
+
+        uint64_t sizes[2] = { local.dimtags.size(), local.index.size() };
+        h = hashBytes(sizes, sizeof(sizes), h);
+        for (const auto& dimtag : local.dimtags) {
+            int pair[2] = { dimtag.first, dimtag.second };
+            h = hashBytes(pair, sizeof(pair), h);
+        }
+        h = hashBytes(local.index.data(), local.index.size() * sizeof(int), h);
+
+        for (const auto& component : local.data) {
+            uint64_t size = component.size();
+            h = hashBytes(&size, sizeof(size), h);
+            h = hashBytes(component.data(), component.size() * sizeof(double), h);
+        }
+
+        // 0 保留为"未知"
+        return h == 0 ? 1 : h;
+    }
+
+    bool SharedData::isUnchanged(uint64_t hash, double t) const
+    {
+        // 哈希不含时刻，时刻推进的相同内容仍须发布
+        if (!skipUnchanged.load() || hash == 0 || hash != contentHash.load()) {
+            return false;
+        }
+        return t == (isSlotted() ? slots[frontSlot.load()].t : this->t);
+    }
+
+    const SharedMemoryVector<int>& SharedData::currentIndex() const
+    {
+        return isSlotted() ? slots[frontSlot.load()].index : index;
+    }
+
+    void SharedData::copyRowsToLocal(const std::vector<size_t>& rows, LocalData& local) const
+    {
+        // 多缓冲模式：固定前台槽后收集
+        if (isSlotted()) {
+            int slot = pinFrontSlot(local);
+            try {
+                gatherRowsToLocal(slots[slot].index, slots[slot].data, rows, local);
+            }
+            catch (...) {
+                unpinSlot(slot);
+                throw;
+            }
+            unpinSlot(slot);
+            return;
+        }
+
+        copyMetaToLocal(local);
+        local.version = version.load();
+        gatherRowsToLocal(index, data, rows, local);
+    }
+
+    void SharedData::copyFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t hash, uint64_t denseRows)
+    {
+        // 如果版本号相同，则不需要更新
+        if (local.version == version.load()) {
+            // 直接返回，不做任何更改
+            return;
+        }
+
+        // 在开始写入之前检查，避免抛出异常时留下写入中的状态
+        if (!local.hasUniformComponents()) {
+            throw std::invalid_argument("各分量长度不一致");
+        }
+
+        // 内容与上次整体写入相同时不复制，版本号不变，读取方也不必重新读取。未开启时不计算哈希
+        if (hash == 0 && skipUnchanged.load()) {
+            hash = hashContent(local);
+        }
+        if (isUnchanged(hash, local.t)) {
+            return;
+        }
+
+        // 多缓冲模式：调用方已持锁，直接完成 选槽-填充-发布 三步。
+        // 后台槽都被读取方固定时不在锁内等待，由调用方在加锁前等待 hasWriteSlot
+        if (isSlotted()) {
+            int slot = acquireWriteSlot();
+            if (slot < 0) {
+                throw std::runtime_error("没有可写入的后台槽: " + std::string(name.c_str()));
+            }
+            fillSlot(slot, local, allocator, denseRows);
+            publishSlot(slot, local, allocator, hash);
+            return;
+        }
+
+        beginWrite();
+        version.store(version.load() + 1);
+        fullWriteVersion = version.load();
+
+        copyMetaFromLocal(local, allocator);
+        copyPayloadFromLocal(local, index, data, layout, precision, &stats, denseRows);
+        contentHash.store(hash);
+        indexHash.store(DataKernels::hashBytes(local.index.data(), local.index.size() * sizeof(int), 1) | 1);
+
+        dataRead.store(false); // 标记为未读
+        endWrite();
+
+        // 多版本保留在发布之后复制，不延长乐观读取的冲突窗口
+        retainCurrent();
+    }
+
+    void SharedData::copyToLocal(LocalData& local) const
+    {
+        // 如果版本号相同，则不需要更新
+        if (local.version == version.load()) {
+            // 直接返回，不做任何更改
+            return;
+        }
+
+        // 多缓冲模式：调用方已持锁，读取前台槽
+        if (isSlotted()) {
+            int slot = pinFrontSlot(local);
+            try {
+                copySlotToLocal(slot, local);
+            }
+            catch (...) {
+                unpinSlot(slot);
+                throw;
+            }
+            unpinSlot(slot);
+            return;
+        }
+
+        copyMetaToLocal(local);
+        local.version = version.load(); // 更新本地版本号
+        copyPayloadToLocal(index, data, local);
+
+        dataRead.store(true); // 标记为已读
+    }
+
+    void SharedData::writeRange(size_t offset, size_t count, const std::vector<std::vector<double>>& components)
+    {
+        if (offset + count > data.rowCount || components.size() > data.componentCount) {
+            throw std::out_of_range("局部更新超出计算数据的范围");
+        }
+        for (const auto& component : components) {
+            if (component.size() < count) {
+                throw std::out_of_range("局部更新的分量数据不足");
+            }
+        }
+
+        beginWrite();
+        version.store(version.load() + 1);
+
+        for (size_t c = 0; c < components.size(); ++c) {
+            data.writeComponent(c, offset, count, components[c].data());
+        }
+
+        SharedDirtyRange& range = dirtyRanges[dirtyCount % MAX_DIRTY_RANGES];
+        range.version = version.load();
+        range.offset = offset;
+        range.count = count;
+        ++dirtyCount;
+
+        // 局部更新后不重新计算整体的哈希和统计量，下次整体写入前视为未知
+        contentHash.store(0);
+        stats.clear();
+
+        dataRead.store(false); // 标记为未读
+        endWrite();
+
+        retainCurrent();
+    }
+
+    bool SharedData::copyChangesToLocal(LocalData& local, std::vector<std::pair<size_t, size_t>>& ranges) const
+    {
+        ranges.clear();
+
+        uint64_t current = version.load();
+        if (local.version == current) {
+            return true;
+        }
 
-        // 复制每个分量的数据
-        for (const auto& componentData : local.data) {
-            // 创建新的共享内存向量
-            SharedMemoryVector<double> sharedComponentData(doubleAllocator);
-            sharedComponentData.reserve(componentData.size());
+        // local.version 之后的版本必须全部是仍保留着记录的局部更新
+        if (isSlotted() || local.version < fullWriteVersion || local.version > current) {
+            return false;
+        }
+        uint64_t needed = current - local.version;
+        if (needed > dirtyCount || needed > MAX_DIRTY_RANGES) {
+            return false;
+        }
 
-            // 复制数据
-            for (const auto& val : componentData) {
-                sharedComponentData.push_back(val);
+        // local 的形状必须与共享数据一致，才能只覆盖改写过的行
+        if (local.data.size() != data.componentCount || local.index.size() != index.size()) {
+            return false;
+        }
+        for (const auto& component : local.data) {
+            if (component.size() != data.rowCount) {
+                return false;
             }
+        }
 
-            // 添加到数据列表
-            data.push_back(sharedComponentData);
+        // 收集记录并合并重叠或相邻的行范围
+        for (uint64_t k = dirtyCount - needed; k < dirtyCount; ++k) {
+            const SharedDirtyRange& range = dirtyRanges[k % MAX_DIRTY_RANGES];
+            ranges.push_back(std::make_pair(static_cast<size_t>(range.offset), static_cast<size_t>(range.count)));
+        }
+        std::sort(ranges.begin(), ranges.end());
+        size_t merged = 0;
+        for (size_t i = 1; i < ranges.size(); ++i) {
+            size_t end = ranges[merged].first + ranges[merged].second;
+            if (ranges[i].first <= end) {
+                size_t newEnd = std::max(end, ranges[i].first + ranges[i].second);
+                ranges[merged].second = newEnd - ranges[merged].first;
+            } else {
+                ranges[++merged] = ranges[i];
+            }
         }
+        ranges.resize(merged + 1);
 
-        // 复制几何位置数据 - 优化：先预分配空间
-        dimtags.clear();
-        dimtags.reserve(local.dimtags.size());
-        for (const auto& dimtag : local.dimtags) {
-            dimtags.push_back(SharedMemoryPair(dimtag.first, dimtag.second));
+        for (size_t c = 0; c < data.componentCount; ++c) {
+            double* dst = local.data[c].data();
+            for (const auto& range : ranges) {
+                data.readComponent(c, range.first, range.second, dst + range.first);
+            }
+        }
+
+        local.t = t;
+        local.version = current;
+        dataRead.store(true); // 标记为已读
+        return true;
+    }
+
+    void SharedData::setLayout(DataLayout newLayout)
+    {
+        if (newLayout == layout) {
+            return;
+        }
+
+        beginWrite();
+        layout = newLayout;
+        data.setLayout(newLayout);
+        for (uint32_t i = 0; i < MAX_SLOTS; ++i) {
+            slots[i].data.setLayout(newLayout);
+        }
+        endWrite();
+    }
+
+    void SharedData::setPrecision(DataPrecision newPrecision)
+    {
+        if (newPrecision == precision) {
+            return;
+        }
+
+        beginWrite();
+        precision = newPrecision;
+        data.setPrecision(newPrecision);
+        for (uint32_t i = 0; i < MAX_SLOTS; ++i) {
+            slots[i].data.setPrecision(newPrecision);
+        }
+        endWrite();
+    }
+
+    bool SharedData::isSlotted() const
+    {
+        return slotCount > 1;
+    }
+
+    void SharedData::setSlotCount(uint32_t count)
+    {
+        if (count == 1) {
+            count = 0;
+        }
+        if (count > MAX_SLOTS) {
+            count = MAX_SLOTS;
+        }
+        if (count == slotCount) {
+            return;
+        }
+
+        beginWrite();
+
+        if (isSlotted()) {
+            // 多缓冲 -> 其他布局：先把前台槽内容搬回单缓冲
+            SharedDataSlot& front = slots[frontSlot.load()];
+            index = front.index;
+            data = front.data;
+            t = front.t;
+            for (uint32_t i = 0; i < MAX_SLOTS; ++i) {
+                slots[i].index.clear();
+                slots[i].index.shrink_to_fit();
+                slots[i].data.clear();
+                slots[i].data.shrinkToFit();
+                slots[i].titles.clear();
+                slots[i].titles.shrink_to_fit();
+                slots[i].units.clear();
+                slots[i].units.shrink_to_fit();
+                slots[i].version.store(0);
+            }
+        }
+
+        if (count > 1) {
+            // 单缓冲 -> 多缓冲：当前内容作为槽 0 发布
+            slots[0].index = index;
+            slots[0].data = data;
+            slots[0].titles = titles;
+            slots[0].units = units;
+            slots[0].t = t;
+            slots[0].version.store(version.load());
+            frontSlot.store(0);
+            index.clear();
+            index.shrink_to_fit();
+            data.clear();
+            data.shrinkToFit();
+        }
+
+        slotCount = count;
+        endWrite();
+    }
+
+    void SharedData::setRetention(uint32_t depth, uint32_t capacity)
+    {
+        bip::managed_shared_memory::segment_manager* segment_manager = name.get_allocator().get_segment_manager();
+        if (depth == 0) {
+            if (versions) {
+                segment_manager->destroy_ptr(versions.get());
+                versions = nullptr;
+            }
+            return;
+        }
+
+        if (!versions) {
+            versions = segment_manager->construct<SharedVersionStore>(bip::anonymous_instance)(segment_manager);
+        }
+        versions->configure(depth, capacity);
+        retainCurrent();
+    }
+
+    void SharedData::retainCurrent()
+    {
+        if (!versions || version.load() == 0) {
+            return;
+        }
+        if (isSlotted()) {
+            const SharedDataSlot& front = slots[frontSlot.load()];
+            versions->retain(front.version.load(), front.t, front.index, front.data);
+        }
+        else {
+            versions->retain(version.load(), t, index, data);
+        }
+    }
+
+    bool SharedData::copyVersionToLocal(uint64_t v, LocalData& local) const
+    {
+        const SharedRetainedVersion* entry = versions ? versions->find(v) : nullptr;
+        if (!entry) {
+            return false;
+        }
+
+        copyMetaToLocal(local);
+        local.t = entry->t;
+        local.version = entry->version;
+        copyPayloadToLocal(entry->index, entry->data, local);
+        return true;
+    }
+
+    bool SharedData::slotsBusy() const
+    {
+        for (uint32_t i = 0; i < MAX_SLOTS; ++i) {
+            if (slots[i].readers.load() != 0 || slots[i].writing.load()) {
+                return true;
+            }
         }
+        return false;
+    }
+
+    bool SharedData::hasWriteSlot() const
+    {
+        uint32_t front = frontSlot.load();
+        for (uint32_t i = 0; i < slotCount && i < MAX_SLOTS; ++i) {
+            if (i != front && slots[i].readers.load() == 0 && !slots[i].writing.load()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int SharedData::acquireWriteSlot()
+    {
+        // 选择一个非前台、无人读写的槽，优先选择版本最旧的槽
+        int best = -1;
+        uint32_t front = frontSlot.load();
+        for (uint32_t i = 0; i < slotCount && i < MAX_SLOTS; ++i) {
+            if (i == front || slots[i].readers.load() != 0 || slots[i].writing.load()) {
+                continue;
+            }
+            if (best < 0 || slots[i].version.load() < slots[best].version.load()) {
+                best = static_cast<int>(i);
+            }
+        }
+        if (best >= 0) {
+            slots[best].writing.store(true);
+        }
+        return best;
+    }
+
+    void SharedData::fillSlot(int slot, const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t denseRows)
+    {
+        SharedDataSlot& s = slots[slot];
+        s.t = local.t;
+        copyTitlesFromLocal(local, s.titles, s.units, allocator);
+        copyPayloadFromLocal(local, s.index, s.data, layout, precision, &s.stats, denseRows);
+    }
+
+    void SharedData::publishSlot(int slot, const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t hash)
+    {
+        beginWrite();
+        copyMetaFromLocal(local, allocator);
+        contentHash.store(hash != 0 || !skipUnchanged.load() ? hash : hashContent(local));
+        stats = slots[slot].stats;
+        indexHash.store(DataKernels::hashBytes(local.index.data(), local.index.size() * sizeof(int), 1) | 1);
+
+        uint64_t newVersion = version.load() + 1;
+        slots[slot].version.store(newVersion);
+        slots[slot].writing.store(false);
+        frontSlot.store(static_cast<uint32_t>(slot));
+        version.store(newVersion);
+        fullWriteVersion = newVersion;
 
         dataRead.store(false); // 标记为未读
-        writing.store(false);
+        endWrite();
+
+        retainCurrent();
     }
 
-    void SharedData::copyToLocal(LocalData& local) const
+    void SharedData::abandonSlot(int slot)
     {
-        // 如果版本号相同，则不需要更新
-        if (local.version == version.load()) {
-            // 直接返回，不做任何更改
+        if (slot >= 0 && slot < static_cast<int>(MAX_SLOTS)) {
+            slots[slot].writing.store(false);
+        }
+    }
+
+    int SharedData::pinFrontSlot(LocalData& local) const
+    {
+        uint32_t slot = frontSlot.load();
+        slots[slot].readers.fetch_add(1);
+
+        copyMetaToLocal(local);
+        local.t = slots[slot].t;
+        local.version = slots[slot].version.load(); // 更新本地版本号
+
+        dataRead.store(true); // 标记为已读
+        return static_cast<int>(slot);
+    }
+
+    void SharedData::copySlotToLocal(int slot, LocalData& local) const
+    {
+        copyPayloadToLocal(slots[slot].index, slots[slot].data, local);
+    }
+
+    void SharedData::unpinSlot(int slot) const
+    {
+        if (slot >= 0 && slot < static_cast<int>(MAX_SLOTS)) {
+            slots[slot].readers.fetch_sub(1);
+        }
+    }
+
+    //================ SharedDataView 实现 ================
+    SharedDataView::SharedDataView()
+        : data_(nullptr),
+        slot_(-1),
+        holder_(-1),
+        version_(0)
+    {
+    }
+
+    SharedDataView::SharedDataView(SharedData* data, std::shared_ptr<const void> mapping, int64_t holderPid)
+        : data_(data),
+        slot_(-1),
+        holder_(-1),
+        version_(0),
+        mapping_(std::move(mapping))
+    {
+        // 降低精度存储的数据没有可以直接映射的双精度数组
+        if (!data_ || data_->precision != Float64Precision) {
+            data_ = nullptr;
+            mapping_.reset();
             return;
         }
 
-        // 设置基础属性
-        local.name = std::string(name.c_str());
-        local.sysTimeStamp = sysTimeStamp;
-        local.version = version.load(); // 更新本地版本号
-        local.dataType = dataType;
-        local.meshName = std::string(meshName.c_str());
-        local.isFieldData = isFieldData;
-        local.type = type;
-        local.t = t;
+        // 在互斥锁保护下增加固定计数，保证不会固定到写入中途的数据
+        bip::scoped_lock<bip::interprocess_mutex> lock(data_->mutex);
+        if (data_->isSlotted()) {
+            // 多缓冲模式只固定前台槽，不阻塞写入方
+            slot_ = static_cast<int>(data_->frontSlot.load());
+            data_->slots[slot_].readers.fetch_add(1);
+            version_ = data_->slots[slot_].version.load();
+        } else {
+            data_->viewPins.fetch_add(1);
+            version_ = data_->version.load();
+        }
+        // 登记持有方进程，持有方异常退出后写入方据此回收固定
+        holder_ = data_->registerViewHolder(holderPid, slot_);
+        data_->dataRead.store(true); // 标记为已读
+    }
 
-        // 复制索引数据 - 优化：先预分配空间
-        local.index.clear();
-        local.index.reserve(index.size());
-        for (const auto& idx : index) {
-            local.index.push_back(idx);
+    SharedDataView::SharedDataView(SharedDataView&& other) noexcept
+        : data_(other.data_),
+        slot_(other.slot_),
+        holder_(other.holder_),
+        version_(other.version_),
+        mapping_(std::move(other.mapping_))
+    {
+        other.data_ = nullptr;
+        other.slot_ = -1;
+        other.holder_ = -1;
+        other.version_ = 0;
+    }
+
+    SharedDataView& SharedDataView::operator=(SharedDataView&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            data_ = other.data_;
+            slot_ = other.slot_;
+            holder_ = other.holder_;
+            version_ = other.version_;
+            mapping_ = std::move(other.mapping_);
+            other.data_ = nullptr;
+            other.slot_ = -1;
+            other.holder_ = -1;
+            other.version_ = 0;
         }
+        return *this;
+    }
 
-        // 复制分量标题和单位
-        local.titles.clear();
-        local.units.clear();
-        local.titles.reserve(titles.size());
-        local.units.reserve(units.size());
-        for (size_t i = 0; i < titles.size(); ++i) {
-            local.titles.push_back(std::string(titles[i].c_str()));
-            if (i < units.size()) {
-                local.units.push_back(std::string(units[i].c_str()));
+    SharedDataView::~SharedDataView()
+    {
+        release();
+    }
+
+    void SharedDataView::release()
+    {
+        if (data_) {
+            // 先释放登记项，回收方不会再按登记项重复扣减
+            data_->releaseViewHolder(holder_);
+            if (slot_ >= 0) {
+                data_->unpinSlot(slot_);
             } else {
-                local.units.push_back("");
+                data_->viewPins.fetch_sub(1);
             }
+            data_ = nullptr;
+            slot_ = -1;
+            holder_ = -1;
+        }
+        mapping_.reset();
+    }
+
+    bool SharedDataView::isValid() const {
+        return data_ != nullptr;
+    }
+
+    uint64_t SharedDataView::getVersion() const {
+        return version_;
+    }
+
+    double SharedDataView::getTime() const {
+        if (!data_) {
+            return 0.0;
         }
+        return slot_ >= 0 ? data_->slots[slot_].t : data_->t;
+    }
+
+    std::string SharedDataView::getName() const {
+        return data_ ? std::string(data_->name.c_str()) : std::string();
+    }
 
-        // 复制多分量数据 - 优化：先预分配空间
-        local.data.clear();
-        local.data.reserve(data.size());
+    size_t SharedDataView::getRowCount() const {
+        if (!data_) {
+            return 0;
+        }
+        if (!dataBuffer().empty()) {
+            return dataBuffer().rowCount;
+        }
+        return indexVector().size();
+    }
 
-        // 复制每个分量的数据
-        for (const auto& componentData : data) {
-            // 创建新的向量
-            std::vector<double> localComponentData;
-            localComponentData.reserve(componentData.size());
+    size_t SharedDataView::getComponentCount() const {
+        return data_ ? dataBuffer().componentCount : 0;
+    }
 
-            // 复制数据
-            for (const auto& val : componentData) {
-                localComponentData.push_back(val);
+    size_t SharedDataView::getComponentIndex(const std::string& title) const {
+        if (data_) {
+            // 多缓冲模式下对象头的标题随每次发布改写，只读取固定的槽内的标题
+            const SharedMemoryVectorString& titles = slot_ >= 0 ? data_->slots[slot_].titles : data_->titles;
+            for (size_t i = 0; i < titles.size(); ++i) {
+                if (title == titles[i].c_str()) {
+                    return i;
+                }
             }
+        }
+        return static_cast<size_t>(-1); // 如果找不到，返回无效索引
+    }
 
-            // 添加到数据列表
-            local.data.push_back(localComponentData);
+    SharedDataView::ComponentMap SharedDataView::component(size_t i) const {
+        // 没有可映射的双精度数组(空视图、无数据或降低精度存储)时返回空 Map
+        const double* values = componentData(i);
+        if (!values) {
+            return ComponentMap(nullptr, 0, InnerStride<>(1));
         }
+        return ComponentMap(values, static_cast<Index>(dataBuffer().rowCount),
+            InnerStride<>(static_cast<Index>(componentStride(i))));
+    }
 
-        // 复制几何位置数据 - 优化：先预分配空间
-        local.dimtags.clear();
-        local.dimtags.reserve(dimtags.size());
-        for (const auto& dimtag : dimtags) {
-            local.dimtags.push_back(std::make_pair(dimtag.first, dimtag.second));
+    SharedDataView::ComponentMap SharedDataView::component(const std::string& title) const {
+        return component(getComponentIndex(title));
+    }
+
+    SharedDataView::IndexMap SharedDataView::index() const {
+        if (!data_) {
+            return IndexMap(nullptr, 0);
+        }
+        return IndexMap(indexData(), static_cast<Index>(indexVector().size()));
+    }
+
+    const double* SharedDataView::componentData(size_t i) const {
+        if (!data_) {
+            return nullptr;
         }
+        return dataBuffer().componentData(i);
+    }
 
-        dataRead.store(true); // 标记为已读
+    size_t SharedDataView::componentStride(size_t) const {
+        return data_ ? dataBuffer().componentStride() : 1;
+    }
+
+    const int* SharedDataView::indexData() const {
+        if (!data_ || indexVector().empty()) {
+            return nullptr;
+        }
+        return &indexVector()[0];
+    }
+
+    const SharedMemoryVector<int>& SharedDataView::indexVector() const {
+        return slot_ >= 0 ? data_->slots[slot_].index : data_->index;
+    }
+
+    const SharedFieldBuffer& SharedDataView::dataBuffer() const {
+        return slot_ >= 0 ? data_->slots[slot_].data : data_->data;
     }
 
     //================ SharedControlData 实现 ================
+    SharedNameDirectory::SharedNameDirectory(bip::managed_shared_memory::segment_manager* segment_manager)
+        : hashes(SharedMemoryAllocator<uint64_t>(segment_manager)),
+        segments(SharedMemoryAllocator<int32_t>(segment_manager)),
+        handles(SharedMemoryAllocator<SharedHandle>(segment_manager)),
+        names(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
+        count(0)
+    {
+    }
+
+    uint64_t SharedNameDirectory::hashName(SegmentId segment, const std::string& name)
+    {
+        // FNV-1a，以内存段编号作为第一个字节
+        uint64_t hash = 14695981039346656037ULL;
+        hash = (hash ^ static_cast<uint64_t>(segment)) * 1099511628211ULL;
+        for (unsigned char c : name) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return hash == 0 ? 1 : hash;
+    }
+
+    SharedHandle SharedNameDirectory::find(SegmentId segment, const std::string& name) const
+    {
+        size_t capacity = hashes.size();
+        if (capacity == 0) {
+            return INVALID_HANDLE;
+        }
+
+        checkSharedContainer(hashes);
+        checkSharedContainer(segments);
+        checkSharedContainer(handles);
+        checkSharedContainer(names);
+        if (segments.size() != capacity || handles.size() != capacity || names.size() != capacity ||
+            (capacity & (capacity - 1)) != 0) {
+            throw SharedReadConflict("名称目录正在重建");
+        }
+
+        uint64_t hash = hashName(segment, name);
+        size_t mask = capacity - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        for (size_t probe = 0; probe < capacity; ++probe, i = (i + 1) & mask) {
+            if (hashes[i] == 0) {
+                return INVALID_HANDLE;
+            }
+            if (hashes[i] == hash && segments[i] == segment) {
+                const SharedMemoryString& entry = names[i];
+                checkSharedRange(entry.data(), entry.size(), sizeof(char));
+                if (entry.size() == name.size() && std::equal(name.begin(), name.end(), entry.data())) {
+                    return handles[i];
+                }
+            }
+        }
+        return INVALID_HANDLE;
+    }
+
+    void SharedNameDirectory::insert(SegmentId segment, const std::string& name, SharedHandle handle, SharedMemoryAllocator<char> allocator)
+    {
+        if ((count + 1) * 2 > hashes.size()) {
+            rehash(hashes.empty() ? 64 : hashes.size() * 2, allocator);
+        }
+
+        uint64_t hash = hashName(segment, name);
+        size_t mask = hashes.size() - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        while (hashes[i] != 0) {
+            if (hashes[i] == hash && segments[i] == segment && names[i].size() == name.size() &&
+                std::equal(name.begin(), name.end(), names[i].data())) {
+                handles[i] = handle;
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+
+        hashes[i] = hash;
+        segments[i] = segment;
+        handles[i] = handle;
+        names[i] = SharedMemoryString(name.c_str(), allocator);
+        ++count;
+    }
+
+    void SharedNameDirectory::rehash(size_t capacity, SharedMemoryAllocator<char> allocator)
+    {
+        SharedMemoryVector<uint64_t> oldHashes(hashes.get_allocator());
+        SharedMemoryVector<int32_t> oldSegments(segments.get_allocator());
+        SharedMemoryVector<SharedHandle> oldHandles(handles.get_allocator());
+        SharedMemoryVectorString oldNames(names.get_allocator());
+        oldHashes.swap(hashes);
+        oldSegments.swap(segments);
+        oldHandles.swap(handles);
+        oldNames.swap(names);
+
+        hashes.assign(capacity, 0);
+        segments.assign(capacity, 0);
+        handles.assign(capacity, INVALID_HANDLE);
+        names.reserve(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            names.push_back(SharedMemoryString(allocator));
+        }
+
+        // 旧表项的哈希值已知，直接放入新表，名称字符串交换而不重新分配
+        size_t mask = capacity - 1;
+        for (size_t j = 0; j < oldHashes.size(); ++j) {
+            if (oldHashes[j] == 0) {
+                continue;
+            }
+            size_t i = static_cast<size_t>(oldHashes[j]) & mask;
+            while (hashes[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            hashes[i] = oldHashes[j];
+            segments[i] = oldSegments[j];
+            handles[i] = oldHandles[j];
+            names[i].swap(oldNames[j]);
+        }
+    }
+
+    void SharedNameDirectory::clear()
+    {
+        hashes.clear();
+        segments.clear();
+        handles.clear();
+        names.clear();
+        count = 0;
+    }
+
+    SharedSegmentRecord::SharedSegmentRecord()
+        : magic(MAGIC), layout(0), fingerprint(0)
+    {
+        committed.store(0);
+    }
+
     SharedControlData::SharedControlData(bip::managed_shared_memory::segment_manager* segment_manager)
         : SharedDataBase(segment_manager, DataType::CONTROL_DATA),
         jsonConfig(SharedMemoryAllocator<char>(segment_manager)),
@@ -1366,7 +3454,9 @@ namespace EMP {
         sharedDataNames(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
         sharedDataMemorySizes(SharedMemoryAllocator<int>(segment_manager)),
         sharedDefinitionNames(SharedMemoryAllocator<SharedMemoryString>(segment_manager)),
-        sharedDefinitionMemorySizes(SharedMemoryAllocator<int>(segment_manager))
+        sharedDefinitionMemorySizes(SharedMemoryAllocator<int>(segment_manager)),
+        persistentDirectory(SharedMemoryAllocator<char>(segment_manager)),
+        directory(segment_manager)
     {
         // 初始化基本类型
         dt = 0.01;
@@ -1384,6 +3474,35 @@ namespace EMP {
         controlSegmentFreeSize = 0;
         definitionSegmentTotalSize = 0;
         definitionSegmentFreeSize = 0;
+
+        // 初始化内存段纪元
+        for (int i = 0; i < SegmentCount; ++i) {
+            segmentEpochs[i].store(0);
+            segmentAccesses[i].store(0);
+            segmentGrowing[i].store(false);
+            segmentGrowOwners[i].store(0);
+            segmentNumaPolicies[i].store(0);
+            segmentNumaNodes[i].store(-1);
+            segmentPersistent[i].store(false);
+            segmentHugePageSizes[i].store(0);
+        }
+        for (uint32_t i = 0; i < MAX_SEGMENT_USERS; ++i) {
+            segmentUserPids[i].store(0);
+            for (int j = 0; j < SegmentCount; ++j) {
+                segmentUserAccesses[i][j].store(0);
+            }
+        }
+
+        // 初始化读取方登记表
+        readerMask.store(0);
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerGenerations[i].store(0);
+            readerPids[i].store(0);
+            readerNames[i][0] = '\0';
+        }
+
+        groupSequence.store(0);
+        groupVersion.store(0);
     }
 
     SharedControlData::SharedControlData(const SharedControlData& other)
@@ -1410,8 +3529,34 @@ namespace EMP {
         controlSegmentTotalSize(other.controlSegmentTotalSize),
         controlSegmentFreeSize(other.controlSegmentFreeSize),
         definitionSegmentTotalSize(other.definitionSegmentTotalSize),
-        definitionSegmentFreeSize(other.definitionSegmentFreeSize)
+        definitionSegmentFreeSize(other.definitionSegmentFreeSize),
+        persistentDirectory(other.persistentDirectory),
+        directory(other.directory)
     {
+        for (int i = 0; i < SegmentCount; ++i) {
+            segmentEpochs[i].store(other.segmentEpochs[i].load());
+            segmentAccesses[i].store(0);
+            segmentGrowing[i].store(false);
+            segmentGrowOwners[i].store(0);
+            segmentNumaPolicies[i].store(other.segmentNumaPolicies[i].load());
+            segmentNumaNodes[i].store(other.segmentNumaNodes[i].load());
+            segmentPersistent[i].store(other.segmentPersistent[i].load());
+            segmentHugePageSizes[i].store(other.segmentHugePageSizes[i].load());
+        }
+        for (uint32_t i = 0; i < MAX_SEGMENT_USERS; ++i) {
+            segmentUserPids[i].store(0);
+            for (int j = 0; j < SegmentCount; ++j) {
+                segmentUserAccesses[i][j].store(0);
+            }
+        }
+        readerMask.store(other.readerMask.load());
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerGenerations[i].store(other.readerGenerations[i].load());
+            readerPids[i].store(other.readerPids[i].load());
+            std::memcpy(readerNames[i], other.readerNames[i], READER_NAME_SIZE);
+        }
+        groupSequence.store(0);
+        groupVersion.store(other.groupVersion.load());
         setDataType(DataType::CONTROL_DATA);
     }
 
@@ -1441,6 +3586,20 @@ namespace EMP {
         controlSegmentFreeSize = other.controlSegmentFreeSize;
         definitionSegmentTotalSize = other.definitionSegmentTotalSize;
         definitionSegmentFreeSize = other.definitionSegmentFreeSize;
+        for (int i = 0; i < SegmentCount; ++i) {
+            segmentNumaPolicies[i].store(other.segmentNumaPolicies[i].load());
+            segmentNumaNodes[i].store(other.segmentNumaNodes[i].load());
+            segmentPersistent[i].store(other.segmentPersistent[i].load());
+            segmentHugePageSizes[i].store(other.segmentHugePageSizes[i].load());
+        }
+        readerMask.store(other.readerMask.load());
+        for (uint32_t i = 0; i < MAX_READERS; ++i) {
+            readerGenerations[i].store(other.readerGenerations[i].load());
+            readerPids[i].store(other.readerPids[i].load());
+            std::memcpy(readerNames[i], other.readerNames[i], READER_NAME_SIZE);
+        }
+        directory = other.directory;
+        persistentDirectory = other.persistentDirectory;
 
         return *this;
     }
@@ -1453,7 +3612,7 @@ namespace EMP {
             return;
         }
 
-        writing.store(true);
+        beginWrite();
         version.store(version.load() + 1);
 
         // 设置基础属性
@@ -1545,8 +3704,22 @@ namespace EMP {
             }
         }
 
+        // 按名称列表中的序号登记句柄，目录只增不删，已有名称的句柄保持不变
+        for (size_t i = 0; i < local.modelNames.size(); ++i) {
+            directory.insert(GeometrySegment, local.modelNames[i], static_cast<SharedHandle>(i), allocator);
+        }
+        for (size_t i = 0; i < local.meshNames.size(); ++i) {
+            directory.insert(MeshSegment, local.meshNames[i], static_cast<SharedHandle>(i), allocator);
+        }
+        for (size_t i = 0; i < local.dataNames.size(); ++i) {
+            directory.insert(DataSegment, local.dataNames[i], static_cast<SharedHandle>(i), allocator);
+        }
+        for (size_t i = 0; i < local.definitionNames.size(); ++i) {
+            directory.insert(DefinitionSegment, local.definitionNames[i], static_cast<SharedHandle>(i), allocator);
+        }
+
         dataRead.store(false); // 标记为未读
-        writing.store(false);
+        endWrite();
     }
 
     void SharedControlData::copyToLocal(LocalControlData& local) const
@@ -1558,11 +3731,11 @@ namespace EMP {
         }
 
         // 设置基础属性
-        local.name = std::string(name.c_str());
+        local.name = toLocalString(name);
         local.sysTimeStamp = sysTimeStamp;
         local.version = version.load(); // 更新本地版本号
         local.dataType = dataType;
-        local.jsonConfig = std::string(jsonConfig.c_str());
+        local.jsonConfig = toLocalString(jsonConfig);
         local.dt = dt;
         local.t = t;
         local.isConverged = isConverged;
@@ -1580,12 +3753,14 @@ namespace EMP {
         local.definitionSegmentFreeSize = definitionSegmentFreeSize;
 
         // 复制模型名称和内存大小列表
+        checkSharedContainer(sharedModelNames);
+        checkSharedContainer(sharedModelMemorySizes);
         local.modelNames.clear();
         local.modelMemorySizes.clear();
         local.modelNames.reserve(sharedModelNames.size());
         local.modelMemorySizes.reserve(sharedModelMemorySizes.size());
         for (size_t i = 0; i < sharedModelNames.size(); ++i) {
-            local.modelNames.push_back(std::string(sharedModelNames[i].c_str()));
+            local.modelNames.push_back(toLocalString(sharedModelNames[i]));
             if (i < sharedModelMemorySizes.size()) {
                 local.modelMemorySizes.push_back(sharedModelMemorySizes[i]);
             }
@@ -1595,12 +3770,14 @@ namespace EMP {
         }
 
         // 复制网格名称和内存大小列表
+        checkSharedContainer(sharedMeshNames);
+        checkSharedContainer(sharedMeshMemorySizes);
         local.meshNames.clear();
         local.meshMemorySizes.clear();
         local.meshNames.reserve(sharedMeshNames.size());
         local.meshMemorySizes.reserve(sharedMeshMemorySizes.size());
         for (size_t i = 0; i < sharedMeshNames.size(); ++i) {
-            local.meshNames.push_back(std::string(sharedMeshNames[i].c_str()));
+            local.meshNames.push_back(toLocalString(sharedMeshNames[i]));
             if (i < sharedMeshMemorySizes.size()) {
                 local.meshMemorySizes.push_back(sharedMeshMemorySizes[i]);
             }
@@ -1610,12 +3787,14 @@ namespace EMP {
         }
 
         // 复制数据名称和内存大小列表
+        checkSharedContainer(sharedDataNames);
+        checkSharedContainer(sharedDataMemorySizes);
         local.dataNames.clear();
         local.dataMemorySizes.clear();
         local.dataNames.reserve(sharedDataNames.size());
         local.dataMemorySizes.reserve(sharedDataMemorySizes.size());
         for (size_t i = 0; i < sharedDataNames.size(); ++i) {
-            local.dataNames.push_back(std::string(sharedDataNames[i].c_str()));
+            local.dataNames.push_back(toLocalString(sharedDataNames[i]));
             if (i < sharedDataMemorySizes.size()) {
                 local.dataMemorySizes.push_back(sharedDataMemorySizes[i]);
             }
@@ -1625,12 +3804,14 @@ namespace EMP {
         }
 
         // 复制模型参数名称和内存大小列表
+        checkSharedContainer(sharedDefinitionNames);
+        checkSharedContainer(sharedDefinitionMemorySizes);
         local.definitionNames.clear();
         local.definitionMemorySizes.clear();
         local.definitionNames.reserve(sharedDefinitionNames.size());
         local.definitionMemorySizes.reserve(sharedDefinitionMemorySizes.size());
         for (size_t i = 0; i < sharedDefinitionNames.size(); ++i) {
-            local.definitionNames.push_back(std::string(sharedDefinitionNames[i].c_str()));
+            local.definitionNames.push_back(toLocalString(sharedDefinitionNames[i]));
             if (i < sharedDefinitionMemorySizes.size()) {
                 local.definitionMemorySizes.push_back(sharedDefinitionMemorySizes[i]);
             }
@@ -9,6 +9,7 @@
 #include <chrono>
 #include <iostream>
 #include <atomic>
+#include <memory>
 #include <Eigen/Dense>
 #include <boost/interprocess/managed_shared_memory.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
@@ -17,8 +18,13 @@
 #include <boost/interprocess/containers/map.hpp>
 #include <boost/interprocess/containers/pair.hpp>
 #include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#ifdef _WIN32
 #include <Windows.h> // 包含 Windows.h
+#endif
 #include "SolverHubDef.h"
+#include "SharedDataKernels.h"
 
 using namespace Eigen;
 
@@ -66,6 +72,32 @@ namespace EMP {
 		BlockData // 定义在网格体上
 	};
 
+	// 可扩容的共享内存段编号，用于控制数据中记录各段的纪元
+	enum SegmentId {
+		GeometrySegment = 0,
+		MeshSegment,
+		DataSegment,
+		DefinitionSegment,
+		SegmentCount
+	};
+
+	// 共享对象句柄：对象在控制数据对应名称列表中的序号，所有进程一致，对象存在期间不变
+	typedef int32_t SharedHandle;
+	const SharedHandle INVALID_HANDLE = -1;
+
+	// 共享内存中多分量数据的排列方式
+	enum DataLayout {
+		PlanarLayout = 0, // 按分量连续存放：ux[0..n), uy[0..n), uz[0..n)
+		InterleavedLayout // 按行交错存放：(ux,uy,uz)[0], (ux,uy,uz)[1], ...
+	};
+
+	// 共享内存中多分量数据的存储精度，读写接口始终使用 double，写入和读取时转换
+	enum DataPrecision {
+		Float64Precision = 0, // 双精度，支持零拷贝视图
+		Float32Precision,     // 单精度，占用一半空间，用于后处理和监控
+		BFloat16Precision     // bfloat16，占用四分之一空间，只有约 3 位有效数字，用于可视化
+	};
+
 	// 本地数据基类，为所有本地数据结构提供统一接口
 	class SOLVERHUB_API LocalDataBase {
 	public:
@@ -99,12 +131,78 @@ namespace EMP {
 		void setDataType(DataType type);
 	};
 
+	// 等待策略：先自旋 spinMicros 微秒(每次检查之间执行 CPU 的 pause 指令)，再让出 CPU yieldMicros 微秒，之后阻塞。
+	// adaptive 时按近期实测的等待时间调整自旋时长：等待通常很快结束时只自旋略长于平均等待的时间，通常较长时不自旋
+	struct SOLVERHUB_API WaitPolicy
+	{
+		uint32_t spinMicros = 0;        // 自旋时长上限
+		uint32_t yieldMicros = 0;       // 让出 CPU 的时长
+		bool adaptive = false;          // 是否按实测等待时间调整自旋时长
+	};
+
+	// 自旋等待中的一次 CPU 停顿，降低自旋对同一物理核上其他线程和内存总线的影响
+	inline void cpuRelax()
+	{
+#if defined(_MSC_VER)
+		YieldProcessor();
+#elif defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+		__asm__ __volatile__("yield");
+#endif
+	}
+
+	// 乐观(无锁)读取时检测到并发写入，调用方应重试
+	class SOLVERHUB_API SharedReadConflict : public std::runtime_error {
+	public:
+		explicit SharedReadConflict(const std::string& message) : std::runtime_error(message) {}
+	};
+
+	// 乐观读取期间写入方可能正在改写对象，共享容器的指针和长度可能处于中间状态。
+	// beginOptimisticRead 记录当前线程正在读取的内存段地址范围，copyToLocal 复制容器前
+	// 用 checkSharedRange 校验，越界时抛出 SharedReadConflict；不在乐观读取中时校验直接通过。
+	SOLVERHUB_API void beginOptimisticRead(const void* segmentBase, size_t segmentSize);
+	SOLVERHUB_API void endOptimisticRead();
+	SOLVERHUB_API void checkSharedRange(const void* ptr, size_t count, size_t elementSize);
+
+	template <typename Container>
+	inline void checkSharedContainer(const Container& c) {
+		checkSharedRange(c.data(), c.size(), sizeof(typename Container::value_type));
+	}
+
+	// 校验后将共享字符串复制为 std::string
+	SOLVERHUB_API std::string toLocalString(const SharedMemoryString& s);
+
 	// 共享数据基类，为所有共享数据结构提供统一接口
 	class SOLVERHUB_API SharedDataBase {
 	public:
 		std::atomic<uint64_t> version;    // 版本号，原子类型确保多进程并发安全
 		std::atomic<bool> writing;        // 写入锁标志
+		std::atomic<uint64_t> sequence;   // 顺序锁计数，写入期间为奇数，供乐观读取校验
+		bip::interprocess_condition versionChanged; // 版本号变化时通知等待方
+		std::atomic<uint32_t> waiters;    // 正在等待新版本的读取方数量
+		uint64_t writeStartVersion;       // 本次写入开始时的版本号
 		mutable std::atomic<bool> dataRead;       // 数据是否已被读取标志
+		mutable std::atomic<uint32_t> viewPins;   // 零拷贝只读视图的固定计数，大于0时写入方需等待
+
+		// 持有视图(或正在读取多缓冲槽)的进程号、固定的槽(-1 表示整个对象，计入 viewPins)及计数，
+		// 持有方进程退出后写入方据此回收遗留的计数；登记表已满时只计入 viewPins 或槽的 readers
+		static const uint32_t MAX_VIEW_HOLDERS = 8;
+		mutable std::atomic<int64_t> viewHolderPids[MAX_VIEW_HOLDERS];
+		mutable std::atomic<int32_t> viewHolderSlots[MAX_VIEW_HOLDERS];
+		mutable std::atomic<uint32_t> viewHolderPins[MAX_VIEW_HOLDERS];
+
+		// 读取方游标：按读取方编号记录各读取方最近读到的版本，高 16 位为读取方登记时的代数，
+		// 编号被重新分配后旧游标的代数不再匹配，视为未读取
+		static const uint32_t MAX_READERS = 16;
+		static const uint32_t READER_GENERATION_SHIFT = 48;
+		mutable std::atomic<uint64_t> readerCursors[MAX_READERS];
+
+		// 本对象上的等待策略(见 WaitPolicy)和近期等待时间的指数平均(微秒)，由所有进程共享
+		std::atomic<uint32_t> waitSpinMicros;
+		std::atomic<uint32_t> waitYieldMicros;
+		std::atomic<bool> waitAdaptive;
+		mutable std::atomic<uint32_t> waitAverageMicros;
 		time_t sysTimeStamp;              // 系统时间戳
 		SharedMemoryString name;          // 数据名称
 		bip::interprocess_mutex mutex;    // 用于保护共享数据的互斥锁
@@ -127,6 +225,86 @@ namespace EMP {
 
 		// 设置数据类型
 		void setDataType(DataType type);
+
+		// 写入方在修改对象前后调用(需持有 mutex)，维护 writing 标志和顺序锁计数；
+		// 写入期间版本号发生变化时，endWrite 唤醒所有等待新版本的读取方
+		void beginWrite();
+		void endWrite();
+
+		// 等待版本号不同于 lastSeen(需持有 mutex)，timeoutMs 小于 0 表示一直等待。
+		// 返回等待结束时的版本号，超时返回时版本号仍为 lastSeen
+		uint64_t waitForVersion(bip::scoped_lock<bip::interprocess_mutex>& lock, uint64_t lastSeen, int timeoutMs);
+
+		// 乐观读取：readBegin 返回当前顺序锁计数，写入进行中时返回奇数；
+		// 复制完成后用 readValidate 确认期间没有写入发生
+		uint64_t readBegin() const;
+		bool readValidate(uint64_t seq) const;
+
+		// 为进程 holderPid 在槽 slot(-1 表示整个对象)上的一个固定登记持有方(持锁)，优先沿用已有的登记项。
+		// 返回登记项，holderPid 为 0 或登记表已满时返回 -1
+		int registerViewHolder(int64_t holderPid, int32_t slot) const;
+
+		// 释放 registerViewHolder 登记的一个固定(无需持锁)，holder 为 -1 时不做任何事
+		void releaseViewHolder(int holder) const;
+
+		// 记录编号为 reader、代数为 generation 的读取方已读到 readVersion
+		void markConsumed(uint32_t reader, uint32_t generation, uint64_t readVersion) const;
+
+		// 编号为 reader、代数为 generation 的读取方最近读到的版本，代数不符或从未读取时为 0
+		uint64_t consumedVersion(uint32_t reader, uint32_t generation) const;
+
+		// 编号为 reader、代数为 generation 的读取方是否订阅了本对象(读取过或显式订阅，游标代数相符)
+		bool hasConsumer(uint32_t reader, uint32_t generation) const;
+
+		// 清除编号为 reader 的游标，该读取方不再订阅本对象
+		void clearConsumer(uint32_t reader) const;
+
+		// 等待策略
+		WaitPolicy getWaitPolicy() const;
+		void setWaitPolicy(const WaitPolicy& policy);
+
+		// 本次等待实际使用的自旋时长：adaptive 时由近期等待时间决定
+		uint32_t effectiveSpinMicros() const;
+
+		// 记录一次等待的实测时长，adaptive 时用于调整自旋时长
+		void recordWait(uint64_t micros) const;
+
+		// 按等待策略自旋、让出 CPU，直到 ready() 为真或进入阻塞阶段；返回 ready() 是否已为真，为 false 时调用方阻塞等待
+		template <typename Ready>
+		bool spinWait(Ready ready) const {
+			if (ready()) {
+				return true;
+			}
+
+			uint32_t spinMicros = effectiveSpinMicros();
+			uint32_t yieldMicros = waitYieldMicros.load(std::memory_order_relaxed);
+			if (spinMicros == 0 && yieldMicros == 0) {
+				return false;
+			}
+
+			auto spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(spinMicros);
+			auto yieldEnd = spinEnd + std::chrono::microseconds(yieldMicros);
+			while (std::chrono::steady_clock::now() < spinEnd) {
+				// 每检查一次停顿若干次，避免频繁读取时钟
+				for (int i = 0; i < 32; ++i) {
+					cpuRelax();
+				}
+				if (ready()) {
+					return true;
+				}
+			}
+			while (std::chrono::steady_clock::now() < yieldEnd) {
+				std::this_thread::yield();
+				if (ready()) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// 重置锁、写入标志、顺序锁计数和读取方计数。只在没有其他进程访问该对象时调用，
+		// 用于打开上次运行留下的持久化内存段
+		void resetTransientState();
 	};
 
 	// 定义模型的一组参数
@@ -286,6 +464,23 @@ namespace EMP {
 		bool saveToFile(const std::string& filePath) const;
 		bool loadFromFile(const std::string& filePath);
 
+		// 压缩的二进制文件读写，用于归档大规模场数据的时间历程。errorBounds[c] 为第 c 个分量允许的绝对误差，
+		// 不大于 0 时该分量无损保存；errorBounds 比分量少时其余分量沿用最后一个值，为空时全部无损。
+		// 索引列总是无损保存。threads 为压缩/解压线程数，0 表示按 CPU 核数
+		bool saveCompressed(const std::string& filePath, const std::vector<double>& errorBounds, unsigned threads = 0) const;
+		bool loadCompressed(const std::string& filePath, unsigned threads = 0);
+
+		// 稀疏表示：sparse 只保留至少一个分量的绝对值大于 zeroTolerance 的行(NaN/Inf 视为非零)，
+		// 保留行的索引即稀疏模式；索引列为空时以行号作为索引。行数按索引列和各分量中最短的计
+		void toSparse(LocalData& sparse, double zeroTolerance = 0.0) const;
+
+		// 将稀疏数据展开到 denseIndex 给出的各行：索引列中出现的行取对应的值，其余行为 0，
+		// 不在 denseIndex 中的行被忽略。sparse/dense 可以是本对象
+		void toDense(const std::vector<int>& denseIndex, LocalData& dense) const;
+
+		// 各分量长度是否相同，共享对象只接受长度一致的分量
+		bool hasUniformComponents() const;
+
 		// 分量管理
 		void addComponent(const std::string& componentName, const std::vector<double>& componentData, const std::string& unit = "");
 		std::vector<double> getComponent(const std::string& componentName) const;
@@ -293,6 +488,23 @@ namespace EMP {
 		size_t getComponentIndex(const std::string& componentName) const;
 	};
 
+	// 由精细数据生成低分辨率数据的规则：低分辨率数据的第 k 行取精细数据中索引值为
+	// members[offsets[k]] 到 members[offsets[k + 1] - 1] 的各行的平均值。精细数据没有索引列时成员为行号；
+	// 精细数据中没有的成员不计入平均，稀疏模式下省略的全零行按 0 计入；没有任何成员的组为 0
+	struct SOLVERHUB_API DataCoarsening
+	{
+		std::vector<int> coarseIndex;    // 低分辨率数据的索引列
+		std::vector<size_t> offsets;     // 各组在 members 中的起止位置，大小为 coarseIndex.size() + 1
+		std::vector<int> members;        // 各组包含的精细数据索引值
+
+		// 抽样：只保留索引值为 ids 的行(如预先选定的稀疏结点子集)
+		static DataCoarsening sampling(const std::vector<int>& ids);
+
+		// 分组平均：coarseIndex[k] 行取 groups[k] 中各行的平均值，如按单元的结点把结点量平均为单元量。
+		// groups 与 coarseIndex 的大小不一致时抛出 std::invalid_argument
+		static DataCoarsening averaging(const std::vector<int>& coarseIndex, const std::vector<std::vector<int>>& groups);
+	};
+
 	// 共享的几何文件类
 	struct SOLVERHUB_API SharedGeometry : public SharedDataBase
 	{
@@ -369,9 +581,223 @@ namespace EMP {
 		void copyToLocal(LocalMesh& local) const;
 	};
 
+	/// 计算数据写入时统计的各分量统计量，只统计前 MAX_COMPONENTS 个分量。
+	/// 保存在数据头中，监控和收敛判断只需读取这几百个字节，不必复制整个场
+	struct SOLVERHUB_API SharedFieldStats
+	{
+		static const uint32_t MAX_COMPONENTS = 9;      // 最多统计的分量数，足够容纳 3x3 张量
+
+		uint32_t componentCount;                        // 已统计的分量数，0 表示未知
+		uint64_t rowCount;                              // 每个分量的行数
+		DataKernels::ValueStats components[MAX_COMPONENTS];
+
+		SharedFieldStats();
+
+		// 置为未知
+		void clear();
+
+		// 稀疏模式省略的行按 0 计入，使统计量与展开为 denseRows 行的稠密数据一致
+		void addImplicitZeros(uint64_t denseRows);
+	};
+
+	/// 多分量数据的连续存储：所有分量存放在同一块共享内存中，
+	/// 复制只需按分量(平面排列)或整体转置(交错排列)进行，不再为每个分量单独分配
+	struct SOLVERHUB_API SharedFieldBuffer
+	{
+		DataLayout layout;                  // 排列方式
+		DataPrecision precision;            // 存储精度
+		uint32_t componentCount;            // 分量个数
+		uint64_t rowCount;                  // 每个分量的行数
+		SharedMemoryVector<double> values;  // 双精度存储时的数据，共 componentCount * rowCount 个值
+		SharedMemoryVector<char> packed;    // 单精度或 bfloat16 存储时的数据，按相同的排列方式存放
+
+		SharedFieldBuffer(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 拷贝构造函数
+		SharedFieldBuffer(const SharedFieldBuffer& other);
+
+		// operator=()
+		SharedFieldBuffer& operator=(const SharedFieldBuffer& other);
+
+		// 每个值按 precision 存储时占用的字节数
+		static size_t elementBytes(DataPrecision precision);
+
+		// 是否以低于双精度的精度存储
+		bool isReduced() const;
+
+		bool empty() const;
+
+		// 清空数据，保留已分配的空间
+		void clear();
+
+		// 释放多余的空间
+		void shrinkToFit();
+
+		// 存储数据的首地址和字节数，与精度无关
+		const void* storage() const;
+		size_t storageBytes() const;
+
+		// 分量 c 的首地址及相邻元素的步长(以 double 计)，只在双精度存储时有效，否则返回 nullptr
+		const double* componentData(size_t c) const;
+		double* componentData(size_t c);
+		size_t componentStride() const;
+
+		// 读写分量 c 的 [offset, offset + count) 行，任何精度和排列方式均可，调用方需确认范围有效
+		void readComponent(size_t c, size_t offset, size_t count, double* out) const;
+		void writeComponent(size_t c, size_t offset, size_t count, const double* in);
+
+		// 按行号收集分量 c 的值
+		void gatherComponent(size_t c, const std::vector<size_t>& rows, double* out) const;
+
+		// 按指定排列方式和精度写入各分量，各分量长度必须相同，否则抛出 std::invalid_argument 且不修改本对象；
+		// stats 不为空时统计各分量写入的值(降低精度前)，双精度平面排列时与复制在同一遍循环中完成
+		void assign(const std::vector<std::vector<double>>& components, DataLayout newLayout,
+			DataPrecision newPrecision = Float64Precision, SharedFieldStats* stats = nullptr);
+
+		// 读出各分量
+		void extract(std::vector<std::vector<double>>& components) const;
+
+		// 原地转换排列方式
+		void setLayout(DataLayout newLayout);
+
+		// 原地转换存储精度，降低精度时舍入已有数据
+		void setPrecision(DataPrecision newPrecision);
+	};
+
+	/// SharedData 多缓冲模式下的单个数据槽
+	/// 写入方填充后台槽，再通过原子地切换 frontSlot 发布；读取方只读取已发布的前台槽
+	struct SOLVERHUB_API SharedDataSlot
+	{
+		std::atomic<uint64_t> version;          // 槽内数据对应的版本号
+		mutable std::atomic<uint32_t> readers;  // 正在读取该槽的读取方数量(含零拷贝视图)
+		std::atomic<bool> writing;              // 写入方是否正在填充该槽
+		double t;                               // 槽内数据对应的耦合计算时刻
+		SharedMemoryVector<int> index;          // 槽内数据索引
+		SharedFieldBuffer data;                 // 槽内多分量数据
+		SharedMemoryVectorString titles;        // 槽内数据的分量标题和单位，随槽发布，视图固定槽期间不会被改写
+		SharedMemoryVectorString units;
+		SharedFieldStats stats;                 // 填充槽时统计的各分量统计量，发布时复制到数据头
+
+		SharedDataSlot(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 拷贝构造函数
+		SharedDataSlot(const SharedDataSlot& other);
+
+		// operator=()
+		SharedDataSlot& operator=(const SharedDataSlot& other);
+	};
+
+	/// 计算数据的历史帧环形缓冲：每帧为某一时刻的全部分量(平面排列)，容量固定，
+	/// 追加时覆盖最旧的帧。只在第一次追加或帧的形状改变时分配空间，之后追加不再重新分配
+	struct SOLVERHUB_API SharedFrameRing
+	{
+		uint32_t capacity;                  // 可保存的帧数，0 表示未启用
+		uint32_t componentCount;            // 每帧的分量个数
+		uint64_t rowCount;                  // 每个分量的行数
+		uint64_t frameCount;                // 累计追加的帧数
+		SharedMemoryVector<double> times;   // 各槽位的帧时刻
+		SharedMemoryVector<double> values;  // 各槽位的帧数据，共 capacity * componentCount * rowCount 个值
+
+		SharedFrameRing(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 拷贝构造函数
+		SharedFrameRing(const SharedFrameRing& other);
+
+		// operator=()
+		SharedFrameRing& operator=(const SharedFrameRing& other);
+
+		// 设置容量，保留最新的 min(原容量, 新容量) 帧；容量不变时不做任何事，0 表示关闭并释放空间
+		void setCapacity(uint32_t newCapacity);
+
+		// 当前保存的帧数
+		size_t size() const;
+
+		// 追加形状为 components 的一帧是否需要重新分配空间
+		bool needsAllocation(const std::vector<std::vector<double>>& components) const;
+
+		// 追加一帧，时刻必须大于最新帧的时刻；形状与已有帧不同时重新分配并清空历史
+		bool append(double t, const std::vector<std::vector<double>>& components);
+
+		// 第 k 帧：k >= 0 从最旧的帧数起，k < 0 从最新的帧倒数(-1 为最新帧)
+		bool frame(int k, double& t, std::vector<std::vector<double>>& components) const;
+
+		// 时刻 t 的数据：在两帧之间时线性插值，晚于最新帧时 extrapolate 为真则按最近两帧线性外推
+		bool atTime(double t, std::vector<std::vector<double>>& components, bool extrapolate = false) const;
+
+	private:
+		// 第 k 旧的帧所在的槽位
+		size_t slotOf(size_t k) const;
+		const double* slotData(size_t slot) const;
+	};
+
+	/// SharedData 的一次局部更新记录：版本 version 改写了 [offset, offset + count) 行
+	struct SharedDirtyRange
+	{
+		uint64_t version;
+		uint64_t offset;
+		uint64_t count;
+	};
+
+	/// SharedData 中一个几何位置(dimension, tag)对应的连续行范围 [offset, offset + count)
+	struct SharedDataRegion
+	{
+		int dim;
+		int tag;
+		uint64_t offset;
+		uint64_t count;
+	};
+
+	/// SharedData 保留的一个版本
+	struct SOLVERHUB_API SharedRetainedVersion
+	{
+		uint64_t version;                   // 版本号，0 表示空位
+		double t;                           // 该版本对应的耦合计算时刻
+		SharedMemoryVector<int> index;      // 该版本的数据索引
+		SharedFieldBuffer data;             // 该版本的多分量数据
+
+		SharedRetainedVersion(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 是否占有数据空间
+		bool allocated() const;
+
+		// 释放数据空间并置为空位
+		void release();
+	};
+
+	/// 计算数据的多版本保留：每次发布新版本后把完整数据复制到一个空位，读取方可以按版本号读取仍保留的版本。
+	/// 最新的 depth 个版本和版本号不低于 collectBelow 的版本不会被回收；其余版本在下次保留时被回收，
+	/// 其空间优先给新版本重复使用，多余的空间释放。空位用尽时覆盖最旧的版本。读写需持有互斥锁
+	struct SOLVERHUB_API SharedVersionStore
+	{
+		static const uint32_t MAX_VERSIONS = 8;    // 最多保留的版本数
+
+		uint32_t depth;                         // 至少保留的最新版本数
+		uint32_t capacity;                      // 空位数，depth <= capacity <= MAX_VERSIONS
+		std::atomic<uint64_t> collectBelow;     // 回收下限，写入方按最慢读取方的游标设置
+		uint64_t evictedCount;                  // 空位用尽时被覆盖的、仍在回收下限之上的版本数
+		SharedRetainedVersion entries[MAX_VERSIONS];
+
+		SharedVersionStore(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 设置保留的版本数并清空已有版本
+		void configure(uint32_t newDepth, uint32_t newCapacity);
+
+		// 保留版本 version 的数据，返回是否保留成功(内存段空间不足时放弃本版本)
+		bool retain(uint64_t version, double t, const SharedMemoryVector<int>& index, const SharedFieldBuffer& data);
+
+		// 版本 version 的保留数据，不存在时返回 nullptr
+		const SharedRetainedVersion* find(uint64_t version) const;
+
+		// 仍保留的版本号，从旧到新
+		std::vector<uint64_t> versions() const;
+	};
+
 	///共享的场和全局量的计算数据
 	struct SOLVERHUB_API SharedData : public SharedDataBase
 	{
+		static const uint32_t MAX_SLOTS = 3;   // 多缓冲模式下的最大槽数
+		static const uint32_t MAX_DIRTY_RANGES = 32;   // 保留的局部更新记录数
+
 		bool isFieldData;			    // 是否是场数据
 		double t;                       // 数据对应的耦合计算时刻
 		DataGeoType type;			    // 数据类型
@@ -380,21 +806,220 @@ namespace EMP {
 		SharedMemoryVector<int> index;	     // 数据索引, 指定数据对应的网格结点、边、面或体 element 的 id，所有数据都必须包含索引列
 		SharedMemoryVectorString titles;      // 各数据分量的标题，例如，ux, uy, uz
 		SharedMemoryVectorString units;       // 各数据分量的单位，例如，m/s, m/s, m/s
-		SharedMemoryVector<SharedMemoryVector<double>> data; // 多分量数据
+		DataLayout layout;                   // 多分量数据的排列方式，写入时按此排列
+		DataPrecision precision;             // 多分量数据的存储精度，写入时按此转换
+		SharedFieldBuffer data;              // 多分量数据(单缓冲模式)
+
+		// 多缓冲模式：slotCount 为 0 时使用上面的 index/data 单缓冲，
+		// 为 2 或 3 时 index/data/t 存放在 slots 中，frontSlot 指向最近一次完整发布的槽
+		uint32_t slotCount;
+		std::atomic<uint32_t> frontSlot;
+		SharedDataSlot slots[MAX_SLOTS];
+
+		// 局部更新记录：fullWriteVersion 为最近一次整体写入的版本，之后的每个版本都是一次局部更新，
+		// 按顺序记录在环形数组 dirtyRanges 中，dirtyCount 为累计的局部更新次数
+		uint64_t fullWriteVersion;
+		uint64_t dirtyCount;
+		SharedDirtyRange dirtyRanges[MAX_DIRTY_RANGES];
+
+		// 耦合历史帧，读写需持有互斥锁
+		SharedFrameRing history;
+
+		// 多版本保留，未启用时为空；启用时在同一内存段中单独分配
+		bip::offset_ptr<SharedVersionStore> versions;
+
+		// 内容哈希：最近一次整体写入的索引、分量数据和元数据(不含时刻 t)的哈希，0 表示未知(尚未写入、之后有过局部更新
+		// 或写入时未开启 skipUnchanged)。skipUnchanged 为真时才计算哈希，内容与哈希相同且时刻相同的整体写入不复制数据、不增加版本号
+		std::atomic<uint64_t> contentHash;
+		std::atomic<bool> skipUnchanged;
+
+		// 最近一次整体写入时统计的各分量统计量，之后有过局部更新时为未知
+		SharedFieldStats stats;
+
+		// 各几何位置对应的行范围，由写入方设置，用于按 dimtag 读取子集；未设置时为空
+		SharedMemoryVector<SharedDataRegion> regions;
+
+		// 索引列的哈希，只在整体写入时更新，0 表示未知。读取方据此判断缓存的索引值到行号的映射是否仍有效
+		std::atomic<uint64_t> indexHash;
+
+		// 稀疏模式：整体写入时只保存至少一个分量的绝对值大于 sparseTolerance 的行，索引列即稀疏模式。
+		// 读取得到的是稀疏数据，需要稠密数据时由读取方按网格的索引展开(见 LocalData::toDense)
+		std::atomic<bool> sparse;
+		std::atomic<double> sparseTolerance;
 
 		SharedData(bip::managed_shared_memory::segment_manager* segment_manager);
 
-		// 拷贝构造函数
+		// 拷贝构造函数(保留的版本不随对象复制)
 		SharedData(const SharedData& other);
 
+		// 释放多版本保留的空间
+		~SharedData();
+
 		// operator=()
 		SharedData& operator=(const SharedData& other);
 
-		// 从LocalData复制数据到共享对象
-		void copyFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator);
+		// 从LocalData复制数据到共享对象，hash 为 local 的内容哈希，0 表示由本函数按需计算(只在开启 skipUnchanged 时)。
+		// 稀疏模式下 denseRows 为去掉全零行之前的行数，统计量把省略的行按 0 计入。
+		// 多缓冲模式下没有可写入的后台槽时抛出 std::runtime_error，调用方应在加锁前等待 hasWriteSlot
+		void copyFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t hash = 0, uint64_t denseRows = 0);
+
+		// LocalData 的内容哈希，与共享数据的排列方式和槽数无关，不会为 0
+		static uint64_t hashContent(const LocalData& local);
+
+		// 内容哈希为 hash、时刻为 t 的整体写入是否可以跳过
+		bool isUnchanged(uint64_t hash, double t) const;
+
+		// 当前数据的索引列(多缓冲模式下为前台槽的索引，持锁)
+		const SharedMemoryVector<int>& currentIndex() const;
+
+		// 只把第 rows 行的索引和数据按 rows 的顺序复制到 LocalData(持锁)，元数据取当前值；
+		// 行号超出范围时抛出 std::out_of_range
+		void copyRowsToLocal(const std::vector<size_t>& rows, LocalData& local) const;
 
 		// 复制数据到LocalData
 		void copyToLocal(LocalData& local) const;
+
+		// 改写从 offset 开始的 count 行(单缓冲模式，调用方需持有互斥锁并确认行范围有效)，
+		// components[c] 为第 c 个分量的 count 个新值，可以只给出前几个分量；索引、标题和单位不变
+		void writeRange(size_t offset, size_t count, const std::vector<std::vector<double>>& components);
+
+		// 只把 local.version 之后局部更新过的行复制到 local，ranges 返回合并后的行范围(持锁)。
+		// 期间有过整体写入、记录已被覆盖或 local 的形状与共享数据不一致时返回 false，调用方需整体读取
+		bool copyChangesToLocal(LocalData& local, std::vector<std::pair<size_t, size_t>>& ranges) const;
+
+		// 切换多分量数据的排列方式，已有数据原地转置，调用方需持有互斥锁且无读写进行中
+		void setLayout(DataLayout newLayout);
+
+		// 切换多分量数据的存储精度，已有数据原地转换，调用方需持有互斥锁且无读写进行中
+		void setPrecision(DataPrecision newPrecision);
+
+		// 是否启用多缓冲模式
+		bool isSlotted() const;
+
+		// 切换槽数(0、2 或 3)，当前数据保留在新的布局中，调用方需持有互斥锁且无读写进行中
+		void setSlotCount(uint32_t count);
+
+		// 是否有读取方或写入方正在使用任何槽
+		bool slotsBusy() const;
+
+		// 以下为多缓冲模式的分步接口，标注"持锁"的需由调用方持有互斥锁
+		// 是否有可以写入的后台槽(持锁)：非前台、无读取方固定、未被其他写入方占用
+		bool hasWriteSlot() const;
+
+		// 选取并占用一个后台槽(持锁)，没有可用槽时返回 -1
+		int acquireWriteSlot();
+
+		// 将 LocalData 的索引和数据写入已占用的后台槽(无需持锁)，denseRows 同 copyFromLocal
+		void fillSlot(int slot, const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t denseRows = 0);
+
+		// 复制元数据并发布后台槽为前台槽(持锁)，hash 为 local 的内容哈希，0 表示由本函数计算
+		void publishSlot(int slot, const LocalData& local, SharedMemoryAllocator<char> allocator, uint64_t hash = 0);
+
+		// 放弃已占用但未发布的后台槽(持锁)
+		void abandonSlot(int slot);
+
+		// 固定前台槽并复制元数据到LocalData(持锁)，返回被固定的槽号
+		int pinFrontSlot(LocalData& local) const;
+
+		// 从已固定的槽复制索引和数据到LocalData(无需持锁)
+		void copySlotToLocal(int slot, LocalData& local) const;
+
+		// 释放对槽的固定(无需持锁)
+		void unpinSlot(int slot) const;
+
+		// 设置多版本保留(持锁)：depth 为至少保留的最新版本数，capacity 为最多保留的版本数，depth 为 0 时关闭并释放空间。
+		// 已有数据立即作为当前版本保留
+		void setRetention(uint32_t depth, uint32_t capacity);
+
+		// 把保留的版本 v 复制到 LocalData(持锁)，元数据取当前值；版本不存在时返回 false
+		bool copyVersionToLocal(uint64_t v, LocalData& local) const;
+
+	private:
+		// 保留刚发布的当前版本(持锁)
+		void retainCurrent();
+
+		// 复制除索引和数据外的元数据
+		void copyMetaFromLocal(const LocalData& local, SharedMemoryAllocator<char> allocator);
+		void copyMetaToLocal(LocalData& local) const;
+	};
+
+	/// SharedData 的零拷贝只读视图
+	/// 视图存在期间固定(pin)当前版本：写入方在复制新数据前会等待所有视图释放，
+	/// 因此视图返回的指针和 Eigen Map 在其生命周期内始终指向同一版本的数据。
+	/// 注意：同一线程持有视图时不要写入同一数据对象，否则会死锁。
+	/// 多缓冲模式下视图固定的是前台槽，写入方改写其他槽，不会等待视图。
+	/// 降低精度存储的数据没有双精度数组可供映射，构造得到空视图。
+	class SOLVERHUB_API SharedDataView {
+	public:
+		using ComponentMap = Map<const ArrayXd, 0, InnerStride<>>;
+		using IndexMap = Map<const ArrayXi>;
+
+		// 空视图
+		SharedDataView();
+
+		// 加锁并固定 data 的当前版本；mapping 为 data 所在的映射，视图存在期间保持该映射有效。
+		// holderPid 大于 0 时登记为持有方进程，进程退出后写入方可以回收其固定计数
+		explicit SharedDataView(SharedData* data, std::shared_ptr<const void> mapping = nullptr, int64_t holderPid = 0);
+
+		// 移动构造和移动赋值，视图不可拷贝
+		SharedDataView(SharedDataView&& other) noexcept;
+		SharedDataView& operator=(SharedDataView&& other) noexcept;
+		SharedDataView(const SharedDataView&) = delete;
+		SharedDataView& operator=(const SharedDataView&) = delete;
+
+		// 析构时释放固定
+		~SharedDataView();
+
+		// 释放固定，之后视图变为空视图
+		void release();
+
+		// 视图是否有效
+		bool isValid() const;
+
+		// 固定的版本号
+		uint64_t getVersion() const;
+
+		// 数据对应的耦合计算时刻
+		double getTime() const;
+
+		// 数据名称
+		std::string getName() const;
+
+		// 数据行数
+		size_t getRowCount() const;
+
+		// 数据分量个数
+		size_t getComponentCount() const;
+
+		// 根据标题查找分量序号，找不到返回 -1
+		size_t getComponentIndex(const std::string& title) const;
+
+		// 分量 i 的只读 Map，直接指向共享内存
+		ComponentMap component(size_t i) const;
+
+		// 根据标题获取分量的只读 Map
+		ComponentMap component(const std::string& title) const;
+
+		// 索引列的只读 Map，直接指向共享内存
+		IndexMap index() const;
+
+		// 分量 i 的首地址及相邻元素的步长（以 double 计）
+		const double* componentData(size_t i) const;
+		size_t componentStride(size_t i) const;
+
+		// 索引列首地址
+		const int* indexData() const;
+
+	private:
+		// 视图指向的索引和数据(单缓冲模式为对象本身，多缓冲模式为被固定的槽)
+		const SharedMemoryVector<int>& indexVector() const;
+		const SharedFieldBuffer& dataBuffer() const;
+
+		SharedData* data_;
+		int slot_;
+		int holder_;
+		uint64_t version_;
+		std::shared_ptr<const void> mapping_;
 	};
 
 	// Exception structure for inter-process exception handling
@@ -455,6 +1080,46 @@ namespace EMP {
 		DataType getDataType() const override;
 	};
 
+	/// 名称目录：开放寻址哈希表，键为(内存段, 名称)，值为对象句柄。
+	/// 表项只增不删，容量为2的幂，装载因子超过一半时翻倍重建
+	struct SOLVERHUB_API SharedNameDirectory
+	{
+		SharedMemoryVector<uint64_t> hashes;        // 0 表示空位
+		SharedMemoryVector<int32_t> segments;       // 内存段编号
+		SharedMemoryVector<SharedHandle> handles;   // 对象句柄
+		SharedMemoryVectorString names;             // 名称，用于确认哈希命中
+		uint32_t count;                             // 已登记的名称数
+
+		SharedNameDirectory(bip::managed_shared_memory::segment_manager* segment_manager);
+
+		// 查找名称对应的句柄，不存在时返回 INVALID_HANDLE
+		SharedHandle find(SegmentId segment, const std::string& name) const;
+
+		// 登记名称对应的句柄，已存在时覆盖
+		void insert(SegmentId segment, const std::string& name, SharedHandle handle, SharedMemoryAllocator<char> allocator);
+
+		// 清空目录
+		void clear();
+
+	private:
+		static uint64_t hashName(SegmentId segment, const std::string& name);
+		void rehash(size_t capacity, SharedMemoryAllocator<char> allocator);
+	};
+
+	/// 持久化内存段中的校验记录，以 SharedSegmentRecord::NAME 存放在段内
+	struct SOLVERHUB_API SharedSegmentRecord
+	{
+		static constexpr const char* NAME = "SegmentRecord";
+		static const uint64_t MAGIC = 0x314D474553424853ULL;   // "SHBSEGM1"
+
+		uint64_t magic;                     // 固定标识
+		uint64_t layout;                    // 共享对象布局的签名，共享对象的定义改变后不再匹配
+		uint64_t fingerprint;               // 调用方提供的内容指纹
+		std::atomic<uint32_t> committed;    // 内容是否完整：提交后为 1，之后有写入时清零，creator 正常退出时恢复
+
+		SharedSegmentRecord();
+	};
+
 	/// 共享耦合控制数据
 	struct SOLVERHUB_API SharedControlData : public SharedDataBase
 	{
@@ -493,6 +1158,47 @@ namespace EMP {
 		size_t definitionSegmentTotalSize;  // 模型参数共享内存段总大小
 		size_t definitionSegmentFreeSize;   // 模型参数共享内存段可用空间大小
 
+		// 内存段扩容协调：扩容或重建后纪元加一，各进程发现纪元变化后重新映射该段。
+		// 各管理器在 segmentUserPids 中占用一项，在段内读写期间计入该项的 segmentUserAccesses，
+		// 未占到登记项的管理器计入 segmentAccesses。扩容方置 segmentGrowing 并在 segmentGrowOwners 记下进程号，
+		// 再等待各项归零；已退出进程的登记项不再等待，扩容方退出后等待方清除扩容标志
+		static const uint32_t MAX_SEGMENT_USERS = 64;
+		std::atomic<uint64_t> segmentEpochs[SegmentCount];
+		std::atomic<uint32_t> segmentAccesses[SegmentCount];
+		std::atomic<bool> segmentGrowing[SegmentCount];
+		std::atomic<int64_t> segmentGrowOwners[SegmentCount];
+		std::atomic<int64_t> segmentUserPids[MAX_SEGMENT_USERS];
+		std::atomic<uint32_t> segmentUserAccesses[MAX_SEGMENT_USERS][SegmentCount];
+
+		// 各内存段的 NUMA 放置策略(SegmentNumaPolicy)和绑定的节点，所有进程按此放置各自写入的页
+		std::atomic<uint32_t> segmentNumaPolicies[SegmentCount];
+		std::atomic<int32_t> segmentNumaNodes[SegmentCount];
+
+		// 持久化内存段：persistentDirectory 为后备文件所在的目录，segmentPersistent 标记哪些内存段使用文件
+		SharedMemoryString persistentDirectory;
+		std::atomic<bool> segmentPersistent[SegmentCount];
+
+		// 各内存段实际所在 hugetlbfs 的页大小，0 表示共享内存对象或持久化文件；打开和扩容时只使用记录的后备存储
+		std::atomic<uint64_t> segmentHugePageSizes[SegmentCount];
+
+		// 读取方登记表：readerMask 按位标记已占用的读取方编号，编号重新分配时 readerGenerations 加一，
+		// 使各共享对象上该编号留下的游标失效；readerPids 为登记进程的进程号，用于识别已退出的读取方
+		static const size_t READER_NAME_SIZE = 64;
+		std::atomic<uint32_t> readerMask;
+		std::atomic<uint32_t> readerGenerations[MAX_READERS];
+		std::atomic<int64_t> readerPids[MAX_READERS];
+		char readerNames[MAX_READERS][READER_NAME_SIZE];
+
+		// 名称到对象句柄的目录，随名称列表一起更新
+		SharedNameDirectory directory;
+
+		// 多对象事务：提交期间 groupSequence 为奇数，提交完成后恢复为偶数并且 groupVersion 加一；
+		// 事务之外的每次计算数据写入完成后 groupSequence 加 2。
+		// 读取方在 groupSequence 不变的前提下读完一组对象即得到一致的一组数据，冲突过多时持 groupMutex 读取
+		std::atomic<uint64_t> groupSequence;
+		std::atomic<uint64_t> groupVersion;
+		bip::interprocess_mutex groupMutex;
+
 		SharedControlData(bip::managed_shared_memory::segment_manager* segment_manager);
 
 		// 拷贝构造函数
@@ -0,0 +1,585 @@
+#include "SharedSegment.h"
+#include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+#elif defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace EMP {
+
+    static_assert(std::is_same<SharedSegment::ManagedBuffer::segment_manager, bip::managed_shared_memory::segment_manager>::value,
+        "SharedSegment 必须与 managed_shared_memory 使用相同的段管理器");
+
+    namespace {
+
+        // 段头中的初始化状态
+        enum SegmentState : uint32_t {
+            SegmentUninitialized = 0,
+            SegmentInitialized = 1
+        };
+
+        // 打开方等待创建方完成初始化的最长时间
+        const std::chrono::milliseconds INIT_TIMEOUT(5000);
+
+        size_t roundUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        std::atomic<uint32_t>* segmentState(const SegmentMapping& mapping)
+        {
+            return static_cast<std::atomic<uint32_t>*>(mapping.region.get_address());
+        }
+
+        char* userAddress(const SegmentMapping& mapping)
+        {
+            return static_cast<char*>(mapping.region.get_address()) + SharedSegment::HEADER_SIZE;
+        }
+
+        size_t userSize(const SegmentMapping& mapping)
+        {
+            return mapping.region.get_size() - SharedSegment::HEADER_SIZE;
+        }
+
+        // 打开方等待段头标记为已初始化
+        void waitInitialized(const SegmentMapping& mapping)
+        {
+            auto deadline = std::chrono::steady_clock::now() + INIT_TIMEOUT;
+            while (segmentState(mapping)->load(std::memory_order_acquire) != SegmentInitialized) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    throw bip::interprocess_exception("共享内存段未完成初始化");
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // 打开映射，并确认创建方已完成初始化后再接入段管理器
+        SegmentMapping openInitialized(const char* name, const std::string& directory = std::string(), size_t hugePageSize = 0)
+        {
+            SegmentMapping mapping = SegmentMapping::open(name, directory, hugePageSize);
+            waitInitialized(mapping);
+            return mapping;
+        }
+
+#ifdef __linux__
+        // hugetlbfs 挂载点
+        struct HugePageMount
+        {
+            std::string dir;
+            size_t pageSize;
+        };
+
+        // 解析 "2M"、"1G"、"2048k" 形式的页大小
+        size_t parsePageSize(const std::string& text)
+        {
+            size_t value = 0;
+            size_t pos = 0;
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                value = value * 10 + static_cast<size_t>(text[pos] - '0');
+                ++pos;
+            }
+            if (pos < text.size()) {
+                switch (text[pos]) {
+                case 'k': case 'K': value *= 1024; break;
+                case 'm': case 'M': value *= 1024 * 1024; break;
+                case 'g': case 'G': value *= 1024 * 1024 * 1024; break;
+                default: break;
+                }
+            }
+            return value;
+        }
+
+        // 系统默认大页大小(/proc/meminfo 中的 Hugepagesize)
+        size_t defaultHugePageSize()
+        {
+            std::ifstream meminfo("/proc/meminfo");
+            std::string key;
+            while (meminfo >> key) {
+                if (key == "Hugepagesize:") {
+                    size_t kb = 0;
+                    meminfo >> kb;
+                    return kb * 1024;
+                }
+                meminfo.ignore((std::numeric_limits<std::streamsize>::max)(), '\n');
+            }
+            return 0;
+        }
+
+        // 从 /proc/mounts 中列出所有 hugetlbfs 挂载点及其页大小
+        std::vector<HugePageMount> hugePageMounts()
+        {
+            std::vector<HugePageMount> mounts;
+            std::ifstream file("/proc/mounts");
+            std::string line;
+            while (std::getline(file, line)) {
+                std::istringstream iss(line);
+                std::string device, dir, type, options;
+                if (!(iss >> device >> dir >> type >> options) || type != "hugetlbfs") {
+                    continue;
+                }
+
+                HugePageMount mount{ dir, 0 };
+                std::istringstream optionStream(options);
+                std::string option;
+                while (std::getline(optionStream, option, ',')) {
+                    if (option.compare(0, 9, "pagesize=") == 0) {
+                        mount.pageSize = parsePageSize(option.substr(9));
+                    }
+                }
+                if (mount.pageSize == 0) {
+                    mount.pageSize = defaultHugePageSize();
+                }
+                if (mount.pageSize != 0) {
+                    mounts.push_back(mount);
+                }
+            }
+            return mounts;
+        }
+
+        std::string hugePagePath(const HugePageMount& mount, const char* name)
+        {
+            return mount.dir + "/" + name;
+        }
+
+        // 解析 "0-1,3" 形式的节点列表
+        std::vector<int> readNodeList(const char* path)
+        {
+            std::vector<int> nodes;
+            std::ifstream file(path);
+            std::string text;
+            if (!std::getline(file, text)) {
+                return nodes;
+            }
+
+            std::istringstream iss(text);
+            std::string item;
+            while (std::getline(iss, item, ',')) {
+                if (item.empty()) {
+                    continue;
+                }
+                size_t dash = item.find('-');
+                int first = std::stoi(item.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+                for (int node = first; node <= last; ++node) {
+                    nodes.push_back(node);
+                }
+            }
+            return nodes;
+        }
+
+        // mbind 的节点位图
+        std::vector<unsigned long> nodeMask(const std::vector<int>& nodes)
+        {
+            const size_t bitsPerWord = sizeof(unsigned long) * 8;
+            std::vector<unsigned long> mask(static_cast<size_t>(SharedSegment::numaNodeCount()) / bitsPerWord + 1, 0);
+            for (int node : nodes) {
+                if (node >= 0 && static_cast<size_t>(node) / bitsPerWord < mask.size()) {
+                    mask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+                }
+            }
+            return mask;
+        }
+
+        // 对 [addr, addr + length) 设置内存策略，addr 须按页对齐
+        bool bindMemory(void* addr, size_t length, int mode, const std::vector<unsigned long>& mask, unsigned flags)
+        {
+            // 内核按 maxnode - 1 位读取位图
+            unsigned long maxNode = mask.empty() ? 0 : mask.size() * sizeof(unsigned long) * 8 + 1;
+            return ::syscall(SYS_mbind, addr, length, mode, mask.empty() ? nullptr : mask.data(), maxNode, flags) == 0;
+        }
+
+#endif
+
+        // 映射文件；hugetlbfs 中的文件在大页池不足时 mmap 失败并抛出异常
+        SegmentMapping mapFile(const std::string& path, size_t pageSize, bool persistent)
+        {
+            bip::file_mapping file(path.c_str(), bip::read_write);
+            SegmentMapping mapping;
+            mapping.region = bip::mapped_region(file, bip::read_write);
+            mapping.path = path;
+            mapping.pageSize = pageSize;
+            mapping.persistent = persistent;
+            return mapping;
+        }
+
+        std::string persistentPath(const char* name, const std::string& directory)
+        {
+            return (fs::path(directory) / name).string();
+        }
+    }
+
+    const size_t SharedSegment::HEADER_SIZE = roundUp(sizeof(uint32_t), SharedSegment::ManagedBuffer::segment_manager::memory_algorithm::Alignment);
+
+    size_t SharedSegment::defaultPageSize()
+    {
+        return bip::mapped_region::get_page_size();
+    }
+
+    SegmentMapping SegmentMapping::create(const char* name, size_t size, size_t pageSize)
+    {
+#ifdef __linux__
+        if (pageSize > SharedSegment::defaultPageSize()) {
+            for (const auto& mount : hugePageMounts()) {
+                if (mount.pageSize != pageSize) {
+                    continue;
+                }
+
+                // 与共享内存对象一样只创建新文件，已有的同名文件可能属于仍在运行的内存段，不能截断
+                std::string path = hugePagePath(mount, name);
+                int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+                if (fd < 0) {
+                    if (errno == EEXIST) {
+                        throw bip::interprocess_exception(("hugetlbfs 中已存在同名内存段: " + path).c_str());
+                    }
+                    continue;
+                }
+                ::close(fd);
+
+                // 大页上的映射大小必须是页大小的整数倍
+                try {
+                    fs::resize_file(path, roundUp(size, pageSize));
+                    return mapFile(path, pageSize, false);
+                }
+                catch (const std::exception&) {
+                    std::error_code ec;
+                    fs::remove(path, ec);
+                }
+            }
+        }
+#endif
+
+        bip::shared_memory_object shm(bip::create_only, name, bip::read_write);
+        shm.truncate(static_cast<bip::offset_t>(size));
+        SegmentMapping mapping;
+        mapping.region = bip::mapped_region(shm, bip::read_write);
+        mapping.pageSize = SharedSegment::defaultPageSize();
+
+#ifdef __linux__
+        // 没有可用的 hugetlbfs 时请求透明大页，内核是否采用由 shmem_enabled 决定，页大小仍按默认页报告
+        if (pageSize > SharedSegment::defaultPageSize()) {
+            ::madvise(mapping.region.get_address(), mapping.region.get_size(), MADV_HUGEPAGE);
+        }
+#endif
+        return mapping;
+    }
+
+    SegmentMapping SegmentMapping::createFile(const char* name, size_t size, const std::string& directory)
+    {
+        fs::create_directories(directory);
+        std::string path = persistentPath(name, directory);
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                throw bip::interprocess_exception(("无法创建持久化内存段文件: " + path).c_str());
+            }
+        }
+        fs::resize_file(path, size);
+        return mapFile(path, SharedSegment::defaultPageSize(), true);
+    }
+
+    SegmentMapping SegmentMapping::open(const char* name, const std::string& directory, size_t hugePageSize)
+    {
+        if (!directory.empty()) {
+            return mapFile(persistentPath(name, directory), SharedSegment::defaultPageSize(), true);
+        }
+
+        if (hugePageSize > 0) {
+#ifdef __linux__
+            for (const auto& mount : hugePageMounts()) {
+                std::string path = hugePagePath(mount, name);
+                std::error_code ec;
+                if (mount.pageSize == hugePageSize && fs::exists(path, ec)) {
+                    return mapFile(path, mount.pageSize, false);
+                }
+            }
+#endif
+            throw bip::interprocess_exception(("hugetlbfs 中找不到内存段: " + std::string(name)).c_str());
+        }
+
+        bip::shared_memory_object shm(bip::open_only, name, bip::read_write);
+        SegmentMapping mapping;
+        mapping.region = bip::mapped_region(shm, bip::read_write);
+        mapping.pageSize = SharedSegment::defaultPageSize();
+        return mapping;
+    }
+
+    SharedSegment::SharedSegment(bip::create_only_t, const char* name, size_t size, size_t pageSize)
+        : SegmentMapping(SegmentMapping::create(name, size, pageSize))
+        , ManagedBuffer(bip::create_only, userAddress(*this), userSize(*this))
+    {
+        segmentState(*this)->store(SegmentInitialized, std::memory_order_release);
+    }
+
+    SharedSegment::SharedSegment(bip::open_only_t, const char* name, size_t hugePageSize)
+        : SegmentMapping(openInitialized(name, std::string(), hugePageSize))
+        , ManagedBuffer(bip::open_only, userAddress(*this), userSize(*this))
+    {
+    }
+
+    SharedSegment::SharedSegment(bip::create_only_t, const char* name, size_t size, const std::string& directory)
+        : SegmentMapping(SegmentMapping::createFile(name, size, directory))
+        , ManagedBuffer(bip::create_only, userAddress(*this), userSize(*this))
+    {
+        segmentState(*this)->store(SegmentInitialized, std::memory_order_release);
+    }
+
+    SharedSegment::SharedSegment(bip::open_only_t, const char* name, const std::string& directory)
+        : SegmentMapping(openInitialized(name, directory))
+        , ManagedBuffer(bip::open_only, userAddress(*this), userSize(*this))
+    {
+    }
+
+    bool SharedSegment::flush()
+    {
+        return path.empty() || region.flush();
+    }
+
+    SharedSegment::~SharedSegment()
+    {
+    }
+
+    int SharedSegment::numaNodeCount()
+    {
+#ifdef __linux__
+        std::vector<int> nodes = readNodeList("/sys/devices/system/node/online");
+        return nodes.empty() ? 1 : nodes.back() + 1;
+#else
+        return 1;
+#endif
+    }
+
+    int SharedSegment::currentNumaNode()
+    {
+#ifdef __linux__
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+            return static_cast<int>(node);
+        }
+#endif
+        return 0;
+    }
+
+    bool SharedSegment::setNumaPolicy(SegmentNumaPolicy policy, int node)
+    {
+#ifdef __linux__
+        int mode = MPOL_DEFAULT;
+        unsigned flags = 0;
+        std::vector<unsigned long> mask;
+        switch (policy) {
+        case NumaInterleave: {
+            // 只在有内存的节点间交错
+            std::vector<int> nodes = readNodeList("/sys/devices/system/node/has_memory");
+            if (nodes.empty()) {
+                nodes.push_back(0);
+            }
+            mode = MPOL_INTERLEAVE;
+            mask = nodeMask(nodes);
+            flags = MPOL_MF_MOVE;
+            break;
+        }
+        case NumaBind:
+            if (node < 0 || node >= numaNodeCount()) {
+                return false;
+            }
+            mode = MPOL_BIND;
+            mask = nodeMask({ node });
+            flags = MPOL_MF_MOVE;
+            break;
+        default:
+            // NumaDefault 和 NumaFirstTouch 在段上都使用默认策略，后者由写入方放置各自对象的页
+            break;
+        }
+        return bindMemory(region.get_address(), region.get_size(), mode, mask, flags);
+#else
+        (void)policy;
+        (void)node;
+        return false;
+#endif
+    }
+
+    bool SharedSegment::placeRange(const void* addr, size_t bytes, int node)
+    {
+#ifdef __linux__
+        char* base = static_cast<char*>(region.get_address());
+        const char* begin = static_cast<const char*>(addr);
+        if (bytes == 0 || node < 0 || begin < base || begin + bytes > base + region.get_size()) {
+            return false;
+        }
+
+        // 扩展到完整的页，与相邻对象共用的页也一并放置
+        size_t first = static_cast<size_t>(begin - base) / pageSize * pageSize;
+        size_t last = roundUp(static_cast<size_t>(begin - base) + bytes, pageSize);
+        return bindMemory(base + first, last - first, MPOL_PREFERRED, nodeMask({ node }), MPOL_MF_MOVE);
+#else
+        (void)addr;
+        (void)bytes;
+        (void)node;
+        return false;
+#endif
+    }
+
+    SegmentNumaInfo SharedSegment::numaInfo() const
+    {
+        SegmentNumaInfo info;
+        info.pageSize = pageSize;
+        info.totalPages = (region.get_size() + pageSize - 1) / pageSize;
+        info.nodePages.assign(static_cast<size_t>(numaNodeCount()), 0);
+
+#ifdef __linux__
+        char* base = static_cast<char*>(region.get_address());
+        size_t basePage = defaultPageSize();
+        std::vector<unsigned char> resident((region.get_size() + basePage - 1) / basePage);
+        if (::mincore(base, region.get_size(), resident.data()) != 0) {
+            return info;
+        }
+
+        std::vector<void*> pages;
+        for (size_t i = 0; i < info.totalPages; ++i) {
+            if (resident[i * (pageSize / basePage)] & 1) {
+                pages.push_back(base + i * pageSize);
+            }
+        }
+        info.residentPages = pages.size();
+
+        // 其他进程分配而本进程尚未映射的页先读一次建立映射(不会分配新页)，再查询所在节点
+        for (void* page : pages) {
+            (void)*static_cast<volatile const char*>(page);
+        }
+
+        const size_t batch = 4096;
+        std::vector<int> status(batch);
+        for (size_t offset = 0; offset < pages.size(); offset += batch) {
+            size_t count = (std::min)(batch, pages.size() - offset);
+            if (::syscall(SYS_move_pages, 0, count, pages.data() + offset, nullptr, status.data(), 0) != 0) {
+                break;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (status[i] >= 0 && static_cast<size_t>(status[i]) < info.nodePages.size()) {
+                    ++info.nodePages[status[i]];
+                }
+            }
+        }
+#endif
+        return info;
+    }
+
+    bool SharedSegment::grow(const char* name, size_t extraBytes, const std::string& directory, size_t hugePageSize)
+    {
+        try {
+            SegmentMapping mapping = openInitialized(name, directory, hugePageSize);
+            size_t oldSize = mapping.region.get_size();
+            // 段尾追加的空闲块不能小于分配器的最小块，增量至少为一页
+            extraBytes = (std::max)(extraBytes, mapping.pageSize);
+            size_t newSize = mapping.path.empty() || mapping.persistent ? oldSize + extraBytes : roundUp(oldSize + extraBytes, mapping.pageSize);
+
+            // 先扩展底层对象，再按新大小映射并在段尾追加空闲块
+            if (mapping.path.empty()) {
+                bip::shared_memory_object shm(bip::open_only, name, bip::read_write);
+                shm.truncate(static_cast<bip::offset_t>(newSize));
+                mapping.region = bip::mapped_region(shm, bip::read_write);
+            }
+            else {
+                // 先解除映射再改变文件大小
+                size_t pageSize = mapping.pageSize;
+                bool persistent = mapping.persistent;
+                std::string path = mapping.path;
+                mapping = SegmentMapping();
+                fs::resize_file(path, newSize);
+                mapping = mapFile(path, pageSize, persistent);
+            }
+
+            ManagedBuffer buffer(bip::open_only, userAddress(mapping), oldSize - HEADER_SIZE);
+            buffer.grow(newSize - oldSize);
+            return true;
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    bool SharedSegment::reserveAddressRange(void* addr, size_t size)
+    {
+#ifdef __linux__
+        // 不带 MAP_FIXED，地址已被占用时内核另选地址，此时撤销并返回 false
+        void* reserved = ::mmap(addr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (reserved == MAP_FAILED) {
+            return false;
+        }
+        if (reserved != addr) {
+            ::munmap(reserved, size);
+            return false;
+        }
+        return true;
+#elif defined(_WIN32)
+        return ::VirtualAlloc(addr, size, MEM_RESERVE, PAGE_NOACCESS) == addr;
+#else
+        (void)addr;
+        (void)size;
+        return false;
+#endif
+    }
+
+    void SharedSegment::unreserveAddressRange(void* addr, size_t size)
+    {
+#ifdef __linux__
+        ::munmap(addr, size);
+#elif defined(_WIN32)
+        (void)size;
+        ::VirtualFree(addr, 0, MEM_RELEASE);
+#else
+        (void)addr;
+        (void)size;
+#endif
+    }
+
+    bool SharedSegment::remove(const char* name, const std::string& directory)
+    {
+        if (!directory.empty()) {
+            std::error_code ec;
+            return fs::remove(persistentPath(name, directory), ec);
+        }
+
+        bool removed = bip::shared_memory_object::remove(name);
+#ifdef __linux__
+        for (const auto& mount : hugePageMounts()) {
+            std::error_code ec;
+            removed = fs::remove(hugePagePath(mount, name), ec) || removed;
+        }
+#endif
+        return removed;
+    }
+
+    bool SharedSegment::exists(const char* name, const std::string& directory)
+    {
+        // 只读取段头，不映射整个文件
+        std::ifstream file(persistentPath(name, directory), std::ios::binary);
+        uint32_t state = SegmentUninitialized;
+        if (!file.read(reinterpret_cast<char*>(&state), sizeof(state))) {
+            return false;
+        }
+        return state == SegmentInitialized;
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef SHAREDSEGMENT_H
+#define SHAREDSEGMENT_H
+
+#include <string>
+#include <vector>
+#include <boost/interprocess/managed_external_buffer.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
+#include <boost/interprocess/indexes/iset_index.hpp>
+#include <boost/interprocess/creation_tags.hpp>
+#include "SolverHubDef.h"
+
+namespace bip = boost::interprocess;
+
+namespace EMP {
+
+    // 内存段使用的页大小
+    enum SegmentPageSize {
+        DefaultPages = 0,                   // 系统默认页(通常为 4 KB)
+        HugePages2M = 2 * 1024 * 1024,      // 2 MB 大页
+        HugePages1G = 1024 * 1024 * 1024    // 1 GB 大页
+    };
+
+    // 内存段的 NUMA 放置策略
+    enum SegmentNumaPolicy {
+        NumaDefault = 0,        // 系统默认：页面分配在首次访问它的进程所在节点
+        NumaInterleave,         // 页面在所有节点间交错分配
+        NumaBind,               // 页面只分配在指定节点
+        NumaFirstTouch          // 各对象的页面放在第一次写入它的进程所在节点，已分配的页随之迁移
+    };
+
+    // 内存段各页所在节点的统计
+    struct SOLVERHUB_API SegmentNumaInfo
+    {
+        size_t pageSize = 0;                // 统计所用的页大小
+        size_t totalPages = 0;              // 段内的页数
+        size_t residentPages = 0;           // 已分配物理内存的页数
+        std::vector<size_t> nodePages;      // 各节点上的页数，下标为节点号
+    };
+
+    // 内存段的映射：共享内存对象、hugetlbfs 中的文件或持久化目录下的普通文件
+    struct SOLVERHUB_API SegmentMapping
+    {
+        bip::mapped_region region;      // 整个映射，起始处为段头
+        std::string path;               // 映射的文件路径，使用共享内存对象时为空
+        size_t pageSize = 0;            // 映射实际使用的页大小
+        bool persistent = false;        // 是否为持久化目录下的普通文件
+
+        SegmentMapping() = default;
+        SegmentMapping(SegmentMapping&&) = default;
+        SegmentMapping& operator=(SegmentMapping&&) = default;
+
+        // 创建映射：pageSize 大于系统页时优先放在对应大小的 hugetlbfs 中；同名的共享内存对象或 hugetlbfs 文件已存在时抛出异常
+        static SegmentMapping create(const char* name, size_t size, size_t pageSize);
+        // 在 directory 下创建名为 name 的文件并映射
+        static SegmentMapping createFile(const char* name, size_t size, const std::string& directory);
+        // 打开已有映射：directory 不为空时打开其中的文件；否则 hugePageSize 大于 0 时只打开该页大小的 hugetlbfs 中的文件，
+        // 为 0 时只打开共享内存对象。后备存储由创建方记录，其他位置遗留的同名文件不会被误用
+        static SegmentMapping open(const char* name, const std::string& directory = std::string(), size_t hugePageSize = 0);
+    };
+
+    /// 共享内存段。
+    /// 与 managed_shared_memory 使用相同的分配算法和名称索引，段内对象的分配器类型不变；
+    /// 映射可以放在系统默认页上，也可以放在 2 MB / 1 GB 的大页上(Linux 下通过 hugetlbfs)。
+    /// 大页不可用时(未挂载 hugetlbfs、大页池不足或非 Linux 平台)回退到默认页，getPageSize 返回实际使用的页大小。
+    /// 指定目录创建的内存段以该目录下的普通文件为后备存储，进程退出后保留，之后的运行可以直接打开。
+    class SOLVERHUB_API SharedSegment
+        : private SegmentMapping
+        , public bip::basic_managed_external_buffer<char, bip::rbtree_best_fit<bip::mutex_family>, bip::iset_index>
+    {
+    public:
+        typedef bip::basic_managed_external_buffer<char, bip::rbtree_best_fit<bip::mutex_family>, bip::iset_index> ManagedBuffer;
+
+        // 段头大小：初始化标志，按分配器的 Alignment 对齐
+        static const size_t HEADER_SIZE;
+
+        // 创建内存段，同名的已有内存段需先 remove
+        SharedSegment(bip::create_only_t, const char* name, size_t size, size_t pageSize = DefaultPages);
+        // 打开已有内存段，hugePageSize 为创建时实际使用的大页大小(getPageSize)，位于默认页上时为 0
+        SharedSegment(bip::open_only_t, const char* name, size_t hugePageSize = 0);
+
+        // 在 directory 下创建持久化内存段，同名文件已存在时被覆盖
+        SharedSegment(bip::create_only_t, const char* name, size_t size, const std::string& directory);
+        // 打开 directory 下的持久化内存段
+        SharedSegment(bip::open_only_t, const char* name, const std::string& directory);
+        ~SharedSegment();
+
+        SharedSegment(const SharedSegment&) = delete;
+        SharedSegment& operator=(const SharedSegment&) = delete;
+
+        // 映射实际使用的页大小
+        size_t getPageSize() const { return pageSize; }
+
+        // 是否位于大页上
+        bool isHugePage() const { return !path.empty() && !persistent; }
+
+        // 是否为持久化内存段
+        bool isPersistent() const { return persistent; }
+
+        // 整个映射(含段头)的起始地址和大小
+        void* mappedAddress() const { return region.get_address(); }
+        size_t mappedSize() const { return region.get_size(); }
+
+        // 把修改写回后备文件，共享内存对象上总是成功
+        bool flush();
+
+        // 设置整个段的 NUMA 策略并迁移已分配的页。策略作用于共享内存对象本身，映射该段的所有进程之后分配的页都按此放置；
+        // NumaBind 需指定 node。非 Linux 平台或内核不支持时返回 false
+        bool setNumaPolicy(SegmentNumaPolicy policy, int node = -1);
+
+        // 将 [addr, addr + bytes) 所在的页优先放在 node 上，并迁移已分配的页
+        bool placeRange(const void* addr, size_t bytes, int node);
+
+        // 统计段内各页所在的节点，只统计已分配物理内存的页，不会触发新页的分配
+        SegmentNumaInfo numaInfo() const;
+
+        // 系统的 NUMA 节点数(非 NUMA 系统为 1)
+        static int numaNodeCount();
+
+        // 当前线程所在的 NUMA 节点
+        static int currentNumaNode();
+
+        // 原地扩容：扩展共享内存对象(大页时按页对齐)并在段尾追加空闲块，已有对象不移动；
+        // directory 不为空时扩容其中的持久化内存段，hugePageSize 同打开时
+        static bool grow(const char* name, size_t extraBytes, const std::string& directory = std::string(), size_t hugePageSize = 0);
+
+        // 删除内存段，包括 hugetlbfs 中的同名文件；directory 不为空时删除其中的持久化内存段文件
+        static bool remove(const char* name, const std::string& directory = std::string());
+
+        // directory 下的持久化内存段文件是否存在且已完成初始化
+        static bool exists(const char* name, const std::string& directory);
+
+        // 系统默认页大小
+        static size_t defaultPageSize();
+
+        // 保留 [addr, addr + size) 的地址空间而不占用内存，解除映射后防止该范围被之后的映射复用；
+        // 该范围已被占用或平台不支持时返回 false
+        static bool reserveAddressRange(void* addr, size_t size);
+        static void unreserveAddressRange(void* addr, size_t size);
+    };
+}
+
+#endif // SHAREDSEGMENT_H
@@ -16,6 +16,7 @@
 #include "GeoException.h"
 #include "Numeric.h"
 #include "ConstFieldSolver.h"
+#include "SharedMemoryPlanner.h"
 
 using json = nlohmann::json;
 
@@ -37,146 +38,117 @@ Interface::~Interface()
 {
 }
 
-//int Interface::addData(std::string dname, int storesize)
-//{
-//	if (!dataMap.count(dname)) {
-//		Tdata newdata(dname,name,;
-//		newdata.size = storesize;
-//		newdata.time.clear();
-//		newdata.data.clear();
-//		newdata.name = dname;
-//		newdata.pos = this;
-//		dataPool.push_back(newdata);
-//		//dataMap.clear();
-//		//for (auto& d : dataPool) {
-//		//	dataMap[d.name] = &d;
-//		//}
-//		dataMap[dname] = &(dataPool.back());
-//	}
-//	else {
-//		dataMap[dname]->size = storesize;
-//	}
-//	return 0;
-//}
-//
-//
-//int Interface::setData(std::string dname, double t, ArrayXd& data)
-//{
-//	Tdata* thedata = dataMap[dname];
-//	if (!thedata) return 1;
-//	if (!data.size()) return 2;
-//	if (thedata->time.size() && thedata->time.back() >= t) return 3;
-//
-//	thedata->time.push_back(t);
-//	thedata->data.push_back(data);
-//	if (thedata->time.size() > thedata->size)
-//		thedata->time.pop_front();
-//	if (thedata->data.size() > thedata->size)
-//		thedata->data.pop_front();
-//	if (isDebug)
-//		GM_MESSAGE("%s = [%f, %f, %f]\n", dname.c_str(), data[0], data[1], data[2]);
-//
-//	return 0;
-//}
-//
-//int Interface::setData(std::string dname, double t, std::vector<double>& data)
-//{
-//	Tdata* thedata = dataMap[dname];
-//	if (!thedata) return 1;
-//	if (!data.size()) return 2;
-//	if (thedata->time.size() && thedata->time.back() >= t) return 3;
-//	thedata->time.push_back(t);
-//	thedata->data.push_back(Map<ArrayXd>(&(data[0]), data.size()));
-//	if (thedata->time.size() > thedata->size)
-//		thedata->time.pop_front();
-//	if (thedata->data.size() > thedata->size)
-//		thedata->data.pop_front();
-//
-//	if (isDebug)
-//		GM_MESSAGE("%s = [%f, %f, %f]\n", dname.c_str(), data[0], data[1], data[2]);
-//	return 0;
-//}
-//
-//int Interface::getDataByPos(std::string dname, int i, ArrayXd& data)
-//{
-//	Tdata* thedata = dataMap[dname];
-//	if (!thedata) return 1;
-//	int dsize = thedata->data.size();
-//	if (i >= dsize || -i >dsize) return 2;
-//	if (i < 0) {
-//		data = thedata->data[dsize + i];
-//	}
-//	else {
-//		data = thedata->data[i];
-//	}
-//	if (isDebug)
-//		GM_MESSAGE("%s = [%f, %f, %f]\n", dname.c_str(), data[0], data[1], data[2]);
-//	return 0;
-//}
-//
-//int Interface::getData(std::string dname, double t, ArrayXd& data)
-//{
-//	Tdata* thedata = dataMap[dname];
-//	if (!thedata) return 1;
-//	if (thedata->time.size() == 0)
-//		return 3;
-//	else if (thedata->time.size() == 1) {
-//		if (t == thedata->time[0]) {
-//			data = thedata->data[0];
-//		}
-//		else
-//			return 4;
-//	}
-//	else {
-//		if (thedata->time.back() < t) return 5;
-//		int i = thedata->time.size() - 2;
-//		for (;i < 0; i--) {
-//			if (thedata->time[i] < t) break;
-//		}
-//		// 1st order interpolation
-//		double coe = (t - thedata->time[i]) / (thedata->time[i + 1] - thedata->time[i]);
-//		data = thedata->data[i] + coe * (thedata->data[i + 1] - thedata->data[i]);
-//	}
-//	if (isDebug)
-//		GM_MESSAGE("%s = [%d, %d, %d]\n", dname.c_str(), data[0], data[1], data[2]);
-//	return 0;
-//}
-//
-//
-//int Interface::getData(std::string dname, double t, std::vector<double>& data)
-//{
-//	Tdata* thedata = dataMap[dname];
-//	if (!thedata) return 1;
-//	data.clear();
-//	if (thedata->time.size() == 0) 
-//		return 3;
-//	else if (thedata->time.size() == 1) {
-//		if (t == thedata->time[0]) {
-//			data.resize(thedata->data[0].size());
-//			Map<ArrayXd> cdata(&(data[0]), data.size());
-//			cdata = thedata->data[0];
-//		}
-//		else
-//			return 4;
-//	}
-//	else {
-//		if (thedata->time.back() < t) return 5;
-//		int i = thedata->time.size() - 2;
-//		for (;i < 0; i--) {
-//			if (thedata->time[i] < t) break;
-//		}
-//		// 1st order interpolation
-//		data.resize(thedata->data[i].size());
-//
-//		Map<ArrayXd> cdata(&(data[0]), data.size());
-//		double coe = (t - thedata->time[i]) / (thedata->time[i + 1] - thedata->time[i]);
-//		cdata = thedata->data[i] + coe * (thedata->data[i + 1] - thedata->data[i]);
-//	}
-//	if (isDebug)
-//		GM_MESSAGE("%s = [%d, %d, %d]\n", dname.c_str(), data[0], data[1], data[2]);
-//	return 0;
-//}
-//
+int Interface::addData(std::string dname, int storesize)
+{
+	if (!dataMap.count(dname)) {
+		Tdata newdata;
+		newdata.name = dname;
+		newdata.type = VertexData;
+		newdata.isSequentiallyMatchedWithMesh = false;
+		newdata.size = storesize;
+		dataPool.push_back(newdata);
+
+		// dataPool ݺԪصַ仯ؽ
+		dataMap.clear();
+		for (auto& d : dataPool) {
+			dataMap[d.name] = &d;
+		}
+	}
+	else {
+		dataMap[dname]->size = storesize;
+	}
+
+	// ʷݱڹڴмݶʷ֡̹ͬһݡ
+	// ݶδʱֻ¼ GenerateSharedData 
+	if (sharedMemoryManager == nullptr) return 1;
+	if (sharedMemoryManager->findDataByName(dname) == nullptr) return 0;
+	if (!sharedMemoryManager->setDataHistory(dname, storesize)) return 2;
+	return 0;
+}
+
+// пʼǰݳع滮ڴΣmemorySize ¼ÿ֡ݵֵ
+// ʷ֡ȡݵ size滮Χڵд׷ʷ֡ٴ
+int Interface::GenerateSharedData()
+{
+	if (sharedMemoryManager == nullptr) return 1;
+
+	SharedMemoryPlanner planner;
+	for (auto& d : dataPool) {
+		LocalData local(d.name, d.meshName);
+		auto it = memorySize.find(d.name);
+		size_t count = (it != memorySize.end() && it->second > 0) ? static_cast<size_t>(it->second) : 0;
+		local.data.assign(1, std::vector<double>(count, 0.0));
+		planner.addData(local, 0, static_cast<uint32_t>((std::max)(d.size, 0)));
+	}
+	if (!sharedMemoryManager->applyMemoryPlan(planner)) return 2;
+
+	for (auto& d : dataPool) {
+		if (!sharedMemoryManager->setDataHistory(d.name, d.size)) return 3;
+	}
+	return 0;
+}
+
+int Interface::setData(std::string dname, double t, ArrayXd& data)
+{
+	if (!dataMap.count(dname) || sharedMemoryManager == nullptr) return 1;
+	if (!data.size()) return 2;
+
+	std::vector<std::vector<double>> frame(1, std::vector<double>(data.data(), data.data() + data.size()));
+	if (!sharedMemoryManager->appendDataFrame(dname, t, frame)) return 3;
+	return 0;
+}
+
+int Interface::setData(std::string dname, double t, std::vector<double>& data)
+{
+	if (!dataMap.count(dname) || sharedMemoryManager == nullptr) return 1;
+	if (!data.size()) return 2;
+
+	std::vector<std::vector<double>> frame(1, data);
+	if (!sharedMemoryManager->appendDataFrame(dname, t, frame)) return 3;
+	return 0;
+}
+
+int Interface::getDataByPos(std::string dname, int i, ArrayXd& data)
+{
+	if (!dataMap.count(dname) || sharedMemoryManager == nullptr) return 1;
+
+	double t;
+	std::vector<std::vector<double>> frame;
+	if (!sharedMemoryManager->getDataFrame(dname, i, t, frame) || frame.empty()) return 2;
+	data = Map<const ArrayXd>(frame[0].data(), frame[0].size());
+	return 0;
+}
+
+int Interface::getData(std::string dname, double t, ArrayXd& data)
+{
+	if (!dataMap.count(dname) || sharedMemoryManager == nullptr) return 1;
+
+	size_t count = sharedMemoryManager->getDataFrameCount(dname);
+	if (count == 0) return 3;
+
+	// ֮֡ 1 ײֵ
+	std::vector<std::vector<double>> frame;
+	if (!sharedMemoryManager->getDataAtTime(dname, t, frame) || frame.empty())
+		return count == 1 ? 4 : 5;
+	data = Map<const ArrayXd>(frame[0].data(), frame[0].size());
+	return 0;
+}
+
+int Interface::getData(std::string dname, double t, std::vector<double>& data)
+{
+	data.clear();
+	if (!dataMap.count(dname) || sharedMemoryManager == nullptr) return 1;
+
+	size_t count = sharedMemoryManager->getDataFrameCount(dname);
+	if (count == 0) return 3;
+
+	// ֮֡ 1 ײֵ
+	std::vector<std::vector<double>> frame;
+	if (!sharedMemoryManager->getDataAtTime(dname, t, frame) || frame.empty())
+		return count == 1 ? 4 : 5;
+	data = frame[0];
+	return 0;
+}
 
 //Solver::Solver(std::string _name, SolverHub *sys)
 //{
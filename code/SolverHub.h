@@ -16,11 +16,9 @@ namespace EMP {
 		std::string name;
 		std::string meshName;
 		DataGeoType type;			   // 
-		std::deque<ArrayXd> data;
-		std::deque<double> time; // ݶӦʱ
 		ArrayXi pos;   // ݶӦλ
 		bool isSequentiallyMatchedWithMesh; // Ƿ˳ƥ
-		int size;
+		int size;      // ʷ֡ʷ֡ڹڴļݶ
 	};
 
 	// Ϊ SharedMemoryManager  creator 
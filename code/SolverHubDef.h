@@ -6,11 +6,15 @@
 // that uses this DLL. This way any other project whose source files include this file see
 // SOLVERHUB_API functions as being imported from a DLL, whereas this DLL sees symbols
 // defined with this macro as being exported.
+#ifdef _WIN32
 #ifdef SOLVERHUB_EXPORTS
 #define SOLVERHUB_API __declspec(dllexport)
 #else
 #define SOLVERHUB_API __declspec(dllimport)
 #endif
+#else
+#define SOLVERHUB_API __attribute__((visibility("default")))
+#endif
 
 #include "pch.h"
 
@@ -1,8 +1,13 @@
 ﻿#include "gtest/gtest.h"
 #include "../code/SharedMemoryStruct.h"
+#include "../code/SharedDataKernels.h"
 #include <fstream>
 #include <ctime>
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <cstring>
 
 class LocalDataTest : public ::testing::Test {
 protected:
@@ -404,4 +409,160 @@ TEST_F(LocalDataTest, ScientificNotation) {
 
     // 清理测试文件
     // std::remove(scientificFilePath.c_str());
-}
\ No newline at end of file
+}
+// 测试有界误差的压缩保存与加载
+TEST_F(LocalDataTest, CompressedSaveAndLoad) {
+    std::string compressedFilePath = "test_compressed_data.emz";
+
+    // 数据量超过一个压缩块，覆盖多线程分块路径
+    const size_t rowCount = 200000;
+    EMP::LocalData originalData("compressed_test", "compressed_mesh");
+    originalData.isFieldData = true;
+    originalData.type = EMP::DataGeoType::VertexData;
+    originalData.t = 2.5;
+    originalData.version = 42;
+    originalData.sysTimeStamp = time(nullptr);
+    originalData.dimtags.push_back(std::make_pair(3, 1));
+
+    std::vector<double> pressure(rowCount), temperature(rowCount), flag(rowCount);
+    for (size_t i = 0; i < rowCount; ++i) {
+        originalData.index.push_back(static_cast<int>(i * 2 + 1));
+        pressure[i] = 1.0e5 * std::sin(i * 1.0e-4) + 3.0 * std::cos(i * 0.37);
+        temperature[i] = 300.0 + 1.0e-3 * static_cast<double>(i % 1000);
+        flag[i] = static_cast<double>(i % 7);
+    }
+    pressure[10] = std::numeric_limits<double>::quiet_NaN();
+    pressure[11] = 1.0e300;
+    originalData.addComponent("p", pressure, "Pa");
+    originalData.addComponent("T", temperature, "K");
+    originalData.addComponent("flag", flag, "1");
+
+    // 压力允许 1 Pa 误差，温度允许 1e-6 K，标志无损
+    std::vector<double> errorBounds = { 1.0, 1.0e-6, 0.0 };
+    ASSERT_TRUE(originalData.saveCompressed(compressedFilePath, errorBounds, 4));
+
+    EMP::LocalData loadedData;
+    ASSERT_TRUE(loadedData.loadCompressed(compressedFilePath, 4));
+
+    EXPECT_EQ(originalData.name, loadedData.name);
+    EXPECT_EQ(originalData.meshName, loadedData.meshName);
+    EXPECT_EQ(originalData.isFieldData, loadedData.isFieldData);
+    EXPECT_EQ(originalData.type, loadedData.type);
+    EXPECT_EQ(originalData.version, loadedData.version);
+    EXPECT_DOUBLE_EQ(originalData.t, loadedData.t);
+    EXPECT_EQ(originalData.dimtags, loadedData.dimtags);
+    EXPECT_EQ(originalData.index, loadedData.index);
+    EXPECT_EQ(originalData.titles, loadedData.titles);
+    EXPECT_EQ(originalData.units, loadedData.units);
+
+    // 每个值的误差都不超过给定的上限，NaN 和超出量化范围的值原样保存
+    ASSERT_EQ(3, loadedData.data.size());
+    for (size_t c = 0; c < 3; ++c) {
+        ASSERT_EQ(rowCount, loadedData.data[c].size());
+        for (size_t i = 0; i < rowCount; ++i) {
+            double expected = originalData.data[c][i];
+            double actual = loadedData.data[c][i];
+            if (std::isnan(expected)) {
+                EXPECT_TRUE(std::isnan(actual));
+            } else if (errorBounds[c] > 0.0) {
+                ASSERT_LE(std::fabs(expected - actual), errorBounds[c]) << "component " << c << " row " << i;
+            } else {
+                ASSERT_EQ(expected, actual);
+            }
+        }
+    }
+    EXPECT_EQ(1.0e300, loadedData.data[0][11]);
+
+    // 压缩文件应明显小于原始数据
+    std::ifstream file(compressedFilePath, std::ios::binary | std::ios::ate);
+    size_t rawBytes = rowCount * (3 * sizeof(double) + sizeof(int));
+    EXPECT_LT(static_cast<size_t>(file.tellg()), rawBytes / 2);
+    file.close();
+
+    // std::remove(compressedFilePath.c_str());
+}
+
+// 测试加载损坏或格式不符的压缩文件
+TEST_F(LocalDataTest, LoadInvalidCompressedFile) {
+    EMP::LocalData data("keep", "keep_mesh");
+    data.addComponent("x", { 1.0, 2.0 }, "m");
+
+    // 文本格式的数据文件不是压缩文件
+    EMP::LocalData textData("text", "text_mesh");
+    textData.addComponent("x", { 1.0 }, "m");
+    textData.index = { 1 };
+    ASSERT_TRUE(textData.saveToFile(dataFilePath));
+    EXPECT_FALSE(data.loadCompressed(dataFilePath));
+
+    // 截断的压缩文件
+    std::string truncatedFilePath = "test_truncated_data.emz";
+    textData.saveCompressed(truncatedFilePath, { 0.1 });
+    std::ifstream in(truncatedFilePath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(truncatedFilePath, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size() - 3);
+    out.close();
+    EXPECT_FALSE(data.loadCompressed(truncatedFilePath));
+
+    // 头部记录的值个数与数据长度不符，不按该个数分配内存
+    std::vector<double> values = { 1.0, 2.0, 3.0, 4.0 };
+    std::vector<double> decoded;
+    for (double errorBound : { 0.0, 0.1 }) {
+        std::vector<uint8_t> blob;
+        EMP::DataKernels::compressValues(values.data(), values.size(), errorBound, blob);
+        ASSERT_TRUE(EMP::DataKernels::decompressValues(blob.data(), blob.size(), decoded));
+        EXPECT_EQ(values.size(), decoded.size());
+        for (uint64_t count : { uint64_t(5), uint64_t(1) << 61, std::numeric_limits<uint64_t>::max() }) {
+            std::vector<uint8_t> corrupted = blob;
+            std::memcpy(corrupted.data() + 1, &count, sizeof(count));
+            EXPECT_FALSE(EMP::DataKernels::decompressValues(corrupted.data(), corrupted.size(), decoded));
+        }
+    }
+
+    // 加载失败时原有数据保持不变
+    EXPECT_EQ("keep", data.name);
+    ASSERT_EQ(1, data.data.size());
+    EXPECT_EQ(2, data.data[0].size());
+
+    // std::remove(truncatedFilePath.c_str());
+}
+
+// 测试稀疏表示与稠密展开
+TEST_F(LocalDataTest, SparseAndDense) {
+    EMP::LocalData denseData("contact_pressure", "test_mesh");
+    denseData.t = 0.5;
+    denseData.version = 7;
+    denseData.index = { 10, 11, 12, 13, 14, 15 };
+    denseData.addComponent("p", { 0.0, 2.5, 0.0, 0.0, 1.0e-12, 0.0 }, "Pa");
+    denseData.addComponent("q", { 0.0, 0.0, 0.0, -3.0, 0.0, std::numeric_limits<double>::quiet_NaN() }, "W");
+
+    // 只保留至少一个分量非零的行，NaN 视为非零
+    EMP::LocalData sparseData;
+    denseData.toSparse(sparseData);
+    EXPECT_EQ("contact_pressure", sparseData.name);
+    EXPECT_EQ(7, sparseData.version);
+    EXPECT_EQ(denseData.titles, sparseData.titles);
+    EXPECT_EQ(std::vector<int>({ 11, 13, 14, 15 }), sparseData.index);
+    ASSERT_EQ(2, sparseData.data.size());
+    EXPECT_EQ(std::vector<double>({ 2.5, 0.0, 1.0e-12, 0.0 }), sparseData.data[0]);
+    EXPECT_TRUE(std::isnan(sparseData.data[1][3]));
+
+    // 容差以内的值视为零
+    EMP::LocalData tolerantData;
+    denseData.toSparse(tolerantData, 1.0e-9);
+    EXPECT_EQ(std::vector<int>({ 11, 13, 15 }), tolerantData.index);
+
+    // 展开到网格的全部编号，未保存的行为 0，不在网格中的行被忽略
+    std::vector<int> meshIndex = { 9, 10, 11, 12, 13 };
+    EMP::LocalData expandedData;
+    tolerantData.toDense(meshIndex, expandedData);
+    EXPECT_EQ(meshIndex, expandedData.index);
+    EXPECT_EQ(std::vector<double>({ 0.0, 0.0, 2.5, 0.0, 0.0 }), expandedData.data[0]);
+    EXPECT_EQ(std::vector<double>({ 0.0, 0.0, 0.0, 0.0, -3.0 }), expandedData.data[1]);
+
+    // 可以原地转换
+    tolerantData.toDense(denseData.index, tolerantData);
+    EXPECT_EQ(denseData.index, tolerantData.index);
+    EXPECT_EQ(std::vector<double>({ 0.0, 2.5, 0.0, 0.0, 0.0, 0.0 }), tolerantData.data[0]);
+}
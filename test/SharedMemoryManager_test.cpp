@@ -0,0 +1,868 @@
+﻿#include "gtest/gtest.h"
+#include "../code/SharedMemoryManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// 每个测试创建一个独立命名的共享内存；创建者同时登记为读取方，读写都经过同一个管理器
+class SharedMemoryManagerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        memoryName = std::string("SMMTest_") + ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        writer = std::make_unique<EMP::SharedMemoryManager>(memoryName, true);
+
+        EMP::LocalControlData ctrl("model", "");
+        ctrl.dataNames = { "u", "v" };
+        ctrl.dataMemorySizes = { 64, 64 };
+        ctrl.version = 1;
+        writer->updateControlData(ctrl);
+        writer->createDataSegmentAndObjects();
+        u = writer->findDataByName("u");
+        v = writer->findDataByName("v");
+        ASSERT_NE(u, nullptr);
+        ASSERT_NE(v, nullptr);
+    }
+
+    void TearDown() override {
+        writer.reset();
+    }
+
+    // 以 version 写入 count 个值均为 value 的一个分量
+    void write(EMP::SharedData* data, uint64_t version, double value, size_t count = 64) {
+        EMP::LocalData local;
+        local.name = data->name.c_str();
+        local.data = { std::vector<double>(count, value) };
+        local.version = version;
+        writer->updateData(data, local);
+    }
+
+    // 用新的 LocalData 读取，避免按版本号跳过复制
+    EMP::LocalData read(EMP::SharedMemoryManager& manager, const std::string& name) {
+        EMP::LocalData local;
+        manager.getData(manager.findDataByName(name), local);
+        return local;
+    }
+
+    std::string memoryName;
+    std::unique_ptr<EMP::SharedMemoryManager> writer;
+    EMP::SharedData* u = nullptr;
+    EMP::SharedData* v = nullptr;
+};
+
+// 只有订阅了对象的读取方计入背压，未读取过的对象不受其他读取方影响
+TEST_F(SharedMemoryManagerTest, BackpressureCountsSubscribedReadersOnly) {
+    write(u, 1, 1.0);
+    write(v, 1, 1.0);
+
+    EMP::SharedMemoryManager& reader = *writer;
+    ASSERT_GE(reader.registerReader("structure"), 0);
+    read(reader, "u");
+
+    write(u, 2, 2.0);
+    write(v, 2, 2.0);
+    EXPECT_EQ(writer->slowestReaderVersion(u), 1u);
+    EXPECT_EQ(writer->slowestReaderVersion(v), v->version.load());
+    EXPECT_TRUE(writer->waitForReaders(v, 0, 10));
+    EXPECT_FALSE(writer->waitForReaders(u, 0, 10));
+
+    auto cursors = writer->getReaderCursors(v);
+    ASSERT_EQ(cursors.size(), 1u);
+    EXPECT_FALSE(cursors[0].subscribed);
+    EXPECT_TRUE(cursors[0].alive);
+
+    // 显式订阅从当前版本开始，取消订阅后不再拖慢写入方
+    EXPECT_TRUE(reader.subscribeReader(reader.findDataByName("v")));
+    EXPECT_EQ(writer->slowestReaderVersion(v), v->version.load());
+    write(v, 3, 3.0);
+    EXPECT_FALSE(writer->waitForReaders(v, 0, 10));
+    EXPECT_TRUE(reader.unsubscribeReader(reader.findDataByName("v")));
+    EXPECT_TRUE(writer->waitForReaders(v, 0, 10));
+}
+
+// 默认的背压等待有上限，读取方停止读取时写入在超时后照常进行
+TEST_F(SharedMemoryManagerTest, BackpressureDefaultTimeoutIsFinite) {
+    write(u, 1, 1.0);
+
+    EMP::SharedMemoryManager& reader = *writer;
+    ASSERT_GE(reader.registerReader("stalled"), 0);
+    read(reader, "u");
+
+    writer->setReaderBackpressure(1);
+    auto start = std::chrono::steady_clock::now();
+    write(u, 2, 2.0);
+    write(u, 3, 3.0);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(u->version.load(), 3u);
+    EXPECT_GE(elapsed, EMP::SharedMemoryManager::DEFAULT_BACKPRESSURE_TIMEOUT_MS);
+    EXPECT_LT(elapsed, 4 * EMP::SharedMemoryManager::DEFAULT_BACKPRESSURE_TIMEOUT_MS);
+}
+
+// 调整历史帧容量保留最新的帧，容量不变时不清空
+TEST_F(SharedMemoryManagerTest, HistoryCapacityChangeKeepsNewestFrames) {
+    ASSERT_TRUE(writer->setDataHistory("u", 3));
+    for (int i = 1; i <= 4; ++i) {
+        ASSERT_TRUE(writer->appendDataFrame("u", i, { { double(i), 2.0 * i } }));
+    }
+    ASSERT_TRUE(writer->setDataHistory("u", 3));
+    EXPECT_EQ(writer->getDataFrameCount("u"), 3u);
+
+    double t = 0.0;
+    std::vector<std::vector<double>> frame;
+    ASSERT_TRUE(writer->setDataHistory("u", 2));
+    EXPECT_EQ(writer->getDataFrameCount("u"), 2u);
+    ASSERT_TRUE(writer->getDataFrame("u", 0, t, frame));
+    EXPECT_EQ(t, 3.0);
+    EXPECT_EQ(frame[0][1], 6.0);
+
+    ASSERT_TRUE(writer->setDataHistory("u", 4));
+    EXPECT_EQ(writer->getDataFrameCount("u"), 2u);
+    ASSERT_TRUE(writer->appendDataFrame("u", 5.0, { { 5.0, 10.0 } }));
+    ASSERT_TRUE(writer->getDataFrame("u", -1, t, frame));
+    EXPECT_EQ(t, 5.0);
+    ASSERT_TRUE(writer->getDataAtTime("u", 3.5, frame));
+    EXPECT_DOUBLE_EQ(frame[0][0], 3.5);
+}
+
+// 原地扩容后已有对象的内容和之前取得的指针、视图仍然可用
+TEST_F(SharedMemoryManagerTest, GrowSegmentKeepsObjectsAndViews) {
+    write(u, 1, 3.0);
+
+    EMP::SharedDataView view = writer->getDataView("u");
+    ASSERT_TRUE(view.isValid());
+
+    size_t before = writer->getDataMemoryUsage().first;
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 4));
+    EXPECT_GE(writer->getDataMemoryUsage().first, before * 4 - EMP::SharedSegment::HEADER_SIZE);
+
+    // 扩容前取得的指针换到新映射中的同名对象
+    EMP::LocalData local;
+    writer->getData(u, local);
+    ASSERT_EQ(local.data.size(), 1u);
+    EXPECT_EQ(local.data[0][10], 3.0);
+    EXPECT_EQ(view.component(0)[10], 3.0);
+    view.release();
+
+    // 扩容出的空间可以容纳更大的数据
+    write(u, 2, 5.0, 10 * before / sizeof(double) / 4);
+    EMP::LocalData grown = read(*writer, "u");
+    ASSERT_EQ(grown.data[0].size(), 10 * before / sizeof(double) / 4);
+    EXPECT_EQ(grown.data[0].back(), 5.0);
+}
+
+// 扩容前取得的指针仍可用于等待新版本，跨多个等待分段的超时按时返回
+TEST_F(SharedMemoryManagerTest, WaitForNewVersionAfterGrow) {
+    write(u, 1, 1.0);
+    size_t before = writer->getDataMemoryUsage().first;
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 2));
+    EXPECT_EQ(writer->waitForNewVersion(u, 1, 10), 1u);
+    // u 仍指向旧映射，写入使用当前映射中的对象
+    write(writer->findDataByName("u"), 2, 2.0);
+    EXPECT_EQ(writer->waitForNewVersion(u, 1, 10), 2u);
+
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 4));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(writer->waitForNewVersion(u, 2, 250), 2u);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(250));
+    EXPECT_LT(elapsed, std::chrono::seconds(2));
+    EXPECT_EQ(writer->waitForNewVersion("u", 0, 10), 2u);
+}
+
+// 读取方游标的接口接受扩容前的对象指针，作用在当前映射中的对象上
+TEST_F(SharedMemoryManagerTest, ReaderCursorsAfterGrow) {
+    write(u, 1, 1.0);
+    EMP::SharedMemoryManager& reader = *writer;
+    ASSERT_GE(reader.registerReader("structure"), 0);
+    size_t before = writer->getDataMemoryUsage().first;
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 2));
+
+    // u 仍指向旧映射
+    EXPECT_TRUE(reader.subscribeReader(u));
+    write(writer->findDataByName("u"), 2, 2.0);
+    EXPECT_EQ(writer->slowestReaderVersion(u), 1u);
+    EXPECT_FALSE(writer->waitForReaders(u, 0, 250));
+
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 4));
+    reader.markConsumed(u, 2);
+    EXPECT_EQ(writer->slowestReaderVersion(writer->findDataByName("u")), 2u);
+    EXPECT_TRUE(writer->waitForReaders(u, 0, 10));
+    auto cursors = writer->getReaderCursors(u);
+    ASSERT_EQ(cursors.size(), 1u);
+    EXPECT_TRUE(cursors[0].subscribed);
+    EXPECT_EQ(cursors[0].version, 2u);
+
+    EXPECT_TRUE(reader.unsubscribeReader(u));
+    EXPECT_FALSE(writer->getReaderCursors(writer->findDataByName("u"))[0].subscribed);
+}
+
+// 等待策略的接口接受扩容前的对象指针，设置保存在当前映射中的对象上
+TEST_F(SharedMemoryManagerTest, WaitPolicyAfterGrow) {
+    size_t before = writer->getDataMemoryUsage().first;
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 2));
+
+    // u 仍指向旧映射
+    EMP::WaitPolicy policy;
+    policy.spinMicros = 20;
+    policy.yieldMicros = 30;
+    policy.adaptive = true;
+    writer->setWaitPolicy(u, policy);
+    EXPECT_EQ(writer->findDataByName("u")->getWaitPolicy().spinMicros, 20u);
+
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, before * 4));
+    EMP::WaitPolicy current = writer->getWaitPolicy(u);
+    EXPECT_EQ(current.spinMicros, 20u);
+    EXPECT_EQ(current.yieldMicros, 30u);
+    EXPECT_TRUE(current.adaptive);
+    EXPECT_EQ(writer->waitForNewVersion(u, 0, 10), 0u);
+    EXPECT_GT(writer->getAverageWaitMicros(u), 0u);
+}
+
+// 重建计算数据内存段后各对象的配置、内容、版本号和历史帧保持不变
+TEST_F(SharedMemoryManagerTest, RecreateDataSegmentKeepsConfiguration) {
+    ASSERT_TRUE(writer->setDataSlotCount(u, 2));
+    ASSERT_TRUE(writer->setDataRetention(u, 2, 4));
+    ASSERT_TRUE(writer->setDataHistory(u, 3));
+    writer->setSkipUnchangedWrites(u, true);
+    write(u, 1, 1.0);
+    write(u, 2, 2.0);
+    ASSERT_TRUE(writer->appendDataFrame(u, 1.0, { { 1.0, 2.0 } }));
+    ASSERT_TRUE(writer->appendDataFrame(u, 2.0, { { 3.0, 4.0 } }));
+
+    ASSERT_TRUE(writer->setDataPrecision(v, EMP::Float32Precision));
+    ASSERT_TRUE(writer->setDataLayout(v, EMP::InterleavedLayout));
+    writer->setDataSparse(v, true, 0.5);
+    EMP::LocalData local("v", "mesh");
+    local.index = { 1, 2, 3, 4 };
+    local.data = { { 0.0, 1.5, 0.0, 3.0 }, { 0.0, 2.5, 0.0, 4.0 } };
+    local.version = 1;
+    writer->updateData(v, local);
+    uint64_t uVersion = u->version.load();
+    uint64_t vVersion = v->version.load();
+
+    // 先扩容，再以较小的大小重建：不能原地扩容时按控制数据登记的大小重新创建内存段
+    size_t grown = 2 * writer->getDataMemoryUsage().first;
+    ASSERT_TRUE(writer->growSegment(EMP::DataSegment, grown));
+    ASSERT_TRUE(writer->recreateDataSegment(1));
+    ASSERT_LT(writer->getDataMemoryUsage().first, grown);
+    EMP::SharedData* u2 = writer->findDataByName("u");
+    EMP::SharedData* v2 = writer->findDataByName("v");
+    ASSERT_NE(u2, nullptr);
+    ASSERT_NE(v2, nullptr);
+
+    EXPECT_EQ(u2->slotCount, 2u);
+    ASSERT_TRUE(u2->versions);
+    EXPECT_EQ(u2->versions->depth, 2u);
+    EXPECT_EQ(u2->versions->capacity, 4u);
+    EXPECT_TRUE(u2->skipUnchanged.load());
+    EXPECT_EQ(u2->version.load(), uVersion);
+    EXPECT_EQ(read(*writer, "u").data[0][5], 2.0);
+    EXPECT_EQ(u2->history.capacity, 3u);
+    ASSERT_EQ(writer->getDataFrameCount(u2), 2u);
+    double t = 0.0;
+    std::vector<std::vector<double>> frame;
+    ASSERT_TRUE(writer->getDataFrame(u2, -1, t, frame));
+    EXPECT_EQ(t, 2.0);
+    EXPECT_EQ(frame[0][1], 4.0);
+
+    EXPECT_EQ(v2->precision, EMP::Float32Precision);
+    EXPECT_EQ(v2->layout, EMP::InterleavedLayout);
+    EXPECT_TRUE(v2->sparse.load());
+    EXPECT_EQ(v2->sparseTolerance.load(), 0.5);
+    EXPECT_EQ(v2->version.load(), vVersion);
+    EMP::LocalData restored = read(*writer, "v");
+    EXPECT_EQ(restored.index, (std::vector<int>{ 2, 4 }));
+    ASSERT_EQ(restored.data.size(), 2u);
+    EXPECT_EQ(restored.data[1][1], 4.0);
+}
+
+// 低分辨率副本：抽样取对应的行，分组平均取各组的平均值；副本不能成环，后台线程按精细数据的新版本更新副本
+TEST_F(SharedMemoryManagerTest, CoarseningValuesAndRefreshThread) {
+    EMP::LocalData fine("u", "mesh");
+    fine.index = { 10, 11, 12, 13, 14, 15 };
+    fine.data = { { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 }, { 10.0, 20.0, 30.0, 40.0, 50.0, 60.0 } };
+    fine.version = 1;
+
+    ASSERT_TRUE(writer->setDataCoarsening("u", "v", EMP::DataCoarsening::sampling({ 14, 11 })));
+    writer->updateData(u, fine);
+    EMP::LocalData coarse = read(*writer, "v");
+    EXPECT_EQ(coarse.index, (std::vector<int>{ 14, 11 }));
+    ASSERT_EQ(coarse.data.size(), 2u);
+    EXPECT_EQ(coarse.data[0], (std::vector<double>{ 5.0, 2.0 }));
+    EXPECT_EQ(coarse.data[1], (std::vector<double>{ 50.0, 20.0 }));
+
+    EXPECT_FALSE(writer->setDataCoarsening("v", "u", EMP::DataCoarsening::sampling({ 11 })));
+    EXPECT_THROW(EMP::DataCoarsening::averaging({ 0, 1 }, { { 10, 11 } }), std::invalid_argument);
+
+    writer->clearDataCoarsening("u");
+    ASSERT_TRUE(writer->setDataCoarsening("u", "v",
+        EMP::DataCoarsening::averaging({ 0, 1 }, { { 10, 11, 12 }, { 13, 15 } }), false));
+    ASSERT_TRUE(writer->startCoarseRefresh(5));
+    fine.data[0][5] = 8.0;
+    fine.version = 2;
+    writer->updateData(u, fine);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    do {
+        coarse = read(*writer, "v");
+        // 线程启动时可能先按上一个版本生成一次副本，等到出现新版本的结果
+        if (coarse.index == std::vector<int>{ 0, 1 } && coarse.data.size() == 2 && coarse.data[0][1] == 6.0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    } while (std::chrono::steady_clock::now() < deadline);
+    writer->stopCoarseRefresh();
+
+    coarse = read(*writer, "v");
+    EXPECT_EQ(coarse.index, (std::vector<int>{ 0, 1 }));
+    ASSERT_EQ(coarse.data.size(), 2u);
+    EXPECT_DOUBLE_EQ(coarse.data[0][0], 2.0);
+    EXPECT_DOUBLE_EQ(coarse.data[0][1], 6.0);
+    EXPECT_DOUBLE_EQ(coarse.data[1][0], 20.0);
+    EXPECT_DOUBLE_EQ(coarse.data[1][1], 50.0);
+}
+
+// 没有索引列的精细数据按行号解析成员；平均只计入存在的成员，稀疏模式下省略的全零行按 0 计入
+TEST_F(SharedMemoryManagerTest, CoarseningCountsPresentMembers) {
+    EMP::LocalData fine("u", "mesh");
+    fine.data = { { 1.0, 0.0, 3.0, 4.0 } };
+    fine.version = 1;
+
+    ASSERT_TRUE(writer->setDataCoarsening("u", "v",
+        EMP::DataCoarsening::averaging({ 0, 1, 2 }, { { 0, 1 }, { 3, 7 }, { 8, 9 } })));
+    writer->updateData(u, fine);
+    EMP::LocalData coarse = read(*writer, "v");
+    EXPECT_EQ(coarse.index, (std::vector<int>{ 0, 1, 2 }));
+    ASSERT_EQ(coarse.data.size(), 1u);
+    EXPECT_EQ(coarse.data[0], (std::vector<double>{ 0.5, 4.0, 0.0 }));
+
+    // 稀疏模式只保存第 0、2、3 行，第 1 行按 0 计入
+    writer->clearDataCoarsening("u");
+    ASSERT_TRUE(writer->setDataSparse("u", true));
+    ASSERT_TRUE(writer->setDataCoarsening("u", "v",
+        EMP::DataCoarsening::averaging({ 0, 1 }, { { 0, 1 }, { 1, 2, 3 } }), false));
+    fine.version = 2;
+    writer->updateData(u, fine);
+    ASSERT_EQ(writer->refreshCoarseData(), 1u);
+    coarse = read(*writer, "v");
+    ASSERT_EQ(coarse.data.size(), 1u);
+    EXPECT_DOUBLE_EQ(coarse.data[0][0], 0.5);
+    EXPECT_DOUBLE_EQ(coarse.data[0][1], 7.0 / 3.0);
+}
+
+// 分量长度不一致的数据被拒绝，共享对象保持上一次写入的内容
+TEST_F(SharedMemoryManagerTest, RaggedComponentsRejected) {
+    EMP::LocalData ragged("u", "mesh");
+    ragged.data = { { 1.0, 2.0, 3.0 }, { 4.0 } };
+    ragged.version = 1;
+
+    writer->updateData(u, ragged);
+    EXPECT_EQ(u->version.load(), 0u);
+
+    write(u, 2, 5.0, 3);
+    ragged.version = 3;
+    ASSERT_TRUE(writer->setDataLayout(u, EMP::InterleavedLayout));
+    writer->updateData(u, ragged);
+    EMP::LocalData out = read(*writer, "u");
+    ASSERT_EQ(out.data.size(), 1u);
+    EXPECT_EQ(out.data[0], (std::vector<double>{ 5.0, 5.0, 5.0 }));
+
+    writer->beginTransaction();
+    EXPECT_FALSE(writer->stageData(u, ragged));
+    writer->commitTransaction();
+
+    EMP::SharedFieldBuffer& buffer = u->data;
+    EXPECT_THROW(buffer.assign(ragged.data, EMP::PlanarLayout), std::invalid_argument);
+    EXPECT_EQ(buffer.rowCount, 3u);
+}
+
+// 视图未释放时写入在超时后放弃，已退出进程遗留的视图计数被回收
+TEST_F(SharedMemoryManagerTest, ViewReleaseTimesOutAndRecoversExitedHolders) {
+    write(u, 1, 1.0);
+    writer->setViewReleaseTimeout(50);
+    {
+        EMP::SharedDataView view = writer->getDataView("u");
+        ASSERT_TRUE(view.isValid());
+        write(u, 2, 2.0);
+        EXPECT_EQ(u->version.load(), 1u);
+        EXPECT_FALSE(writer->updateDataRange(u, 0, 1, { { 3.0 } }));
+        EXPECT_FALSE(writer->setDataLayout(u, EMP::InterleavedLayout));
+        EXPECT_EQ(view.component(0)[0], 1.0);
+    }
+    write(u, 2, 2.0);
+    EXPECT_EQ(u->version.load(), 2u);
+    EXPECT_EQ(u->viewPins.load(), 0u);
+
+#ifndef _WIN32
+    // 子进程固定视图后直接退出，不释放
+    pid_t child = fork();
+    if (child == 0) {
+        new EMP::SharedDataView(writer->getDataView("u"));
+        _exit(0);
+    }
+    ASSERT_GT(child, 0);
+    waitpid(child, nullptr, 0);
+    ASSERT_EQ(u->viewPins.load(), 1u);
+
+    writer->setViewReleaseTimeout(EMP::SharedMemoryManager::DEFAULT_VIEW_RELEASE_TIMEOUT_MS);
+    write(u, 3, 3.0);
+    EXPECT_EQ(u->version.load(), 3u);
+    EXPECT_EQ(u->viewPins.load(), 0u);
+#endif
+}
+
+// 多缓冲模式下视图读取固定的槽内的标题，之后的发布改写标题不影响视图
+TEST_F(SharedMemoryManagerTest, SlottedViewKeepsPublishedTitles) {
+    ASSERT_TRUE(writer->setDataSlotCount(u, 2));
+    EMP::LocalData local("u", "mesh");
+    local.titles = { "ux", "uy" };
+    local.data = { { 1.0, 2.0 }, { 3.0, 4.0 } };
+    local.version = 1;
+    writer->updateData(u, local);
+
+    EMP::SharedDataView view = writer->getDataView("u");
+    ASSERT_TRUE(view.isValid());
+
+    local.titles = { "p" };
+    local.data = { { 5.0, 6.0 } };
+    local.version = 2;
+    writer->updateData(u, local);
+    EXPECT_EQ(u->version.load(), 2u);
+
+    EXPECT_EQ(view.getComponentIndex("uy"), 1u);
+    EXPECT_EQ(view.getComponentIndex("p"), static_cast<size_t>(-1));
+    EXPECT_EQ(view.component("uy")[1], 4.0);
+    view.release();
+
+    EMP::SharedDataView current = writer->getDataView("u");
+    EXPECT_EQ(current.getComponentIndex("p"), 0u);
+    EXPECT_EQ(current.component("p")[0], 5.0);
+}
+
+// 稀疏模式的统计量包含省略的全零行
+TEST_F(SharedMemoryManagerTest, SparseStatsCountImplicitZeros) {
+    ASSERT_TRUE(writer->setDataSparse("u", true));
+    EMP::LocalData local("u", "mesh");
+    local.data = { { 0.0, 2.0, 0.0, 0.0, 4.0 } };
+    local.version = 1;
+    writer->updateData(u, local);
+    ASSERT_EQ(read(*writer, "u").data[0].size(), 2u);
+
+    EMP::SharedFieldStats stats;
+    ASSERT_TRUE(writer->getDataStats(u, stats));
+    EXPECT_EQ(stats.rowCount, 5u);
+    EXPECT_EQ(stats.components[0].count, 5u);
+    EXPECT_EQ(stats.components[0].min, 0.0);
+    EXPECT_EQ(stats.components[0].max, 4.0);
+    EXPECT_DOUBLE_EQ(stats.components[0].mean(), 1.2);
+}
+
+// 稀疏对象的索引子集对省略的全零行输出零；存储行不再对应稠密行号，按几何位置读取被拒绝
+TEST_F(SharedMemoryManagerTest, SparseSubsetsFillOmittedRows) {
+    ASSERT_TRUE(writer->setDataSparse("u", true));
+    ASSERT_TRUE(writer->setDataRegions(u, { EMP::SharedDataRegion{ 2, 7, 4, 2 } }));
+    EMP::LocalData local("u", "mesh");
+    local.data = { { 1, 0, 2, 3, 0, 5, 6, 7, 9, 0 } };
+    local.version = 1;
+    writer->updateData(u, local);
+    ASSERT_EQ(read(*writer, "u").data[0].size(), 7u);
+
+    EMP::LocalData subset;
+    EXPECT_FALSE(writer->getDataSubset(u, std::vector<std::pair<int, int>>{ { 2, 7 } }, subset));
+
+    ASSERT_TRUE(writer->getDataSubset(u, std::vector<int>{ 4, 5, 9, 1, 0 }, subset));
+    EXPECT_EQ(subset.index, (std::vector<int>{ 4, 5, 9, 1, 0 }));
+    ASSERT_EQ(subset.data.size(), 1u);
+    EXPECT_EQ(subset.data[0], (std::vector<double>{ 0, 5, 0, 0, 1 }));
+}
+
+// 数据名称中的路径字符不改变压缩快照文件的位置，恢复时名称从文件内容读取
+TEST_F(SharedMemoryManagerTest, CompressedSnapshotEscapesDataNames) {
+    std::string name = memoryName + "_names";
+    EMP::SharedMemoryManager manager(name, true);
+    EMP::LocalControlData ctrl("model", "");
+    ctrl.dataNames = { "a/b", "../c", "a%2Fb" };
+    ctrl.dataMemorySizes = { 64, 64, 64 };
+    ctrl.version = 1;
+    manager.updateControlData(ctrl);
+    manager.createDataSegmentAndObjects();
+    for (size_t i = 0; i < ctrl.dataNames.size(); ++i) {
+        EMP::LocalData local(ctrl.dataNames[i], "mesh");
+        local.data = { std::vector<double>(8, double(i + 1)) };
+        local.version = 1;
+        manager.updateData(manager.findDataByName(ctrl.dataNames[i]), local);
+    }
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(dir);
+    ASSERT_TRUE(manager.createCompressedSnapshot(dir.string()));
+    size_t files = 0;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+        if (entry.is_regular_file()) {
+            EXPECT_EQ(entry.path().parent_path().parent_path(), dir);
+            ++files;
+        }
+    }
+    EXPECT_EQ(files, ctrl.dataNames.size());
+
+    for (size_t i = 0; i < ctrl.dataNames.size(); ++i) {
+        EMP::LocalData local(ctrl.dataNames[i], "mesh");
+        local.data = { std::vector<double>(8, 0.0) };
+        local.version = 2;
+        manager.updateData(manager.findDataByName(ctrl.dataNames[i]), local);
+    }
+    ASSERT_TRUE(manager.restoreCompressedSnapshot(dir.string()));
+    for (size_t i = 0; i < ctrl.dataNames.size(); ++i) {
+        EMP::LocalData local = read(manager, ctrl.dataNames[i]);
+        ASSERT_EQ(local.data.size(), 1u);
+        EXPECT_EQ(local.data[0][7], double(i + 1)) << ctrl.dataNames[i];
+    }
+    std::filesystem::remove_all(dir);
+}
+
+// 读取方与写入方并发时，无论乐观读取还是加锁读取都只看到完整的一次写入
+TEST_F(SharedMemoryManagerTest, ConcurrentReadsSeeWholeWrites) {
+    write(u, 1, 1.0);
+    EMP::SharedMemoryManager& reader = *writer;
+
+    for (bool optimistic : { true, false }) {
+        reader.setOptimisticReads(optimistic);
+        uint64_t first = u->version.load() + 1;
+        std::atomic<bool> done(false);
+        std::thread producer([&]() {
+            for (uint64_t k = first; k < first + 200; ++k) {
+                write(u, k, double(k));
+            }
+            done = true;
+        });
+        size_t reads = 0;
+        size_t torn = 0;
+        while (!done || reads == 0) {
+            EMP::LocalData local = read(reader, "u");
+            if (local.data.size() != 1 || local.data[0].size() != 64
+                || std::count(local.data[0].begin(), local.data[0].end(), local.data[0][0]) != 64) {
+                ++torn;
+            }
+            ++reads;
+        }
+        producer.join();
+        EXPECT_EQ(torn, 0u) << (optimistic ? "optimistic" : "locked");
+        EXPECT_EQ(read(reader, "u").data[0][63], double(first + 199));
+    }
+}
+
+// 多缓冲模式下视图固定已发布的槽，写入方不等待视图释放
+TEST_F(SharedMemoryManagerTest, SlottedViewDoesNotBlockWriter) {
+    ASSERT_TRUE(writer->setDataSlotCount(u, 2));
+    writer->setViewReleaseTimeout(50);
+    write(u, 1, 1.0);
+
+    EMP::SharedMemoryManager& reader = *writer;
+    EMP::SharedDataView view = reader.getDataView("u");
+    ASSERT_TRUE(view.isValid());
+
+    write(u, 2, 2.0);
+    EXPECT_EQ(u->version.load(), 2u);
+    EXPECT_EQ(view.component(0)[0], 1.0);
+    EXPECT_EQ(view.component(0)[63], 1.0);
+    EXPECT_EQ(read(reader, "u").data[0][0], 2.0);
+    view.release();
+
+    // 单缓冲对象上的视图存活期间写入被放弃
+    write(v, 1, 1.0);
+    EMP::SharedDataView single = reader.getDataView("v");
+    ASSERT_TRUE(single.isValid());
+    write(v, 2, 2.0);
+    EXPECT_EQ(v->version.load(), 1u);
+    single.release();
+    write(v, 2, 2.0);
+    EXPECT_EQ(read(reader, "v").data[0][0], 2.0);
+}
+
+// 双缓冲对象上的视图跨过两次写入时，第二次写入没有后台槽，超时后放弃而不是一直等待；
+// 事务同样放弃提交，已退出进程遗留的槽固定被回收
+TEST_F(SharedMemoryManagerTest, SlotWriteTimesOutWhileViewHeldAcrossWrites) {
+    ASSERT_TRUE(writer->setDataSlotCount(u, 2));
+    writer->setViewReleaseTimeout(50);
+    write(u, 1, 1.0);
+    {
+        EMP::SharedDataView view = writer->getDataView("u");
+        ASSERT_TRUE(view.isValid());
+        write(u, 2, 2.0);
+        EXPECT_EQ(u->version.load(), 2u);
+
+        auto start = std::chrono::steady_clock::now();
+        write(u, 3, 3.0);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+        EXPECT_EQ(u->version.load(), 2u);
+        EXPECT_EQ(read(*writer, "u").data[0][0], 2.0);
+
+        EMP::LocalData local("u", "mesh");
+        local.data = { std::vector<double>(64, 4.0) };
+        local.version = 4;
+        writer->beginTransaction();
+        ASSERT_TRUE(writer->stageData(u, local));
+        EXPECT_EQ(writer->commitTransaction(), 0u);
+        EXPECT_EQ(view.component(0)[0], 1.0);
+    }
+    write(u, 3, 3.0);
+    EXPECT_EQ(u->version.load(), 3u);
+
+#ifndef _WIN32
+    // 子进程固定前台槽后直接退出，两次写入之后该槽成为唯一的后台槽
+    pid_t child = fork();
+    if (child == 0) {
+        new EMP::SharedDataView(writer->getDataView("u"));
+        _exit(0);
+    }
+    ASSERT_GT(child, 0);
+    waitpid(child, nullptr, 0);
+
+    writer->setViewReleaseTimeout(EMP::SharedMemoryManager::DEFAULT_VIEW_RELEASE_TIMEOUT_MS);
+    write(u, 4, 4.0);
+    write(u, 5, 5.0);
+    EXPECT_EQ(u->version.load(), 5u);
+    EXPECT_EQ(read(*writer, "u").data[0][0], 5.0);
+#endif
+}
+
+// 局部更新记录改写的行范围，增量读取只复制这些行；其间有整体写入时退回整体读取
+TEST_F(SharedMemoryManagerTest, DirtyRangesAndIncrementalReads) {
+    EMP::LocalData local("u", "mesh");
+    local.data = { std::vector<double>(100, 0.0), std::vector<double>(100, 1.0) };
+    local.version = 1;
+    writer->updateData(u, local);
+
+    EMP::SharedMemoryManager& reader = *writer;
+    EMP::LocalData cached = read(reader, "u");
+
+    ASSERT_TRUE(writer->updateDataRange(u, 10, 2, { { 5.0, 6.0 } }));
+    ASSERT_TRUE(writer->updateDataRange(u, 90, 1, { { 7.0 }, { 8.0 } }));
+    EXPECT_FALSE(writer->updateDataRange(u, 99, 2, { { 9.0, 9.0 } }));
+
+    auto changes = reader.getDataChanges("u", cached);
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0], std::make_pair(size_t(10), size_t(2)));
+    EXPECT_EQ(changes[1], std::make_pair(size_t(90), size_t(1)));
+    EXPECT_EQ(cached.data[0][11], 6.0);
+    EXPECT_EQ(cached.data[0][90], 7.0);
+    EXPECT_EQ(cached.data[1][90], 8.0);
+    EXPECT_EQ(cached.data[1][10], 1.0);
+    EXPECT_EQ(cached.version, u->version.load());
+    EXPECT_TRUE(reader.getDataChanges("u", cached).empty());
+
+    local.data[0].assign(100, 3.0);
+    local.version = 2;
+    writer->updateData(u, local);
+    ASSERT_TRUE(writer->updateDataRange(u, 0, 1, { { 4.0 } }));
+    changes = reader.getDataChanges("u", cached);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0], std::make_pair(size_t(0), size_t(100)));
+    EXPECT_EQ(cached.data[0][0], 4.0);
+    EXPECT_EQ(cached.data[0][50], 3.0);
+}
+
+// 事务中暂存的更新在提交时一起发布，放弃的事务不改变共享数据
+TEST_F(SharedMemoryManagerTest, TransactionsPublishGroupsTogether) {
+    EXPECT_EQ(writer->commitTransaction(), 0u);
+
+    EMP::LocalData lu("u", "mesh");
+    lu.data = { std::vector<double>(64, 1.0) };
+    lu.version = 1;
+    EMP::LocalData lv = lu;
+    lv.name = "v";
+
+    writer->beginTransaction();
+    ASSERT_TRUE(writer->stageData(u, lu));
+    ASSERT_TRUE(writer->stageData("v", lv));
+    // 暂存时已复制，提交前修改本地数据不影响提交的内容
+    lv.data[0].assign(64, -1.0);
+    EXPECT_EQ(u->version.load(), 0u);
+    uint64_t group = writer->commitTransaction();
+    ASSERT_NE(group, 0u);
+
+    EMP::SharedMemoryManager& reader = *writer;
+    std::vector<EMP::LocalData> locals;
+    EXPECT_EQ(reader.getDataGroup(std::vector<std::string>{ "u", "v" }, locals), group);
+    ASSERT_EQ(locals.size(), 2u);
+    EXPECT_EQ(locals[0].data[0][0], 1.0);
+    EXPECT_EQ(locals[1].data[0][63], 1.0);
+
+    writer->beginTransaction();
+    lu.data[0].assign(64, 2.0);
+    lu.version = 2;
+    ASSERT_TRUE(writer->stageData(u, lu));
+    writer->abortTransaction();
+    EXPECT_EQ(writer->commitTransaction(), 0u);
+    EXPECT_EQ(read(reader, "u").data[0][0], 1.0);
+
+    // 组版本只随提交递增，事务之外的写入照常读到
+    write(u, 3, 3.0);
+    EXPECT_EQ(reader.getDataGroup(std::vector<std::string>{ "u", "v" }, locals), group);
+    EXPECT_EQ(locals[0].data[0][0], 3.0);
+    EXPECT_EQ(locals[1].data[0][0], 1.0);
+}
+
+// 多版本保留：没有读取方时保留最新的 depth 个版本，登记的读取方落后时保留其读取的版本及之前 depth - 1 个
+TEST_F(SharedMemoryManagerTest, RetentionKeepsVersionsForLaggingReaders) {
+    write(u, 1, 1.0);
+    ASSERT_TRUE(writer->setDataRetention(u, 2));
+    write(u, 2, 2.0);
+    write(u, 3, 3.0);
+    EXPECT_EQ(writer->getRetainedVersions(u), (std::vector<uint64_t>{ 2, 3 }));
+
+    EMP::LocalData local;
+    ASSERT_TRUE(writer->getDataVersion(u, 2, local));
+    EXPECT_EQ(local.version, 2u);
+    EXPECT_EQ(local.data[0][0], 2.0);
+    EXPECT_FALSE(writer->getDataVersion(u, 1, local));
+
+    EMP::SharedMemoryManager& reader = *writer;
+    ASSERT_GE(reader.registerReader("slow"), 0);
+    EXPECT_EQ(read(reader, "u").version, 3u);
+    write(u, 4, 4.0);
+    write(u, 5, 5.0);
+    EXPECT_EQ(writer->getRetainedVersions(u), (std::vector<uint64_t>{ 2, 3, 4, 5 }));
+    ASSERT_TRUE(reader.getDataVersion("u", 2, local));
+    EXPECT_EQ(local.data[0][63], 2.0);
+
+    // 读取方跟上后回收旧版本，注销后只按 depth 保留
+    EXPECT_EQ(read(reader, "u").version, 5u);
+    write(u, 6, 6.0);
+    EXPECT_EQ(writer->getRetainedVersions(u), (std::vector<uint64_t>{ 4, 5, 6 }));
+    reader.unregisterReader();
+    write(u, 7, 7.0);
+    EXPECT_EQ(writer->getRetainedVersions(u), (std::vector<uint64_t>{ 6, 7 }));
+
+    ASSERT_TRUE(writer->setDataRetention(u, 0));
+    EXPECT_TRUE(writer->getRetainedVersions(u).empty());
+}
+
+// 降低存储精度后按对应精度舍入，恢复双精度不还原已舍入的值，之后的写入按双精度保存
+TEST_F(SharedMemoryManagerTest, PrecisionRoundTrip) {
+    EMP::LocalData local("u", "mesh");
+    local.data = { { 1.0, 0.1, -3.5, 1e10 }, { 2.0, 0.2, 7.0, -1e-3 } };
+    local.version = 1;
+    writer->updateData(u, local);
+    size_t doubleBytes = u->data.storageBytes();
+
+    ASSERT_TRUE(writer->setDataPrecision(u, EMP::Float32Precision));
+    EXPECT_EQ(u->data.storageBytes() * 2, doubleBytes);
+    EXPECT_FALSE(writer->getDataView(u).isValid());
+    EMP::LocalData out = read(*writer, "u");
+    ASSERT_EQ(out.data.size(), 2u);
+    EXPECT_EQ(out.data[0][0], 1.0);
+    EXPECT_EQ(out.data[0][1], double(float(0.1)));
+    EXPECT_EQ(out.data[0][3], 1e10);
+    EXPECT_EQ(out.data[1][3], double(float(-1e-3)));
+
+    local.version = 2;
+    writer->updateData(u, local);
+    EXPECT_EQ(read(*writer, "u").data[1][1], double(float(0.2)));
+
+    ASSERT_TRUE(writer->setDataPrecision(u, EMP::BFloat16Precision));
+    EXPECT_EQ(u->data.storageBytes() * 4, doubleBytes);
+    out = read(*writer, "u");
+    EXPECT_EQ(out.data[0][2], -3.5);
+    EXPECT_EQ(out.data[1][2], 7.0);
+    EXPECT_NEAR(out.data[0][1], 0.1, 0.1 / 128);
+    EXPECT_NEAR(out.data[0][3], 1e10, 1e10 / 128);
+
+    ASSERT_TRUE(writer->setDataPrecision(u, EMP::Float64Precision));
+    EXPECT_EQ(u->data.storageBytes(), doubleBytes);
+    EMP::LocalData widened = read(*writer, "u");
+    EXPECT_EQ(widened.data[0][1], out.data[0][1]);
+    EXPECT_TRUE(writer->getDataView(u).isValid());
+
+    local.version = 3;
+    writer->updateData(u, local);
+    out = read(*writer, "u");
+    EXPECT_EQ(out.data[0][1], 0.1);
+    EXPECT_EQ(out.data[1][3], -1e-3);
+}
+
+// 写入时统计与手工计算的结果一致：NaN/Inf 只计入 nonFinite，局部更新后统计失效，稀疏模式按稠密行数统计
+TEST_F(SharedMemoryManagerTest, WriteStatsMatchHandComputedValues) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    EMP::LocalData local("u", "mesh");
+    local.data = {
+        { 3.0, -1.0, nan, 4.0, inf, 0.0 },
+        { 1.0, 2.0, 2.0, -inf, 5.0, -8.0 },
+        { nan, nan, nan, nan, nan, nan },
+    };
+    local.version = 1;
+    writer->updateData(u, local);
+
+    EMP::SharedFieldStats stats;
+    uint64_t version = 0;
+    ASSERT_TRUE(writer->getDataStats(u, stats, &version));
+    EXPECT_EQ(version, u->version.load());
+    EXPECT_EQ(stats.componentCount, 3u);
+    EXPECT_EQ(stats.rowCount, 6u);
+
+    const EMP::DataKernels::ValueStats& x = stats.components[0];
+    EXPECT_EQ(x.count, 4u);
+    EXPECT_EQ(x.nonFinite, 2u);
+    EXPECT_EQ(x.min, -1.0);
+    EXPECT_EQ(x.max, 4.0);
+    EXPECT_DOUBLE_EQ(x.mean(), 1.5);
+    EXPECT_DOUBLE_EQ(x.l2Norm(), std::sqrt(26.0));
+
+    const EMP::DataKernels::ValueStats& y = stats.components[1];
+    EXPECT_EQ(y.count, 5u);
+    EXPECT_EQ(y.nonFinite, 1u);
+    EXPECT_EQ(y.min, -8.0);
+    EXPECT_EQ(y.max, 5.0);
+    EXPECT_DOUBLE_EQ(y.mean(), 0.4);
+    EXPECT_DOUBLE_EQ(y.l2Norm(), std::sqrt(98.0));
+
+    const EMP::DataKernels::ValueStats& z = stats.components[2];
+    EXPECT_EQ(z.count, 0u);
+    EXPECT_EQ(z.nonFinite, 6u);
+    EXPECT_EQ(z.min, inf);
+    EXPECT_EQ(z.max, -inf);
+    EXPECT_EQ(z.mean(), 0.0);
+
+    ASSERT_TRUE(writer->updateDataRange(u, 0, 1, { { 100.0 } }));
+    EXPECT_FALSE(writer->getDataStats(u, stats));
+
+    // 稀疏模式只保存第 1、3、4 行(NaN 视为非零)，省略的两行按 0 计入
+    writer->setDataSparse(v, true);
+    EMP::LocalData sparse("v", "mesh");
+    sparse.data = {
+        { 0.0, -2.0, 0.0, nan, 0.0 },
+        { 0.0, 0.0, 0.0, 0.0, 6.0 },
+    };
+    sparse.version = 1;
+    writer->updateData(v, sparse);
+    ASSERT_EQ(read(*writer, "v").data[0].size(), 3u);
+
+    ASSERT_TRUE(writer->getDataStats(v, stats));
+    EXPECT_EQ(stats.componentCount, 2u);
+    EXPECT_EQ(stats.rowCount, 5u);
+    EXPECT_EQ(stats.components[0].count, 4u);
+    EXPECT_EQ(stats.components[0].nonFinite, 1u);
+    EXPECT_EQ(stats.components[0].min, -2.0);
+    EXPECT_EQ(stats.components[0].max, 0.0);
+    EXPECT_DOUBLE_EQ(stats.components[0].mean(), -0.5);
+    EXPECT_DOUBLE_EQ(stats.components[0].l2Norm(), 2.0);
+    EXPECT_EQ(stats.components[1].count, 5u);
+    EXPECT_EQ(stats.components[1].nonFinite, 0u);
+    EXPECT_EQ(stats.components[1].min, 0.0);
+    EXPECT_EQ(stats.components[1].max, 6.0);
+    EXPECT_DOUBLE_EQ(stats.components[1].mean(), 1.2);
+    EXPECT_DOUBLE_EQ(stats.components[1].l2Norm(), 6.0);
+}